@@ -22,6 +22,7 @@
 #include "nrf_sdh_ble.h"
 #include "nrf_ble_gatt.h"
 #include "nrf_ble_qwr.h"
+#include "ble_conn_state.h"
 #include "app_timer.h"
 #include "app_util_platform.h"
 #include "bsp_btn_ble.h"
@@ -29,15 +30,43 @@
 #include "nrf_delay.h"
 
 #include "sys_bm.h"
+#include "sys_pm.h"
 #include "ble_bas.h"
 #include "ble_dis.h"
 #include "ble_acs.h"
 #include "ble_mgs.h"
 #include "ble_gys.h"
+#include "ble_evs.h"
+#include "ble_wfs.h"
+#include "ble_mos.h"
+#include "ble_tx_queue.h"
+#include "ble_link.h"
+#if (_CONFIG_CTRL_POINT)
+#include "ble_cps.h"
+#endif
+#if (_CONFIG_HRS)
+#include "ble_hrs.h"
+#include "hr_stream.h"
+#endif
 #include "bsp_hw.h"
+#include "bsp_time.h"
 #include "bsp_imu.h"
 #include "bsp_afe.h"
+#include "ecg_rhythm.h"
+#include "dsp_stages.h"
+#include "imu_ahrs.h"
+#include "imu_activity.h"
+#include "imu_calib.h"
 #include "bsp_nand_flash.h"
+#include "wave_stream.h"
+#include "motion_stream.h"
+#if (_CONFIG_WAVE_SPOOL)
+#include "wave_spool.h"
+#endif
+#include "sys_ctrl.h"
+#if (_CONFIG_BROADCAST)
+#include "vitals_adv.h"
+#endif
 #include "nrf52832_peripherals.h"
 
 #if defined(UART_PRESENT)
@@ -50,7 +79,8 @@
 /* Private defines ---------------------------------------------------- */
 #define APP_BLE_CONN_CFG_TAG            1                                          /**< A tag identifying the SoftDevice BLE configuration. */
 
-#define SENSORS_MEAS_INTERVAL           APP_TIMER_TICKS(2000)                      /**< Sensors measurement interval (ticks). */
+#define SENSORS_MEAS_PERIOD_MS          2000                                       /**< Boot sensors measurement period (ms). */
+#define SENSORS_MEAS_PERIOD_MIN_MS      100                                        /**< Shortest sensors measurement period set by the control point (ms). */
 #define BATT_LEVEL_MEAS_INTERVAL        APP_TIMER_TICKS(20000)                     /**< Battery level measurement interval (ticks). */
 
 #define DEVICE_NAME                     "imu-lcd"                                  /**< Name of device. Will be included in the advertising data. */
@@ -65,6 +95,9 @@
 
 #define APP_ADV_DURATION                18000                                       /**< The advertising duration (180 seconds) in units of 10 milliseconds. */
 
+#define BROADCAST_ADV_INTERVAL          MSEC_TO_UNITS(250, UNIT_0_625_MS)           /**< Broadcast only advertising interval (250 ms). */
+#define BROADCAST_PERIOD_MIN_MS         250                                         /**< Shortest vitals update period set by the control point (ms). */
+
 #define MIN_CONN_INTERVAL               MSEC_TO_UNITS(20, UNIT_1_25_MS)             /**< Minimum acceptable connection interval (20 ms), Connection interval uses 1.25 ms units. */
 #define MAX_CONN_INTERVAL               MSEC_TO_UNITS(75, UNIT_1_25_MS)             /**< Maximum acceptable connection interval (75 ms), Connection interval uses 1.25 ms units. */
 #define SLAVE_LATENCY                   0                                           /**< Slave latency. */
@@ -73,67 +106,130 @@
 #define NEXT_CONN_PARAMS_UPDATE_DELAY   APP_TIMER_TICKS(30000)                      /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
 #define MAX_CONN_PARAMS_UPDATE_COUNT    3                                           /**< Number of attempts before giving up the connection parameter negotiation. */
 
-#define DEAD_BEEF                       0xDEADBEEF                                  /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
+#define STILL_MIN_CONN_INTERVAL         MSEC_TO_UNITS(100, UNIT_1_25_MS)            /**< Minimum acceptable connection interval while still (100 ms). */
+#define STILL_MAX_CONN_INTERVAL         MSEC_TO_UNITS(200, UNIT_1_25_MS)            /**< Maximum acceptable connection interval while still (200 ms). */
+#define STILL_SLAVE_LATENCY             4                                           /**< Slave latency while still. */
+#define UNWORN_MIN_CONN_INTERVAL        MSEC_TO_UNITS(500, UNIT_1_25_MS)            /**< Minimum acceptable connection interval while unworn (500 ms). */
+#define UNWORN_MAX_CONN_INTERVAL        MSEC_TO_UNITS(1000, UNIT_1_25_MS)           /**< Maximum acceptable connection interval while unworn (1 second). */
+#define UNWORN_SLAVE_LATENCY            0                                           /**< Slave latency while unworn. */
+#define STREAM_MIN_CONN_INTERVAL        MSEC_TO_UNITS(7.5, UNIT_1_25_MS)            /**< Minimum acceptable connection interval while streaming (7.5 ms). */
+#define STREAM_MAX_CONN_INTERVAL        MSEC_TO_UNITS(15, UNIT_1_25_MS)             /**< Maximum acceptable connection interval while streaming (15 ms). */
+#define STREAM_SLAVE_LATENCY            0                                           /**< Slave latency while streaming. */
+
+#define STREAMING_WAVE                  SYS_CTRL_STREAM_WAVE                        /**< Waveform notifications enabled. */
+#define STREAMING_MOTION                SYS_CTRL_STREAM_MOTION                      /**< Motion notifications enabled. */
+
+#define LOG_FLUSH_WINDOWS               30                                          /**< Activity windows between two NAND flash log flushes (60 s), the records lost on a reset. */
 
-#define MA_FILTER_SIZE                  50                                          /**< Size of MA filter for filtering ECG/EMG data. */ 
-#define EMG_SIGNAL_SIZE                 64                                          /**< Size of processed ECG/EMG signal. */ 
-#define ENVELOPE_SIZE                   100                                         /**< Size of EMG envelope. */
-#define THRESHOLD                       0                                           /**< Threshold for myopulse percent 
+#define QWR_MEM_BUFF_SIZE               128                                         /**< Queued write memory of each link, a control point command in 23-byte ATT MTU chunks. */
+
+#define DEAD_BEEF                       0xDEADBEEF                                  /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
 
 /* Private macros ----------------------------------------------------- */                                                            /**< BLE HRNS service instance. */
+#if (_CONFIG_IMU_RAW_STREAM)
 BLE_ACS_DEF(m_acs);                                                                 /**< BLE ACS service instance. */
 BLE_MGS_DEF(m_mgs);                                                                 /**< BLE MGS service instance. */
 BLE_GYS_DEF(m_gys);                                                                 /**< BLE GYS service instance. */
+#endif
+#if (_CONFIG_IMU_MOTION_STREAM)
+BLE_MOS_DEF(m_mos, NRF_SDH_BLE_TOTAL_LINK_COUNT);                                   /**< BLE MOS service instance. */
+#endif
+#if (_CONFIG_CTRL_POINT)
+BLE_CPS_DEF(m_cps, NRF_SDH_BLE_TOTAL_LINK_COUNT);                                   /**< BLE CPS service instance. */
+#endif
+BLE_EVS_DEF(m_evs);                                                                 /**< BLE EVS service instance. */
+#if (_CONFIG_WAVE_STREAM)
+BLE_WFS_DEF(m_wfs, NRF_SDH_BLE_TOTAL_LINK_COUNT);                                   /**< BLE WFS service instance. */
+#endif
+#if (_CONFIG_HRS)
+BLE_HRS_DEF(m_hrs);                                                                 /**< BLE HRS service instance. */
+#endif
 BLE_BAS_DEF(m_bas);                                                                 /**< Structure used to identify the battery service. */
 NRF_BLE_GATT_DEF(m_gatt);                                                           /**< GATT module instance. */
-NRF_BLE_QWR_DEF(m_qwr);                                                             /**< Context for the Queued Write module.*/
+NRF_BLE_QWRS_DEF(m_qwr, NRF_SDH_BLE_TOTAL_LINK_COUNT);                              /**< Context for the Queued Write module, one per link.*/
 BLE_ADVERTISING_DEF(m_advertising);                                                 /**< Advertising module instance. */
 APP_TIMER_DEF(m_sensors_timer_id);                                                  /**< Sensor measurement timer. */
 APP_TIMER_DEF(m_battery_timer_id);                                                  /**< Battery timer. */
+#if (_CONFIG_BROADCAST)
+APP_TIMER_DEF(m_broadcast_timer_id);                                                /**< Vitals advertising data update timer. */
+#endif
 
 /* Private variables -------------------------------------------------- */
-static uint16_t   m_conn_handle          = BLE_CONN_HANDLE_INVALID;                 /**< Handle of the current connection. */
+static uint16_t   m_time_conn_handle     = BLE_CONN_HANDLE_INVALID;                 /**< Link the sample timebase follows. */
+static bool       m_advertising_on       = false;                                   /**< Advertising running, it is stopped by a connection or a timeout. */
+static volatile bool m_sleep_pending     = false;                                   /**< System off requested from an event handler, entered from the main loop. */
+static uint8_t    m_log_windows          = 0;                                       /**< Activity windows since the last NAND flash log flush. */
 static ble_uuid_t m_adv_uuids[]          =                                          /**< Universally unique service identifier. */
 {
+#if (_CONFIG_HRS)
+  {BLE_UUID_HEART_RATE_SERVICE,         BLE_UUID_TYPE_BLE},
+#endif
   {BLE_UUID_BATTERY_SERVICE,            BLE_UUID_TYPE_BLE},
   {BLE_UUID_DEVICE_INFORMATION_SERVICE, BLE_UUID_TYPE_BLE}
 };
 
-// uint32_t app_time;
-// int16_t ecg_value;
+uint32_t app_time;                                                                   /**< Elapsed time in the app. */
+int16_t emg_value_raw;                                                               /**< Current raw ECG/EMG sample from AFE. */
+
+static uint16_t   m_snippet_offset       = 0;                                       /**< Next snapshot sample to send on the EVS snippet characteristic. */
+static uint8_t    m_activity_buf[IMU_ACTIVITY_RECORD_ENCODED_SIZE];                  /**< Latest activity record waiting for the EVS activity characteristic. */
+static uint8_t    m_activity_len         = 0;                                       /**< Length of the waiting activity record, 0 if none. */
+static uint8_t    m_link_buf[NRF_SDH_BLE_TOTAL_LINK_COUNT][BLE_LINK_PARAMS_ENCODED_SIZE];   /**< Latest parameters of each link waiting for the EVS link characteristic. */
+static uint8_t    m_link_len[NRF_SDH_BLE_TOTAL_LINK_COUNT];                         /**< Length of the waiting link parameters, 0 if none. */
+static uint8_t    m_streams_on           = 0;                                       /**< STREAMING_ flags of the streams running for the links. */
+static volatile uint8_t m_streams_wanted = 0;                                       /**< STREAMING_ flags the links ask for, applied from the main loop. */
+static uint8_t    m_streams_blocked[NRF_SDH_BLE_TOTAL_LINK_COUNT];                  /**< STREAMING_ flags the control point of each link stopped, 0 on connection. */
+static uint16_t   m_sensors_period       = SENSORS_MEAS_PERIOD_MS;                  /**< Sensors measurement period (ms). */
+static uint8_t    m_qwr_mem[NRF_SDH_BLE_TOTAL_LINK_COUNT][QWR_MEM_BUFF_SIZE];       /**< Queued write memory of each link. */
+#if (_CONFIG_WAVE_STREAM)
+static wave_stream_config_t m_wave_config;                                          /**< Waveform configuration written on WFS, applied from the main loop. */
+static volatile uint16_t m_wave_config_conn_handle = BLE_CONN_HANDLE_INVALID;       /**< Link that wrote it, BLE_CONN_HANDLE_INVALID if none is pending. */
+#endif
+#if (_CONFIG_BROADCAST)
+static bool       m_adv_connectable      = _CONFIG_BROADCAST_CONNECTABLE;           /**< Advertising lets the centrals connect, otherwise broadcast only. */
+static uint16_t   m_broadcast_period     = _CONFIG_BROADCAST_PERIOD;                /**< Vitals advertising data update period (ms). */
+static uint8_t    m_battery_level        = VITALS_ADV_BATTERY_UNKNOWN;              /**< Latest averaged battery level (%). */
+static uint8_t    m_vitals_buf[VITALS_ADV_SIZE];                                    /**< Vitals of the manufacturer specific data. */
+static ble_advdata_manuf_data_t m_vitals_manuf;                                     /**< Manufacturer specific data of the advertising data. */
+#endif
 
-uint32_t app_time;                                                                   /**< Elapsed time in the app. */                                                                                                                                           
-int16_t emg_value_raw;                                                               /**< Current raw ECG/EMG sample from AFE. */  
-int16_t emg_mean_absolute_value;                                                     /**< Mean absolute value for the collected ECG/EMG samples. */                                                         
-int16_t emg_integrated;                                                              /**< Integrated ECG/EMG value for the collected samples. */ 
-int16_t emg_ssi;                                                                     /**< Integrated square ECG/EMG value for collected samples. */
-int16_t emg_variance;                                                                /**< Variance of ECG/EMG signal. */  
-int16_t emg_myopulse_percent;                                                        /**< Myopulse percentage rate of ECG/EMG signal. */
+static ble_gap_conn_params_t const m_pm_conn_params[SYS_PM_STATE_MAX] =            /**< Connection parameters of each power state. */
+{
+  [SYS_PM_STATE_ACTIVE] = { MIN_CONN_INTERVAL, MAX_CONN_INTERVAL, SLAVE_LATENCY, CONN_SUP_TIMEOUT },
+  [SYS_PM_STATE_STILL]  = { STILL_MIN_CONN_INTERVAL, STILL_MAX_CONN_INTERVAL, STILL_SLAVE_LATENCY, CONN_SUP_TIMEOUT },
+  [SYS_PM_STATE_UNWORN] = { UNWORN_MIN_CONN_INTERVAL, UNWORN_MAX_CONN_INTERVAL, UNWORN_SLAVE_LATENCY, CONN_SUP_TIMEOUT }
+};
 
-int16_t emg_array_raw[MA_FILTER_SIZE];                                               /**< Raw ECG/EMG signals used for MA filter. */ 
-uint8_t emg_array_raw_index;                                                         /**< Index for ecg_array_raw. */ 
-int16_t emg_array_out[EMG_SIGNAL_SIZE];                                              /**< Processed output ECG/EMG signals. */ 
-uint8_t emg_array_out_index;                                                         /**< Index for ecg_array_out. */
-int16_t emg_envelope[ENVELOPE_SIZE];                                                 /**< EMG envelope. */
-uint8_t emg_envelope_index;                                                          /**< Index for EMG envelope. */
+static ble_gap_conn_params_t const m_stream_conn_params =                           /**< Connection parameters of the streaming link profile. */
+  { STREAM_MIN_CONN_INTERVAL, STREAM_MAX_CONN_INTERVAL, STREAM_SLAVE_LATENCY, CONN_SUP_TIMEOUT };
 
 /* Private function prototypes ---------------------------------------- */
 static void timers_init(void);
 static void gap_params_init(void);
 static void nrf_qwr_error_handler(uint32_t nrf_error);
+#if (_CONFIG_CTRL_POINT)
+static uint16_t nrf_qwr_evt_handler(nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_evt_t *p_evt);
+#endif
 static void services_init(void);
 static void on_conn_params_evt(ble_conn_params_evt_t *p_evt);
 static void conn_params_init(void);
 static void sleep_mode_enter(void);
+static void sleep_mode_request(void);
 static void on_adv_evt(ble_adv_evt_t ble_adv_evt);
 static void ble_evt_handler(ble_evt_t const *p_ble_evt, void *p_context);
 static void ble_stack_init(void);
 static void gatt_init(void);
 static void advertising_init(void);
+static void advertising_data_get(ble_advdata_t *p_advdata, ble_advdata_t *p_srdata);
 static void log_init(void);
 static void power_management_init(void);
 static void idle_state_handle(void);
 static void advertising_start(void);
+#if (_CONFIG_BROADCAST)
+static void advertising_restart(void);
+static void broadcast_timeout_handler(void *p_context);
+static void broadcast_update(void);
+#endif
 
 static void battery_level_meas_timeout_handler(void * p_context);
 static void sensors_meas_timeout_handler(void * p_context);
@@ -141,12 +237,64 @@ static void sensors_meas_timeout_handler(void * p_context);
 static void battery_level_update(void);
 static void sensors_value_update(void);
 
+#if (_CONFIG_IMU_RAW_STREAM)
 static void acs_service_init(void);
 static void mgs_service_init(void);
+#endif
+static void evs_service_init(void);
+#if (_CONFIG_CTRL_POINT)
+static void cps_service_init(void);
+static void control_point_process(void);
+static sys_ctrl_result_t control_point_execute(const sys_ctrl_cmd_t *p_cmd, uint16_t conn_handle,
+                                               uint8_t *p_payload, uint8_t *p_len);
+static void control_point_status_get(uint16_t conn_handle, sys_ctrl_status_t *p_status);
+#endif
+#if (_CONFIG_IMU_MOTION_STREAM)
+static void mos_service_init(void);
+static void mos_evt_handler(ble_mos_t *p_mos, ble_mos_evt_t *p_evt);
+static ret_code_t mos_data_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+#endif
+#if (_CONFIG_WAVE_STREAM)
+static void wfs_service_init(void);
+static void wfs_evt_handler(ble_wfs_t *p_wfs, ble_wfs_evt_t *p_evt);
+static ret_code_t wfs_data_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+static void wave_config_process(void);
+static base_status_t wave_config_apply(uint16_t conn_handle, const wave_stream_config_t *p_config);
+#endif
+#if (_CONFIG_HRS)
+static void hrs_service_init(void);
+static ret_code_t hrs_measurement_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+#endif
 static void bas_service_init(void);
 static void dis_service_init(void);
 
 static void application_timers_start(void);
+static void tx_queue_init(void);
+static void rhythm_events_process(void);
+static uint16_t rhythm_event_fill(uint8_t *p_buf, uint16_t max_len);
+static uint16_t rhythm_snippet_fill(uint8_t *p_buf, uint16_t max_len);
+static uint16_t link_time_fill(uint8_t *p_buf, uint16_t max_len);
+static uint16_t activity_record_fill(uint8_t *p_buf, uint16_t max_len);
+static ret_code_t evs_event_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+static ret_code_t evs_snippet_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+static ret_code_t evs_time_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+static ret_code_t evs_activity_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+static void emg_features_sink(const dsp_block_t *p_block, void *p_context);
+#if (_CONFIG_IMU_RAW_STREAM)
+static int16_t sensor_value_to_ble(int32_t value, int32_t divisor);
+#endif
+static void pm_state_handler(sys_pm_state_t state);
+static void pm_conn_params_apply(void);
+static void link_conn_params_apply(uint16_t conn_handle);
+static uint8_t link_streams_get(uint16_t conn_handle);
+static bool stream_config_owned(uint16_t conn_handle, uint8_t stream);
+static void streams_update(uint16_t conn_handle);
+static void streams_process(void);
+static void link_params_handler(const ble_link_params_t *p_params);
+static uint16_t link_params_fill(uint8_t *p_buf, uint16_t max_len);
+static ret_code_t evs_link_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+static void activity_record_handler(const imu_activity_record_t *p_record);
+static void calib_done_handler(imu_calib_state_t state, bool success);
 
 /* Function definitions ----------------------------------------------- */
 /**
@@ -155,27 +303,41 @@ static void application_timers_start(void);
 int main(void)
 {
   // Initialize.
-
-  // initialize arrays 
-  emg_array_raw_index = 0; 
-  emg_array_out_index = 0; 
-
-  double MA_sum = 0; 
-
   log_init();
   timers_init();
   power_management_init();
   ble_stack_init();
+  bsp_time_init();
   gap_params_init();
   gatt_init();
   services_init();
+  tx_queue_init();
   advertising_init();
   conn_params_init();
 
   bsp_hw_init();
   bsp_nand_flash_init();
   bsp_imu_init();
+#if (_CONFIG_IMU_MOTION_STREAM)
+  motion_stream_init(_CONFIG_IMU_FIFO_RATE, _CONFIG_IMU_MOTION_RATE, _CONFIG_IMU_MAG);
+  bsp_imu_register_block_handler(motion_stream_block_handler);
+#endif
+#if (_CONFIG_IMU_CALIB)
+  imu_calib_register_done_handler(calib_done_handler);
+#endif
+#if (_CONFIG_IMU_ACTIVITY)
+  imu_activity_register_record_handler(activity_record_handler);
+#endif
   bsp_afe_init();
+  bsp_afe_sink_add(emg_features_sink, NULL);
+#if (_CONFIG_WAVE_SPOOL)
+  wave_spool_init();
+#endif
+
+#if (_CONFIG_PM)
+  sys_pm_register_state_handler(pm_state_handler);
+  sys_pm_init();
+#endif
 
   // Start execution.
   application_timers_start();
@@ -185,42 +347,43 @@ int main(void)
   {
     NRF_LOG_PROCESS();
 
-    if (bsp_afe_get_ecg(&emg_value_raw) == BS_OK) {
-      // works for MA filter, trying iEMG
+    rhythm_events_process();
 
-      // print raw EMG data
-      NRF_LOG_INFO("In EMG: %d\n", emg_value_raw);
+    // A piece of the NAND flash log page per pass, the replay reads share its SPI budget
+    bsp_nand_flash_process();
 
-      // add raw sample to ecg_array_raw, increment index
-      emg_array_raw[emg_array_raw_index] = emg_value_raw; 
-      if(emg_array_raw_index < MA_FILTER_SIZE - 1) emg_array_raw_index++; 
-      else emg_array_raw_index = 0; 
+    // Streams switched by the BLE events start and stop between two packets
+    streams_process();
 
-      // filter data using moving average filter and add to output array
-      for(uint8_t i = 0; i < MA_FILTER_SIZE; i++) MA_sum += emg_array_raw[i];  
-      emg_array_out[emg_array_out_index] = MA_sum / MA_FILTER_SIZE;
+    // Events, waveforms and snippets share the SoftDevice TX queue by priority
+    ble_tx_queue_process();
 
-      // print processed EMG value, increment index 
-      NRF_LOG_RAW_INFO("Out EMG: %d\n", emg_array_out[emg_array_out_index]); 
-      if(emg_array_out_index < EMG_SIGNAL_SIZE - 1) emg_array_out_index++; 
-      else emg_array_out_index = 0; 
+    bsp_imu_fifo_process();
 
-      for(uint8_t i = 0; i < EMG_SIGNAL_SIZE; i++) {
-        emg_integrated += emg_array_out[i];
-      }
+#if (_CONFIG_WAVE_SPOOL)
+    // The waveform packets no link takes go to the NAND flash log
+    wave_spool_process();
+#endif
 
-      // calculate MAV, variance, and myopulse %
-      emg_mean_absolute_value = emg_integrated / EMG_SIGNAL_SIZE; 
+#if (_CONFIG_PM)
+    sys_pm_process();
+#endif
 
-      NRF_LOG_RAW_INFO("MAV: %d\n", emg_mean_absolute_value); 
-      NRF_LOG_RAW_INFO("iEMG: %d\n", emg_integrated); 
-      NRF_LOG_RAW_INFO("\n"); 
+#if (_CONFIG_CTRL_POINT)
+    // Commands are applied between two blocks of the AFE pipeline
+    control_point_process();
+#endif
 
-      // reset variables
-      MA_sum = 0; 
-      emg_integrated = 0;
-      emg_mean_absolute_value = 0; 
-    }
+#if (_CONFIG_WAVE_STREAM)
+    // So is the waveform configuration written on WFS
+    wave_config_process();
+#endif
+
+    // Samples are processed in blocks by the AFE pipeline and delivered to the sinks
+    bsp_afe_get_ecg(&emg_value_raw);
+
+    if (m_sleep_pending)
+      sleep_mode_enter();
   }
 }
 
@@ -264,6 +427,13 @@ static void timers_init(void)
                               APP_TIMER_MODE_REPEATED,
                               battery_level_meas_timeout_handler);
   APP_ERROR_CHECK(err_code);
+
+#if (_CONFIG_BROADCAST)
+  err_code = app_timer_create(&m_broadcast_timer_id,
+                              APP_TIMER_MODE_REPEATED,
+                              broadcast_timeout_handler);
+  APP_ERROR_CHECK(err_code);
+#endif
 }
 
 /**
@@ -313,6 +483,24 @@ static void nrf_qwr_error_handler(uint32_t nrf_error)
   APP_ERROR_HANDLER(nrf_error);
 }
 
+#if (_CONFIG_CTRL_POINT)
+/**
+ * @brief         Function for handling the Queued Write module events.
+ *
+ * @param[in]     p_qwr     Queued Write instance of the link
+ * @param[in]     p_evt     Queued Write event
+ *
+ * @attention     The control point is the only attribute registered for long writes
+ *
+ * @return        BLE_GATT_STATUS_SUCCESS to accept the execute write, otherwise the ATT error
+ */
+static uint16_t nrf_qwr_evt_handler(nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_evt_t *p_evt)
+{
+  return ble_cps_on_qwr_evt(&m_cps, p_qwr, p_evt);
+}
+#endif
+
+#if (_CONFIG_IMU_RAW_STREAM)
 /**
  * @brief         Function for ACS service init
  *
@@ -399,6 +587,282 @@ static void mgs_service_init(void)
   err_code = ble_mgs_init(&m_mgs, &mgs_init);
   APP_ERROR_CHECK(err_code);
 }
+#endif
+
+/**
+ * @brief         Function for EVS service init
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void evs_service_init(void)
+{
+  uint32_t           err_code;
+  ble_evs_init_t     evs_init;
+
+// Initialize EVS
+  memset(&evs_init, 0, sizeof(evs_init));
+
+  evs_init.evt_handler          = NULL;
+  evs_init.support_notification = true;
+
+  evs_init.bl_rd_sec        = SEC_OPEN;
+  evs_init.bl_cccd_wr_sec   = SEC_OPEN;
+
+  err_code = ble_evs_init(&m_evs, &evs_init);
+  APP_ERROR_CHECK(err_code);
+}
+
+#if (_CONFIG_WAVE_STREAM)
+/**
+ * @brief         Function for WFS service init
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void wfs_service_init(void)
+{
+  uint32_t             err_code;
+  ble_wfs_init_t       wfs_init;
+  wave_stream_config_t config;
+
+  // Initialize WFS with the boot stream configuration
+  memset(&wfs_init, 0, sizeof(wfs_init));
+
+  wave_stream_config_get(&config);
+  wave_stream_config_encode(&config, wfs_init.init_config);
+
+  wfs_init.evt_handler    = wfs_evt_handler;
+  wfs_init.bl_rd_sec      = SEC_OPEN;
+  wfs_init.bl_wr_sec      = SEC_OPEN;
+  wfs_init.bl_cccd_wr_sec = SEC_OPEN;
+
+  err_code = ble_wfs_init(&m_wfs, &wfs_init);
+  APP_ERROR_CHECK(err_code);
+}
+
+/**
+ * @brief         Function for handling the WFS events
+ *
+ * @param[in]     p_wfs     WFS service instance
+ * @param[in]     p_evt     WFS event
+ *
+ * @attention     Runs in interrupt context, the configuration is applied from the main loop. A
+ *                rejected configuration is answered at once with the one in use, the
+ *                configuration is shared and another link that streams keeps it.
+ *
+ * @return        None
+ */
+static void wfs_evt_handler(ble_wfs_t *p_wfs, ble_wfs_evt_t *p_evt)
+{
+  wave_stream_config_t config;
+  uint8_t              buf[WAVE_STREAM_CONFIG_SIZE];
+
+  switch (p_evt->evt_type)
+  {
+  case BLE_WFS_EVT_NOTIFICATION_ENABLED:
+  case BLE_WFS_EVT_NOTIFICATION_DISABLED:
+    streams_update(p_evt->conn_handle);
+    break;
+
+  case BLE_WFS_EVT_CONFIG_WRITE:
+    if (!stream_config_owned(p_evt->conn_handle, STREAMING_WAVE))
+    {
+      NRF_LOG_WARNING("Waveform configuration rejected, another link streams");
+    }
+    else if (wave_stream_config_decode(p_evt->p_data, p_evt->len, &config) != BS_OK)
+    {
+      NRF_LOG_WARNING("Waveform configuration rejected");
+    }
+    else
+    {
+      // A later write replaces the pending one
+      m_wave_config             = config;
+      m_wave_config_conn_handle = p_evt->conn_handle;
+      break;
+    }
+
+    wave_stream_config_get(&config);
+    wave_stream_config_encode(&config, buf);
+    ble_wfs_config_update(p_wfs, buf);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief         Function for applying the waveform configuration written on WFS
+ *
+ * @param[in]     None
+ *
+ * @attention     Only run between two blocks of the AFE pipeline, like the control point
+ *
+ * @return        None
+ */
+static void wave_config_process(void)
+{
+  wave_stream_config_t config;
+  uint16_t             conn_handle;
+
+  if ((m_wave_config_conn_handle == BLE_CONN_HANDLE_INVALID) || !bsp_afe_block_boundary())
+    return;
+
+  CRITICAL_REGION_ENTER();
+  config                    = m_wave_config;
+  conn_handle               = m_wave_config_conn_handle;
+  m_wave_config_conn_handle = BLE_CONN_HANDLE_INVALID;
+  CRITICAL_REGION_EXIT();
+
+  // The writer left in the meantime
+  if (ble_conn_state_status(conn_handle) != BLE_CONN_STATUS_CONNECTED)
+    return;
+
+  if (wave_config_apply(conn_handle, &config) != BS_OK)
+    NRF_LOG_WARNING("Waveform configuration rejected");
+}
+
+/**
+ * @brief         Function for applying a waveform configuration
+ *
+ * @param[in]     conn_handle   Link that wrote it
+ * @param[in]     p_config      Configuration
+ *
+ * @attention     Main loop only, between two blocks of the AFE pipeline. The configuration
+ *                characteristic is answered with the one in use afterwards.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS    Bad configuration
+ * - BS_ERROR           Another link streams the waveform
+ */
+static base_status_t wave_config_apply(uint16_t conn_handle, const wave_stream_config_t *p_config)
+{
+  wave_stream_config_t config;
+  uint8_t              buf[WAVE_STREAM_CONFIG_SIZE];
+  base_status_t        status = BS_ERROR;
+
+  if (stream_config_owned(conn_handle, STREAMING_WAVE))
+    status = (wave_stream_configure(p_config) == BS_OK) ? BS_OK : BS_ERROR_PARAMS;
+
+  wave_stream_config_get(&config);
+  wave_stream_config_encode(&config, buf);
+  ble_wfs_config_update(&m_wfs, buf);
+
+  return status;
+}
+#endif
+
+#if (_CONFIG_IMU_MOTION_STREAM)
+/**
+ * @brief         Function for MOS service init
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void mos_service_init(void)
+{
+  uint32_t           err_code;
+  ble_mos_init_t     mos_init;
+
+  // Initialize MOS
+  memset(&mos_init, 0, sizeof(mos_init));
+
+  mos_init.evt_handler    = mos_evt_handler;
+  mos_init.bl_cccd_wr_sec = SEC_OPEN;
+
+  err_code = ble_mos_init(&m_mos, &mos_init);
+  APP_ERROR_CHECK(err_code);
+}
+
+/**
+ * @brief         Function for handling the MOS events
+ *
+ * @param[in]     p_mos     MOS service instance
+ * @param[in]     p_evt     MOS event
+ *
+ * @attention     The subscription of the link is kept by the service
+ *
+ * @return        None
+ */
+static void mos_evt_handler(ble_mos_t *p_mos, ble_mos_evt_t *p_evt)
+{
+  streams_update(p_evt->conn_handle);
+}
+#endif
+
+#if (_CONFIG_CTRL_POINT)
+/**
+ * @brief         Function for CPS service init
+ *
+ * @param[in]     None
+ *
+ * @attention     The control point takes long writes through the Queued Write instances
+ *
+ * @return        None
+ */
+static void cps_service_init(void)
+{
+  uint32_t           err_code;
+  ble_cps_init_t     cps_init;
+
+  // Initialize CPS
+  memset(&cps_init, 0, sizeof(cps_init));
+
+  cps_init.wr_sec      = SEC_OPEN;
+  cps_init.cccd_wr_sec = SEC_OPEN;
+
+  err_code = ble_cps_init(&m_cps, &cps_init);
+  APP_ERROR_CHECK(err_code);
+
+  for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+  {
+    err_code = nrf_ble_qwr_attr_register(&m_qwr[i], m_cps.cp_handles.value_handle);
+    APP_ERROR_CHECK(err_code);
+  }
+}
+#endif
+
+#if (_CONFIG_HRS)
+/**
+ * @brief         Function for HRS service init
+ *
+ * @param[in]     None
+ *
+ * @attention     The measurements are built by hr_stream and sent by the TX scheduler
+ *
+ * @return        None
+ */
+static void hrs_service_init(void)
+{
+  uint32_t           err_code;
+  ble_hrs_init_t     hrs_init;
+  uint8_t            body_sensor_location = BLE_HRS_BODY_SENSOR_LOCATION_CHEST;
+
+  // Initialize Heart Rate Service.
+  memset(&hrs_init, 0, sizeof(hrs_init));
+
+  hrs_init.evt_handler                 = NULL;
+  hrs_init.is_sensor_contact_supported = _CONFIG_PM;
+  hrs_init.p_body_sensor_location      = &body_sensor_location;
+
+  hrs_init.hrm_cccd_wr_sec = SEC_OPEN;
+  hrs_init.bsl_rd_sec      = SEC_OPEN;
+
+  err_code = ble_hrs_init(&m_hrs, &hrs_init);
+  APP_ERROR_CHECK(err_code);
+}
+#endif
 
 /**
  * @brief         Function for BAS service init
@@ -470,16 +934,42 @@ static void services_init(void)
   uint32_t           err_code;
   nrf_ble_qwr_init_t qwr_init = {0};
 
-  // Initialize Queued Write Module.
+  // Initialize Queued Write Module instances.
   qwr_init.error_handler = nrf_qwr_error_handler;
+#if (_CONFIG_CTRL_POINT)
+  qwr_init.callback      = nrf_qwr_evt_handler;
+#endif
 
-  err_code = nrf_ble_qwr_init(&m_qwr, &qwr_init);
-  APP_ERROR_CHECK(err_code);
+  for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+  {
+    qwr_init.mem_buffer.p_mem = m_qwr_mem[i];
+    qwr_init.mem_buffer.len   = QWR_MEM_BUFF_SIZE;
+
+    err_code = nrf_ble_qwr_init(&m_qwr[i], &qwr_init);
+    APP_ERROR_CHECK(err_code);
+  }
 
   // Initialize Custom Service
+#if (_CONFIG_IMU_RAW_STREAM)
   acs_service_init();
   mgs_service_init();
   gys_service_init();
+#endif
+#if (_CONFIG_IMU_MOTION_STREAM)
+  mos_service_init();
+#endif
+  evs_service_init();
+#if (_CONFIG_WAVE_STREAM)
+  wfs_service_init();
+#endif
+#if (_CONFIG_CTRL_POINT)
+  cps_service_init();
+#endif
+
+#if (_CONFIG_HRS)
+  // Initialize Heart Rate Service.
+  hrs_service_init();
+#endif
 
   // Initialize Battery Service.
   bas_service_init();
@@ -503,7 +993,7 @@ static void on_conn_params_evt(ble_conn_params_evt_t *p_evt)
 
   if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_FAILED)
   {
-    err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
+    err_code = sd_ble_gap_disconnect(p_evt->conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
     APP_ERROR_CHECK(err_code);
   }
 }
@@ -556,12 +1046,14 @@ static void conn_params_init(void)
  *
  * @param[in]     None
  *
- * @attention     None
+ * @attention     Main loop only, the buffered NAND flash log records are programmed first
  *
  * @return        None
  */
 static void sleep_mode_enter(void)
 {
+  bsp_nand_flash_log_sync();
+
   uint32_t err_code = bsp_indication_set(BSP_INDICATE_IDLE);
   APP_ERROR_CHECK(err_code);
 
@@ -574,6 +1066,21 @@ static void sleep_mode_enter(void)
   APP_ERROR_CHECK(err_code);
 }
 
+/**
+ * @brief         Function for requesting the sleep mode from an event handler.
+ *
+ * @param[in]     None
+ *
+ * @attention     The NAND flash is not touched from interrupt context, the main loop enters the
+ *                sleep mode after its current pass
+ *
+ * @return        None
+ */
+static void sleep_mode_request(void)
+{
+  m_sleep_pending = true;
+}
+
 /**
  * @brief         Function for handling advertising events.
  *
@@ -594,7 +1101,10 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
     APP_ERROR_CHECK(err_code);
     break;
   case BLE_ADV_EVT_IDLE:
-    sleep_mode_enter();
+    // The connected links keep the device awake, a disconnection advertises again
+    m_advertising_on = false;
+    if (ble_conn_state_peripheral_conn_count() == 0)
+      sleep_mode_request();
     break;
   default:
     break;
@@ -613,46 +1123,90 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
  */
 static void ble_evt_handler(ble_evt_t const *p_ble_evt, void *p_context)
 {
+  uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
   uint32_t err_code;
 
   switch (p_ble_evt->header.evt_id)
   {
   case BLE_GAP_EVT_CONNECTED:
-    NRF_LOG_INFO("Connected");
+    NRF_LOG_INFO("Connected 0x%x", conn_handle);
     err_code = bsp_indication_set(BSP_INDICATE_CONNECTED);
     APP_ERROR_CHECK(err_code);
-    m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
-    err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
+    err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr[ble_conn_state_conn_idx(conn_handle)], conn_handle);
     APP_ERROR_CHECK(err_code);
-    break;
+#if (_CONFIG_PM)
+    // The connection parameters module negotiates the boot parameters otherwise
+    if (sys_pm_state_get() != SYS_PM_STATE_ACTIVE)
+      link_conn_params_apply(conn_handle);
+#endif
+    // The timebase follows the connection events of one link
+    if (m_time_conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+      m_time_conn_handle = conn_handle;
+      bsp_time_link_start(p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval);
+    }
+    ble_tx_queue_link_set(conn_handle, nrf_ble_gatt_eff_mtu_get(&m_gatt, conn_handle) - 3);
 
-  case BLE_GAP_EVT_DISCONNECTED:
-    NRF_LOG_INFO("Disconnected");
-    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+    // The connection stopped the advertising, it goes on while a link is free and the vitals
+    // broadcast goes on once every link is taken
+    m_advertising_on = false;
+    if (_CONFIG_BROADCAST || (ble_conn_state_peripheral_conn_count() < NRF_SDH_BLE_PERIPHERAL_LINK_COUNT))
+      advertising_start();
     break;
 
-  case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
+  case BLE_GAP_EVT_DISCONNECTED:
   {
-    NRF_LOG_DEBUG("PHY update request.");
-    ble_gap_phys_t const phys =
-        {
-          .rx_phys = BLE_GAP_PHY_AUTO,
-          .tx_phys = BLE_GAP_PHY_AUTO,
-        };
-    err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
-    APP_ERROR_CHECK(err_code);
+    ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+
+    NRF_LOG_INFO("Disconnected 0x%x", conn_handle);
+    m_link_len[ble_conn_state_conn_idx(conn_handle)]        = 0;
+    m_streams_blocked[ble_conn_state_conn_idx(conn_handle)] = 0;
+    if (conn_handles.len == 0)
+      m_activity_len = 0;
+
+    if (conn_handle == m_time_conn_handle)
+    {
+      ble_link_params_t params;
+
+      bsp_time_link_stop();
+      m_time_conn_handle = BLE_CONN_HANDLE_INVALID;
+
+      // Handed over to a remaining link
+      if ((conn_handles.len != 0) && ble_link_params_get(conn_handles.conn_handles[0], &params))
+      {
+        m_time_conn_handle = conn_handles.conn_handles[0];
+        bsp_time_link_start(params.conn_interval);
+      }
+    }
+
+    // Streams only the remaining links subscribed to are kept
+    streams_update(conn_handle);
+
+#if (_CONFIG_BROADCAST)
+    // The broadcast only advertising of a full device becomes connectable
+    advertising_restart();
+#else
+    if (!m_advertising_on)
+      advertising_start();
+#endif
   }
   break;
 
+  case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+    // The connection events move to the new interval
+    if (conn_handle == m_time_conn_handle)
+      bsp_time_link_start(p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval);
+    break;
+
   case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
     // Pairing not supported
-    err_code = sd_ble_gap_sec_params_reply(m_conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
+    err_code = sd_ble_gap_sec_params_reply(conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
     APP_ERROR_CHECK(err_code);
     break;
 
   case BLE_GATTS_EVT_SYS_ATTR_MISSING:
     // No system attributes have been stored.
-    err_code = sd_ble_gatts_sys_attr_set(m_conn_handle, NULL, 0, 0);
+    err_code = sd_ble_gatts_sys_attr_set(p_ble_evt->evt.gatts_evt.conn_handle, NULL, 0, 0);
     APP_ERROR_CHECK(err_code);
     break;
 
@@ -697,6 +1251,14 @@ static void ble_stack_init(void)
   err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
   APP_ERROR_CHECK(err_code);
 
+  // Room for several notifications per connection event.
+  ble_cfg_t ble_cfg;
+  memset(&ble_cfg, 0, sizeof(ble_cfg));
+  ble_cfg.conn_cfg.conn_cfg_tag                            = APP_BLE_CONN_CFG_TAG;
+  ble_cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = BLE_TX_QUEUE_HVN_SIZE;
+  err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &ble_cfg, ram_start);
+  APP_ERROR_CHECK(err_code);
+
   // Enable BLE stack.
   err_code = nrf_sdh_ble_enable(&ram_start);
   APP_ERROR_CHECK(err_code);
@@ -721,6 +1283,8 @@ static void gatt_evt_handler(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_t const *p
     NRF_LOG_INFO("GATT ATT MTU on connection 0x%x changed to %d.",
                  p_evt->conn_handle,
                  p_evt->params.att_mtu_effective);
+
+    ble_tx_queue_link_set(p_evt->conn_handle, p_evt->params.att_mtu_effective - 3);
   }
 }
 
@@ -742,6 +1306,10 @@ static void gatt_init(void)
 
   err_code = nrf_ble_gatt_att_mtu_periph_set(&m_gatt, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
   APP_ERROR_CHECK(err_code);
+
+  // PHY, data length and connection event extension follow the streams
+  err_code = ble_link_init(&m_gatt, link_params_handler);
+  APP_ERROR_CHECK(err_code);
 }
 
 /**
@@ -759,19 +1327,35 @@ void bsp_event_handler(bsp_event_t event)
   switch (event)
   {
   case BSP_EVENT_SLEEP:
-    sleep_mode_enter();
+    sleep_mode_request();
     break;
 
   case BSP_EVENT_DISCONNECT:
-    err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-    if (err_code != NRF_ERROR_INVALID_STATE)
+  {
+    ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+
+    for (uint32_t i = 0; i < conn_handles.len; i++)
     {
-      APP_ERROR_CHECK(err_code);
+      err_code = sd_ble_gap_disconnect(conn_handles.conn_handles[i], BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+      if (err_code != NRF_ERROR_INVALID_STATE)
+      {
+        APP_ERROR_CHECK(err_code);
+      }
     }
-    break;
+  }
+  break;
 
   case BSP_EVENT_WHITELIST_OFF:
-    if (m_conn_handle == BLE_CONN_HANDLE_INVALID)
+#if (_CONFIG_BROADCAST)
+    // The button lets the centrals connect to a broadcast only device again
+    if (!m_adv_connectable)
+    {
+      m_adv_connectable = true;
+      advertising_restart();
+      break;
+    }
+#endif
+    if (m_advertising_on)
     {
       err_code = ble_advertising_restart_without_whitelist(&m_advertising);
       if (err_code != NRF_ERROR_INVALID_STATE)
@@ -802,15 +1386,16 @@ static void advertising_init(void)
 
   memset(&init, 0, sizeof(init));
 
-  init.advdata.name_type              = BLE_ADVDATA_FULL_NAME;
-  init.advdata.include_appearance     = false;
-  init.advdata.flags                  = BLE_GAP_ADV_FLAGS_LE_ONLY_LIMITED_DISC_MODE;
-  init.srdata.uuids_complete.uuid_cnt = sizeof(m_adv_uuids) / sizeof(m_adv_uuids[0]);
-  init.srdata.uuids_complete.p_uuids  = m_adv_uuids;
+  advertising_data_get(&init.advdata, &init.srdata);
 
   init.config.ble_adv_fast_enabled  = true;
   init.config.ble_adv_fast_interval = APP_ADV_INTERVAL;
+#if (_CONFIG_BROADCAST)
+  init.config.ble_adv_fast_timeout  = BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED;
+#else
   init.config.ble_adv_fast_timeout  = APP_ADV_DURATION;
+#endif
+  init.config.ble_adv_on_disconnect_disabled = true;    // Restarted by the application, links may stay connected
   init.evt_handler                  = on_adv_evt;
 
   err_code = ble_advertising_init(&m_advertising, &init);
@@ -819,6 +1404,65 @@ static void advertising_init(void)
   ble_advertising_conn_cfg_tag_set(&m_advertising, APP_BLE_CONN_CFG_TAG);
 }
 
+/**
+ * @brief         Function for filling the advertising and scan response data.
+ *
+ * @param[out]    p_advdata   Advertising data
+ * @param[out]    p_srdata    Scan response data
+ *
+ * @attention     The vitals broadcast advertises without timeout, in the general discoverable mode.
+ *                Every call builds a new vitals update.
+ *
+ * @return        None
+ */
+static void advertising_data_get(ble_advdata_t *p_advdata, ble_advdata_t *p_srdata)
+{
+  memset(p_advdata, 0, sizeof(*p_advdata));
+  memset(p_srdata, 0, sizeof(*p_srdata));
+
+  p_advdata->name_type              = BLE_ADVDATA_FULL_NAME;
+  p_advdata->include_appearance     = false;
+  p_srdata->uuids_complete.uuid_cnt = sizeof(m_adv_uuids) / sizeof(m_adv_uuids[0]);
+  p_srdata->uuids_complete.p_uuids  = m_adv_uuids;
+
+#if (_CONFIG_BROADCAST)
+  vitals_adv_t vitals;
+  uint8_t      links = ble_conn_state_peripheral_conn_count();
+
+  vitals.flags = 0;
+  if (bsp_afe_lead_off_get())
+    vitals.flags |= VITALS_ADV_FLAG_LEAD_OFF;
+  if (sys_pm_state_get() == SYS_PM_STATE_UNWORN)
+    vitals.flags |= VITALS_ADV_FLAG_UNWORN;
+  if (m_adv_connectable && (links < NRF_SDH_BLE_PERIPHERAL_LINK_COUNT))
+    vitals.flags |= VITALS_ADV_FLAG_CONNECTABLE;
+  if (links != 0)
+    vitals.flags |= VITALS_ADV_FLAG_LINKED;
+
+  // The rates of the last beats are stale once the electrodes are off
+  if (vitals.flags & (VITALS_ADV_FLAG_LEAD_OFF | VITALS_ADV_FLAG_UNWORN))
+  {
+    vitals.heart_rate       = 0;
+    vitals.respiration_rate = 0;
+  }
+  else
+  {
+    vitals.heart_rate       = global_heart_rate;
+    vitals.respiration_rate = global_respiration_rate;
+  }
+  vitals.battery_level = m_battery_level;
+
+  m_vitals_manuf.company_identifier = VITALS_ADV_COMPANY_ID;
+  m_vitals_manuf.data.p_data        = m_vitals_buf;
+  m_vitals_manuf.data.size          = vitals_adv_build(&vitals, m_vitals_buf);
+
+  p_advdata->flags                  = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE;
+  p_advdata->p_manuf_specific_data  = &m_vitals_manuf;
+#else
+  p_advdata->flags                  = BLE_GAP_ADV_FLAGS_LE_ONLY_LIMITED_DISC_MODE;
+#endif
+}
+
 /**
  * @brief         Function for initializing the nrf log module.
  *
@@ -880,9 +1524,107 @@ static void idle_state_handle(void)
  */
 static void advertising_start(void)
 {
-  uint32_t err_code = ble_advertising_start(&m_advertising, BLE_ADV_MODE_FAST);
+  uint32_t err_code;
+
+#if (_CONFIG_BROADCAST)
+  // The connectable flag of the vitals follows the advertising type
+  broadcast_update();
+
+  // The advertising module only runs connectable advertising
+  if (!m_adv_connectable || (ble_conn_state_peripheral_conn_count() >= NRF_SDH_BLE_PERIPHERAL_LINK_COUNT))
+  {
+    ble_gap_adv_params_t adv_params;
+
+    memset(&adv_params, 0, sizeof(adv_params));
+
+    adv_params.properties.type = BLE_GAP_ADV_TYPE_NONCONNECTABLE_SCANNABLE_UNDIRECTED;
+    adv_params.primary_phy     = BLE_GAP_PHY_1MBPS;
+    adv_params.filter_policy   = BLE_GAP_ADV_FP_ANY;
+    adv_params.interval        = BROADCAST_ADV_INTERVAL;
+    adv_params.duration        = BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED;
+
+    err_code = sd_ble_gap_adv_set_configure(&m_advertising.adv_handle, m_advertising.p_adv_data, &adv_params);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = sd_ble_gap_adv_start(m_advertising.adv_handle, APP_BLE_CONN_CFG_TAG);
+    APP_ERROR_CHECK(err_code);
+
+    m_advertising_on = true;
+    return;
+  }
+#endif
+
+  err_code = ble_advertising_start(&m_advertising, BLE_ADV_MODE_FAST);
   APP_ERROR_CHECK(err_code);
+
+  m_advertising_on = true;
+}
+
+#if (_CONFIG_BROADCAST)
+/**
+ * @brief         Function for restarting the advertising with the current broadcast mode.
+ *
+ * @param[in]     None
+ *
+ * @attention     The advertising type cannot change while advertising
+ *
+ * @return        None
+ */
+static void advertising_restart(void)
+{
+  uint32_t err_code;
+
+  if (m_advertising_on)
+  {
+    err_code = sd_ble_gap_adv_stop(m_advertising.adv_handle);
+    if (err_code != NRF_ERROR_INVALID_STATE)
+    {
+      APP_ERROR_CHECK(err_code);
+    }
+    m_advertising_on = false;
+  }
+
+  advertising_start();
+}
+
+/**
+ * @brief         Function for handling the vitals broadcast timer timeout.
+ *
+ * @param[in]     p_context   Pointer to context
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void broadcast_timeout_handler(void *p_context)
+{
+  UNUSED_PARAMETER(p_context);
+  broadcast_update();
+}
+
+/**
+ * @brief         Function for updating the vitals in the advertising data
+ *
+ * @param[in]     None
+ *
+ * @attention     The advertising module swaps its data buffers, the running advertising keeps its
+ *                type and interval
+ *
+ * @return        None
+ */
+static void broadcast_update(void)
+{
+  ble_advdata_t advdata;
+  ble_advdata_t srdata;
+  uint32_t      err_code;
+
+  advertising_data_get(&advdata, &srdata);
+
+  err_code = ble_advertising_advdata_update(&m_advertising, &advdata, &srdata);
+  if (err_code != NRF_SUCCESS)
+    NRF_LOG_WARNING("Vitals advertising data not updated: 0x%x", err_code);
 }
+#endif
 
 /**
  * @brief         Function for handling the Battery measurement timer timeout.
@@ -941,6 +1683,9 @@ static void battery_level_update(void)
     sum_battery_level = 0;
 
    ble_bas_battery_level_update(&m_bas, battery_level, BLE_CONN_HANDLE_ALL);
+#if (_CONFIG_BROADCAST)
+   m_battery_level = battery_level;
+#endif
   }
 }
 
@@ -955,34 +1700,72 @@ static void battery_level_update(void)
  */
 static void sensors_value_update(void)
 {
-  mpu9250_scaled_data_t acc_data;
-  mpu9250_scaled_data_t gyr_data;
+  mpu9250_unit_data_t acc_data;         // mg
+  mpu9250_unit_data_t gyr_data;         // mdps
+  mpu9250_unit_data_t mag_data = { 0 }; // nT
+  imu_ahrs_output_t     orientation;
 
   bsp_gyro_accel_get(&acc_data, &gyr_data);
+  bsp_mag_get(&mag_data);
+  imu_ahrs_get(&orientation);
 
   NRF_LOG_INFO("++++++++++++++++++++++++++++++++++++");
-  NRF_LOG_INFO("Acc X Axis: %d", acc_data.x);
-  NRF_LOG_INFO("Acc Y Axis: %d", acc_data.y);
-  NRF_LOG_INFO("Acc Z Axis: %d", acc_data.z);
+  NRF_LOG_INFO("Acc X Axis: %d mg", (int)acc_data.x);
+  NRF_LOG_INFO("Acc Y Axis: %d mg", (int)acc_data.y);
+  NRF_LOG_INFO("Acc Z Axis: %d mg", (int)acc_data.z);
   NRF_LOG_INFO("-----------------------------------");
-  NRF_LOG_INFO("Gyr X Axis: %d", gyr_data.x);
-  NRF_LOG_INFO("Gyr Y Axis: %d", gyr_data.y);
-  NRF_LOG_INFO("Gyr Z Axis: %d", gyr_data.z);
+  NRF_LOG_INFO("Gyr X Axis: %d mdps", (int)gyr_data.x);
+  NRF_LOG_INFO("Gyr Y Axis: %d mdps", (int)gyr_data.y);
+  NRF_LOG_INFO("Gyr Z Axis: %d mdps", (int)gyr_data.z);
+  NRF_LOG_INFO("-----------------------------------");
+  NRF_LOG_INFO("Mag X Axis: %d nT", (int)mag_data.x);
+  NRF_LOG_INFO("Mag Y Axis: %d nT", (int)mag_data.y);
+  NRF_LOG_INFO("Mag Z Axis: %d nT", (int)mag_data.z);
+  NRF_LOG_INFO("-----------------------------------");
+  NRF_LOG_INFO("Quat: %d %d %d %d", orientation.q[0], orientation.q[1], orientation.q[2], orientation.q[3]);
+  NRF_LOG_INFO("Roll: %d Pitch: %d Yaw: %d", orientation.roll, orientation.pitch, orientation.yaw);
   NRF_LOG_INFO("++++++++++++++++++++++++++++++++++++");
   NRF_LOG_INFO("");
 
-  ble_acs_acc_update(&m_acs, (uint16_t)acc_data.x, BLE_CONN_HANDLE_ALL, BLE_ACS_AXIS_X_CHAR);
-  ble_acs_acc_update(&m_acs, (uint16_t)acc_data.y, BLE_CONN_HANDLE_ALL, BLE_ACS_AXIS_Y_CHAR);
-  ble_acs_acc_update(&m_acs, (uint16_t)acc_data.z, BLE_CONN_HANDLE_ALL, BLE_ACS_AXIS_Z_CHAR);
+#if (_CONFIG_IMU_RAW_STREAM)
+  // Accel in mg, mag in 0.1 uT, gyro in 0.1 dps
+  ble_acs_acc_update(&m_acs, sensor_value_to_ble(acc_data.x, 1), BLE_CONN_HANDLE_ALL, BLE_ACS_AXIS_X_CHAR);
+  ble_acs_acc_update(&m_acs, sensor_value_to_ble(acc_data.y, 1), BLE_CONN_HANDLE_ALL, BLE_ACS_AXIS_Y_CHAR);
+  ble_acs_acc_update(&m_acs, sensor_value_to_ble(acc_data.z, 1), BLE_CONN_HANDLE_ALL, BLE_ACS_AXIS_Z_CHAR);
+
+  ble_mgs_mag_update(&m_mgs, sensor_value_to_ble(mag_data.x, 100), BLE_CONN_HANDLE_ALL, BLE_MGS_AXIS_X_CHAR);
+  ble_mgs_mag_update(&m_mgs, sensor_value_to_ble(mag_data.y, 100), BLE_CONN_HANDLE_ALL, BLE_MGS_AXIS_Y_CHAR);
+  ble_mgs_mag_update(&m_mgs, sensor_value_to_ble(mag_data.z, 100), BLE_CONN_HANDLE_ALL, BLE_MGS_AXIS_Z_CHAR);
+
+  ble_gys_gyr_update(&m_gys, sensor_value_to_ble(gyr_data.x, 100), BLE_CONN_HANDLE_ALL, BLE_GYS_AXIS_X_CHAR);
+  ble_gys_gyr_update(&m_gys, sensor_value_to_ble(gyr_data.y, 100), BLE_CONN_HANDLE_ALL, BLE_GYS_AXIS_Y_CHAR);
+  ble_gys_gyr_update(&m_gys, sensor_value_to_ble(gyr_data.z, 100), BLE_CONN_HANDLE_ALL, BLE_GYS_AXIS_Z_CHAR);
+#endif
+}
+
+#if (_CONFIG_IMU_RAW_STREAM)
+/**
+ * @brief         Function for scaling a sensor value to a signed 16-bit characteristic
+ *
+ * @param[in]     value       Value in the sensor unit
+ * @param[in]     divisor     Sensor unit per characteristic LSB
+ *
+ * @attention     Saturated instead of wrapped
+ *
+ * @return        Characteristic value
+ */
+static int16_t sensor_value_to_ble(int32_t value, int32_t divisor)
+{
+  value /= divisor;
 
-  ble_mgs_mag_update(&m_mgs, (uint16_t)gyr_data.x, BLE_CONN_HANDLE_ALL, BLE_MGS_AXIS_X_CHAR);
-  ble_mgs_mag_update(&m_mgs, (uint16_t)gyr_data.y, BLE_CONN_HANDLE_ALL, BLE_MGS_AXIS_Y_CHAR);
-  ble_mgs_mag_update(&m_mgs, (uint16_t)gyr_data.z, BLE_CONN_HANDLE_ALL, BLE_MGS_AXIS_Z_CHAR);
+  if (value > INT16_MAX)
+    return INT16_MAX;
+  if (value < INT16_MIN)
+    return INT16_MIN;
 
-  ble_gys_gyr_update(&m_gys, (uint16_t)gyr_data.x, BLE_CONN_HANDLE_ALL, BLE_GYS_AXIS_X_CHAR);
-  ble_gys_gyr_update(&m_gys, (uint16_t)gyr_data.y, BLE_CONN_HANDLE_ALL, BLE_GYS_AXIS_Y_CHAR);
-  ble_gys_gyr_update(&m_gys, (uint16_t)gyr_data.z, BLE_CONN_HANDLE_ALL, BLE_GYS_AXIS_Z_CHAR);
+  return (int16_t)value;
 }
+#endif
 
 /**
  * @brief         Function for starting application timers.
@@ -998,12 +1781,902 @@ static void application_timers_start(void)
   ret_code_t err_code;
 
   // Start application timers.
-  err_code = app_timer_start(m_sensors_timer_id, SENSORS_MEAS_INTERVAL, NULL);
+  err_code = app_timer_start(m_sensors_timer_id, APP_TIMER_TICKS(m_sensors_period), NULL);
     APP_ERROR_CHECK(err_code);
 
 
   err_code =  app_timer_start(m_battery_timer_id, BATT_LEVEL_MEAS_INTERVAL, NULL);
     APP_ERROR_CHECK(err_code);
+
+#if (_CONFIG_BROADCAST)
+  err_code = app_timer_start(m_broadcast_timer_id, APP_TIMER_TICKS(m_broadcast_period), NULL);
+  APP_ERROR_CHECK(err_code);
+#endif
+}
+
+/**
+ * @brief         Function for adding the notification streams to the TX scheduler
+ *
+ * @param[in]     None
+ *
+ * @attention     Events are served first, then the waveforms, then the snapshot snippets
+ *
+ * @return        None
+ */
+static void tx_queue_init(void)
+{
+  ret_code_t err_code;
+
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_EVENT, rhythm_event_fill, evs_event_send, NULL);
+  APP_ERROR_CHECK(err_code);
+
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_EVENT, activity_record_fill, evs_activity_send, NULL);
+  APP_ERROR_CHECK(err_code);
+
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_EVENT, link_time_fill, evs_time_send, NULL);
+  APP_ERROR_CHECK(err_code);
+
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_EVENT, link_params_fill, evs_link_send, NULL);
+  APP_ERROR_CHECK(err_code);
+
+#if (_CONFIG_HRS)
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_EVENT, hr_stream_packet_build, hrs_measurement_send, NULL);
+  APP_ERROR_CHECK(err_code);
+#endif
+
+#if (_CONFIG_WAVE_STREAM)
+#if (_CONFIG_WAVE_SPOOL)
+  // The replayed packets go in turn with the live ones
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_WAVEFORM, wave_spool_replay_fill, wfs_data_send, NULL);
+  APP_ERROR_CHECK(err_code);
+
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_WAVEFORM, wave_spool_fill, wfs_data_send, NULL);
+  APP_ERROR_CHECK(err_code);
+#else
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_WAVEFORM, wave_stream_packet_build, wfs_data_send, NULL);
+  APP_ERROR_CHECK(err_code);
+#endif
+#endif
+
+#if (_CONFIG_IMU_MOTION_STREAM)
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_WAVEFORM, motion_stream_packet_build, mos_data_send, NULL);
+  APP_ERROR_CHECK(err_code);
+#endif
+
+  err_code = ble_tx_queue_stream_add(BLE_TX_QUEUE_PRIO_TELEMETRY, rhythm_snippet_fill, evs_snippet_send, NULL);
+  APP_ERROR_CHECK(err_code);
+}
+
+/**
+ * @brief         Function for dropping the ECG snapshot while nobody is connected
+ *
+ * @param[in]     None
+ *
+ * @attention     The rhythm events stay queued in ecg_rhythm for the next connection
+ *
+ * @return        None
+ */
+static void rhythm_events_process(void)
+{
+  if ((ble_conn_state_peripheral_conn_count() == 0) &&
+      (ecg_rhythm_snapshot_state(NULL) == ECG_RHYTHM_SNAPSHOT_READY))
+  {
+    ecg_rhythm_snapshot_release();
+    m_snippet_offset = 0;
+  }
+}
+
+/**
+ * @brief         Function for building the next rhythm event notification
+ *
+ * @param[out]    p_buf       Output buffer
+ * @param[in]     max_len     Usable ATT payload
+ *
+ * @attention     None
+ *
+ * @return        Packet length, 0 if there is no event
+ */
+static uint16_t rhythm_event_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  ecg_rhythm_event_t event;
+
+  if ((max_len < ECG_RHYTHM_EVENT_ENCODED_SIZE) || !ecg_rhythm_get_event(&event))
+    return 0;
+
+  NRF_LOG_INFO("Rhythm event %d, seq %d, HR %d", event.type, event.sequence, event.heart_rate);
+
+  return ecg_rhythm_event_encode(&event, p_buf);
+}
+
+/**
+ * @brief         Function for building the next chunk of the rhythm event ECG snapshot
+ *
+ * @param[out]    p_buf       Output buffer
+ * @param[in]     max_len     Usable ATT payload
+ *
+ * @attention     Snippet chunks are {event sequence (u16), sample offset (u16), samples (i16)...}.
+ *                The snapshot is released once every sample is built.
+ *
+ * @return        Packet length, 0 if there is no snapshot
+ */
+static uint16_t rhythm_snippet_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  int16_t  samples[BLE_EVS_MAX_DATA_LEN / sizeof(int16_t)];
+  uint16_t sequence;
+  uint16_t count;
+  uint16_t len = 0;
+
+  if ((max_len <= 4) || (ecg_rhythm_snapshot_state(&sequence) != ECG_RHYTHM_SNAPSHOT_READY))
+    return 0;
+
+  count = ecg_rhythm_snapshot_read(m_snippet_offset, samples, (MIN(max_len, BLE_EVS_MAX_DATA_LEN) - 4) / sizeof(int16_t));
+  if (count == 0)
+  {
+    ecg_rhythm_snapshot_release();
+    m_snippet_offset = 0;
+    return 0;
+  }
+
+  len += uint16_encode(sequence, &p_buf[len]);
+  len += uint16_encode(m_snippet_offset, &p_buf[len]);
+  for (uint16_t i = 0; i < count; i++)
+    len += uint16_encode((uint16_t)samples[i], &p_buf[len]);
+
+  m_snippet_offset += count;
+
+  return len;
+}
+
+/**
+ * @brief         Function for sending a rhythm event on EVS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_evs_data_update()
+ */
+static ret_code_t evs_event_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_evs_data_update(&m_evs, p_data, len, conn_handle, BLE_EVS_EVENT_CHAR);
+}
+
+/**
+ * @brief         Function for sending a snapshot chunk on EVS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_evs_data_update()
+ */
+static ret_code_t evs_snippet_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_evs_data_update(&m_evs, p_data, len, conn_handle, BLE_EVS_SNIPPET_CHAR);
+}
+
+/**
+ * @brief         Function for sending a timebase record on EVS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_evs_data_update()
+ */
+static ret_code_t evs_time_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_evs_data_update(&m_evs, p_data, len, conn_handle, BLE_EVS_TIME_CHAR);
+}
+
+/**
+ * @brief         Function for sending an activity record on EVS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_evs_data_update()
+ */
+static ret_code_t evs_activity_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_evs_data_update(&m_evs, p_data, len, conn_handle, BLE_EVS_ACTIVITY_CHAR);
+}
+
+/**
+ * @brief         Function for logging the EMG features of each processed block
+ *
+ * @param[in]     p_block     Processed block
+ * @param[in]     p_context   Unused
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void emg_features_sink(const dsp_block_t *p_block, void *p_context)
+{
+  dsp_emg_features_t features;
+
+  UNUSED_PARAMETER(p_context);
+
+  dsp_stages_emg_get(&features);
+
+  NRF_LOG_RAW_INFO("Out EMG: %d\n", p_block->data[DSP_CHANNEL_ECG][p_block->count - 1]);
+  NRF_LOG_RAW_INFO("MAV: %d\n", features.mean_absolute_value);
+  NRF_LOG_RAW_INFO("iEMG: %d\n", features.integrated);
+  NRF_LOG_RAW_INFO("\n");
+}
+
+/**
+ * @brief         Function for handling the power state changes
+ *
+ * @param[in]     state       New power state
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void pm_state_handler(sys_pm_state_t state)
+{
+  NRF_LOG_INFO("Power state: %d", state);
+
+  // The counter and its crystal only run with the full acquisition
+  if (state != SYS_PM_STATE_ACTIVE)
+    bsp_time_suspend();
+  else if (bsp_time_resume() != BS_OK)
+    NRF_LOG_WARNING("Timebase crystal request failed");
+
+  // Nothing new may be logged for a while, keep what is buffered
+  bsp_nand_flash_log_flush();
+  m_log_windows = 0;
+
+  pm_conn_params_apply();
 }
 
+/**
+ * @brief         Function for requesting the connection parameters of the power state
+ *
+ * @param[in]     None
+ *
+ * @attention     The preferred parameters are updated for the next connections as well
+ *
+ * @return        None
+ */
+static void pm_conn_params_apply(void)
+{
+  ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+  ret_code_t                        err_code;
+
+  // A new link starts in the low-power profile
+  err_code = sd_ble_gap_ppcp_set(&m_pm_conn_params[sys_pm_state_get()]);
+  APP_ERROR_CHECK(err_code);
+
+  for (uint32_t i = 0; i < conn_handles.len; i++)
+    link_conn_params_apply(conn_handles.conn_handles[i]);
+}
+
+/**
+ * @brief         Function for requesting the connection parameters of a link
+ *
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     A streaming link keeps its short interval whatever the power state
+ *
+ * @return        None
+ */
+static void link_conn_params_apply(uint16_t conn_handle)
+{
+  ble_gap_conn_params_t conn_params = m_pm_conn_params[sys_pm_state_get()];
+  ret_code_t            err_code;
+
+  if (ble_link_profile_get(conn_handle) == BLE_LINK_PROFILE_STREAMING)
+    conn_params = m_stream_conn_params;
+
+  // Dropped while another update is pending, the next state change requests again
+  err_code = ble_conn_params_change_conn_params(conn_handle, &conn_params);
+  if (err_code != NRF_ERROR_BUSY)
+    APP_ERROR_CHECK(err_code);
+}
+
+/**
+ * @brief         Function for getting the streams a link subscribed to
+ *
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     The subscriptions are kept per link by the services, the ones the control point
+ *                of the link stopped are left out
+ *
+ * @return        STREAMING_ flags
+ */
+static uint8_t link_streams_get(uint16_t conn_handle)
+{
+  uint8_t streams = 0;
+
+#if (_CONFIG_WAVE_STREAM)
+  if (ble_wfs_is_notification_enabled(&m_wfs, conn_handle))
+    streams |= STREAMING_WAVE;
+#endif
+#if (_CONFIG_IMU_MOTION_STREAM)
+  if (ble_mos_is_notification_enabled(&m_mos, conn_handle))
+    streams |= STREAMING_MOTION;
+#endif
+
+  return streams & ~m_streams_blocked[ble_conn_state_conn_idx(conn_handle)];
+}
+
+/**
+ * @brief         Function for checking a link may change the configuration of a stream
+ *
+ * @param[in]     conn_handle   Connection handle of the writer
+ * @param[in]     stream        STREAMING_ flag
+ *
+ * @attention     A stream is built once for every link, its configuration belongs to the link
+ *                that streams it. Another link may only change it while none streams.
+ *
+ * @return        true if no other link streams it
+ */
+static bool stream_config_owned(uint16_t conn_handle, uint8_t stream)
+{
+  ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+
+  for (uint32_t i = 0; i < conn_handles.len; i++)
+  {
+    if ((conn_handles.conn_handles[i] != conn_handle) && (link_streams_get(conn_handles.conn_handles[i]) & stream))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief         Function for following a subscription change of a link
+ *
+ * @param[in]     conn_handle   Connection handle of the link that changed
+ *
+ * @attention     A stream is built once and runs while any connected link subscribed to it and
+ *                did not stop it, it is started and stopped by streams_process(). The link gets
+ *                the streaming profile while it streams.
+ *
+ * @return        None
+ */
+static void streams_update(uint16_t conn_handle)
+{
+  ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+  uint8_t                           streams      = 0;
+  ble_link_profile_t                profile;
+  ret_code_t                        err_code;
+
+  for (uint32_t i = 0; i < conn_handles.len; i++)
+    streams |= link_streams_get(conn_handles.conn_handles[i]);
+
+  // Enabling flushes a stream, the main loop may be building from it
+  m_streams_wanted = streams;
+
+  if (ble_conn_state_status(conn_handle) != BLE_CONN_STATUS_CONNECTED)
+    return;
+
+  profile = (link_streams_get(conn_handle) != 0) ? BLE_LINK_PROFILE_STREAMING : BLE_LINK_PROFILE_LOW_POWER;
+  if (profile == ble_link_profile_get(conn_handle))
+    return;
+
+  err_code = ble_link_profile_set(conn_handle, profile);
+  APP_ERROR_CHECK(err_code);
+
+  link_conn_params_apply(conn_handle);
+}
+
+/**
+ * @brief         Function for starting and stopping the streams the links ask for
+ *
+ * @param[in]     None
+ *
+ * @attention     Main loop only, before the TX scheduler builds from them. Enabling flushes a
+ *                stream, it is only done on a change.
+ *
+ * @return        None
+ */
+static void streams_process(void)
+{
+  uint8_t streams = m_streams_wanted;
+
+  if (streams == m_streams_on)
+    return;
+
+#if (_CONFIG_WAVE_STREAM)
+  if ((streams ^ m_streams_on) & STREAMING_WAVE)
+  {
+#if (_CONFIG_WAVE_SPOOL)
+    // The waveform keeps going to the NAND flash log without a link
+    wave_spool_live_set((streams & STREAMING_WAVE) != 0);
+#else
+    wave_stream_enable((streams & STREAMING_WAVE) != 0);
+#endif
+  }
+#endif
+#if (_CONFIG_IMU_MOTION_STREAM)
+  if ((streams ^ m_streams_on) & STREAMING_MOTION)
+    motion_stream_enable((streams & STREAMING_MOTION) != 0);
+#endif
+  m_streams_on = streams;
+}
+
+/**
+ * @brief         Function for reporting the negotiated link parameters over EVS
+ *
+ * @param[in]     p_params    Link parameters
+ *
+ * @attention     Sent by the TX scheduler to every link, only the latest parameters of each link
+ *                are kept
+ *
+ * @return        None
+ */
+static void link_params_handler(const ble_link_params_t *p_params)
+{
+  uint16_t idx = ble_conn_state_conn_idx(p_params->conn_handle);
+
+  if (idx < NRF_SDH_BLE_TOTAL_LINK_COUNT)
+    m_link_len[idx] = ble_link_params_encode(p_params, m_link_buf[idx]);
+}
+
+/**
+ * @brief         Function for building the waiting link parameters
+ *
+ * @param[out]    p_buf       Output buffer
+ * @param[in]     max_len     Usable ATT payload
+ *
+ * @attention     One link per packet
+ *
+ * @return        Packet length, 0 if there are no parameters
+ */
+static uint16_t link_params_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+  {
+    uint16_t len = m_link_len[i];
+
+    if ((len == 0) || (max_len < len))
+      continue;
+
+    memcpy(p_buf, m_link_buf[i], len);
+    m_link_len[i] = 0;
+
+    return len;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief         Function for sending the link parameters on EVS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_evs_data_update()
+ */
+static ret_code_t evs_link_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_evs_data_update(&m_evs, p_data, len, conn_handle, BLE_EVS_LINK_CHAR);
+}
+
+#if (_CONFIG_WAVE_STREAM)
+/**
+ * @brief         Function for sending a waveform packet on WFS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_wfs_data_update()
+ */
+static ret_code_t wfs_data_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_wfs_data_update(&m_wfs, p_data, len, conn_handle);
+}
+#endif
+
+#if (_CONFIG_IMU_MOTION_STREAM)
+/**
+ * @brief         Function for sending a motion packet on MOS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Error code of ble_mos_data_update()
+ */
+static ret_code_t mos_data_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  return ble_mos_data_update(&m_mos, p_data, len, conn_handle);
+}
+#endif
+
+#if (_CONFIG_HRS)
+/**
+ * @brief         Function for sending a heart rate measurement on HRS
+ *
+ * @param[in]     p_data        Packet
+ * @param[in]     len           Packet length
+ * @param[in]     conn_handle   Connection handle
+ *
+ * @attention     ble_hrs only notifies its last connection, the SoftDevice checks the CCCD of
+ *                each link and NRF_ERROR_INVALID_STATE skips the unsubscribed ones
+ *
+ * @return        Error code of sd_ble_gatts_hvx()
+ */
+static ret_code_t hrs_measurement_send(const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  ret_code_t             err_code;
+  ble_gatts_hvx_params_t hvx_params;
+  uint16_t               hvx_len = len;
+
+  memset(&hvx_params, 0, sizeof(hvx_params));
+
+  hvx_params.handle = m_hrs.hrm_handles.value_handle;
+  hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+  hvx_params.offset = 0;
+  hvx_params.p_len  = &hvx_len;
+  hvx_params.p_data = p_data;
+
+  err_code = sd_ble_gatts_hvx(conn_handle, &hvx_params);
+
+  // A link without stored CCCD values has not subscribed either
+  if (err_code == BLE_ERROR_GATTS_SYS_ATTR_MISSING)
+    err_code = NRF_ERROR_INVALID_STATE;
+
+  return err_code;
+}
+#endif
+
+/**
+ * @brief         Function for building the timebase record against the connection events
+ *
+ * @param[out]    p_buf       Output buffer
+ * @param[in]     max_len     Usable ATT payload
+ *
+ * @attention     A new record follows after BSP_TIME_LINK_WINDOW_S
+ *
+ * @return        Packet length, 0 if there is no new record
+ */
+static uint16_t link_time_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  bsp_time_link_t link;
+
+  if ((max_len < BSP_TIME_LINK_ENCODED_SIZE) || !bsp_time_link_get(&link))
+    return 0;
+
+  NRF_LOG_DEBUG("Link tick %u, drift %d ppb", link.tick, link.drift_ppb);
+
+  return bsp_time_link_encode(&link, p_buf);
+}
+
+/**
+ * @brief         Function for building the waiting activity record
+ *
+ * @param[out]    p_buf       Output buffer
+ * @param[in]     max_len     Usable ATT payload
+ *
+ * @attention     None
+ *
+ * @return        Packet length, 0 if there is no record
+ */
+static uint16_t activity_record_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  uint16_t len = m_activity_len;
+
+  if ((len == 0) || (max_len < len))
+    return 0;
+
+  memcpy(p_buf, m_activity_buf, len);
+  m_activity_len = 0;
+
+  return len;
+}
+
+/**
+ * @brief         Function for reporting an activity record over EVS and logging it to the NAND flash
+ *
+ * @param[in]     p_record    Activity record of the closed window
+ *
+ * @attention     A record not delivered is only kept in the flash log, the log is flushed every
+ *                LOG_FLUSH_WINDOWS windows
+ *
+ * @return        None
+ */
+static void activity_record_handler(const imu_activity_record_t *p_record)
+{
+  uint8_t buf[1 + IMU_ACTIVITY_RECORD_ENCODED_SIZE];
+  uint8_t len;
+
+  // The log record is tagged with its type, the EVS one is the bare record
+  buf[0] = BSP_NAND_FLASH_RECORD_ACTIVITY;
+  len    = imu_activity_record_encode(p_record, &buf[1]);
+
+  NRF_LOG_DEBUG("Activity %d, steps %d, cadence %d", p_record->activity, p_record->steps, p_record->cadence);
+
+  // Sent by the TX scheduler, a record not sent before the next window is replaced
+  if (ble_conn_state_peripheral_conn_count() != 0)
+  {
+    memcpy(m_activity_buf, &buf[1], len);
+    m_activity_len = len;
+  }
+
+  bsp_nand_flash_log_append(buf, 1 + len);
+
+  // The page is only programmed once full, bound what a reset loses
+  if (++m_log_windows >= LOG_FLUSH_WINDOWS)
+  {
+    bsp_nand_flash_log_flush();
+    m_log_windows = 0;
+  }
+}
+
+/**
+ * @brief         Function for reporting the end of an IMU calibration
+ *
+ * @param[in]     state       Calibration that ended
+ * @param[in]     success     Parameters updated and stored
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void calib_done_handler(imu_calib_state_t state, bool success)
+{
+  NRF_LOG_INFO("IMU calibration %d %s", state, success ? "done" : "failed");
+}
+
+#if (_CONFIG_CTRL_POINT)
+/**
+ * @brief         Function for executing the command written on the control point
+ *
+ * @param[in]     None
+ *
+ * @attention     Only run between two blocks of the AFE pipeline, a chain, stream or rate
+ *                change applies to whole blocks and the next sample is read in time
+ *
+ * @return        None
+ */
+static void control_point_process(void)
+{
+  uint8_t           cmd[BLE_CPS_MAX_LEN];
+  uint8_t           rsp[BLE_CPS_MAX_LEN];
+  uint8_t           payload[BLE_CPS_MAX_LEN - SYS_CTRL_RESPONSE_HEADER_SIZE];
+  uint8_t           payload_len = 0;
+  uint16_t          len;
+  sys_ctrl_cmd_t    command;
+  sys_ctrl_result_t result;
+  base_status_t     status;
+  ret_code_t        err_code;
+
+  if (!bsp_afe_block_boundary() || !ble_cps_command_get(&m_cps, cmd, &len))
+    return;
+
+  status = sys_ctrl_cmd_decode(cmd, len, &command);
+  if (status == BS_OK)
+    result = control_point_execute(&command, m_cps.conn_handle, payload, &payload_len);
+  else
+    result = (status == BS_ERROR) ? SYS_CTRL_RESULT_NOT_SUPPORTED : SYS_CTRL_RESULT_INVALID_PARAM;
+
+  NRF_LOG_INFO("Control point opcode 0x%02x, result %d", command.opcode, result);
+
+  // A response that is not delivered frees the control point at once
+  len      = sys_ctrl_response_encode(command.opcode, result, payload, payload_len, rsp);
+  err_code = ble_cps_response_send(&m_cps, rsp, len);
+  if (err_code != NRF_SUCCESS)
+    NRF_LOG_WARNING("Control point response not sent: 0x%x", err_code);
+}
+
+/**
+ * @brief         Function for applying a control point command
+ *
+ * @param[in]     p_cmd         Decoded command
+ * @param[in]     conn_handle   Link that wrote the command
+ * @param[out]    p_payload     Response payload
+ * @param[out]    p_len         Response payload length
+ *
+ * @attention     The stream and link changes also run from the BLE events, they are applied with
+ *                the application interrupts masked
+ *
+ * @return        Result of the command
+ */
+static sys_ctrl_result_t control_point_execute(const sys_ctrl_cmd_t *p_cmd, uint16_t conn_handle,
+                                               uint8_t *p_payload, uint8_t *p_len)
+{
+  base_status_t     status   = BS_OK;
+  ret_code_t        err_code = NRF_SUCCESS;
+  sys_ctrl_status_t dev_status;
+
+  *p_len = 0;
+
+  switch (p_cmd->opcode)
+  {
+  case SYS_CTRL_OP_STATUS_GET:
+    control_point_status_get(conn_handle, &dev_status);
+    *p_len = sys_ctrl_status_encode(&dev_status, p_payload);
+    break;
+
+  case SYS_CTRL_OP_STREAMS_SET:
+    if (p_cmd->params.streams & ~(STREAMING_WAVE | STREAMING_MOTION))
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+
+    // Only the streams of the writer, the other link keeps its own
+    CRITICAL_REGION_ENTER();
+    m_streams_blocked[ble_conn_state_conn_idx(conn_handle)] = (uint8_t)(~p_cmd->params.streams & (STREAMING_WAVE | STREAMING_MOTION));
+    streams_update(conn_handle);
+    CRITICAL_REGION_EXIT();
+    break;
+
+  case SYS_CTRL_OP_WAVE_CONFIG:
+#if (_CONFIG_WAVE_STREAM)
+    // The configuration characteristic follows
+    status = wave_config_apply(conn_handle, &p_cmd->params.wave_config);
+    if (status != BS_OK)
+      return (status == BS_ERROR) ? SYS_CTRL_RESULT_FAILED : SYS_CTRL_RESULT_INVALID_PARAM;
+    break;
+#else
+    return SYS_CTRL_RESULT_NOT_SUPPORTED;
+#endif
+
+  case SYS_CTRL_OP_PIPELINE_SET:
+    if (bsp_afe_pipeline_configure(p_cmd->params.pipeline.ids, p_cmd->params.pipeline.count) != BS_OK)
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+    break;
+
+  case SYS_CTRL_OP_PIPELINE_GET:
+    *p_len = bsp_afe_pipeline_get(p_payload);
+    break;
+
+  case SYS_CTRL_OP_RESP_SOURCE:
+    if (p_cmd->params.resp_source > BSP_AFE_RESP_SOURCE_EDR)
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+
+    status = bsp_afe_set_resp_source((bsp_afe_resp_source_t)p_cmd->params.resp_source);
+    break;
+
+  case SYS_CTRL_OP_MOTION_RATE:
+#if (_CONFIG_IMU_MOTION_STREAM)
+    if (!stream_config_owned(conn_handle, STREAMING_MOTION))
+      return SYS_CTRL_RESULT_FAILED;
+
+    if (motion_stream_rate_set(p_cmd->params.motion_rate) != BS_OK)
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+    break;
+#else
+    return SYS_CTRL_RESULT_NOT_SUPPORTED;
+#endif
+
+  case SYS_CTRL_OP_SENSORS_PERIOD:
+    if (p_cmd->params.sensors_period < SENSORS_MEAS_PERIOD_MIN_MS)
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+
+    err_code = app_timer_stop(m_sensors_timer_id);
+    if (err_code == NRF_SUCCESS)
+      err_code = app_timer_start(m_sensors_timer_id, APP_TIMER_TICKS(p_cmd->params.sensors_period), NULL);
+    if (err_code == NRF_SUCCESS)
+      m_sensors_period = p_cmd->params.sensors_period;
+    break;
+
+  case SYS_CTRL_OP_LINK_PROFILE:
+    if (p_cmd->params.link_profile >= BLE_LINK_PROFILE_MAX)
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+
+    // Kept until the subscriptions of the link change
+    CRITICAL_REGION_ENTER();
+    err_code = ble_link_profile_set(conn_handle, (ble_link_profile_t)p_cmd->params.link_profile);
+    if (err_code == NRF_SUCCESS)
+      link_conn_params_apply(conn_handle);
+    CRITICAL_REGION_EXIT();
+    break;
+
+  case SYS_CTRL_OP_IMU_CALIB:
+#if (_CONFIG_IMU_CALIB)
+    switch (p_cmd->params.calib.target)
+    {
+    case SYS_CTRL_CALIB_ABORT:
+      imu_calib_abort();
+      break;
+
+    case SYS_CTRL_CALIB_ACCEL:
+      status = imu_calib_accel_start();
+      break;
+
+    case SYS_CTRL_CALIB_MAG:
+      status = imu_calib_mag_start(p_cmd->params.calib.duration);
+      break;
+
+    default:
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+    }
+    break;
+#else
+    return SYS_CTRL_RESULT_NOT_SUPPORTED;
+#endif
+
+  case SYS_CTRL_OP_BROADCAST:
+#if (_CONFIG_BROADCAST)
+    if ((p_cmd->params.broadcast.connectable > 1) || (p_cmd->params.broadcast.period < BROADCAST_PERIOD_MIN_MS))
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+
+    err_code = app_timer_stop(m_broadcast_timer_id);
+    if (err_code == NRF_SUCCESS)
+      err_code = app_timer_start(m_broadcast_timer_id, APP_TIMER_TICKS(p_cmd->params.broadcast.period), NULL);
+    if (err_code == NRF_SUCCESS)
+      m_broadcast_period = p_cmd->params.broadcast.period;
+
+    // A broadcast only device keeps its links, the response still goes to the writer
+    CRITICAL_REGION_ENTER();
+    m_adv_connectable = (p_cmd->params.broadcast.connectable != 0);
+    advertising_restart();
+    CRITICAL_REGION_EXIT();
+    break;
+#else
+    return SYS_CTRL_RESULT_NOT_SUPPORTED;
+#endif
+
+  case SYS_CTRL_OP_REPLAY:
+#if (_CONFIG_WAVE_SPOOL)
+    status = wave_spool_replay_request(p_cmd->params.replay.first, p_cmd->params.replay.count);
+    if (status == BS_ERROR_PARAMS)
+      return SYS_CTRL_RESULT_INVALID_PARAM;
+    break;
+#else
+    return SYS_CTRL_RESULT_NOT_SUPPORTED;
+#endif
+
+  default:
+    return SYS_CTRL_RESULT_NOT_SUPPORTED;
+  }
+
+  return ((status == BS_OK) && (err_code == NRF_SUCCESS)) ? SYS_CTRL_RESULT_SUCCESS : SYS_CTRL_RESULT_FAILED;
+}
+
+/**
+ * @brief         Function for collecting the status reported by the control point
+ *
+ * @param[in]     conn_handle   Link that reads the status
+ * @param[out]    p_status      Pointer to status
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void control_point_status_get(uint16_t conn_handle, sys_ctrl_status_t *p_status)
+{
+  uint8_t ids[DSP_PIPELINE_MAX_STAGES];
+
+  memset(p_status, 0, sizeof(*p_status));
+
+  p_status->streams          = m_streams_on;
+  p_status->streams_allowed  = (uint8_t)(~m_streams_blocked[ble_conn_state_conn_idx(conn_handle)] & (STREAMING_WAVE | STREAMING_MOTION));
+  p_status->resp_source      = (uint8_t)bsp_afe_get_resp_source();
+  p_status->pm_state         = (uint8_t)sys_pm_state_get();
+  p_status->lead_off         = bsp_afe_lead_off_get();
+  p_status->heart_rate       = global_heart_rate;
+  p_status->respiration_rate = global_respiration_rate;
+  p_status->link_profile     = (uint8_t)ble_link_profile_get(conn_handle);
+  p_status->sensors_period   = m_sensors_period;
+  p_status->stage_count      = bsp_afe_pipeline_get(ids);
+  wave_stream_config_get(&p_status->wave_config);
+#if (_CONFIG_IMU_MOTION_STREAM)
+  p_status->motion_rate      = motion_stream_rate_get();
+#endif
+}
+#endif
+
 /* End of fi le -------------------------------------------------------- */
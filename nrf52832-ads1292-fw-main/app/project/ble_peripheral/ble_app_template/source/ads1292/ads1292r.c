@@ -160,6 +160,78 @@ base_status_t ads1292_init(const int chip_select, const int pwdn_pin, const int
   return BS_OK;
 }
 
+base_status_t ads1292_set_resp_modulation(const int chip_select, bool enable)
+{
+  // Registers can only be written with Read Data Continuous mode stopped
+  ads1292_stop_read_data_continuous(chip_select);
+  platform_delay(10);
+
+  if (enable)
+  {
+    ads1292_reg_write(ADS1292_REG_CH1SET, 64, chip_select);   // Ch 1 enabled, gain 6, connected to electrode in
+    platform_delay(10);
+    ads1292_reg_write(ADS1292_REG_RESP1, 242, chip_select);   // Respiration: MOD/DEMOD turned only, phase 0
+  }
+  else
+  {
+    ads1292_reg_write(ADS1292_REG_RESP1, 0x02, chip_select);  // Respiration: MOD/DEMOD off
+    platform_delay(10);
+    ads1292_reg_write(ADS1292_REG_CH1SET, 0x81, chip_select); // Ch 1 powered down, input shorted
+  }
+  platform_delay(10);
+
+  ads1292_start_read_data_continuous(chip_select);
+  platform_delay(10);
+
+  return BS_OK;
+}
+
+base_status_t ads1292_set_lead_off_detect(const int chip_select, bool enable)
+{
+  // Registers can only be written with Read Data Continuous mode stopped
+  ads1292_stop_read_data_continuous(chip_select);
+  platform_delay(10);
+
+  if (enable)
+  {
+    ads1292_reg_write(ADS1292_REG_CONFIG2, 224, chip_select);   // Lead-off comp on, test signal disabled
+    platform_delay(10);
+    ads1292_reg_write(ADS1292_REG_LOFFSENS, 0x0C, chip_select); // LOFF settings: LOFFP2 and LOFFN2, DC current on both Ch 2 inputs
+  }
+  else
+  {
+    ads1292_reg_write(ADS1292_REG_LOFFSENS, 0x00, chip_select); // LOFF settings: all disabled
+    platform_delay(10);
+    ads1292_reg_write(ADS1292_REG_CONFIG2, 160, chip_select);   // Lead-off comp off, test signal disabled
+  }
+  platform_delay(10);
+
+  ads1292_start_read_data_continuous(chip_select);
+  platform_delay(10);
+
+  return BS_OK;
+}
+
+base_status_t ads1292_set_standby(const int chip_select, bool standby)
+{
+  if (standby)
+  {
+    // Conversions and the DRDY pulses stop, only the reference stays powered
+    ads1292_stop_read_data_continuous(chip_select);
+    platform_delay(10);
+    ads1292_spi_command_data(ADS1292_CMD_STANDBY, chip_select);
+  }
+  else
+  {
+    ads1292_spi_command_data(ADS1292_CMD_WAKEUP, chip_select);
+    platform_delay(10);
+    ads1292_start_read_data_continuous(chip_select);
+  }
+  platform_delay(10);
+
+  return BS_OK;
+}
+
 /* Private function definitions --------------------------------------- */
 static char *ads1292_read_data(const int chip_select)
 {
@@ -64,6 +64,9 @@ ads1292_output_value_t;
 /* Public function prototypes ----------------------------------------- */
 base_status_t ads1292_get_ecg_and_respiration_sample(const int data_ready, const int chip_select, ads1292_output_value_t *data_sample);
 base_status_t ads1292_init(const int chip_select, const int pwdn_pin, const int start_pin);
+base_status_t ads1292_set_resp_modulation(const int chip_select, bool enable);
+base_status_t ads1292_set_lead_off_detect(const int chip_select, bool enable);
+base_status_t ads1292_set_standby(const int chip_select, bool standby);
 
 /* -------------------------------------------------------------------------- */
 #ifdef __cplusplus
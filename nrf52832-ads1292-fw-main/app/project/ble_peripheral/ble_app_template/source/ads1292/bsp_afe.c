@@ -11,57 +11,322 @@
  */
 
 /* Includes ----------------------------------------------------------- */
+#include <string.h>
 #include "bsp_afe.h"
 #include "ecg_res_algo.h"
+#include "ecg_rhythm.h"
+#include "ecg_edr.h"
+#include "bsp_imu.h"
+#include "dsp_stages.h"
+#include "bsp_time.h"
+#include "wave_stream.h"
+#include "wave_record.h"
+#include "hr_stream.h"
 
 /* Private defines ---------------------------------------------------- */
 /* Private enumerate/structure ---------------------------------------- */
 /* Private macros ----------------------------------------------------- */
 /* Public variables --------------------------------------------------- */
 /* Private variables -------------------------------------------------- */
+DSP_PIPELINE_DEF(m_pipeline);
+
+static bsp_afe_resp_source_t m_resp_source = BSP_AFE_RESP_SOURCE_IMPEDANCE;
+static bool m_lead_off = false;
+static bool m_standby  = false;
+static int16_t m_ecg_filtered = 0;
+
+static uint8_t m_chain_ids[DSP_PIPELINE_MAX_STAGES] =
+{
+   DSP_STAGE_ECG_FILTER
+#if (_CONFIG_MOTION_CANCEL)
+  ,DSP_STAGE_MOTION_CANCEL
+#endif
+  ,DSP_STAGE_RESP_FILTER
+  ,DSP_STAGE_EMG_FEATURES
+};
+static uint8_t m_chain_len = 3 + _CONFIG_MOTION_CANCEL;
+
 /* Private function prototypes ---------------------------------------- */
+static void m_bsp_afe_chain_build(void);
+static void m_bsp_afe_detector_sink(const dsp_block_t *p_block, void *p_ctx);
+static void m_bsp_afe_on_beat(const QRS_Beat_t *beat);
+
 volatile uint8_t global_heart_rate = 0;
 volatile uint8_t global_respiration_rate = 0;
 
-int16_t ecg_wave_buf, ecg_filter_out;
-int16_t res_wave_buf, resp_filter_out;
-
 /* Function definitions ----------------------------------------------- */
 base_status_t bsp_afe_init(void)
 {
-  return ads1292_init(IO_AFE_CS, IO_AFE_RST, IO_AFE_START);
+  // Rhythm detector, EDR and heart rate stream are fed with every beat of the QRS detector
+  ecg_rhythm_init();
+  ecg_edr_init();
+#if (_CONFIG_HRS)
+  // The sensor contact is the lead-off detection, only enabled with the power states
+  hr_stream_init(SAMPLING_RATE, _CONFIG_PM);
+#endif
+  QRS_Register_Beat_Callback(m_bsp_afe_on_beat);
+
+  // Boot chain, the detectors run as the first sink
+  dsp_pipeline_init(&m_pipeline);
+  m_bsp_afe_chain_build();
+  dsp_pipeline_sink_add(&m_pipeline, m_bsp_afe_detector_sink, NULL);
+
+#if (_CONFIG_WAVE_STREAM)
+  // Waveform streaming, the filtered samples come out of the chain, the raw ones from the ADC
+  wave_stream_init(SAMPLING_RATE);
+  dsp_pipeline_sink_add(&m_pipeline, wave_stream_sink, NULL);
+#endif
+
+#if (_CONFIG_WAVE_RECORD)
+  // Lossless-compressed filtered ECG in the NAND flash log
+  wave_record_init(SAMPLING_RATE);
+  dsp_pipeline_sink_add(&m_pipeline, wave_record_sink, NULL);
+#endif
+
+  CHECK_STATUS(ads1292_init(IO_AFE_CS, IO_AFE_RST, IO_AFE_START));
+
+  // DRDY stays polled, its falling edge is only routed to the timebase capture
+  nrf_drv_gpiote_in_config_t in_config = GPIOTE_CONFIG_IN_SENSE_HITOLO(true);
+
+  in_config.pull = NRF_GPIO_PIN_PULLUP;
+  CHECK(nrf_drv_gpiote_in_init(IO_AFE_DRDY, &in_config, NULL) == NRF_SUCCESS, BS_ERROR);
+  nrf_drv_gpiote_in_event_enable(IO_AFE_DRDY, false);
+  CHECK_STATUS(bsp_time_capture_attach(BSP_TIME_CAPTURE_AFE_DRDY, nrf_drv_gpiote_in_event_addr_get(IO_AFE_DRDY)));
+
+#if (_CONFIG_RESP_SOURCE_EDR)
+  CHECK_STATUS(bsp_afe_set_resp_source(BSP_AFE_RESP_SOURCE_EDR));
+#endif
+
+#if (_CONFIG_PM)
+  // The power manager tells a worn device by the ECG electrodes
+  CHECK_STATUS(ads1292_set_lead_off_detect(IO_AFE_CS, true));
+#endif
+
+  return BS_OK;
 }
 
 base_status_t bsp_afe_get_ecg(int16_t *ecg_data)
 {
   ads1292_output_value_t ecg_values;
+  int16_t  sample[DSP_CHANNEL_MAX];
+  uint16_t channel_mask = (1u << DSP_CHANNEL_ECG);
 
   base_status_t ret = ads1292_get_ecg_and_respiration_sample(IO_AFE_DRDY, IO_AFE_CS, &ecg_values);
   if (ret == BS_OK)
   {
     // Ignore the lower 8 bits out of 24bits
-    ecg_wave_buf = (int16_t)(ecg_values.daq_vals[1] >> 8);
-    res_wave_buf = (int16_t)(ecg_values.result_temp_resp >> 8);
-
-    if (ecg_values.lead_off_detected == false)
-    {
-      // Filter out the line noise @40Hz cutoff 161 order
-      ECG_ProcessCurrSample(&ecg_wave_buf, &ecg_filter_out);
-
-      // Calculate
-      QRS_Algorithm_Interface(ecg_filter_out, &global_heart_rate);
-    }
-    else
-    {
-      ecg_filter_out = 0;
-      resp_filter_out = 0;
-    }
-
-    *ecg_data = ecg_filter_out;
+    sample[DSP_CHANNEL_ECG]  = (int16_t)(ecg_values.daq_vals[1] >> 8);
+    sample[DSP_CHANNEL_RESP] = (int16_t)(ecg_values.result_temp_resp >> 8);
+
+    if (m_resp_source == BSP_AFE_RESP_SOURCE_IMPEDANCE)
+      channel_mask |= (1u << DSP_CHANNEL_RESP);
+
+#if (_CONFIG_MOTION_CANCEL)
+    // Newest IMU FIFO/PPI frame, held until the next block is drained
+    static mpu9250_raw_data_t accel_raw;
+
+    bsp_accel_raw_get(&accel_raw);
+    channel_mask |= (1u << DSP_CHANNEL_ACC_X) | (1u << DSP_CHANNEL_ACC_Y) | (1u << DSP_CHANNEL_ACC_Z);
+#else
+    mpu9250_raw_data_t accel_raw = { 0 };
+#endif
+    sample[DSP_CHANNEL_ACC_X] = accel_raw.x;
+    sample[DSP_CHANNEL_ACC_Y] = accel_raw.y;
+    sample[DSP_CHANNEL_ACC_Z] = accel_raw.z;
+
+#if (_CONFIG_WAVE_STREAM)
+    int32_t raw[DSP_CHANNEL_MAX];
+
+    raw[DSP_CHANNEL_ECG]   = ecg_values.daq_vals[1];
+    raw[DSP_CHANNEL_RESP]  = ecg_values.daq_vals[0];
+    raw[DSP_CHANNEL_ACC_X] = (int32_t)accel_raw.x * 256;
+    raw[DSP_CHANNEL_ACC_Y] = (int32_t)accel_raw.y * 256;
+    raw[DSP_CHANNEL_ACC_Z] = (int32_t)accel_raw.z * 256;
+    wave_stream_push(WAVE_STREAM_SOURCE_RAW, raw, bsp_time_capture_get(BSP_TIME_CAPTURE_AFE_DRDY));
+#endif
+
+    dsp_pipeline_push(&m_pipeline, sample, channel_mask, ecg_values.lead_off_detected,
+                      bsp_time_capture_get(BSP_TIME_CAPTURE_AFE_DRDY));
+
+    m_lead_off = ecg_values.lead_off_detected;
+#if (_CONFIG_HRS)
+    hr_stream_contact_set(!m_lead_off);
+#endif
+
+    *ecg_data = m_ecg_filtered;
   }
 
   return ret;
 }
 
+base_status_t bsp_afe_pipeline_configure(const uint8_t *p_ids, uint8_t count)
+{
+  CHECK(count <= DSP_PIPELINE_MAX_STAGES, BS_ERROR);
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    CHECK(dsp_stages_get(p_ids[i]) != NULL, BS_ERROR);
+  }
+
+  memcpy(m_chain_ids, p_ids, count);
+  m_chain_len = count;
+  m_bsp_afe_chain_build();
+
+  return BS_OK;
+}
+
+uint8_t bsp_afe_pipeline_get(uint8_t *p_ids)
+{
+  memcpy(p_ids, m_chain_ids, m_chain_len);
+
+  return m_chain_len;
+}
+
+bool bsp_afe_block_boundary(void)
+{
+  return m_standby || (m_pipeline.block.count == 0);
+}
+
+base_status_t bsp_afe_sink_add(dsp_sink_handler_t handler, void *p_ctx)
+{
+  CHECK(dsp_pipeline_sink_add(&m_pipeline, handler, p_ctx), BS_ERROR);
+
+  return BS_OK;
+}
+
+base_status_t bsp_afe_pipeline_stats(uint8_t index, dsp_stage_stats_t *p_stats)
+{
+  CHECK(dsp_pipeline_stats_get(&m_pipeline, index, p_stats), BS_ERROR);
+
+  return BS_OK;
+}
+
+base_status_t bsp_afe_set_resp_source(bsp_afe_resp_source_t source)
+{
+  if (source == m_resp_source)
+    return BS_OK;
+
+  CHECK_STATUS(ads1292_set_resp_modulation(IO_AFE_CS, source == BSP_AFE_RESP_SOURCE_IMPEDANCE));
+
+  // Restart the EDR estimator so a stale rate is not reported
+  if (source == BSP_AFE_RESP_SOURCE_EDR)
+    ecg_edr_init();
+
+  m_resp_source           = source;
+  global_respiration_rate = 0;
+
+  // The impedance RESP filter only runs while it is the source
+  m_bsp_afe_chain_build();
+
+  return BS_OK;
+}
+
+bsp_afe_resp_source_t bsp_afe_get_resp_source(void)
+{
+  return m_resp_source;
+}
+
+base_status_t bsp_afe_set_standby(bool standby)
+{
+  if (standby == m_standby)
+    return BS_OK;
+
+  CHECK_STATUS(ads1292_set_standby(IO_AFE_CS, standby));
+
+  // The electrodes are unknown until the first sample after the wake-up
+  m_standby  = standby;
+  m_lead_off = false;
+
+  return BS_OK;
+}
+
+bool bsp_afe_lead_off_get(void)
+{
+  return m_lead_off;
+}
+
 /* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Build the pipeline chain from the configured stage identifiers
+ *
+ * @param[in]     None
+ *
+ * @attention     The RESP filter stage is skipped while EDR is the respiration source, it is
+ *                initialized again when impedance is selected back
+ *
+ * @return        None
+ */
+static void m_bsp_afe_chain_build(void)
+{
+  const dsp_stage_t *p_stages[DSP_PIPELINE_MAX_STAGES];
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < m_chain_len; i++)
+  {
+    if ((m_chain_ids[i] == DSP_STAGE_RESP_FILTER) && (m_resp_source != BSP_AFE_RESP_SOURCE_IMPEDANCE))
+      continue;
+
+    p_stages[count++] = dsp_stages_get(m_chain_ids[i]);
+  }
+
+  // Stages kept from the previous chain are not initialized again
+  dsp_pipeline_stage_set(&m_pipeline, p_stages, count);
+}
+
+/**
+ * @brief         Detector sink, QRS detection, rhythm snapshot and respiration rate
+ *
+ * @param[in]     p_block       Processed block
+ * @param[in]     p_ctx         Sink context (unused)
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_afe_detector_sink(const dsp_block_t *p_block, void *p_ctx)
+{
+  const int16_t *p_ecg = p_block->data[DSP_CHANNEL_ECG];
+
+  // Newest filtered ECG for bsp_afe_get_ecg(), 0 with the lead off
+  m_ecg_filtered = (p_block->lead_off_mask & (1u << (p_block->count - 1))) ? 0 : p_ecg[p_block->count - 1];
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    if (p_block->lead_off_mask & (1u << n))
+      continue;
+
+    // Keep the filtered ECG for the rhythm event snapshot
+    ecg_rhythm_add_sample(p_ecg[n]);
+
+    // Calculate, beats are stamped with the tick of their sample
+    QRS_Set_Sample_Tick(p_block->tick + BSP_TIME_SAMPLE_TICKS(n, SAMPLING_RATE));
+    QRS_Algorithm_Interface(p_ecg[n], &global_heart_rate);
+  }
+
+  if (m_resp_source == BSP_AFE_RESP_SOURCE_IMPEDANCE)
+    global_respiration_rate = dsp_stages_resp_rate_get();
+  else
+    global_respiration_rate = ecg_edr_get_rate();
+}
+
+/**
+ * @brief         Dispatch a beat of the QRS detector to the beat consumers
+ *
+ * @param[in]     beat          Beat reported by the QRS detector
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_afe_on_beat(const QRS_Beat_t *beat)
+{
+  ecg_rhythm_add_beat(beat);
+#if (_CONFIG_HRS)
+  hr_stream_add_beat(beat);
+#endif
+
+  if (m_resp_source == BSP_AFE_RESP_SOURCE_EDR)
+    ecg_edr_add_beat(beat);
+}
+
 /* End of file -------------------------------------------------------- */
@@ -20,11 +20,25 @@ extern "C" {
 
 /* Includes ----------------------------------------------------------- */
 #include "ads1292r.h"
+#include "dsp_pipeline.h"
 
 /* Public defines ----------------------------------------------------- */
 /* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Respiration rate source enum
+ */
+typedef enum
+{
+   BSP_AFE_RESP_SOURCE_IMPEDANCE   // ADS1292R RESP modulation, impedance pneumography
+  ,BSP_AFE_RESP_SOURCE_EDR         // ECG-derived respiration, RESP modulation turned off
+}
+bsp_afe_resp_source_t;
+
 /* Public macros ------------------------------------------------------ */
 /* Public variables --------------------------------------------------- */
+extern volatile uint8_t global_heart_rate;          // Heart rate of the QRS detector (bpm)
+extern volatile uint8_t global_respiration_rate;    // Respiration rate of the selected source (rpm)
+
 /* Public function prototypes ----------------------------------------- */
 /**
  * @brief         BSP AFE init
@@ -42,15 +56,127 @@ base_status_t bsp_afe_init(void);
 /**
  * @brief         BSP AFE read ECG data - Will be called in the interrupt handler - DRDY pin
  *
+ * @param[out]    ecg_data      Filtered ECG sample, 0 with the lead off
+ *
+ * @attention     The sample is pushed to the DSP pipeline, processed data is delivered
+ *                in blocks to the sinks. The filtered sample is the newest one of the last
+ *                processed block.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_afe_get_ecg(int16_t *ecg_data);
+
+/**
+ * @brief         BSP AFE configure the DSP chain
+ *
+ * @param[in]     p_ids         Stage identifiers (dsp_stage_id_t) in processing order
+ * @param[in]     count         Number of stages
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR     Unknown stage or chain too long
+ */
+base_status_t bsp_afe_pipeline_configure(const uint8_t *p_ids, uint8_t count);
+
+/**
+ * @brief         BSP AFE get the configured DSP chain
+ *
+ * @param[out]    p_ids         Stage identifiers, DSP_PIPELINE_MAX_STAGES bytes
+ *
+ * @attention     The RESP filter is listed even while EDR is the respiration source
+ *
+ * @return        Number of stages
+ */
+uint8_t bsp_afe_pipeline_get(uint8_t *p_ids);
+
+/**
+ * @brief         BSP AFE check for a block boundary
+ *
  * @param[in]     None
  *
+ * @attention     A chain or sink change made at a boundary applies to whole blocks
+ *
+ * @return
+ * - true       No partial block is waiting in the pipeline, or the AFE is in standby
+ * - false      Samples of the next block are already acquired
+ */
+bool bsp_afe_block_boundary(void);
+
+/**
+ * @brief         BSP AFE register a sink of the processed blocks
+ *
+ * @param[in]     handler       Sink handler
+ * @param[in]     p_ctx         Sink context
+ *
  * @attention     None
  *
  * @return
  * - BS_OK
  * - BS_ERROR
  */
-base_status_t bsp_afe_get_ecg(int16_t *ecg_data);
+base_status_t bsp_afe_sink_add(dsp_sink_handler_t handler, void *p_ctx);
+
+/**
+ * @brief         BSP AFE get the cycle accounting of a pipeline stage
+ *
+ * @param[in]     index         Stage index in the chain, number of stages for the sinks
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_afe_pipeline_stats(uint8_t index, dsp_stage_stats_t *p_stats);
+
+/**
+ * @brief         BSP AFE select the respiration rate source
+ *
+ * @param[in]     source        Respiration rate source
+ *
+ * @attention     Selecting EDR turns the ADS1292R RESP modulation and channel 1 off
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_afe_set_resp_source(bsp_afe_resp_source_t source);
+
+/**
+ * @brief         BSP AFE get the respiration rate source
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Respiration rate source
+ */
+bsp_afe_resp_source_t bsp_afe_get_resp_source(void);
+
+/**
+ * @brief         BSP AFE enter or leave the standby mode
+ * @param[in]     standby       Standby
+ * @attention     No samples are delivered in standby, the pipeline keeps its state
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_afe_set_standby(bool standby);
+
+/**
+ * @brief         BSP AFE get the lead-off status of the newest sample
+ * @param[in]     None
+ * @attention     Lead-off detection runs on the ECG channel when _CONFIG_PM is set
+ * @return
+ * - true       Electrodes off
+ * - false      Electrodes on, or no sample since the wake-up
+ */
+bool bsp_afe_lead_off_get(void);
 
 /* -------------------------------------------------------------------------- */
 #ifdef __cplusplus
@@ -0,0 +1,283 @@
+/**
+ * @file       ecg_edr.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      ECG-derived respiration (EDR) rate estimator
+ * @note       Beat features are linearly resampled to ECG_EDR_RESAMPLE_RATE, normalized to
+ *             their running mean, band-passed (2nd order HP + 2nd order LP) and the breaths
+ *             are counted on the positive-going crossings with a hysteresis
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include <math.h>
+#include "ecg_edr.h"
+
+/* Private defines ---------------------------------------------------- */
+#define ECG_EDR_MEAN_TC             (8 * ECG_EDR_RESAMPLE_RATE)                      // Running mean time constant (outputs)
+#define ECG_EDR_POWER_TC            (8 * ECG_EDR_RESAMPLE_RATE)                      // Running power time constant (outputs)
+#define ECG_EDR_HYSTERESIS          (0.5f)                                           // Crossing hysteresis relative to the RMS
+#define ECG_EDR_MIN_INTERVAL        ((uint16_t)(ECG_EDR_RESAMPLE_RATE / ECG_EDR_LP_CUTOFF))
+#define ECG_EDR_MAX_INTERVAL        ((uint16_t)(ECG_EDR_RESAMPLE_RATE / ECG_EDR_HP_CUTOFF))
+#define ECG_EDR_TIMEOUT             (ECG_EDR_TIMEOUT_S * ECG_EDR_RESAMPLE_RATE)
+#define ECG_EDR_MAX_GAP             (ECG_EDR_MAX_GAP_S * SAMPLING_RATE * ECG_EDR_RESAMPLE_RATE)
+
+#define ECG_EDR_PI                  (3.14159265f)
+#define ECG_EDR_BUTTERWORTH_Q       (0.70710678f)
+
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Biquad coefficients (normalized to a0)
+ */
+typedef struct
+{
+  float b0, b1, b2;
+  float a1, a2;
+}
+m_edr_biquad_t;
+
+/**
+ * @brief Per-feature EDR channel state
+ */
+typedef struct
+{
+  float    prev_value;                              // Feature at the previous beat
+  float    mean;                                    // Running mean of the feature
+  float    hp_z[2];                                 // High-pass state (transposed direct form II)
+  float    lp_z[2];                                 // Low-pass state (transposed direct form II)
+  float    power;                                   // Running power of the band-passed series
+  bool     armed;                                   // Series went below the negative hysteresis
+  bool     breath_seen;                             // At least one breath since the last timeout
+  uint16_t since_breath;                            // Outputs since the last breath
+  uint16_t intervals[ECG_EDR_RATE_INTERVALS];       // Last breath intervals (outputs)
+  uint8_t  interval_idx;
+  uint8_t  interval_count;
+  uint8_t  rate;                                    // Breaths/min, 0 if unknown
+}
+m_edr_channel_t;
+
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static m_edr_biquad_t  m_hp;
+static m_edr_biquad_t  m_lp;
+static m_edr_channel_t m_channel[ECG_EDR_FEATURE_MAX];
+
+static bool     m_resampler_valid;
+static uint32_t m_t_prev;                           // Time of the previous beat (1 / ECG_EDR_RESAMPLE_RATE samples)
+static uint32_t m_t_next;                           // Time of the next uniform output
+
+/* Private function prototypes ---------------------------------------- */
+static void m_ecg_edr_biquad_design(m_edr_biquad_t *p_biquad, float cutoff, bool high_pass);
+static float m_ecg_edr_biquad_run(const m_edr_biquad_t *p_biquad, float *z, float x);
+static void m_ecg_edr_process(m_edr_channel_t *p_ch, float value);
+
+/* Function definitions ----------------------------------------------- */
+void ecg_edr_init(void)
+{
+  m_ecg_edr_biquad_design(&m_hp, ECG_EDR_HP_CUTOFF, true);
+  m_ecg_edr_biquad_design(&m_lp, ECG_EDR_LP_CUTOFF, false);
+
+  memset(m_channel, 0, sizeof(m_channel));
+  m_resampler_valid = false;
+}
+
+void ecg_edr_add_beat(const QRS_Beat_t *beat)
+{
+  float    value[ECG_EDR_FEATURE_MAX];
+  uint32_t t = beat->sample_index * ECG_EDR_RESAMPLE_RATE;
+  uint8_t  i;
+
+  value[ECG_EDR_FEATURE_R_AMPLITUDE] = (float)beat->r_amplitude;
+  value[ECG_EDR_FEATURE_QRS_AREA]    = (float)beat->qrs_area;
+
+  // Restart the resampler after a detector reset or a long run of missed beats
+  if ((!m_resampler_valid) || (beat->rr_interval == 0) || ((t - m_t_prev) > ECG_EDR_MAX_GAP))
+  {
+    m_resampler_valid = true;
+    m_t_next          = t + SAMPLING_RATE;
+  }
+  else
+  {
+    // Linear interpolation of the feature on the uniform output grid
+    while ((int32_t)(m_t_next - t) <= 0)
+    {
+      float frac = (float)(m_t_next - m_t_prev) / (float)(t - m_t_prev);
+
+      for (i = 0; i < ECG_EDR_FEATURE_MAX; i++)
+      {
+        m_edr_channel_t *p_ch = &m_channel[i];
+        m_ecg_edr_process(p_ch, p_ch->prev_value + (value[i] - p_ch->prev_value) * frac);
+      }
+
+      m_t_next += SAMPLING_RATE;
+    }
+  }
+
+  m_t_prev = t;
+  for (i = 0; i < ECG_EDR_FEATURE_MAX; i++)
+  {
+    m_channel[i].prev_value = value[i];
+  }
+}
+
+uint8_t ecg_edr_get_rate(void)
+{
+  return m_channel[ecg_edr_get_feature()].rate;
+}
+
+ecg_edr_feature_t ecg_edr_get_feature(void)
+{
+  ecg_edr_feature_t best = ECG_EDR_FEATURE_R_AMPLITUDE;
+
+  // Prefer a feature with a rate, then the one with the deepest relative modulation
+  for (uint8_t i = 1; i < ECG_EDR_FEATURE_MAX; i++)
+  {
+    m_edr_channel_t *p_ch   = &m_channel[i];
+    m_edr_channel_t *p_best = &m_channel[best];
+
+    if (((p_ch->rate != 0) && (p_best->rate == 0)) ||
+        (((p_ch->rate != 0) == (p_best->rate != 0)) && (p_ch->power > p_best->power)))
+    {
+      best = (ecg_edr_feature_t)i;
+    }
+  }
+
+  return best;
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Design a 2nd order Butterworth biquad at the resampled rate (bilinear transform)
+ *
+ * @param[in]     p_biquad      Pointer to coefficients
+ * @param[in]     cutoff        Cut-off frequency (Hz)
+ * @param[in]     high_pass     true for a high-pass, false for a low-pass
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ecg_edr_biquad_design(m_edr_biquad_t *p_biquad, float cutoff, bool high_pass)
+{
+  float w0    = 2.0f * ECG_EDR_PI * cutoff / (float)ECG_EDR_RESAMPLE_RATE;
+  float cs    = cosf(w0);
+  float alpha = sinf(w0) / (2.0f * ECG_EDR_BUTTERWORTH_Q);
+  float a0    = 1.0f + alpha;
+
+  if (high_pass)
+  {
+    p_biquad->b0 = ((1.0f + cs) / 2.0f) / a0;
+    p_biquad->b1 = -(1.0f + cs) / a0;
+  }
+  else
+  {
+    p_biquad->b0 = ((1.0f - cs) / 2.0f) / a0;
+    p_biquad->b1 = (1.0f - cs) / a0;
+  }
+
+  p_biquad->b2 = p_biquad->b0;
+  p_biquad->a1 = (-2.0f * cs) / a0;
+  p_biquad->a2 = (1.0f - alpha) / a0;
+}
+
+/**
+ * @brief         Run one sample through a biquad
+ *
+ * @param[in]     p_biquad      Pointer to coefficients
+ * @param[in]     z             Filter state
+ * @param[in]     x             Input sample
+ *
+ * @attention     None
+ *
+ * @return        Output sample
+ */
+static float m_ecg_edr_biquad_run(const m_edr_biquad_t *p_biquad, float *z, float x)
+{
+  float y = p_biquad->b0 * x + z[0];
+
+  z[0] = p_biquad->b1 * x - p_biquad->a1 * y + z[1];
+  z[1] = p_biquad->b2 * x - p_biquad->a2 * y;
+
+  return y;
+}
+
+/**
+ * @brief         Process one uniformly resampled feature value
+ *
+ * @param[in]     p_ch          Pointer to channel state
+ * @param[in]     value         Feature value
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ecg_edr_process(m_edr_channel_t *p_ch, float value)
+{
+  float x, y, hysteresis;
+
+  if (p_ch->mean <= 0.0f)
+    p_ch->mean = value;
+
+  p_ch->mean += (value - p_ch->mean) / (float)ECG_EDR_MEAN_TC;
+
+  // Relative modulation so that electrode contact does not change the scale
+  x = (p_ch->mean > 0.0f) ? ((value - p_ch->mean) / p_ch->mean) : 0.0f;
+  y = m_ecg_edr_biquad_run(&m_hp, p_ch->hp_z, x);
+  y = m_ecg_edr_biquad_run(&m_lp, p_ch->lp_z, y);
+
+  p_ch->power += (y * y - p_ch->power) / (float)ECG_EDR_POWER_TC;
+  hysteresis   = ECG_EDR_HYSTERESIS * sqrtf(p_ch->power);
+
+  if (p_ch->since_breath < ECG_EDR_TIMEOUT)
+    p_ch->since_breath++;
+
+  if (y < -hysteresis)
+  {
+    p_ch->armed = true;
+  }
+  else if (p_ch->armed && (y > hysteresis))
+  {
+    // Positive-going crossing, one breath
+    p_ch->armed = false;
+
+    if (p_ch->breath_seen &&
+        (p_ch->since_breath >= ECG_EDR_MIN_INTERVAL) && (p_ch->since_breath <= ECG_EDR_MAX_INTERVAL))
+    {
+      p_ch->intervals[p_ch->interval_idx] = p_ch->since_breath;
+      p_ch->interval_idx = (p_ch->interval_idx + 1) % ECG_EDR_RATE_INTERVALS;
+      if (p_ch->interval_count < ECG_EDR_RATE_INTERVALS)
+        p_ch->interval_count++;
+    }
+
+    p_ch->breath_seen  = true;
+    p_ch->since_breath = 0;
+  }
+
+  if (p_ch->since_breath >= ECG_EDR_TIMEOUT)
+  {
+    p_ch->breath_seen    = false;
+    p_ch->interval_count = 0;
+    p_ch->interval_idx   = 0;
+  }
+
+  if (p_ch->interval_count >= 2)
+  {
+    uint32_t sum = 0;
+
+    for (uint8_t i = 0; i < p_ch->interval_count; i++)
+      sum += p_ch->intervals[i];
+
+    p_ch->rate = (uint8_t)((60.0f * ECG_EDR_RESAMPLE_RATE * p_ch->interval_count) / (float)sum + 0.5f);
+  }
+  else
+  {
+    p_ch->rate = 0;
+  }
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,97 @@
+/**
+ * @file       ecg_edr.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      ECG-derived respiration (EDR) rate estimator
+ * @note       Fed with the beat stream of the QRS detector, no RESP modulation needed
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __ECG_EDR_H
+#define __ECG_EDR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include "ecg_res_algo.h"
+
+/* Public defines ----------------------------------------------------- */
+#define ECG_EDR_RESAMPLE_RATE       (4)       // Uniform rate of the beat feature series (Hz)
+#define ECG_EDR_HP_CUTOFF           (0.1f)    // Band-pass low edge (Hz), 6 breaths/min
+#define ECG_EDR_LP_CUTOFF           (0.6f)    // Band-pass high edge (Hz), 36 breaths/min
+#define ECG_EDR_RATE_INTERVALS      (4)       // Breath intervals averaged for the rate
+#define ECG_EDR_TIMEOUT_S           (15)      // Rate reported as 0 without a breath for this long
+#define ECG_EDR_MAX_GAP_S           (3)       // Beat gap that restarts the resampler
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief ECG EDR feature enum
+ */
+typedef enum
+{
+   ECG_EDR_FEATURE_R_AMPLITUDE     // Per-beat R-wave amplitude modulation
+  ,ECG_EDR_FEATURE_QRS_AREA        // Per-beat QRS area modulation
+  ,ECG_EDR_FEATURE_MAX
+}
+ecg_edr_feature_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         ECG EDR init
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ecg_edr_init(void);
+
+/**
+ * @brief         ECG EDR add one beat from the QRS detector
+ *
+ * @param[in]     beat          Beat reported by the QRS detector
+ *
+ * @attention     Matches QRS_Beat_Callback_t so it can be registered directly
+ *
+ * @return        None
+ */
+void ecg_edr_add_beat(const QRS_Beat_t *beat);
+
+/**
+ * @brief         ECG EDR get respiration rate
+ *
+ * @param[in]     None
+ *
+ * @attention     The rate of the feature with the strongest respiratory modulation is returned
+ *
+ * @return        Respiration rate (breaths/min), 0 if unknown
+ */
+uint8_t ecg_edr_get_rate(void);
+
+/**
+ * @brief         ECG EDR get the feature currently used for the rate
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Feature
+ */
+ecg_edr_feature_t ecg_edr_get_feature(void);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __ECG_EDR_H
+
+/* End of file -------------------------------------------------------- */
@@ -21,6 +21,14 @@ uint8_t Respiration_Rate = 0 ;
 
 volatile uint16_t QRS_Heart_Rate = 0 ;
 static uint16_t QRS_B4_Buffer_ptr = 0 ; /*   Variable which holds the threshold value to calculate the maxima */
+static uint32_t QRS_Sample_Counter = 0 ; /* Free-running sample counter used to time stamp beats */
+static uint32_t QRS_Sample_Tick = 0 ; /* Timebase tick of the sample passed next to QRS_Algorithm_Interface */
+static uint32_t QRS_Last_Beat_Sample = 0 ;
+static unsigned char QRS_Last_Beat_Valid = FALSE ;
+static QRS_Beat_t QRS_Pending_Beat ;
+static QRS_Beat_Callback_t QRS_Beat_Handler = NULL ;
+static int16_t QRS_Feature_Buf[QRS_FEATURE_WINDOW] ; /* Last filtered samples, the QRS complex lies inside when a beat is reported */
+static uint8_t QRS_Feature_Index = 0 ;
 int16_t RESP_WorkingBuff[2 * FILTERORDER];
 int16_t Pvev_DC_Sample=0, Pvev_Sample=0;
 int16_t QRS_Threshold_Old = 0;
@@ -138,11 +146,56 @@ void ECG_ProcessCurrSample(int16_t *CurrAqsSample, int16_t *FilteredOut)
   return ;
 }
 
+void QRS_Register_Beat_Callback(QRS_Beat_Callback_t callback)
+{
+  QRS_Beat_Handler = callback;
+}
+
+void QRS_Set_Sample_Tick(uint32_t tick)
+{
+  QRS_Sample_Tick = tick;
+}
+
+static void QRS_Beat_Features(QRS_Beat_t *beat)
+{
+  int16_t i;
+  int16_t Max = -32768;
+  int16_t Min = 32767;
+  long Sum = 0;
+  long Area = 0;
+
+  /*
+    The smoothed derivative crosses the threshold a few samples after the R wave
+    and the beat is reported MAXIMA_SEARCH_WINDOW samples later, so the whole
+    complex is inside the last QRS_FEATURE_WINDOW filtered samples
+  */
+  for ( i = 0; i < QRS_FEATURE_WINDOW; i++ )
+  {
+    if ( QRS_Feature_Buf[i] > Max ) Max = QRS_Feature_Buf[i];
+    if ( QRS_Feature_Buf[i] < Min ) Min = QRS_Feature_Buf[i];
+    Sum += QRS_Feature_Buf[i];
+  }
+
+  Sum = Sum / QRS_FEATURE_WINDOW;
+
+  for ( i = 0; i < QRS_FEATURE_WINDOW; i++ )
+  {
+    Area += (QRS_Feature_Buf[i] > Sum) ? (QRS_Feature_Buf[i] - Sum) : (Sum - QRS_Feature_Buf[i]);
+  }
+
+  Area = Area >> 4;
+  beat->r_amplitude = (uint16_t)((int32_t)Max - Min);
+  beat->qrs_area    = (Area > 0xFFFF) ? 0xFFFF : (uint16_t)Area;
+}
+
 void QRS_Algorithm_Interface(int16_t CurrSample,volatile uint8_t *Heart_rate)
 {
   static int16_t prev_data[32] = {0};
   int16_t i;
   long Mac = 0;
+  QRS_Sample_Counter++;
+  QRS_Feature_Buf[QRS_Feature_Index] = CurrSample;
+  QRS_Feature_Index = (QRS_Feature_Index + 1) % QRS_FEATURE_WINDOW;
   prev_data[0] = CurrSample;
   
   for ( i = 31; i > 0; i--)
@@ -239,6 +292,12 @@ void QRS_check_sample_crossing_threshold( uint16_t scaled_result,volatile uint8_
       maxima_search = 0 ;
       threshold_crossed = FALSE ;
       peak_detected = TRUE ;
+
+      if (QRS_Beat_Handler != NULL)
+      {
+        QRS_Beat_Features(&QRS_Pending_Beat);
+        QRS_Beat_Handler(&QRS_Pending_Beat);
+      }
     }
     
   }else if ( TRUE == peak_detected ){
@@ -305,6 +364,13 @@ void QRS_check_sample_crossing_threshold( uint16_t scaled_result,volatile uint8_
     nopeak = 0;
     /*  storing sample index*/
     sample_index[ s_array_index ] = sample_count ;
+
+    /* Time stamp the beat against the free-running counter */
+    QRS_Pending_Beat.sample_index = QRS_Sample_Counter;
+    QRS_Pending_Beat.tick         = QRS_Sample_Tick;
+    QRS_Pending_Beat.rr_interval  = (QRS_Last_Beat_Valid == TRUE) ? (uint16_t)(QRS_Sample_Counter - QRS_Last_Beat_Sample) : 0;
+    QRS_Last_Beat_Sample = QRS_Sample_Counter;
+    QRS_Last_Beat_Valid  = TRUE;
    
     if ( s_array_index >= 1 )
     {
@@ -333,6 +399,7 @@ void QRS_check_sample_crossing_threshold( uint16_t scaled_result,volatile uint8_
       first_peak_detect = FALSE;
       nopeak = 0;
       QRS_Heart_Rate = 0;
+      QRS_Last_Beat_Valid = FALSE;
     }
   
   }else{
@@ -355,6 +422,7 @@ void QRS_check_sample_crossing_threshold( uint16_t scaled_result,volatile uint8_
       first_peak_detect = FALSE;
       nopeak = 0;
       QRS_Heart_Rate = 0;
+      QRS_Last_Beat_Valid = FALSE;
     }
   }
 
@@ -18,11 +18,26 @@
 #define QRS_THRESHOLD_FRACTION    0.4
 #define TRUE 1
 #define FALSE 0
+#define QRS_FEATURE_WINDOW        48    /* Filtered samples kept for the beat morphology features */
+
+// Beat reported by the QRS detector once its maxima search window has closed
+typedef struct
+{
+  uint32_t sample_index;    // Free-running sample counter at the threshold crossing
+  uint32_t tick;            // Timebase tick of the sample at the threshold crossing (bsp_time)
+  uint16_t rr_interval;     // Samples since the previous beat, 0 for the first beat after a reset
+  uint16_t r_amplitude;     // Peak-to-trough amplitude of the filtered ECG around the QRS
+  uint16_t qrs_area;        // Rectified area of the filtered ECG around the QRS (sum / 16)
+} QRS_Beat_t;
+
+typedef void (*QRS_Beat_Callback_t)(const QRS_Beat_t *beat);
 
 // Publish
 void ECG_FilterProcess(int16_t *WorkingBuff, int16_t *CoeffBuf, int16_t *FilterOut);
 void ECG_ProcessCurrSample(int16_t *CurrAqsSample, int16_t *FilteredOut);
 void QRS_Algorithm_Interface(int16_t CurrSample, volatile uint8_t *Heart_rate);
+void QRS_Register_Beat_Callback(QRS_Beat_Callback_t callback);
+void QRS_Set_Sample_Tick(uint32_t tick);
 void Resp_FilterProcess(int16_t *RESP_WorkingBuff, int16_t *CoeffBuf, int16_t *FilterOut);
 int16_t Resp_ProcessCurrSample(int16_t CurrAqsSample);
 void RESP_Algorithm_Interface(int16_t CurrSample, volatile uint8_t *RespirationRate);
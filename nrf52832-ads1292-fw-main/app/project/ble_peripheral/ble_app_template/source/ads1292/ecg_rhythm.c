@@ -0,0 +1,426 @@
+/**
+ * @file       ecg_rhythm.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      RR irregularity (atrial fibrillation) detector with event snapshots
+ * @note       Screening uses the combined nRMSSD / Shannon entropy / turning point
+ *             ratio rule over a sliding window of RR intervals
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "ecg_rhythm.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+#define ECG_RHYTHM_TRIMMED_BEATS        (ECG_RHYTHM_WINDOW_BEATS - 2 * ECG_RHYTHM_TRIM_BEATS)
+#define ECG_RHYTHM_LOG2_HIST_BINS_Q12   (4 * 4096)                // log2(ECG_RHYTHM_HIST_BINS) in Q12
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+// log2(n) in Q12 for n = 0..64 (log2(0) is unused and set to 0)
+static const uint16_t m_log2_q12[ECG_RHYTHM_WINDOW_BEATS + 1] =
+{
+      0,     0,  4096,  6492,  8192,  9511, 10588, 11499,
+  12288, 12984, 13607, 14170, 14684, 15157, 15595, 16003,
+  16384, 16742, 17080, 17400, 17703, 17991, 18266, 18529,
+  18780, 19021, 19253, 19476, 19691, 19898, 20099, 20292,
+  20480, 20662, 20838, 21010, 21176, 21338, 21496, 21649,
+  21799, 21945, 22087, 22226, 22362, 22495, 22625, 22752,
+  22876, 22998, 23117, 23234, 23349, 23462, 23572, 23680,
+  23787, 23892, 23994, 24095, 24195, 24292, 24388, 24483,
+  24576
+};
+
+static uint16_t m_rr_window[ECG_RHYTHM_WINDOW_BEATS];             // RR intervals (ms), circular
+static uint8_t  m_rr_head;                                        // Next write position
+static uint8_t  m_rr_count;                                       // Valid RR intervals in the window
+static uint8_t  m_rr_stride;                                      // Beats since the last evaluation
+
+static bool     m_episode_active;
+static uint8_t  m_irregular_run;
+static uint8_t  m_regular_run;
+static uint16_t m_episode_beats;
+static uint16_t m_event_sequence;
+
+static ecg_rhythm_event_t m_event_queue[ECG_RHYTHM_EVENT_QUEUE_SIZE];
+static uint8_t  m_event_head;
+static uint8_t  m_event_count;
+
+static int16_t  m_snapshot[ECG_RHYTHM_SNAPSHOT_SIZE];
+static uint16_t m_snapshot_head;
+static uint16_t m_snapshot_post_left;
+static uint16_t m_snapshot_sequence;
+static bool     m_snapshot_pending;                               // Captured for an irregular run not confirmed yet
+static bool     m_snapshot_held;                                  // Captured, frozen until the run is confirmed
+static volatile ecg_rhythm_snapshot_state_t m_snapshot_state;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_ecg_rhythm_evaluate(const QRS_Beat_t *beat);
+static void m_ecg_rhythm_compute(ecg_rhythm_metrics_t *p_metrics);
+static void m_ecg_rhythm_push_event(ecg_rhythm_evt_type_t type, const QRS_Beat_t *beat, const ecg_rhythm_metrics_t *p_metrics);
+static uint32_t m_ecg_rhythm_isqrt(uint32_t value);
+
+/* Function definitions ----------------------------------------------- */
+void ecg_rhythm_init(void)
+{
+  m_rr_head        = 0;
+  m_rr_count       = 0;
+  m_rr_stride      = 0;
+  m_episode_active = false;
+  m_irregular_run  = 0;
+  m_regular_run    = 0;
+  m_episode_beats  = 0;
+  m_event_head     = 0;
+  m_event_count    = 0;
+
+  m_snapshot_head      = 0;
+  m_snapshot_post_left = 0;
+  m_snapshot_pending   = false;
+  m_snapshot_held      = false;
+  m_snapshot_state     = ECG_RHYTHM_SNAPSHOT_IDLE;
+}
+
+void ecg_rhythm_add_sample(int16_t sample)
+{
+  if ((m_snapshot_state == ECG_RHYTHM_SNAPSHOT_READY) || m_snapshot_held)
+    return;
+
+  m_snapshot[m_snapshot_head++] = sample;
+  if (m_snapshot_head >= ECG_RHYTHM_SNAPSHOT_SIZE)
+    m_snapshot_head = 0;
+
+  if (m_snapshot_state == ECG_RHYTHM_SNAPSHOT_CAPTURE)
+  {
+    if (--m_snapshot_post_left == 0)
+    {
+      if (m_snapshot_pending)
+        m_snapshot_held = true;
+      else
+        m_snapshot_state = ECG_RHYTHM_SNAPSHOT_READY;
+    }
+  }
+}
+
+void ecg_rhythm_add_beat(const QRS_Beat_t *beat)
+{
+  uint32_t rr_ms;
+
+  // First beat after a detector reset has no RR interval
+  if (beat->rr_interval == 0)
+    return;
+
+  rr_ms = ((uint32_t)beat->rr_interval * 1000) / SAMPLING_RATE;
+  if ((rr_ms < ECG_RHYTHM_RR_MIN_MS) || (rr_ms > ECG_RHYTHM_RR_MAX_MS))
+    return;
+
+  m_rr_window[m_rr_head] = (uint16_t)rr_ms;
+  m_rr_head = (m_rr_head + 1) % ECG_RHYTHM_WINDOW_BEATS;
+
+  if (m_rr_count < ECG_RHYTHM_WINDOW_BEATS)
+    m_rr_count++;
+
+  if (m_episode_active)
+    m_episode_beats++;
+
+  if (++m_rr_stride < ECG_RHYTHM_EVAL_STRIDE)
+    return;
+
+  m_rr_stride = 0;
+
+  if (m_rr_count == ECG_RHYTHM_WINDOW_BEATS)
+    m_ecg_rhythm_evaluate(beat);
+}
+
+bool ecg_rhythm_get_event(ecg_rhythm_event_t *p_event)
+{
+  uint8_t tail;
+
+  if (m_event_count == 0)
+    return false;
+
+  tail = (m_event_head + ECG_RHYTHM_EVENT_QUEUE_SIZE - m_event_count) % ECG_RHYTHM_EVENT_QUEUE_SIZE;
+  *p_event = m_event_queue[tail];
+  m_event_count--;
+
+  return true;
+}
+
+uint8_t ecg_rhythm_event_encode(const ecg_rhythm_event_t *p_event, uint8_t *p_buf)
+{
+  uint8_t len = 0;
+
+  p_buf[len++] = (uint8_t)p_event->type;
+  len += uint16_encode(p_event->sequence, &p_buf[len]);
+  len += uint32_encode(p_event->sample_index, &p_buf[len]);
+  len += uint16_encode(p_event->beats, &p_buf[len]);
+  p_buf[len++] = p_event->heart_rate;
+  len += uint16_encode(p_event->metrics.nrmssd, &p_buf[len]);
+  len += uint16_encode(p_event->metrics.entropy, &p_buf[len]);
+  len += uint16_encode(p_event->metrics.tpr, &p_buf[len]);
+  len += uint32_encode(p_event->tick, &p_buf[len]);
+
+  return len;
+}
+
+ecg_rhythm_snapshot_state_t ecg_rhythm_snapshot_state(uint16_t *p_sequence)
+{
+  if (p_sequence != NULL)
+    *p_sequence = m_snapshot_sequence;
+
+  return m_snapshot_state;
+}
+
+uint16_t ecg_rhythm_snapshot_read(uint16_t offset, int16_t *p_data, uint16_t count)
+{
+  uint16_t index;
+  uint16_t i;
+
+  if ((m_snapshot_state != ECG_RHYTHM_SNAPSHOT_READY) || (offset >= ECG_RHYTHM_SNAPSHOT_SIZE))
+    return 0;
+
+  if (count > ECG_RHYTHM_SNAPSHOT_SIZE - offset)
+    count = ECG_RHYTHM_SNAPSHOT_SIZE - offset;
+
+  // The ring is full when frozen, so the oldest sample sits at the write position
+  index = (m_snapshot_head + offset) % ECG_RHYTHM_SNAPSHOT_SIZE;
+  for (i = 0; i < count; i++)
+  {
+    p_data[i] = m_snapshot[index++];
+    if (index >= ECG_RHYTHM_SNAPSHOT_SIZE)
+      index = 0;
+  }
+
+  return count;
+}
+
+void ecg_rhythm_snapshot_release(void)
+{
+  m_snapshot_state = ECG_RHYTHM_SNAPSHOT_IDLE;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Evaluate the window and run the episode state machine
+ *
+ * @param[in]     beat          Last beat
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ecg_rhythm_evaluate(const QRS_Beat_t *beat)
+{
+  ecg_rhythm_metrics_t metrics;
+  bool irregular;
+
+  m_ecg_rhythm_compute(&metrics);
+
+  irregular = (metrics.nrmssd > ECG_RHYTHM_NRMSSD_THRESHOLD) &&
+              (metrics.entropy > ECG_RHYTHM_ENTROPY_THRESHOLD) &&
+              (metrics.tpr >= ECG_RHYTHM_TPR_MIN) && (metrics.tpr <= ECG_RHYTHM_TPR_MAX);
+
+  if (irregular)
+  {
+    m_regular_run = 0;
+    if (!m_episode_active)
+      m_irregular_run++;
+
+    // The run starts tens of seconds before the episode opens, the onset is captured from here
+    if ((m_irregular_run == 1) && (m_snapshot_state == ECG_RHYTHM_SNAPSHOT_IDLE))
+    {
+      m_snapshot_post_left = ECG_RHYTHM_SNAPSHOT_POST;
+      m_snapshot_pending   = true;
+      m_snapshot_held      = false;
+      m_snapshot_state     = ECG_RHYTHM_SNAPSHOT_CAPTURE;
+    }
+
+    if (!m_episode_active && (m_irregular_run >= ECG_RHYTHM_ONSET_COUNT))
+    {
+      m_episode_active = true;
+      m_episode_beats  = ECG_RHYTHM_WINDOW_BEATS;
+      m_ecg_rhythm_push_event(ECG_RHYTHM_EVT_IRREGULAR_ONSET, beat, &metrics);
+
+      // The snapshot of the run goes out with the onset event
+      if (m_snapshot_pending)
+      {
+        m_snapshot_sequence = m_event_sequence - 1;
+        m_snapshot_pending  = false;
+        if (m_snapshot_held)
+        {
+          m_snapshot_held  = false;
+          m_snapshot_state = ECG_RHYTHM_SNAPSHOT_READY;
+        }
+      }
+    }
+  }
+  else
+  {
+    m_irregular_run = 0;
+
+    // The run broke before an episode opened, the snapshot is dropped
+    if (m_snapshot_pending)
+    {
+      m_snapshot_pending = false;
+      m_snapshot_held    = false;
+      m_snapshot_state   = ECG_RHYTHM_SNAPSHOT_IDLE;
+    }
+
+    if (m_episode_active && (++m_regular_run >= ECG_RHYTHM_OFFSET_COUNT))
+    {
+      m_episode_active = false;
+      m_ecg_rhythm_push_event(ECG_RHYTHM_EVT_IRREGULAR_OFFSET, beat, &metrics);
+    }
+  }
+}
+
+/**
+ * @brief         Compute the irregularity metrics of the RR window
+ *
+ * @param[out]    p_metrics     Pointer to metrics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ecg_rhythm_compute(ecg_rhythm_metrics_t *p_metrics)
+{
+  uint16_t sorted[ECG_RHYTHM_WINDOW_BEATS];
+  uint8_t  hist[ECG_RHYTHM_HIST_BINS];
+  uint16_t rr[ECG_RHYTHM_WINDOW_BEATS];
+  uint16_t lo, hi, bin_width, value;
+  uint32_t sum = 0, sum_sq = 0, n_log_n = 0;
+  uint16_t diff_count = 0, turning = 0;
+  uint32_t rmssd, entropy_q12;
+  int32_t  diff, d1, d2;
+  uint8_t  i, j;
+
+  // Chronological copy of the window
+  for (i = 0; i < ECG_RHYTHM_WINDOW_BEATS; i++)
+    rr[i] = m_rr_window[(m_rr_head + i) % ECG_RHYTHM_WINDOW_BEATS];
+
+  // Insertion sort to find the outlier bounds
+  for (i = 0; i < ECG_RHYTHM_WINDOW_BEATS; i++)
+  {
+    value = rr[i];
+    for (j = i; (j > 0) && (sorted[j - 1] > value); j--)
+      sorted[j] = sorted[j - 1];
+    sorted[j] = value;
+  }
+
+  lo = sorted[ECG_RHYTHM_TRIM_BEATS];
+  hi = sorted[ECG_RHYTHM_WINDOW_BEATS - 1 - ECG_RHYTHM_TRIM_BEATS];
+
+  for (i = ECG_RHYTHM_TRIM_BEATS; i < ECG_RHYTHM_WINDOW_BEATS - ECG_RHYTHM_TRIM_BEATS; i++)
+    sum += sorted[i];
+
+  p_metrics->mean_rr_ms = (uint16_t)(sum / ECG_RHYTHM_TRIMMED_BEATS);
+
+  // RMSSD over successive pairs inside the trimmed range
+  for (i = 1; i < ECG_RHYTHM_WINDOW_BEATS; i++)
+  {
+    if ((rr[i] < lo) || (rr[i] > hi) || (rr[i - 1] < lo) || (rr[i - 1] > hi))
+      continue;
+
+    diff    = (int32_t)rr[i] - (int32_t)rr[i - 1];
+    sum_sq += (uint32_t)(diff * diff);
+    diff_count++;
+  }
+
+  rmssd = (diff_count != 0) ? m_ecg_rhythm_isqrt(sum_sq / diff_count) : 0;
+  p_metrics->nrmssd = (uint16_t)((rmssd * 1000) / p_metrics->mean_rr_ms);
+
+  // Shannon entropy of the trimmed RR histogram: H = log2(n) - sum(c * log2(c)) / n
+  memset(hist, 0, sizeof(hist));
+  bin_width = (uint16_t)((hi - lo) / ECG_RHYTHM_HIST_BINS + 1);
+  for (i = ECG_RHYTHM_TRIM_BEATS; i < ECG_RHYTHM_WINDOW_BEATS - ECG_RHYTHM_TRIM_BEATS; i++)
+    hist[(sorted[i] - lo) / bin_width]++;
+
+  for (i = 0; i < ECG_RHYTHM_HIST_BINS; i++)
+    n_log_n += (uint32_t)hist[i] * m_log2_q12[hist[i]];
+
+  n_log_n    /= ECG_RHYTHM_TRIMMED_BEATS;
+  entropy_q12 = (n_log_n < m_log2_q12[ECG_RHYTHM_TRIMMED_BEATS]) ? (m_log2_q12[ECG_RHYTHM_TRIMMED_BEATS] - n_log_n) : 0;
+  p_metrics->entropy = (uint16_t)((entropy_q12 * 1000) / ECG_RHYTHM_LOG2_HIST_BINS_Q12);
+
+  // Turning point ratio over the untrimmed series
+  for (i = 1; i < ECG_RHYTHM_WINDOW_BEATS - 1; i++)
+  {
+    d1 = (int32_t)rr[i] - (int32_t)rr[i - 1];
+    d2 = (int32_t)rr[i + 1] - (int32_t)rr[i];
+    if (((d1 > 0) && (d2 < 0)) || ((d1 < 0) && (d2 > 0)))
+      turning++;
+  }
+
+  p_metrics->tpr = (uint16_t)(((uint32_t)turning * 1000) / (ECG_RHYTHM_WINDOW_BEATS - 2));
+}
+
+/**
+ * @brief         Queue an event record, the oldest record is dropped when full
+ *
+ * @param[in]     type          Event type
+ * @param[in]     beat          Last beat
+ * @param[in]     p_metrics     Metrics of the window
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ecg_rhythm_push_event(ecg_rhythm_evt_type_t type, const QRS_Beat_t *beat, const ecg_rhythm_metrics_t *p_metrics)
+{
+  ecg_rhythm_event_t *p_event = &m_event_queue[m_event_head];
+
+  p_event->type         = type;
+  p_event->sequence     = m_event_sequence++;
+  p_event->sample_index = beat->sample_index;
+  p_event->tick         = beat->tick;
+  p_event->beats        = (type == ECG_RHYTHM_EVT_IRREGULAR_OFFSET) ? m_episode_beats : 0;
+  p_event->heart_rate   = (uint8_t)(60000 / p_metrics->mean_rr_ms);
+  p_event->metrics      = *p_metrics;
+
+  m_event_head = (m_event_head + 1) % ECG_RHYTHM_EVENT_QUEUE_SIZE;
+  if (m_event_count < ECG_RHYTHM_EVENT_QUEUE_SIZE)
+    m_event_count++;
+}
+
+/**
+ * @brief         Integer square root
+ *
+ * @param[in]     value         Input value
+ *
+ * @attention     None
+ *
+ * @return        floor(sqrt(value))
+ */
+static uint32_t m_ecg_rhythm_isqrt(uint32_t value)
+{
+  uint32_t root = 0;
+  uint32_t bit  = 1UL << 30;
+
+  while (bit > value)
+    bit >>= 2;
+
+  while (bit != 0)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root   = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return root;
+}
+
+/* End of file -------------------------------------------------------- */
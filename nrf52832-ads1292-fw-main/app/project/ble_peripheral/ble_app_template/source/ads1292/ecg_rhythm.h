@@ -0,0 +1,199 @@
+/**
+ * @file       ecg_rhythm.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      RR irregularity (atrial fibrillation) detector with event snapshots
+ * @note       Fed with the beat stream of the QRS detector and the filtered ECG
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __ECG_RHYTHM_H
+#define __ECG_RHYTHM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include "ecg_res_algo.h"
+
+/* Public defines ----------------------------------------------------- */
+#define ECG_RHYTHM_WINDOW_BEATS         (64)                      // Beats in the sliding analysis window
+#define ECG_RHYTHM_EVAL_STRIDE          (8)                       // Beats between two evaluations of the window
+#define ECG_RHYTHM_HIST_BINS            (16)                      // Bins of the RR histogram for the Shannon entropy
+#define ECG_RHYTHM_TRIM_BEATS           (4)                       // Shortest/longest RR removed as outliers
+#define ECG_RHYTHM_ONSET_COUNT          (3)                       // Irregular evaluations in a row to open an episode
+#define ECG_RHYTHM_OFFSET_COUNT         (3)                       // Regular evaluations in a row to close an episode
+
+#define ECG_RHYTHM_NRMSSD_THRESHOLD     (100)                     // Normalized RMSSD threshold (per mille)
+#define ECG_RHYTHM_ENTROPY_THRESHOLD    (700)                     // Normalized Shannon entropy threshold (per mille)
+#define ECG_RHYTHM_TPR_MIN              (540)                     // Turning point ratio lower bound (per mille)
+#define ECG_RHYTHM_TPR_MAX              (770)                     // Turning point ratio upper bound (per mille)
+
+#define ECG_RHYTHM_RR_MIN_MS            (250)                     // RR intervals outside this range are discarded
+#define ECG_RHYTHM_RR_MAX_MS            (2000)
+
+#define ECG_RHYTHM_SNAPSHOT_PRE         (8 * SAMPLING_RATE)       // Samples kept before the first irregular evaluation of the run
+#define ECG_RHYTHM_SNAPSHOT_POST        (4 * SAMPLING_RATE)       // Samples captured after it
+#define ECG_RHYTHM_SNAPSHOT_SIZE        (ECG_RHYTHM_SNAPSHOT_PRE + ECG_RHYTHM_SNAPSHOT_POST)
+
+#define ECG_RHYTHM_EVENT_QUEUE_SIZE     (4)
+#define ECG_RHYTHM_EVENT_ENCODED_SIZE   (20)                      // Size of an encoded event record (bytes)
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief ECG rhythm event type enum
+ */
+typedef enum
+{
+   ECG_RHYTHM_EVT_IRREGULAR_ONSET  = 0x01
+  ,ECG_RHYTHM_EVT_IRREGULAR_OFFSET = 0x02
+}
+ecg_rhythm_evt_type_t;
+
+/**
+ * @brief ECG rhythm metrics structure
+ */
+typedef struct
+{
+  uint16_t mean_rr_ms;    // Mean RR interval of the window
+  uint16_t nrmssd;        // Normalized RMSSD (per mille)
+  uint16_t entropy;       // Shannon entropy normalized to the bin count (per mille)
+  uint16_t tpr;           // Turning point ratio (per mille)
+}
+ecg_rhythm_metrics_t;
+
+/**
+ * @brief ECG rhythm event record structure
+ */
+typedef struct
+{
+  ecg_rhythm_evt_type_t type;
+  uint16_t              sequence;       // Rolling event number
+  uint32_t              sample_index;   // QRS sample counter of the beat closing the window
+  uint16_t              beats;          // Episode length in beats (offset events only)
+  uint8_t               heart_rate;     // Mean heart rate of the window (bpm)
+  ecg_rhythm_metrics_t  metrics;
+  uint32_t              tick;           // Timebase tick of the beat closing the window (bsp_time)
+}
+ecg_rhythm_event_t;
+
+/**
+ * @brief ECG rhythm snapshot state enum
+ */
+typedef enum
+{
+   ECG_RHYTHM_SNAPSHOT_IDLE      // Ring buffer is recording, no event pending
+  ,ECG_RHYTHM_SNAPSHOT_CAPTURE   // Irregular run started, recording the post-event samples until the onset event
+  ,ECG_RHYTHM_SNAPSHOT_READY     // Ring buffer frozen, waiting to be read out
+}
+ecg_rhythm_snapshot_state_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         ECG rhythm detector init
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ecg_rhythm_init(void);
+
+/**
+ * @brief         ECG rhythm add one filtered ECG sample to the snapshot ring buffer
+ *
+ * @param[in]     sample        Filtered ECG sample
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ecg_rhythm_add_sample(int16_t sample);
+
+/**
+ * @brief         ECG rhythm add one beat from the QRS detector
+ *
+ * @param[in]     beat          Beat reported by the QRS detector
+ *
+ * @attention     Matches QRS_Beat_Callback_t so it can be registered directly
+ *
+ * @return        None
+ */
+void ecg_rhythm_add_beat(const QRS_Beat_t *beat);
+
+/**
+ * @brief         ECG rhythm get the pending event
+ *
+ * @param[out]    p_event       Pointer to event record
+ *
+ * @attention     None
+ *
+ * @return
+ * - true       An event was removed from the queue
+ * - false      No event pending
+ */
+bool ecg_rhythm_get_event(ecg_rhythm_event_t *p_event);
+
+/**
+ * @brief         ECG rhythm encode an event record (little endian)
+ *
+ * @param[in]     p_event       Pointer to event record
+ * @param[out]    p_buf         Output buffer, at least ECG_RHYTHM_EVENT_ENCODED_SIZE bytes
+ *
+ * @attention     None
+ *
+ * @return        Encoded length
+ */
+uint8_t ecg_rhythm_event_encode(const ecg_rhythm_event_t *p_event, uint8_t *p_buf);
+
+/**
+ * @brief         ECG rhythm get snapshot state
+ *
+ * @param[out]    p_sequence    Sequence of the event that triggered the snapshot (may be NULL)
+ *
+ * @attention     None
+ *
+ * @return        Snapshot state
+ */
+ecg_rhythm_snapshot_state_t ecg_rhythm_snapshot_state(uint16_t *p_sequence);
+
+/**
+ * @brief         ECG rhythm read samples of a frozen snapshot in chronological order
+ *
+ * @param[in]     offset        First sample to read (0 is the oldest pre-event sample, the event is the first
+ *                              irregular evaluation of the run that opened the episode)
+ * @param[out]    p_data        Output samples
+ * @param[in]     count         Max number of samples to read
+ *
+ * @attention     Only valid in ECG_RHYTHM_SNAPSHOT_READY state
+ *
+ * @return        Number of samples read
+ */
+uint16_t ecg_rhythm_snapshot_read(uint16_t offset, int16_t *p_data, uint16_t count);
+
+/**
+ * @brief         ECG rhythm release the snapshot and resume recording
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ecg_rhythm_snapshot_release(void);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __ECG_RHYTHM_H
+
+/* End of file -------------------------------------------------------- */
@@ -81,7 +81,7 @@ uint32_t ble_acs_init(ble_acs_t *p_acs, ble_acs_init_t const *p_acs_init)
   return m_ble_acs_add_char(p_acs, p_acs_init, BLE_ACS_AXIS_Z_CHAR);
 }
 
-ret_code_t ble_acs_acc_update(ble_acs_t *p_acs, uint16_t acc, uint16_t conn_handle, ble_acs_charaterictic_t charac)
+ret_code_t ble_acs_acc_update(ble_acs_t *p_acs, int16_t acc, uint16_t conn_handle, ble_acs_charaterictic_t charac)
 {
   ret_code_t err_code;
 
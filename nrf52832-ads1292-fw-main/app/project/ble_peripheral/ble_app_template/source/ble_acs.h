@@ -131,14 +131,14 @@ uint32_t ble_acs_init(ble_acs_t *p_acs, ble_acs_init_t const *p_acs_init);
  * @brief                        Function for updating the Accelerometer level.
  *
  * @param[in]     p_bas          Accelerometer Service structure.
- * @param[in]     acc            New Accelerometer measurement value
+ * @param[in]     acc            New Accelerometer measurement value (mg, signed)
  * @param[in]     conn_handle    Connection handle.
  * 
  * @attention     None
  *
  * @return        None
  */
-ret_code_t ble_acs_acc_update(ble_acs_t *p_acs, uint16_t acc, uint16_t conn_handle, ble_acs_charaterictic_t charac);
+ret_code_t ble_acs_acc_update(ble_acs_t *p_acs, int16_t acc, uint16_t conn_handle, ble_acs_charaterictic_t charac);
 
 /**
  * @brief                     Function for handling the Nordic Accelerometer Service's BLE events.
@@ -0,0 +1,323 @@
+/**
+ * @file       ble_cps.c
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      CPS (BLE Control Point Service)
+ * @note       None
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "sdk_common.h"
+#include "ble.h"
+#include "ble_cps.h"
+#include "ble_srv_common.h"
+#include "nrf_log.h"
+
+/* Private defines ---------------------------------------------------- */
+#define BLE_UUID_CPS_CONTROL_POINT_CHARACTERISTIC   0x7235
+
+#define CPS_BASE_UUID                                                                                \
+  {                                                                                                  \
+    {                                                                                                \
+      0x41, 0xEE, 0x68, 0x3A, 0x99, 0x0F, 0x0E, 0x72, 0x85, 0x49, 0x8D, 0xB3, 0x00, 0x00, 0x00, 0x00 \
+    }                                                                                                \
+  } /**< Used vendor specific UUID. */
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+/* Private function prototypes ---------------------------------------- */
+static void m_ble_cps_on_connect(ble_cps_t *p_cps, ble_evt_t const *p_ble_evt);
+static void m_ble_cps_on_rw_authorize_request(ble_cps_t *p_cps, ble_evt_t const *p_ble_evt);
+static uint16_t m_ble_cps_link_check(ble_cps_t *p_cps, uint16_t conn_handle);
+
+/* Function definitions ----------------------------------------------- */
+uint32_t ble_cps_init(ble_cps_t *p_cps, ble_cps_init_t const *p_cps_init)
+{
+  ret_code_t            err_code;
+  ble_uuid_t            ble_uuid;
+  ble_uuid128_t         cps_base_uuid = CPS_BASE_UUID;
+  ble_add_char_params_t add_char_params;
+
+  VERIFY_PARAM_NOT_NULL(p_cps);
+  VERIFY_PARAM_NOT_NULL(p_cps_init);
+
+  // Initialize the service structure.
+  p_cps->state       = BLE_CPS_STATE_IDLE;
+  p_cps->conn_handle = BLE_CONN_HANDLE_INVALID;
+  p_cps->cmd_len     = 0;
+
+  // Add a custom base UUID.
+  err_code = sd_ble_uuid_vs_add(&cps_base_uuid, &p_cps->uuid_type);
+  VERIFY_SUCCESS(err_code);
+
+  ble_uuid.type = p_cps->uuid_type;
+  ble_uuid.uuid = BLE_UUID_CPS_SERVICE;
+
+  // Add the service.
+  err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &p_cps->service_handle);
+  VERIFY_SUCCESS(err_code);
+
+  // Add the Control Point Characteristic, the writes are authorized by the service.
+  memset(&add_char_params, 0, sizeof(add_char_params));
+  add_char_params.uuid                = BLE_UUID_CPS_CONTROL_POINT_CHARACTERISTIC;
+  add_char_params.uuid_type           = p_cps->uuid_type;
+  add_char_params.max_len             = BLE_CPS_MAX_LEN;
+  add_char_params.init_len            = 0;
+  add_char_params.is_var_len          = true;
+  add_char_params.is_defered_write    = true;
+  add_char_params.char_props.write    = 1;
+  add_char_params.char_props.indicate = 1;
+  add_char_params.write_access        = p_cps_init->wr_sec;
+  add_char_params.cccd_write_access   = p_cps_init->cccd_wr_sec;
+
+  return characteristic_add(p_cps->service_handle, &add_char_params, &p_cps->cp_handles);
+}
+
+bool ble_cps_command_get(ble_cps_t *p_cps, uint8_t *p_buf, uint16_t *p_len)
+{
+  if (p_cps->state != BLE_CPS_STATE_PENDING)
+    return false;
+
+  memcpy(p_buf, p_cps->cmd, p_cps->cmd_len);
+  *p_len       = p_cps->cmd_len;
+  p_cps->state = BLE_CPS_STATE_EXECUTING;
+
+  return true;
+}
+
+ret_code_t ble_cps_response_send(ble_cps_t *p_cps, const uint8_t *p_data, uint16_t len)
+{
+  ble_gatts_hvx_params_t hvx_params;
+  ret_code_t             err_code;
+
+  VERIFY_PARAM_NOT_NULL(p_cps);
+  VERIFY_PARAM_NOT_NULL(p_data);
+  VERIFY_TRUE(p_cps->state == BLE_CPS_STATE_EXECUTING, NRF_ERROR_INVALID_STATE);
+
+  memset(&hvx_params, 0, sizeof(hvx_params));
+
+  hvx_params.handle = p_cps->cp_handles.value_handle;
+  hvx_params.type   = BLE_GATT_HVX_INDICATION;
+  hvx_params.offset = 0;
+  hvx_params.p_len  = &len;
+  hvx_params.p_data = p_data;
+
+  // Set first, the confirmation may come before sd_ble_gatts_hvx() returns
+  p_cps->state = BLE_CPS_STATE_INDICATING;
+
+  err_code = (len <= BLE_CPS_MAX_LEN) ? sd_ble_gatts_hvx(p_cps->conn_handle, &hvx_params) : NRF_ERROR_INVALID_LENGTH;
+  if (err_code != NRF_SUCCESS)
+  {
+    NRF_LOG_DEBUG("Error: 0x%08X while indicating with conn_handle: 0x%04X", err_code, p_cps->conn_handle);
+    p_cps->state = BLE_CPS_STATE_IDLE;
+  }
+
+  return err_code;
+}
+
+uint16_t ble_cps_on_qwr_evt(ble_cps_t *p_cps, nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_evt_t *p_evt)
+{
+  uint16_t status;
+  uint16_t len = BLE_CPS_MAX_LEN;
+
+  if (p_evt->attr_handle != p_cps->cp_handles.value_handle)
+    return BLE_GATT_STATUS_SUCCESS;
+
+  switch (p_evt->evt_type)
+  {
+  case NRF_BLE_QWR_EVT_AUTH_REQUEST:
+    status = m_ble_cps_link_check(p_cps, p_qwr->conn_handle);
+    if (status != BLE_GATT_STATUS_SUCCESS)
+      return status;
+
+    // Only read while idle, the command buffer is not in use
+    if ((nrf_ble_qwr_value_get(p_qwr, p_evt->attr_handle, p_cps->cmd, &len) != NRF_SUCCESS) || (len == 0))
+      return BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+
+    p_cps->cmd_len = len;
+    break;
+
+  case NRF_BLE_QWR_EVT_EXECUTE_WRITE:
+    p_cps->conn_handle = p_qwr->conn_handle;
+    p_cps->state       = BLE_CPS_STATE_PENDING;
+    break;
+
+  default:
+    break;
+  }
+
+  return BLE_GATT_STATUS_SUCCESS;
+}
+
+void ble_cps_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+  if ((p_context == NULL) || (p_ble_evt == NULL))
+    return;
+
+  ble_cps_t *p_cps = (ble_cps_t *)p_context;
+
+  switch (p_ble_evt->header.evt_id)
+  {
+  case BLE_GAP_EVT_CONNECTED:
+    m_ble_cps_on_connect(p_cps, p_ble_evt);
+    break;
+
+  case BLE_GATTS_EVT_WRITE:
+  {
+    ble_gatts_evt_write_t const *p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+    ble_cps_client_context_t    *p_client;
+
+    if ((p_evt_write->handle == p_cps->cp_handles.cccd_handle) && (p_evt_write->len == 2) &&
+        (blcm_link_ctx_get(p_cps->p_link_ctx_storage, p_ble_evt->evt.gatts_evt.conn_handle,
+                           (void *)&p_client) == NRF_SUCCESS))
+      p_client->is_indication_enabled = ble_srv_is_indication_enabled(p_evt_write->data);
+  }
+  break;
+
+  case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+    m_ble_cps_on_rw_authorize_request(p_cps, p_ble_evt);
+    break;
+
+  case BLE_GATTS_EVT_HVC:
+    if ((p_ble_evt->evt.gatts_evt.params.hvc.handle == p_cps->cp_handles.value_handle) &&
+        (p_ble_evt->evt.gatts_evt.conn_handle == p_cps->conn_handle) &&
+        (p_cps->state == BLE_CPS_STATE_INDICATING))
+      p_cps->state = BLE_CPS_STATE_IDLE;
+    break;
+
+  case BLE_GATTS_EVT_TIMEOUT:
+  case BLE_GAP_EVT_DISCONNECTED:
+    // An unconfirmed response would keep the control point busy for the other links
+    if ((p_ble_evt->evt.common_evt.conn_handle == p_cps->conn_handle) &&
+        (p_cps->state == BLE_CPS_STATE_INDICATING))
+      p_cps->state = BLE_CPS_STATE_IDLE;
+    break;
+
+  default:
+    break;
+  }
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Function for setting the client context of a new link.
+ *
+ * @param[in]     p_cps        Control Point Service structure.
+ * @param[in]     p_ble_evt    Event received from the BLE stack.
+ *
+ * @attention     The CCCD of a bonded peer is restored by the SoftDevice before the connected
+ *                event, it is read back instead of assumed disabled
+ *
+ * @return        None
+ */
+static void m_ble_cps_on_connect(ble_cps_t *p_cps, ble_evt_t const *p_ble_evt)
+{
+  ble_cps_client_context_t *p_client;
+  ble_gatts_value_t         gatts_val;
+  uint8_t                   cccd_value[2];
+  uint16_t                  conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+  if (blcm_link_ctx_get(p_cps->p_link_ctx_storage, conn_handle, (void *)&p_client) != NRF_SUCCESS)
+  {
+    NRF_LOG_ERROR("Link context for 0x%02X connection handle could not be fetched.", conn_handle);
+    return;
+  }
+
+  p_client->is_indication_enabled = false;
+
+  memset(&gatts_val, 0, sizeof(gatts_val));
+  gatts_val.p_value = cccd_value;
+  gatts_val.len     = sizeof(cccd_value);
+  gatts_val.offset  = 0;
+
+  if (sd_ble_gatts_value_get(conn_handle, p_cps->cp_handles.cccd_handle, &gatts_val) == NRF_SUCCESS)
+  {
+    p_client->is_indication_enabled = ble_srv_is_indication_enabled(gatts_val.p_value);
+  }
+}
+
+/**
+ * @brief         Function for authorizing a single write of the control point.
+ *
+ * @param[in]     p_cps        Control Point Service structure.
+ * @param[in]     p_ble_evt    Event received from the BLE stack.
+ *
+ * @attention     The queued writes are authorized by nrf_ble_qwr, see ble_cps_on_qwr_evt()
+ *
+ * @return        None
+ */
+static void m_ble_cps_on_rw_authorize_request(ble_cps_t *p_cps, ble_evt_t const *p_ble_evt)
+{
+  ble_gatts_evt_rw_authorize_request_t const *p_auth_req  = &p_ble_evt->evt.gatts_evt.params.authorize_request;
+  ble_gatts_evt_write_t const                *p_evt_write = &p_auth_req->request.write;
+  ble_gatts_rw_authorize_reply_params_t       auth_reply;
+  uint16_t                                    conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+  ret_code_t                                  err_code;
+
+  if ((p_auth_req->type != BLE_GATTS_AUTHORIZE_TYPE_WRITE) ||
+      (p_evt_write->op != BLE_GATTS_OP_WRITE_REQ) ||
+      (p_evt_write->handle != p_cps->cp_handles.value_handle))
+    return;
+
+  memset(&auth_reply, 0, sizeof(auth_reply));
+  auth_reply.type                     = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+  auth_reply.params.write.gatt_status = m_ble_cps_link_check(p_cps, conn_handle);
+
+  if ((auth_reply.params.write.gatt_status == BLE_GATT_STATUS_SUCCESS) &&
+      ((p_evt_write->len == 0) || (p_evt_write->len > BLE_CPS_MAX_LEN)))
+    auth_reply.params.write.gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+
+  if (auth_reply.params.write.gatt_status == BLE_GATT_STATUS_SUCCESS)
+  {
+    auth_reply.params.write.update = 1;
+    auth_reply.params.write.offset = 0;
+    auth_reply.params.write.len    = p_evt_write->len;
+    auth_reply.params.write.p_data = p_evt_write->data;
+  }
+
+  err_code = sd_ble_gatts_rw_authorize_reply(conn_handle, &auth_reply);
+  if ((err_code != NRF_SUCCESS) || (auth_reply.params.write.gatt_status != BLE_GATT_STATUS_SUCCESS))
+  {
+    NRF_LOG_DEBUG("Command rejected: 0x%04X, error 0x%08X", auth_reply.params.write.gatt_status, err_code);
+    return;
+  }
+
+  memcpy(p_cps->cmd, p_evt_write->data, p_evt_write->len);
+  p_cps->cmd_len     = p_evt_write->len;
+  p_cps->conn_handle = conn_handle;
+  p_cps->state       = BLE_CPS_STATE_PENDING;
+}
+
+/**
+ * @brief         Function for checking that a link may write a command.
+ *
+ * @param[in]     p_cps        Control Point Service structure.
+ * @param[in]     conn_handle  Connection handle of the writer.
+ *
+ * @attention     None
+ *
+ * @return        BLE_GATT_STATUS_SUCCESS, otherwise the ATT error of the write
+ */
+static uint16_t m_ble_cps_link_check(ble_cps_t *p_cps, uint16_t conn_handle)
+{
+  ble_cps_client_context_t *p_client;
+
+  // One command at a time, over all links
+  if (p_cps->state != BLE_CPS_STATE_IDLE)
+    return BLE_GATT_STATUS_ATTERR_CPS_PROC_ALR_IN_PROG;
+
+  // The response could not be delivered
+  if ((blcm_link_ctx_get(p_cps->p_link_ctx_storage, conn_handle, (void *)&p_client) != NRF_SUCCESS) ||
+      !p_client->is_indication_enabled)
+    return BLE_GATT_STATUS_ATTERR_CPS_CCCD_CONFIG_ERROR;
+
+  return BLE_GATT_STATUS_SUCCESS;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,182 @@
+/**
+ * @file       ble_cps.h
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      CPS (BLE Control Point Service)
+ * @note       One write/indicate characteristic. A command is accepted only while no other
+ *             command is running and the writing link has enabled the indications, its response
+ *             is indicated to that link. Commands longer than the ATT MTU arrive as queued
+ *             writes through nrf_ble_qwr.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BLE_CPS_H
+#define __BLE_CPS_H
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_ble_qwr.h"
+#include "ble_link_ctx_manager.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BLE_UUID_CPS_SERVICE  (0x7234)                                  /**< The UUID of the Control Point Service. */
+#define BLE_CPS_MAX_LEN       (64)                                      /**< Maximum length of a command or a response. */
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Control Point command state
+ */
+typedef enum
+{
+  BLE_CPS_STATE_IDLE,         /**< Ready for a command */
+  BLE_CPS_STATE_PENDING,      /**< Command written, not taken by the application yet */
+  BLE_CPS_STATE_EXECUTING,    /**< Command taken by the application */
+  BLE_CPS_STATE_INDICATING    /**< Response indicated, waiting for the confirmation */
+}
+ble_cps_state_t;
+
+/**
+ * @brief Control Point Service client context, one per link.
+ */
+typedef struct
+{
+  bool is_indication_enabled;      /**< Indications of the control point enabled by the peer. */
+}
+ble_cps_client_context_t;
+
+/**
+ * @brief Control Point Service initialization structure.
+ */
+typedef struct
+{
+  security_req_t wr_sec;           /**< Security requirement for writing the control point. */
+  security_req_t cccd_wr_sec;      /**< Security requirement for writing the characteristic CCCD. */
+}
+ble_cps_init_t;
+
+/**
+ * @brief Control Point Service structure.
+ */
+typedef struct
+{
+  uint8_t                   uuid_type;               /**< UUID type for Control Point Service Base UUID. */
+  uint16_t                  service_handle;          /**< Handle of Control Point Service (as provided by the BLE stack). */
+  ble_gatts_char_handles_t  cp_handles;              /**< Handles related to the control point characteristic. */
+  volatile ble_cps_state_t  state;                   /**< Command state, changed by the BLE events and the application. */
+  uint16_t                  conn_handle;             /**< Link of the running command. */
+  uint8_t                   cmd[BLE_CPS_MAX_LEN];    /**< Command written by the peer. */
+  uint16_t                  cmd_len;                 /**< Length of the command. */
+  blcm_link_ctx_storage_t  *const p_link_ctx_storage; /**< Client contexts of the links. */
+}
+ble_cps_t;
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Macro for defining a ble_cps instance.
+ *
+ * @param[in]     _name         Name of the instance.
+ * @param[in]     _max_clients  Maximum number of links served at once.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+#define BLE_CPS_DEF(_name, _max_clients)                            \
+BLE_LINK_CTX_MANAGER_DEF(CONCAT_2(_name, _link_ctx_storage),        \
+                         (_max_clients),                            \
+                         sizeof(ble_cps_client_context_t));         \
+static ble_cps_t _name =                                            \
+{                                                                   \
+  .p_link_ctx_storage = &CONCAT_2(_name, _link_ctx_storage)         \
+};                                                                  \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                 \
+                     BLE_HRS_BLE_OBSERVER_PRIO,                     \
+                     ble_cps_on_ble_evt, &_name)
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief                     Function for initializing the Control Point Service.
+ *
+ * @param[in]     p_cps_init  Information needed to initialize the service.
+ *
+ * @param[out]    p_cps       Control Point Service structure. This structure must be supplied
+ *                            by the application. It is initialized by this function and will
+ *                            later be used to identify this particular service instance.
+ *
+ * @attention     The control point is a deferred write, the commands are checked before they
+ *                are accepted. Register cp_handles.value_handle with nrf_ble_qwr for long writes.
+ *
+ * @return
+ * - NRF_SUCCESS If the service was successfully initialized. Otherwise, an error code is returned.
+ * - NRF_ERROR_NULL If either of the pointers p_cps or p_cps_init is NULL.
+ */
+uint32_t ble_cps_init(ble_cps_t *p_cps, ble_cps_init_t const *p_cps_init);
+
+/**
+ * @brief                        Function for taking the command written by the peer.
+ *
+ * @param[in]     p_cps          Control Point Service structure.
+ * @param[out]    p_buf          Command, BLE_CPS_MAX_LEN bytes
+ * @param[out]    p_len          Command length
+ *
+ * @attention     The next command is rejected until the response is confirmed
+ *
+ * @return        true if a command was waiting
+ */
+bool ble_cps_command_get(ble_cps_t *p_cps, uint8_t *p_buf, uint16_t *p_len);
+
+/**
+ * @brief                        Function for indicating the response of the command taken.
+ *
+ * @param[in]     p_cps          Control Point Service structure.
+ * @param[in]     p_data         Response
+ * @param[in]     len            Response length, at most the negotiated ATT MTU - 3
+ *
+ * @attention     The control point is ready again once the peer confirms, or at once if the
+ *                response cannot be sent
+ *
+ * @return
+ * - NRF_SUCCESS on success
+ * - NRF_ERROR_INVALID_STATE if no command was taken
+ * - Otherwise an error code of sd_ble_gatts_hvx()
+ */
+ret_code_t ble_cps_response_send(ble_cps_t *p_cps, const uint8_t *p_data, uint16_t len);
+
+/**
+ * @brief                        Function for handling the queued write events of the control point.
+ *
+ * @param[in]     p_cps          Control Point Service structure.
+ * @param[in]     p_qwr          Queued Write instance of the link.
+ * @param[in]     p_evt          Queued Write event.
+ *
+ * @attention     Called from the nrf_ble_qwr callback of every link
+ *
+ * @return        BLE_GATT_STATUS_SUCCESS to accept the execute write, otherwise the ATT error
+ */
+uint16_t ble_cps_on_qwr_evt(ble_cps_t *p_cps, nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_evt_t *p_evt);
+
+/**
+ * @brief                     Function for handling the Control Point Service's BLE events.
+ *
+ * @param[in]     p_ble_evt   Event received from the SoftDevice.
+ * @param[in]     p_context   Control Point Service structure.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ble_cps_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+#endif // __BLE_CPS_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,222 @@
+/**
+ * @file       ble_evs.c
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      EVS (BLE Event Service)
+ * @note       None
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "sdk_common.h"
+#include "ble.h"
+#include "ble_evs.h"
+#include "ble_srv_common.h"
+#include "ble_conn_state.h"
+#include "nrf_log.h"
+
+/* Private defines ---------------------------------------------------- */
+#define BLE_UUID_EVS_EVENT_CHARACTERISTIC    0x4235
+#define BLE_UUID_EVS_SNIPPET_CHARACTERISTIC  0x4236
+#define BLE_UUID_EVS_ACTIVITY_CHARACTERISTIC 0x4237
+#define BLE_UUID_EVS_TIME_CHARACTERISTIC     0x4238
+#define BLE_UUID_EVS_LINK_CHARACTERISTIC     0x4239
+
+#define EVS_BASE_UUID                                                                                \
+  {                                                                                                  \
+    {                                                                                                \
+      0x41, 0xEE, 0x68, 0x3A, 0x99, 0x0F, 0x0E, 0x72, 0x85, 0x49, 0x8D, 0xB3, 0x00, 0x00, 0x00, 0x00 \
+    }                                                                                                \
+  } /**< Used vendor specific UUID. */
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static const uint16_t BLE_UUID_CHAR[] = {
+  BLE_UUID_EVS_EVENT_CHARACTERISTIC,
+  BLE_UUID_EVS_SNIPPET_CHARACTERISTIC,
+  BLE_UUID_EVS_ACTIVITY_CHARACTERISTIC,
+  BLE_UUID_EVS_TIME_CHARACTERISTIC,
+  BLE_UUID_EVS_LINK_CHARACTERISTIC
+};
+
+/* Private function prototypes ---------------------------------------- */
+static ret_code_t m_ble_evs_add_char(ble_evs_t *p_evs, const ble_evs_init_t *p_evs_init, ble_evs_charaterictic_t charac);
+static ret_code_t m_ble_evs_send_notification(ble_gatts_hvx_params_t *const p_hvx_params, uint16_t conn_handle);
+
+/* Function definitions ----------------------------------------------- */
+uint32_t ble_evs_init(ble_evs_t *p_evs, ble_evs_init_t const *p_evs_init)
+{
+  ret_code_t err_code;
+  ble_uuid_t ble_uuid;
+  ble_uuid128_t evs_base_uuid = EVS_BASE_UUID;
+
+  VERIFY_PARAM_NOT_NULL(p_evs);
+  VERIFY_PARAM_NOT_NULL(p_evs_init);
+
+  // Initialize the service structure.
+  p_evs->evt_handler               = p_evs_init->evt_handler;
+  p_evs->is_notification_supported = p_evs_init->support_notification;
+
+  // Add a custom base UUID.
+  err_code = sd_ble_uuid_vs_add(&evs_base_uuid, &p_evs->uuid_type);
+  VERIFY_SUCCESS(err_code);
+
+  ble_uuid.type = p_evs->uuid_type;
+  ble_uuid.uuid = BLE_UUID_EVS_SERVICE;
+
+  // Add the service.
+  err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &p_evs->service_handle);
+  VERIFY_SUCCESS(err_code);
+
+  // Add the Event Characteristics.
+  err_code = m_ble_evs_add_char(p_evs, p_evs_init, BLE_EVS_EVENT_CHAR);
+  VERIFY_SUCCESS(err_code);
+
+  err_code = m_ble_evs_add_char(p_evs, p_evs_init, BLE_EVS_SNIPPET_CHAR);
+  VERIFY_SUCCESS(err_code);
+
+  err_code = m_ble_evs_add_char(p_evs, p_evs_init, BLE_EVS_ACTIVITY_CHAR);
+  VERIFY_SUCCESS(err_code);
+
+  err_code = m_ble_evs_add_char(p_evs, p_evs_init, BLE_EVS_TIME_CHAR);
+  VERIFY_SUCCESS(err_code);
+
+  return m_ble_evs_add_char(p_evs, p_evs_init, BLE_EVS_LINK_CHAR);
+}
+
+ret_code_t ble_evs_data_update(ble_evs_t *p_evs, const uint8_t *p_data, uint16_t len,
+                               uint16_t conn_handle, ble_evs_charaterictic_t charac)
+{
+  ret_code_t err_code = NRF_ERROR_INVALID_STATE;
+
+  VERIFY_PARAM_NOT_NULL(p_evs);
+  VERIFY_PARAM_NOT_NULL(p_data);
+
+  if (len > BLE_EVS_MAX_DATA_LEN)
+    return NRF_ERROR_INVALID_LENGTH;
+
+  // Send value if connected and notifying.
+  if (conn_handle != BLE_CONN_HANDLE_INVALID)
+  {
+    ble_gatts_hvx_params_t hvx_params;
+
+    memset(&hvx_params, 0, sizeof(hvx_params));
+
+    hvx_params.handle = p_evs->evs_char_handles[charac].value_handle;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+    hvx_params.offset = 0;
+    hvx_params.p_len  = &len;
+    hvx_params.p_data = p_data;
+
+    if (conn_handle == BLE_CONN_HANDLE_ALL)
+    {
+      ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_conn_handles();
+
+      // Try sending notifications to all valid connection handles.
+      for (uint32_t i = 0; i < conn_handles.len; i++)
+      {
+        if (ble_conn_state_status(conn_handles.conn_handles[i]) == BLE_CONN_STATUS_CONNECTED)
+          err_code = m_ble_evs_send_notification(&hvx_params, conn_handles.conn_handles[i]);
+      }
+    }
+    else
+    {
+      err_code = m_ble_evs_send_notification(&hvx_params, conn_handle);
+    }
+  }
+
+  return err_code;
+}
+
+void ble_evs_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+  if ((p_context == NULL) || (p_ble_evt == NULL))
+    return;
+
+  ble_evs_t *p_evs = (ble_evs_t *)p_context;
+
+  switch (p_ble_evt->header.evt_id)
+  {
+  case BLE_GATTS_EVT_WRITE:
+  {
+    ble_gatts_evt_write_t const *p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+
+    if ((p_evs->evt_handler != NULL) &&
+        (p_evt_write->handle == p_evs->evs_char_handles[BLE_EVS_EVENT_CHAR].cccd_handle) &&
+        (p_evt_write->len == 2))
+    {
+      ble_evs_evt_t evt;
+
+      evt.conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+      evt.evt_type    = ble_srv_is_notification_enabled(p_evt_write->data) ?
+                        BLE_EVS_EVT_NOTIFICATION_ENABLED : BLE_EVS_EVT_NOTIFICATION_DISABLED;
+
+      p_evs->evt_handler(p_evs, &evt);
+    }
+  }
+  break;
+
+  default:
+    break;
+  }
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Function for adding an Event characteristic.
+ *
+ * @param[in]     p_evs         Event Service structure.
+ * @param[in]     p_evs_init    Information needed to initialize the service.
+ * @param[in]     charac        Charaterictic
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static ret_code_t m_ble_evs_add_char(ble_evs_t *p_evs, const ble_evs_init_t *p_evs_init, ble_evs_charaterictic_t charac)
+{
+  ble_add_char_params_t   add_char_params;
+
+  memset(&add_char_params, 0, sizeof(add_char_params));
+  add_char_params.uuid              = BLE_UUID_CHAR[charac];
+  add_char_params.uuid_type         = p_evs->uuid_type;
+  add_char_params.max_len           = BLE_EVS_MAX_DATA_LEN;
+  add_char_params.init_len          = 0;
+  add_char_params.is_var_len        = true;
+  add_char_params.char_props.notify = p_evs->is_notification_supported;
+  add_char_params.char_props.read   = 1;
+  add_char_params.cccd_write_access = p_evs_init->bl_cccd_wr_sec;
+  add_char_params.read_access       = p_evs_init->bl_rd_sec;
+
+  return characteristic_add(p_evs->service_handle, &add_char_params, &(p_evs->evs_char_handles[charac]));
+}
+
+/**
+ * @brief         Function for sending notifications with an Event characteristic.
+ *
+ * @param[in]     p_hvx_params Pointer to structure with notification data.
+ * @param[in]     conn_handle  Connection handle.
+ *
+ * @attention     None
+ *
+ * @return        NRF_SUCCESS on success, otherwise an error code.
+ *
+ */
+static ret_code_t m_ble_evs_send_notification(ble_gatts_hvx_params_t *const p_hvx_params, uint16_t conn_handle)
+{
+  ret_code_t err_code = sd_ble_gatts_hvx(conn_handle, p_hvx_params);
+
+  if (err_code != NRF_SUCCESS)
+  {
+    NRF_LOG_DEBUG("Error: 0x%08X while sending notification with conn_handle: 0x%04X", err_code, conn_handle);
+  }
+
+  return err_code;
+}
+
+/* End of file -------------------------------------------------------- */
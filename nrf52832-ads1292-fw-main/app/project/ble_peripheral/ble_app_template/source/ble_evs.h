@@ -0,0 +1,163 @@
+/**
+ * @file       ble_evs.h
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      EVS (BLE Event Service)
+ * @note       None
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BLE_EVS_H
+#define __BLE_EVS_H
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "ble_link_ctx_manager.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BLE_UUID_EVS_SERVICE (0x4234)                                  /**< The UUID of the Event Service. */
+#define BLE_EVS_MAX_DATA_LEN (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3)       /**< Maximum length of a characteristic value. */
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Event Charaterictic
+ */
+typedef enum
+{
+  BLE_EVS_EVENT_CHAR,       /**< Event records */
+  BLE_EVS_SNIPPET_CHAR,     /**< ECG snippet chunks of the last event */
+  BLE_EVS_ACTIVITY_CHAR,    /**< Activity records, one per IMU_ACTIVITY_WINDOW_S */
+  BLE_EVS_TIME_CHAR,        /**< Sample timebase against the connection events, one per BSP_TIME_LINK_WINDOW_S */
+  BLE_EVS_LINK_CHAR,        /**< Negotiated link parameters, on every change */
+  BLE_EVS_MAX_CHAR
+}
+ble_evs_charaterictic_t;
+
+/**
+ * @brief Event Service event type
+ */
+typedef enum
+{
+  BLE_EVS_EVT_NOTIFICATION_ENABLED, /**< Event notification enabled event. */
+  BLE_EVS_EVT_NOTIFICATION_DISABLED /**< Event notification disabled event. */
+}
+ble_evs_evt_type_t;
+
+/**
+ * @brief Event Service event.
+ */
+typedef struct
+{
+  ble_evs_evt_type_t evt_type;     /**< Type of event. */
+  uint16_t           conn_handle;  /**< Connection handle. */
+}
+ble_evs_evt_t;
+
+/* Forward declaration of the ble_evs_t type. */
+typedef struct ble_evs_s ble_evs_t;
+
+/* Event Service event handler type. */
+typedef void (* ble_evs_evt_handler_t) (ble_evs_t * p_evs, ble_evs_evt_t * p_evt);
+
+/**
+ * @brief Event Service initialization structure.
+ */
+typedef struct
+{
+  ble_evs_evt_handler_t  evt_handler;                    /**< Event handler to be called for handling events in the Event Service. */
+  bool                   support_notification;           /**< TRUE if notification of events is supported. */
+  security_req_t         bl_rd_sec;                      /**< Security requirement for reading the characteristic value. */
+  security_req_t         bl_cccd_wr_sec;                 /**< Security requirement for writing the characteristic CCCD. */
+}
+ble_evs_init_t;
+
+/**
+ * @brief Event Service structure.
+ */
+struct ble_evs_s
+{
+  uint8_t                  uuid_type;                           /**< UUID type for Event Service Base UUID. */
+  ble_evs_evt_handler_t    evt_handler;                         /**< Event handler to be called for handling events in the Event Service. */
+  uint16_t                 service_handle;                      /**< Handle of Event Service (as provided by the BLE stack). */
+  ble_gatts_char_handles_t evs_char_handles[BLE_EVS_MAX_CHAR];  /**< Handles related to the Event characteristics. */
+  bool                     is_notification_supported;           /**< TRUE if notification of events is supported. */
+};
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Macro for defining a ble_evs instance.
+ *
+ * @param[in]     _name  Name of the instance.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+#define BLE_EVS_DEF(_name)                        \
+static ble_evs_t _name;                           \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,               \
+                     BLE_HRS_BLE_OBSERVER_PRIO,   \
+                     ble_evs_on_ble_evt, &_name)
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief                     Function for initializing the Event Service.
+ *
+ * @param[in]     p_evs_init  Information needed to initialize the service.
+ *
+ * @param[out]    p_evs       Event Service structure. This structure must be supplied
+ *                            by the application. It is initialized by this function and will
+ *                            later be used to identify this particular service instance.
+ *
+ * @attention     None
+ *
+ * @return
+ * - NRF_SUCCESS If the service was successfully initialized. Otherwise, an error code is returned.
+ * - NRF_ERROR_NULL If either of the pointers p_evs or p_evs_init is NULL.
+ */
+uint32_t ble_evs_init(ble_evs_t *p_evs, ble_evs_init_t const *p_evs_init);
+
+/**
+ * @brief                        Function for sending a value on one of the Event characteristics.
+ *
+ * @param[in]     p_evs          Event Service structure.
+ * @param[in]     p_data         Value to send
+ * @param[in]     len            Value length, at most BLE_EVS_MAX_DATA_LEN and the negotiated ATT MTU - 3
+ * @param[in]     conn_handle    Connection handle.
+ * @param[in]     charac         Characteristic to send on
+ *
+ * @attention     None
+ *
+ * @return
+ * - NRF_SUCCESS on success
+ * - NRF_ERROR_RESOURCES if the notification queue is full, the caller should retry later
+ * - Otherwise an error code is returned
+ */
+ret_code_t ble_evs_data_update(ble_evs_t *p_evs, const uint8_t *p_data, uint16_t len,
+                               uint16_t conn_handle, ble_evs_charaterictic_t charac);
+
+/**
+ * @brief                     Function for handling the Event Service's BLE events.
+ *
+ * @param[in]     p_ble_evt   Event received from the SoftDevice.
+ * @param[in]     p_context   Event Service structure.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ble_evs_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+#endif // __BLE_EVS_H
+
+/* End of file -------------------------------------------------------- */
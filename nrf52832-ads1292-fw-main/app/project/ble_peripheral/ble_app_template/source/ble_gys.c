@@ -81,7 +81,7 @@ uint32_t ble_gys_init(ble_gys_t *p_gys, ble_gys_init_t const *p_gys_init)
   return m_ble_gys_add_char(p_gys, p_gys_init, BLE_GYS_AXIS_Z_CHAR);
 }
 
-ret_code_t ble_gys_gyr_update(ble_gys_t *p_gys, uint16_t gyr, uint16_t conn_handle, ble_gys_charaterictic_t charac)
+ret_code_t ble_gys_gyr_update(ble_gys_t *p_gys, int16_t gyr, uint16_t conn_handle, ble_gys_charaterictic_t charac)
 {
   ret_code_t err_code;
 
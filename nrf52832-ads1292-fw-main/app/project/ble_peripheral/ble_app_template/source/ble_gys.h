@@ -131,14 +131,14 @@ uint32_t ble_gys_init(ble_gys_t *p_gys, ble_gys_init_t const *p_gys_init);
  * @brief                        Function for updating the Gyroscope level.
  *
  * @param[in]     p_bas          Gyroscope Service structure.
- * @param[in]     gyr            New Gyroscope measurement value
+ * @param[in]     gyr            New Gyroscope measurement value (0.1 dps, signed)
  * @param[in]     conn_handle    Connection handle.
  * 
  * @attention     None
  *
  * @return        None
  */
-ret_code_t ble_gys_gyr_update(ble_gys_t *p_gys, uint16_t gyr, uint16_t conn_handle, ble_gys_charaterictic_t charac);
+ret_code_t ble_gys_gyr_update(ble_gys_t *p_gys, int16_t gyr, uint16_t conn_handle, ble_gys_charaterictic_t charac);
 
 /**
  * @brief                     Function for handling the Nordic Gyroscope Service's BLE events.
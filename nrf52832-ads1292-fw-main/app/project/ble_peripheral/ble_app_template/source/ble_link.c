@@ -0,0 +1,300 @@
+/**
+ * @file       ble_link.c
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Link profile, PHY, data length and connection event extension of the connections
+ * @note       The 2M PHY halves the air time of a packet and the 251-byte data length carries a
+ *             full notification in one packet. The connection event extension lets an event run
+ *             past NRF_SDH_BLE_GAP_EVENT_LENGTH while there are packets to send, up to the next
+ *             connection event. The extension is a SoftDevice option, it is on while any link
+ *             streams.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "sdk_common.h"
+#include "ble_link.h"
+#include "nrf_sdh_ble.h"
+#include "ble_conn_state.h"
+#include "ble_link_ctx_manager.h"
+#include "app_util.h"
+#include "app_error.h"
+#include "nrf_log.h"
+
+/* Private defines ---------------------------------------------------- */
+#define BLE_LINK_DATA_LENGTH_DEFAULT  (27)    // Link-layer payload before any update
+#define BLE_LINK_DATA_LENGTH_MAX      (251)   // Largest link-layer payload
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Profile structure
+ */
+typedef struct
+{
+  uint8_t phys;               /**< Requested TX and RX PHY */
+  uint8_t data_length;        /**< Requested data length, 0 to keep the negotiated one */
+  bool    conn_evt_ext;       /**< Connection event extension */
+}
+ble_link_profile_cfg_t;
+
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static const ble_link_profile_cfg_t m_profiles[BLE_LINK_PROFILE_MAX] =
+{
+  [BLE_LINK_PROFILE_LOW_POWER] = { BLE_GAP_PHY_1MBPS, 0,                        false },
+  [BLE_LINK_PROFILE_STREAMING] = { BLE_GAP_PHY_2MBPS, BLE_LINK_DATA_LENGTH_MAX, true  }
+};
+
+static nrf_ble_gatt_t           *mp_gatt;
+static ble_link_params_handler_t m_handler;
+static bool                      m_conn_evt_ext;
+
+BLE_LINK_CTX_MANAGER_DEF(m_link_ctx, NRF_SDH_BLE_TOTAL_LINK_COUNT, sizeof(ble_link_params_t));
+
+/* Private function prototypes ---------------------------------------- */
+static void m_ble_link_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+static ret_code_t m_ble_link_conn_evt_ext_update(void);
+static void m_ble_link_report(const ble_link_params_t *p_params);
+
+NRF_SDH_BLE_OBSERVER(m_ble_link_observer, BLE_LINK_OBSERVER_PRIO, m_ble_link_on_ble_evt, NULL);
+
+/* Function definitions ----------------------------------------------- */
+ret_code_t ble_link_init(nrf_ble_gatt_t *p_gatt, ble_link_params_handler_t handler)
+{
+  VERIFY_PARAM_NOT_NULL(p_gatt);
+
+  mp_gatt        = p_gatt;
+  m_handler      = handler;
+  m_conn_evt_ext = !m_profiles[BLE_LINK_PROFILE_LOW_POWER].conn_evt_ext;    // Written once at init
+
+  return m_ble_link_conn_evt_ext_update();
+}
+
+ret_code_t ble_link_profile_set(uint16_t conn_handle, ble_link_profile_t profile)
+{
+  ble_link_params_t *p_params;
+  ret_code_t         err_code;
+
+  VERIFY_TRUE(profile < BLE_LINK_PROFILE_MAX, NRF_ERROR_INVALID_PARAM);
+
+  err_code = blcm_link_ctx_get(&m_link_ctx, conn_handle, (void *)&p_params);
+  VERIFY_SUCCESS(err_code);
+
+  const ble_link_profile_cfg_t *p_cfg = &m_profiles[profile];
+
+  p_params->profile = profile;
+
+  err_code = m_ble_link_conn_evt_ext_update();
+  VERIFY_SUCCESS(err_code);
+
+  if ((p_params->tx_phy != p_cfg->phys) || (p_params->rx_phy != p_cfg->phys))
+  {
+    ble_gap_phys_t const phys = { .tx_phys = p_cfg->phys, .rx_phys = p_cfg->phys };
+
+    // Busy while another procedure runs, the next profile change requests again
+    err_code = sd_ble_gap_phy_update(conn_handle, &phys);
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_BUSY))
+      return err_code;
+  }
+
+  if ((p_cfg->data_length != 0) && (p_params->max_tx_octets < p_cfg->data_length))
+  {
+    // Logged by the GATT module when refused, the link keeps its data length
+    (void)nrf_ble_gatt_data_length_set(mp_gatt, conn_handle, p_cfg->data_length);
+  }
+
+  NRF_LOG_INFO("Link 0x%x profile %d", conn_handle, profile);
+
+  return NRF_SUCCESS;
+}
+
+ble_link_profile_t ble_link_profile_get(uint16_t conn_handle)
+{
+  ble_link_params_t *p_params;
+
+  if (blcm_link_ctx_get(&m_link_ctx, conn_handle, (void *)&p_params) != NRF_SUCCESS)
+    return BLE_LINK_PROFILE_LOW_POWER;
+
+  return p_params->profile;
+}
+
+bool ble_link_params_get(uint16_t conn_handle, ble_link_params_t *p_params)
+{
+  ble_link_params_t *p_ctx;
+
+  if (blcm_link_ctx_get(&m_link_ctx, conn_handle, (void *)&p_ctx) != NRF_SUCCESS)
+    return false;
+
+  *p_params = *p_ctx;
+
+  return (ble_conn_state_status(conn_handle) == BLE_CONN_STATUS_CONNECTED);
+}
+
+uint8_t ble_link_params_encode(const ble_link_params_t *p_params, uint8_t *p_buf)
+{
+  uint8_t len = 0;
+
+  len += uint16_encode(p_params->conn_handle, &p_buf[len]);
+  p_buf[len++] = (uint8_t)p_params->profile;
+  p_buf[len++] = p_params->tx_phy;
+  p_buf[len++] = p_params->rx_phy;
+  len += uint16_encode(p_params->max_tx_octets, &p_buf[len]);
+  len += uint16_encode(p_params->max_rx_octets, &p_buf[len]);
+  len += uint16_encode(p_params->conn_interval, &p_buf[len]);
+  len += uint16_encode(p_params->slave_latency, &p_buf[len]);
+  len += uint16_encode(p_params->sup_timeout, &p_buf[len]);
+
+  return len;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Track the negotiated parameters and answer the peer PHY requests
+ *
+ * @param[in]     p_ble_evt     Event received from the BLE stack
+ * @param[in]     p_context     Unused
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ble_link_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+  ble_gap_evt_t const *p_gap_evt = &p_ble_evt->evt.gap_evt;
+  ble_link_params_t   *p_params;
+  ret_code_t           err_code;
+
+  UNUSED_PARAMETER(p_context);
+
+  // Only the GAP events of the links are handled
+  if ((p_ble_evt->header.evt_id < BLE_GAP_EVT_BASE) || (p_ble_evt->header.evt_id > BLE_GAP_EVT_LAST))
+    return;
+
+  if (blcm_link_ctx_get(&m_link_ctx, p_gap_evt->conn_handle, (void *)&p_params) != NRF_SUCCESS)
+    return;
+
+  switch (p_ble_evt->header.evt_id)
+  {
+  case BLE_GAP_EVT_CONNECTED:
+    memset(p_params, 0, sizeof(ble_link_params_t));
+    p_params->conn_handle   = p_gap_evt->conn_handle;
+    p_params->profile       = BLE_LINK_PROFILE_LOW_POWER;
+    p_params->tx_phy        = BLE_GAP_PHY_1MBPS;
+    p_params->rx_phy        = BLE_GAP_PHY_1MBPS;
+    p_params->max_tx_octets = BLE_LINK_DATA_LENGTH_DEFAULT;
+    p_params->max_rx_octets = BLE_LINK_DATA_LENGTH_DEFAULT;
+    p_params->conn_interval = p_gap_evt->params.connected.conn_params.max_conn_interval;
+    p_params->slave_latency = p_gap_evt->params.connected.conn_params.slave_latency;
+    p_params->sup_timeout   = p_gap_evt->params.connected.conn_params.conn_sup_timeout;
+    m_ble_link_report(p_params);
+    break;
+
+  case BLE_GAP_EVT_DISCONNECTED:
+    // The link may have been the last one streaming
+    p_params->profile = BLE_LINK_PROFILE_LOW_POWER;
+    err_code = m_ble_link_conn_evt_ext_update();
+    APP_ERROR_CHECK(err_code);
+    break;
+
+  case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+    p_params->conn_interval = p_gap_evt->params.conn_param_update.conn_params.max_conn_interval;
+    p_params->slave_latency = p_gap_evt->params.conn_param_update.conn_params.slave_latency;
+    p_params->sup_timeout   = p_gap_evt->params.conn_param_update.conn_params.conn_sup_timeout;
+    m_ble_link_report(p_params);
+    break;
+
+  case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
+  {
+    ble_gap_phys_t const phys =
+    {
+      .tx_phys = m_profiles[p_params->profile].phys,
+      .rx_phys = m_profiles[p_params->profile].phys
+    };
+
+    NRF_LOG_DEBUG("PHY update request.");
+    err_code = sd_ble_gap_phy_update(p_gap_evt->conn_handle, &phys);
+    APP_ERROR_CHECK(err_code);
+  }
+  break;
+
+  case BLE_GAP_EVT_PHY_UPDATE:
+    if (p_gap_evt->params.phy_update.status != BLE_HCI_STATUS_CODE_SUCCESS)
+      break;
+
+    p_params->tx_phy = p_gap_evt->params.phy_update.tx_phy;
+    p_params->rx_phy = p_gap_evt->params.phy_update.rx_phy;
+    m_ble_link_report(p_params);
+    break;
+
+  case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+    p_params->max_tx_octets = p_gap_evt->params.data_length_update.effective_params.max_tx_octets;
+    p_params->max_rx_octets = p_gap_evt->params.data_length_update.effective_params.max_rx_octets;
+    m_ble_link_report(p_params);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief         Enable the connection event extension while a link streams, disable it otherwise
+ *
+ * @param[in]     None
+ *
+ * @attention     The option is only set when it changes
+ *
+ * @return        Error code of sd_ble_opt_set()
+ */
+static ret_code_t m_ble_link_conn_evt_ext_update(void)
+{
+  ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+  bool                              enable       = false;
+  ble_link_params_t                *p_params;
+  ble_opt_t                         opt;
+  ret_code_t                        err_code;
+
+  for (uint32_t i = 0; i < conn_handles.len; i++)
+  {
+    if ((blcm_link_ctx_get(&m_link_ctx, conn_handles.conn_handles[i], (void *)&p_params) == NRF_SUCCESS) &&
+        m_profiles[p_params->profile].conn_evt_ext)
+      enable = true;
+  }
+
+  if (enable == m_conn_evt_ext)
+    return NRF_SUCCESS;
+
+  memset(&opt, 0, sizeof(opt));
+  opt.common_opt.conn_evt_ext.enable = enable ? 1 : 0;
+
+  err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt);
+  VERIFY_SUCCESS(err_code);
+
+  m_conn_evt_ext = enable;
+
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief         Log the negotiated parameters of a link and pass them to the handler
+ *
+ * @param[in]     p_params      Parameters of the link
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ble_link_report(const ble_link_params_t *p_params)
+{
+  NRF_LOG_INFO("Link 0x%x PHY %d/%d, DLE %d, interval %d, latency %d", p_params->conn_handle,
+               p_params->tx_phy, p_params->rx_phy, p_params->max_tx_octets,
+               p_params->conn_interval, p_params->slave_latency);
+
+  if (m_handler != NULL)
+    m_handler(p_params);
+}
+
+/* End of file -------------------------------------------------------- */
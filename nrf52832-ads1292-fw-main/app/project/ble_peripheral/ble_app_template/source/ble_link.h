@@ -0,0 +1,136 @@
+/**
+ * @file       ble_link.h
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Link profile, PHY, data length and connection event extension of the connections
+ * @note       Each link has its own profile and parameters. The connection interval of each
+ *             profile is requested by the application, with the power state ones. The negotiated
+ *             parameters are reported as:
+ *             {connection handle (u16), profile (u8), TX PHY (u8), RX PHY (u8), max TX octets (u16),
+ *              max RX octets (u16), connection interval in 1.25 ms (u16), slave latency (u16),
+ *              supervision timeout in 10 ms (u16)}
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BLE_LINK_H
+#define __BLE_LINK_H
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "nrf_ble_gatt.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BLE_LINK_PARAMS_ENCODED_SIZE  (15)    /**< Encoded link parameters (bytes). */
+#define BLE_LINK_OBSERVER_PRIO        2       /**< Ahead of the application observer. */
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Link profile
+ */
+typedef enum
+{
+  BLE_LINK_PROFILE_LOW_POWER,     /**< 1M PHY, no connection event extension */
+  BLE_LINK_PROFILE_STREAMING,     /**< 2M PHY, 251-byte data length, connection event extension */
+  BLE_LINK_PROFILE_MAX
+}
+ble_link_profile_t;
+
+/**
+ * @brief Negotiated link parameters
+ */
+typedef struct
+{
+  uint16_t           conn_handle;     /**< Link */
+  ble_link_profile_t profile;         /**< Requested profile */
+  uint8_t            tx_phy;          /**< BLE_GAP_PHY_1MBPS or BLE_GAP_PHY_2MBPS */
+  uint8_t            rx_phy;
+  uint16_t           max_tx_octets;   /**< Link-layer payload */
+  uint16_t           max_rx_octets;
+  uint16_t           conn_interval;   /**< Connection interval (1.25 ms units) */
+  uint16_t           slave_latency;
+  uint16_t           sup_timeout;     /**< Supervision timeout (10 ms units) */
+}
+ble_link_params_t;
+
+/**
+ * @brief Link parameters handler type, called on every negotiated change
+ */
+typedef void (*ble_link_params_handler_t)(const ble_link_params_t *p_params);
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief                        Function for initializing the link profile.
+ *
+ * @param[in]     p_gatt         GATT module instance, for the data length requests
+ * @param[in]     handler        Negotiated parameters handler, may be NULL
+ *
+ * @attention     Called after the SoftDevice is enabled, every link starts in the low-power profile
+ *
+ * @return        NRF_SUCCESS or the error code of sd_ble_opt_set()
+ */
+ret_code_t ble_link_init(nrf_ble_gatt_t *p_gatt, ble_link_params_handler_t handler);
+
+/**
+ * @brief                        Function for switching the profile of a link.
+ *
+ * @param[in]     conn_handle    Connection handle
+ * @param[in]     profile        Profile
+ *
+ * @attention     The PHY and the data length are only requested when they differ from the
+ *                negotiated ones, a peer may refuse them
+ *
+ * @return
+ * - NRF_SUCCESS on success
+ * - NRF_ERROR_INVALID_PARAM on a bad profile
+ * - NRF_ERROR_NOT_FOUND on an unknown link
+ * - The error code of a SoftDevice request otherwise
+ */
+ret_code_t ble_link_profile_set(uint16_t conn_handle, ble_link_profile_t profile);
+
+/**
+ * @brief                        Function for getting the requested profile of a link.
+ *
+ * @param[in]     conn_handle    Connection handle
+ *
+ * @attention     None
+ *
+ * @return        Profile, the low-power one for an unknown link
+ */
+ble_link_profile_t ble_link_profile_get(uint16_t conn_handle);
+
+/**
+ * @brief                        Function for getting the negotiated parameters of a link.
+ *
+ * @param[in]     conn_handle    Connection handle
+ * @param[out]    p_params       Parameters
+ *
+ * @attention     None
+ *
+ * @return        true if the link is connected
+ */
+bool ble_link_params_get(uint16_t conn_handle, ble_link_params_t *p_params);
+
+/**
+ * @brief                        Function for encoding the link parameters.
+ *
+ * @param[in]     p_params       Parameters
+ * @param[out]    p_buf          Output buffer, BLE_LINK_PARAMS_ENCODED_SIZE bytes
+ *
+ * @attention     None
+ *
+ * @return        Encoded length
+ */
+uint8_t ble_link_params_encode(const ble_link_params_t *p_params, uint8_t *p_buf);
+
+#endif // __BLE_LINK_H
+
+/* End of file -------------------------------------------------------- */
@@ -81,7 +81,7 @@ uint32_t ble_mgs_init(ble_mgs_t *p_mgs, ble_mgs_init_t const *p_mgs_init)
   return m_ble_mgs_add_char(p_mgs, p_mgs_init, BLE_MGS_AXIS_Z_CHAR);
 }
 
-ret_code_t ble_mgs_mag_update(ble_mgs_t *p_mgs, uint16_t mag, uint16_t conn_handle, ble_mgs_charaterictic_t charac)
+ret_code_t ble_mgs_mag_update(ble_mgs_t *p_mgs, int16_t mag, uint16_t conn_handle, ble_mgs_charaterictic_t charac)
 {
   ret_code_t err_code;
 
@@ -131,14 +131,14 @@ uint32_t ble_mgs_init(ble_mgs_t *p_mgs, ble_mgs_init_t const *p_mgs_init);
  * @brief                        Function for updating the Magnetometer level.
  *
  * @param[in]     p_bas          Magnetometer Service structure.
- * @param[in]     acc            New Magnetometer measurement value
+ * @param[in]     acc            New Magnetometer measurement value (0.1 uT, signed)
  * @param[in]     conn_handle    Connection handle.
  * 
  * @attention     None
  *
  * @return        None
  */
-ret_code_t ble_mgs_mag_update(ble_mgs_t *p_mgs, uint16_t acc, uint16_t conn_handle, ble_mgs_charaterictic_t charac);
+ret_code_t ble_mgs_mag_update(ble_mgs_t *p_mgs, int16_t acc, uint16_t conn_handle, ble_mgs_charaterictic_t charac);
 
 /**
  * @brief                     Function for handling the Nordic Magnetometer Service's BLE events.
@@ -0,0 +1,186 @@
+/**
+ * @file       ble_mos.h
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      MOS (BLE Motion Service)
+ * @note       None
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BLE_MOS_H
+#define __BLE_MOS_H
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "ble_link_ctx_manager.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BLE_UUID_MOS_SERVICE  (0x6234)                                  /**< The UUID of the Motion Service. */
+#define BLE_MOS_MAX_DATA_LEN  (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3)       /**< Maximum length of a motion packet. */
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Motion Charaterictic
+ */
+typedef enum
+{
+  BLE_MOS_DATA_CHAR,        /**< Motion packets */
+  BLE_MOS_MAX_CHAR
+}
+ble_mos_charaterictic_t;
+
+/**
+ * @brief Motion Service event type
+ */
+typedef enum
+{
+  BLE_MOS_EVT_NOTIFICATION_ENABLED,   /**< Motion notification enabled event. */
+  BLE_MOS_EVT_NOTIFICATION_DISABLED   /**< Motion notification disabled event. */
+}
+ble_mos_evt_type_t;
+
+/**
+ * @brief Motion Service event.
+ */
+typedef struct
+{
+  ble_mos_evt_type_t evt_type;     /**< Type of event. */
+  uint16_t           conn_handle;  /**< Connection handle. */
+}
+ble_mos_evt_t;
+
+/**
+ * @brief Motion Service client context, one per link.
+ */
+typedef struct
+{
+  bool is_notification_enabled;    /**< Notifications of the data characteristic enabled by the peer. */
+}
+ble_mos_client_context_t;
+
+/* Forward declaration of the ble_mos_t type. */
+typedef struct ble_mos_s ble_mos_t;
+
+/* Motion Service event handler type. */
+typedef void (* ble_mos_evt_handler_t) (ble_mos_t * p_mos, ble_mos_evt_t * p_evt);
+
+/**
+ * @brief Motion Service initialization structure.
+ */
+typedef struct
+{
+  ble_mos_evt_handler_t  evt_handler;                      /**< Event handler to be called for handling events in the Motion Service. */
+  security_req_t         bl_cccd_wr_sec;                   /**< Security requirement for writing the characteristic CCCD. */
+}
+ble_mos_init_t;
+
+/**
+ * @brief Motion Service structure.
+ */
+struct ble_mos_s
+{
+  uint8_t                  uuid_type;                            /**< UUID type for Motion Service Base UUID. */
+  ble_mos_evt_handler_t    evt_handler;                          /**< Event handler to be called for handling events in the Motion Service. */
+  uint16_t                 service_handle;                       /**< Handle of Motion Service (as provided by the BLE stack). */
+  ble_gatts_char_handles_t mos_char_handles[BLE_MOS_MAX_CHAR];   /**< Handles related to the Motion characteristics. */
+  uint8_t                  data_value[BLE_MOS_MAX_DATA_LEN];     /**< Application-held value of the data characteristic. */
+  blcm_link_ctx_storage_t *const p_link_ctx_storage;             /**< Client contexts of the links. */
+};
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Macro for defining a ble_mos instance.
+ *
+ * @param[in]     _name         Name of the instance.
+ * @param[in]     _max_clients  Maximum number of links served at once.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+#define BLE_MOS_DEF(_name, _max_clients)                            \
+BLE_LINK_CTX_MANAGER_DEF(CONCAT_2(_name, _link_ctx_storage),        \
+                         (_max_clients),                            \
+                         sizeof(ble_mos_client_context_t));         \
+static ble_mos_t _name =                                            \
+{                                                                   \
+  .p_link_ctx_storage = &CONCAT_2(_name, _link_ctx_storage)         \
+};                                                                  \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                 \
+                     BLE_HRS_BLE_OBSERVER_PRIO,                     \
+                     ble_mos_on_ble_evt, &_name)
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief                     Function for initializing the Motion Service.
+ *
+ * @param[in]     p_mos_init  Information needed to initialize the service.
+ *
+ * @param[out]    p_mos       Motion Service structure. This structure must be supplied
+ *                            by the application. It is initialized by this function and will
+ *                            later be used to identify this particular service instance.
+ *
+ * @attention     The data characteristic value is held in p_mos and is not readable, so the
+ *                packets do not take space in the SoftDevice attribute table
+ *
+ * @return
+ * - NRF_SUCCESS If the service was successfully initialized. Otherwise, an error code is returned.
+ * - NRF_ERROR_NULL If either of the pointers p_mos or p_mos_init is NULL.
+ */
+uint32_t ble_mos_init(ble_mos_t *p_mos, ble_mos_init_t const *p_mos_init);
+
+/**
+ * @brief                        Function for sending a motion packet.
+ *
+ * @param[in]     p_mos          Motion Service structure.
+ * @param[in]     p_data         Packet to send
+ * @param[in]     len            Packet length, at most BLE_MOS_MAX_DATA_LEN and the negotiated ATT MTU - 3
+ * @param[in]     conn_handle    Connection handle.
+ *
+ * @attention     None
+ *
+ * @return
+ * - NRF_SUCCESS on success
+ * - NRF_ERROR_RESOURCES if the notification queue is full, the caller should retry later
+ * - NRF_ERROR_INVALID_STATE if the peer of the link has not enabled the notifications
+ * - Otherwise an error code is returned
+ */
+ret_code_t ble_mos_data_update(ble_mos_t *p_mos, const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+
+/**
+ * @brief                        Function for checking whether a link has enabled the notifications.
+ *
+ * @param[in]     p_mos          Motion Service structure.
+ * @param[in]     conn_handle    Connection handle.
+ *
+ * @attention     None
+ *
+ * @return        true if the peer of the link has enabled the data notifications
+ */
+bool ble_mos_is_notification_enabled(ble_mos_t *p_mos, uint16_t conn_handle);
+
+/**
+ * @brief                     Function for handling the Motion Service's BLE events.
+ *
+ * @param[in]     p_ble_evt   Event received from the SoftDevice.
+ * @param[in]     p_context   Motion Service structure.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ble_mos_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+#endif // __BLE_MOS_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,379 @@
+/**
+ * @file       ble_tx_queue.c
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Notification scheduler, keeps the SoftDevice TX queue full across the streams
+ * @note       The notifications in flight of each link are counted from the sd_ble_gatts_hvx()
+ *             successes and the BLE_GATTS_EVT_HVN_TX_COMPLETE counts, so a packet is only built when
+ *             a SoftDevice queue has room for it. The packet waits for the links with a full queue
+ *             until another link runs dry, a slow link then misses it instead of setting the pace.
+ *             Notifications sent outside the scheduler (battery, legacy IMU services) are not
+ *             counted, a NRF_ERROR_RESOURCES then marks the queue full until the next TX complete
+ *             event.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "sdk_common.h"
+#include "ble_tx_queue.h"
+#include "nrf_sdh_ble.h"
+#include "app_util_platform.h"
+
+/* Private defines ---------------------------------------------------- */
+#define BLE_TX_QUEUE_NO_STREAM      (0xFF)
+
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Stream structure
+ */
+typedef struct
+{
+  ble_tx_queue_prio_t  priority;
+  ble_tx_queue_fill_t  fill;
+  ble_tx_queue_send_t  send;
+  ble_tx_queue_stats_t stats;
+}
+ble_tx_queue_stream_t;
+
+/**
+ * @brief Link structure
+ */
+typedef struct
+{
+  uint16_t conn_handle;
+  uint16_t max_len;
+  uint8_t  in_flight;       // Notifications queued in the SoftDevice
+}
+ble_tx_queue_link_t;
+
+/* Private macros ----------------------------------------------------- */
+STATIC_ASSERT(BLE_TX_QUEUE_MAX_LINKS <= 8);   // Links of a packet are a byte mask
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static ble_tx_queue_stream_t        m_streams[BLE_TX_QUEUE_MAX_STREAMS];
+static uint8_t                      m_stream_count;
+static uint8_t                      m_last_served[BLE_TX_QUEUE_PRIO_MAX];    // Round robin among the streams of a priority
+
+static volatile ble_tx_queue_link_t m_links[BLE_TX_QUEUE_MAX_LINKS];
+static volatile uint8_t             m_link_active;                           // Slots in use
+static volatile uint8_t             m_link_reset;                            // Slots changed since the last call, their held packet is stale
+
+// Packet built once for all the links, held until each link took or refused it
+static uint8_t                      m_held_buf[BLE_TX_QUEUE_MAX_DATA_LEN];
+static uint16_t                     m_held_len;
+static uint8_t                      m_held_id = BLE_TX_QUEUE_NO_STREAM;
+static uint8_t                      m_held_links;                            // Links still to send the held packet to
+
+/* Private function prototypes ---------------------------------------- */
+static void m_ble_tx_queue_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+static uint16_t m_ble_tx_queue_fill_next(uint8_t *p_id, uint16_t max_len);
+static void m_ble_tx_queue_links_get(uint8_t *p_active, uint8_t *p_ready, uint8_t *p_idle, uint16_t *p_max_len);
+static void m_ble_tx_queue_send(uint8_t links);
+static void m_ble_tx_queue_release(void);
+
+NRF_SDH_BLE_OBSERVER(m_ble_tx_queue_observer, BLE_TX_QUEUE_OBSERVER_PRIO, m_ble_tx_queue_on_ble_evt, NULL);
+
+/* Function definitions ----------------------------------------------- */
+ret_code_t ble_tx_queue_stream_add(ble_tx_queue_prio_t priority, ble_tx_queue_fill_t fill,
+                                   ble_tx_queue_send_t send, uint8_t *p_id)
+{
+  VERIFY_TRUE((priority < BLE_TX_QUEUE_PRIO_MAX) && (fill != NULL) && (send != NULL), NRF_ERROR_INVALID_PARAM);
+  VERIFY_TRUE(m_stream_count < BLE_TX_QUEUE_MAX_STREAMS, NRF_ERROR_NO_MEM);
+
+  m_streams[m_stream_count].priority = priority;
+  m_streams[m_stream_count].fill     = fill;
+  m_streams[m_stream_count].send     = send;
+  memset(&m_streams[m_stream_count].stats, 0, sizeof(ble_tx_queue_stats_t));
+
+  if (p_id != NULL)
+    *p_id = m_stream_count;
+
+  m_stream_count++;
+
+  return NRF_SUCCESS;
+}
+
+void ble_tx_queue_link_set(uint16_t conn_handle, uint16_t max_len)
+{
+  uint8_t free_slot = BLE_TX_QUEUE_MAX_LINKS;
+
+  if (conn_handle == BLE_CONN_HANDLE_INVALID)
+    return;
+
+  for (uint8_t i = 0; i < BLE_TX_QUEUE_MAX_LINKS; i++)
+  {
+    if ((m_link_active & (1u << i)) == 0)
+    {
+      if (free_slot == BLE_TX_QUEUE_MAX_LINKS)
+        free_slot = i;
+    }
+    else if (m_links[i].conn_handle == conn_handle)
+    {
+      // The packet is built at the smallest payload, a larger one is used from the next packet
+      m_links[i].max_len = MIN(max_len, BLE_TX_QUEUE_MAX_DATA_LEN);
+      return;
+    }
+  }
+
+  if (free_slot == BLE_TX_QUEUE_MAX_LINKS)
+    return;
+
+  // The held packet belongs to the main loop, the slot is left out of it there
+  m_links[free_slot].in_flight   = 0;
+  m_links[free_slot].max_len     = MIN(max_len, BLE_TX_QUEUE_MAX_DATA_LEN);
+  m_links[free_slot].conn_handle = conn_handle;
+  m_link_active |= (1u << free_slot);
+  m_link_reset  |= (1u << free_slot);
+}
+
+void ble_tx_queue_process(void)
+{
+  uint8_t  reset;
+  uint8_t  active;
+  uint8_t  ready;
+  uint8_t  idle;
+  uint16_t max_len;
+
+  CRITICAL_REGION_ENTER();
+  reset        = m_link_reset;
+  m_link_reset = 0;
+  CRITICAL_REGION_EXIT();
+
+  m_held_links &= ~reset;
+
+  for (;;)
+  {
+    m_ble_tx_queue_links_get(&active, &ready, &idle, &max_len);
+
+    if (m_held_id != BLE_TX_QUEUE_NO_STREAM)
+    {
+      m_held_links &= active;
+
+      if ((m_held_links & ready) == 0)
+      {
+        // Only full links wait for the packet, a slow link misses it rather than starve an idle one
+        if ((m_held_links != 0) && ((idle & ~m_held_links) == 0))
+          return;
+
+        for (uint8_t i = 0; i < BLE_TX_QUEUE_MAX_LINKS; i++)
+        {
+          if (m_held_links & (1u << i))
+            m_streams[m_held_id].stats.dropped++;
+        }
+
+        m_ble_tx_queue_release();
+        continue;
+      }
+    }
+    else
+    {
+      if (ready == 0)
+        return;
+
+      m_held_len = m_ble_tx_queue_fill_next(&m_held_id, max_len);
+      if (m_held_len == 0)
+        return;
+
+      m_held_links = active;
+    }
+
+    m_ble_tx_queue_send(m_held_links & ready);
+
+    if (m_held_links == 0)
+      m_ble_tx_queue_release();
+  }
+}
+
+void ble_tx_queue_stats_get(uint8_t id, ble_tx_queue_stats_t *p_stats)
+{
+  if (id < m_stream_count)
+    *p_stats = m_streams[id].stats;
+  else
+    memset(p_stats, 0, sizeof(ble_tx_queue_stats_t));
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Handle the TX complete and the disconnection events
+ *
+ * @param[in]     p_ble_evt     Event received from the BLE stack
+ * @param[in]     p_context     Unused
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ble_tx_queue_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+  uint8_t i;
+
+  UNUSED_PARAMETER(p_context);
+
+  // Connection handle of a GAP or a GATTS event
+  for (i = 0; i < BLE_TX_QUEUE_MAX_LINKS; i++)
+  {
+    if ((m_link_active & (1u << i)) && (m_links[i].conn_handle == p_ble_evt->evt.common_evt.conn_handle))
+      break;
+  }
+
+  if (i == BLE_TX_QUEUE_MAX_LINKS)
+    return;
+
+  switch (p_ble_evt->header.evt_id)
+  {
+  case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+  {
+    uint8_t count = p_ble_evt->evt.gatts_evt.params.hvn_tx_complete.count;
+
+    m_links[i].in_flight = (m_links[i].in_flight > count) ? (m_links[i].in_flight - count) : 0;
+  }
+  break;
+
+  case BLE_GAP_EVT_DISCONNECTED:
+    m_links[i].in_flight = 0;
+    m_link_active &= ~(1u << i);
+    m_link_reset  |= (1u << i);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief         Build the next packet of the highest priority stream that has one
+ *
+ * @param[out]    p_id          Stream of the packet
+ * @param[in]     max_len       Usable ATT payload
+ *
+ * @attention     Streams of one priority are asked in turn, starting after the last one served
+ *
+ * @return        Packet length, 0 if no stream has a packet
+ */
+static uint16_t m_ble_tx_queue_fill_next(uint8_t *p_id, uint16_t max_len)
+{
+  for (uint8_t prio = 0; prio < BLE_TX_QUEUE_PRIO_MAX; prio++)
+  {
+    for (uint8_t n = 1; n <= m_stream_count; n++)
+    {
+      uint8_t id = (m_last_served[prio] + n) % m_stream_count;
+
+      if (m_streams[id].priority != prio)
+        continue;
+
+      uint16_t len = m_streams[id].fill(m_held_buf, max_len);
+      if (len != 0)
+      {
+        m_last_served[prio] = id;
+        *p_id = id;
+        return len;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief         Get the state of the links
+ *
+ * @param[out]    p_active      Connected links
+ * @param[out]    p_ready       Links with room in their SoftDevice queue
+ * @param[out]    p_idle        Links with nothing in their SoftDevice queue
+ * @param[out]    p_max_len     Smallest usable ATT payload of the connected links
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ble_tx_queue_links_get(uint8_t *p_active, uint8_t *p_ready, uint8_t *p_idle, uint16_t *p_max_len)
+{
+  *p_active  = 0;
+  *p_ready   = 0;
+  *p_idle    = 0;
+  *p_max_len = BLE_TX_QUEUE_MAX_DATA_LEN;
+
+  for (uint8_t i = 0; i < BLE_TX_QUEUE_MAX_LINKS; i++)
+  {
+    uint8_t in_flight = m_links[i].in_flight;
+
+    if ((m_link_active & (1u << i)) == 0)
+      continue;
+
+    *p_active  |= (1u << i);
+    *p_max_len  = MIN(*p_max_len, m_links[i].max_len);
+
+    if (in_flight < BLE_TX_QUEUE_HVN_SIZE)
+      *p_ready |= (1u << i);
+
+    if (in_flight == 0)
+      *p_idle |= (1u << i);
+  }
+}
+
+/**
+ * @brief         Send the held packet to links
+ *
+ * @param[in]     links         Links with room for it
+ *
+ * @attention     A link is cleared from the held links once it took or refused the packet
+ *
+ * @return        None
+ */
+static void m_ble_tx_queue_send(uint8_t links)
+{
+  ble_tx_queue_stream_t *p_stream = &m_streams[m_held_id];
+  ret_code_t             err_code;
+
+  for (uint8_t i = 0; i < BLE_TX_QUEUE_MAX_LINKS; i++)
+  {
+    if ((links & (1u << i)) == 0)
+      continue;
+
+    err_code = p_stream->send(m_held_buf, m_held_len, m_links[i].conn_handle);
+    if (err_code == NRF_ERROR_RESOURCES)
+    {
+      // Queue filled by a notification sent outside the scheduler, wait for a TX complete
+      p_stream->stats.backpressure++;
+      m_links[i].in_flight = BLE_TX_QUEUE_HVN_SIZE;
+      continue;
+    }
+
+    if (err_code == NRF_SUCCESS)
+    {
+      p_stream->stats.sent++;
+      CRITICAL_REGION_ENTER();
+      m_links[i].in_flight++;
+      CRITICAL_REGION_EXIT();
+    }
+    else if (err_code != NRF_ERROR_INVALID_STATE)
+    {
+      // Link lost, the packet can not be delivered
+      p_stream->stats.dropped++;
+    }
+
+    m_held_links &= ~(1u << i);
+  }
+}
+
+/**
+ * @brief         Release the held packet
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_ble_tx_queue_release(void)
+{
+  m_held_id    = BLE_TX_QUEUE_NO_STREAM;
+  m_held_len   = 0;
+  m_held_links = 0;
+}
+
+/* End of file -------------------------------------------------------- */
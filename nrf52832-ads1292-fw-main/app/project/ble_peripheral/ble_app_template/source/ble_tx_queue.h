@@ -0,0 +1,140 @@
+/**
+ * @file       ble_tx_queue.h
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Notification scheduler, keeps the SoftDevice TX queue full across the streams
+ * @note       Streams are pulled: the scheduler asks the highest-priority stream with data for
+ *             its next packet only when the SoftDevice can take it, so nothing is built to be
+ *             thrown away and a stream keeps its backlog in its own buffer. With several links a
+ *             packet is built once, at the smallest payload of the links, and handed to each link
+ *             in turn, the links that have not enabled the stream skip it.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BLE_TX_QUEUE_H
+#define __BLE_TX_QUEUE_H
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "sdk_errors.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BLE_TX_QUEUE_HVN_SIZE       (8)                                   /**< SoftDevice notification queue per link. */
+#define BLE_TX_QUEUE_MAX_STREAMS    (9)                                   /**< Streams that can be added. */
+#define BLE_TX_QUEUE_MAX_DATA_LEN   (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3)   /**< Largest packet. */
+#define BLE_TX_QUEUE_MAX_LINKS      (NRF_SDH_BLE_PERIPHERAL_LINK_COUNT)   /**< Links served at once. */
+#define BLE_TX_QUEUE_OBSERVER_PRIO  2                                     /**< Ahead of the application observer. */
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Stream priority, a lower value is served first
+ */
+typedef enum
+{
+  BLE_TX_QUEUE_PRIO_EVENT,        /**< Rhythm, activity and timing records */
+  BLE_TX_QUEUE_PRIO_WAVEFORM,     /**< Biosignal and motion streams */
+  BLE_TX_QUEUE_PRIO_TELEMETRY,    /**< Bulk transfers that may wait */
+  BLE_TX_QUEUE_PRIO_MAX
+}
+ble_tx_queue_prio_t;
+
+/**
+ * @brief Stream packet builder type
+ *
+ * @param[out]    p_buf       Output buffer
+ * @param[in]     max_len     Usable ATT payload
+ *
+ * @return        Packet length, 0 if the stream has nothing to send
+ */
+typedef uint16_t (*ble_tx_queue_fill_t)(uint8_t *p_buf, uint16_t max_len);
+
+/**
+ * @brief Stream packet sender type, the service notification function
+ *
+ * @param[in]     p_data      Packet
+ * @param[in]     len         Packet length
+ * @param[in]     conn_handle Connection handle
+ *
+ * @return        Error code of sd_ble_gatts_hvx(), NRF_ERROR_INVALID_STATE when the link has not
+ *                enabled the notifications
+ */
+typedef ret_code_t (*ble_tx_queue_send_t)(const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+
+/**
+ * @brief Stream statistics
+ */
+typedef struct
+{
+  uint32_t sent;            /**< Packets taken by the SoftDevice, once per link */
+  uint32_t dropped;         /**< Packets a link lost (link gone, or too slow while another link idled) */
+  uint32_t backpressure;    /**< Packets held back by a full SoftDevice queue */
+}
+ble_tx_queue_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief                        Function for adding a stream.
+ *
+ * @param[in]     priority       Priority, streams of one priority are served in turn
+ * @param[in]     fill           Packet builder
+ * @param[in]     send           Packet sender
+ * @param[out]    p_id           Stream identifier, may be NULL
+ *
+ * @attention     None
+ *
+ * @return
+ * - NRF_SUCCESS on success
+ * - NRF_ERROR_INVALID_PARAM on a bad priority or a NULL function
+ * - NRF_ERROR_NO_MEM if BLE_TX_QUEUE_MAX_STREAMS are added
+ */
+ret_code_t ble_tx_queue_stream_add(ble_tx_queue_prio_t priority, ble_tx_queue_fill_t fill,
+                                   ble_tx_queue_send_t send, uint8_t *p_id);
+
+/**
+ * @brief                        Function for adding a link the streams are sent on, or updating it.
+ *
+ * @param[in]     conn_handle    Connection handle
+ * @param[in]     max_len        Usable ATT payload (ATT MTU - 3)
+ *
+ * @attention     Called on connection and on every ATT MTU update, the link is removed on its
+ *                disconnection. Links beyond BLE_TX_QUEUE_MAX_LINKS are ignored.
+ *
+ * @return        None
+ */
+void ble_tx_queue_link_set(uint16_t conn_handle, uint16_t max_len);
+
+/**
+ * @brief                        Function for sending packets until the SoftDevice queue is full.
+ *
+ * @param[in]     None
+ *
+ * @attention     Called from the main loop, the streams are only pulled from here
+ *
+ * @return        None
+ */
+void ble_tx_queue_process(void);
+
+/**
+ * @brief                        Function for getting the statistics of a stream.
+ *
+ * @param[in]     id             Stream identifier
+ * @param[out]    p_stats        Statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ble_tx_queue_stats_get(uint8_t id, ble_tx_queue_stats_t *p_stats);
+
+#endif // __BLE_TX_QUEUE_H
+
+/* End of file -------------------------------------------------------- */
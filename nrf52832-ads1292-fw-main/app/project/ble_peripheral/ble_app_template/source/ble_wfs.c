@@ -0,0 +1,282 @@
+/**
+ * @file       ble_wfs.c
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      WFS (BLE Waveform Service)
+ * @note       None
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "sdk_common.h"
+#include "ble.h"
+#include "ble_wfs.h"
+#include "ble_srv_common.h"
+#include "ble_conn_state.h"
+#include "nrf_log.h"
+
+/* Private defines ---------------------------------------------------- */
+#define BLE_UUID_WFS_DATA_CHARACTERISTIC     0x5235
+#define BLE_UUID_WFS_CONFIG_CHARACTERISTIC   0x5236
+
+#define WFS_BASE_UUID                                                                                \
+  {                                                                                                  \
+    {                                                                                                \
+      0x41, 0xEE, 0x68, 0x3A, 0x99, 0x0F, 0x0E, 0x72, 0x85, 0x49, 0x8D, 0xB3, 0x00, 0x00, 0x00, 0x00 \
+    }                                                                                                \
+  } /**< Used vendor specific UUID. */
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+/* Private function prototypes ---------------------------------------- */
+static ret_code_t m_ble_wfs_send_notification(ble_gatts_hvx_params_t *const p_hvx_params, uint16_t conn_handle);
+static void m_ble_wfs_on_connect(ble_wfs_t *p_wfs, ble_evt_t const *p_ble_evt);
+
+/* Function definitions ----------------------------------------------- */
+uint32_t ble_wfs_init(ble_wfs_t *p_wfs, ble_wfs_init_t const *p_wfs_init)
+{
+  ret_code_t            err_code;
+  ble_uuid_t            ble_uuid;
+  ble_uuid128_t         wfs_base_uuid = WFS_BASE_UUID;
+  ble_add_char_params_t add_char_params;
+
+  VERIFY_PARAM_NOT_NULL(p_wfs);
+  VERIFY_PARAM_NOT_NULL(p_wfs_init);
+
+  // Initialize the service structure.
+  p_wfs->evt_handler = p_wfs_init->evt_handler;
+
+  // Add a custom base UUID.
+  err_code = sd_ble_uuid_vs_add(&wfs_base_uuid, &p_wfs->uuid_type);
+  VERIFY_SUCCESS(err_code);
+
+  ble_uuid.type = p_wfs->uuid_type;
+  ble_uuid.uuid = BLE_UUID_WFS_SERVICE;
+
+  // Add the service.
+  err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &p_wfs->service_handle);
+  VERIFY_SUCCESS(err_code);
+
+  // Add the Data Characteristic, notify only and held by the application.
+  memset(&add_char_params, 0, sizeof(add_char_params));
+  add_char_params.uuid              = BLE_UUID_WFS_DATA_CHARACTERISTIC;
+  add_char_params.uuid_type         = p_wfs->uuid_type;
+  add_char_params.max_len           = BLE_WFS_MAX_DATA_LEN;
+  add_char_params.init_len          = 0;
+  add_char_params.p_init_value      = p_wfs->data_value;
+  add_char_params.is_var_len        = true;
+  add_char_params.is_value_user     = true;
+  add_char_params.char_props.notify = 1;
+  add_char_params.cccd_write_access = p_wfs_init->bl_cccd_wr_sec;
+
+  err_code = characteristic_add(p_wfs->service_handle, &add_char_params, &(p_wfs->wfs_char_handles[BLE_WFS_DATA_CHAR]));
+  VERIFY_SUCCESS(err_code);
+
+  // Add the Config Characteristic.
+  memset(&add_char_params, 0, sizeof(add_char_params));
+  add_char_params.uuid             = BLE_UUID_WFS_CONFIG_CHARACTERISTIC;
+  add_char_params.uuid_type        = p_wfs->uuid_type;
+  add_char_params.max_len          = BLE_WFS_CONFIG_LEN;
+  add_char_params.init_len         = BLE_WFS_CONFIG_LEN;
+  add_char_params.is_var_len       = true;
+  add_char_params.p_init_value     = (uint8_t *)p_wfs_init->init_config;
+  add_char_params.char_props.read  = 1;
+  add_char_params.char_props.write = 1;
+  add_char_params.read_access      = p_wfs_init->bl_rd_sec;
+  add_char_params.write_access     = p_wfs_init->bl_wr_sec;
+
+  return characteristic_add(p_wfs->service_handle, &add_char_params, &(p_wfs->wfs_char_handles[BLE_WFS_CONFIG_CHAR]));
+}
+
+ret_code_t ble_wfs_data_update(ble_wfs_t *p_wfs, const uint8_t *p_data, uint16_t len, uint16_t conn_handle)
+{
+  ret_code_t err_code = NRF_ERROR_INVALID_STATE;
+
+  VERIFY_PARAM_NOT_NULL(p_wfs);
+  VERIFY_PARAM_NOT_NULL(p_data);
+
+  if (len > BLE_WFS_MAX_DATA_LEN)
+    return NRF_ERROR_INVALID_LENGTH;
+
+  // Send value if connected and notifying.
+  if (conn_handle != BLE_CONN_HANDLE_INVALID)
+  {
+    ble_gatts_hvx_params_t hvx_params;
+
+    memset(&hvx_params, 0, sizeof(hvx_params));
+
+    hvx_params.handle = p_wfs->wfs_char_handles[BLE_WFS_DATA_CHAR].value_handle;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+    hvx_params.offset = 0;
+    hvx_params.p_len  = &len;
+    hvx_params.p_data = p_data;
+
+    if (conn_handle == BLE_CONN_HANDLE_ALL)
+    {
+      ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_conn_handles();
+
+      // Try sending notifications to all valid connection handles.
+      for (uint32_t i = 0; i < conn_handles.len; i++)
+      {
+        if ((ble_conn_state_status(conn_handles.conn_handles[i]) == BLE_CONN_STATUS_CONNECTED) &&
+            ble_wfs_is_notification_enabled(p_wfs, conn_handles.conn_handles[i]))
+          err_code = m_ble_wfs_send_notification(&hvx_params, conn_handles.conn_handles[i]);
+      }
+    }
+    else if (ble_wfs_is_notification_enabled(p_wfs, conn_handle))
+    {
+      // Checked here so the links without the stream cost no SoftDevice call
+      err_code = m_ble_wfs_send_notification(&hvx_params, conn_handle);
+    }
+  }
+
+  return err_code;
+}
+
+bool ble_wfs_is_notification_enabled(ble_wfs_t *p_wfs, uint16_t conn_handle)
+{
+  ble_wfs_client_context_t *p_client;
+
+  if (blcm_link_ctx_get(p_wfs->p_link_ctx_storage, conn_handle, (void *)&p_client) != NRF_SUCCESS)
+    return false;
+
+  return p_client->is_notification_enabled;
+}
+
+ret_code_t ble_wfs_config_update(ble_wfs_t *p_wfs, const uint8_t *p_config)
+{
+  ble_gatts_value_t gatts_value;
+
+  VERIFY_PARAM_NOT_NULL(p_wfs);
+  VERIFY_PARAM_NOT_NULL(p_config);
+
+  memset(&gatts_value, 0, sizeof(gatts_value));
+  gatts_value.len     = BLE_WFS_CONFIG_LEN;
+  gatts_value.offset  = 0;
+  gatts_value.p_value = (uint8_t *)p_config;
+
+  return sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, p_wfs->wfs_char_handles[BLE_WFS_CONFIG_CHAR].value_handle,
+                                &gatts_value);
+}
+
+void ble_wfs_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+  if ((p_context == NULL) || (p_ble_evt == NULL))
+    return;
+
+  ble_wfs_t *p_wfs = (ble_wfs_t *)p_context;
+
+  switch (p_ble_evt->header.evt_id)
+  {
+  case BLE_GAP_EVT_CONNECTED:
+    m_ble_wfs_on_connect(p_wfs, p_ble_evt);
+    break;
+
+  case BLE_GATTS_EVT_WRITE:
+  {
+    ble_gatts_evt_write_t const *p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+    ble_wfs_client_context_t    *p_client;
+    ble_wfs_evt_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+
+    if ((p_evt_write->handle == p_wfs->wfs_char_handles[BLE_WFS_DATA_CHAR].cccd_handle) &&
+        (p_evt_write->len == 2))
+    {
+      bool enabled = ble_srv_is_notification_enabled(p_evt_write->data);
+
+      // The subscription of the link is kept before the application hears of it
+      if (blcm_link_ctx_get(p_wfs->p_link_ctx_storage, evt.conn_handle, (void *)&p_client) == NRF_SUCCESS)
+        p_client->is_notification_enabled = enabled;
+
+      evt.evt_type = enabled ? BLE_WFS_EVT_NOTIFICATION_ENABLED : BLE_WFS_EVT_NOTIFICATION_DISABLED;
+
+      if (p_wfs->evt_handler != NULL)
+        p_wfs->evt_handler(p_wfs, &evt);
+    }
+    else if (p_evt_write->handle == p_wfs->wfs_char_handles[BLE_WFS_CONFIG_CHAR].value_handle)
+    {
+      evt.evt_type = BLE_WFS_EVT_CONFIG_WRITE;
+      evt.p_data   = p_evt_write->data;
+      evt.len      = p_evt_write->len;
+
+      if (p_wfs->evt_handler != NULL)
+        p_wfs->evt_handler(p_wfs, &evt);
+    }
+  }
+  break;
+
+  default:
+    break;
+  }
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Function for setting the client context of a new link.
+ *
+ * @param[in]     p_wfs        Waveform Service structure.
+ * @param[in]     p_ble_evt    Event received from the BLE stack.
+ *
+ * @attention     The CCCD of a bonded peer is restored by the SoftDevice before the connected
+ *                event, it is read back instead of assumed disabled
+ *
+ * @return        None
+ */
+static void m_ble_wfs_on_connect(ble_wfs_t *p_wfs, ble_evt_t const *p_ble_evt)
+{
+  ble_wfs_client_context_t *p_client;
+  ble_gatts_value_t       gatts_val;
+  uint8_t                 cccd_value[2];
+  uint16_t                conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+  if (blcm_link_ctx_get(p_wfs->p_link_ctx_storage, conn_handle, (void *)&p_client) != NRF_SUCCESS)
+  {
+    NRF_LOG_ERROR("Link context for 0x%02X connection handle could not be fetched.", conn_handle);
+    return;
+  }
+
+  p_client->is_notification_enabled = false;
+
+  memset(&gatts_val, 0, sizeof(gatts_val));
+  gatts_val.p_value = cccd_value;
+  gatts_val.len     = sizeof(cccd_value);
+  gatts_val.offset  = 0;
+
+  if (sd_ble_gatts_value_get(conn_handle, p_wfs->wfs_char_handles[BLE_WFS_DATA_CHAR].cccd_handle,
+                             &gatts_val) == NRF_SUCCESS)
+  {
+    p_client->is_notification_enabled = ble_srv_is_notification_enabled(gatts_val.p_value);
+  }
+}
+
+/**
+ * @brief         Function for sending notifications with the Data characteristic.
+ *
+ * @param[in]     p_hvx_params Pointer to structure with notification data.
+ * @param[in]     conn_handle  Connection handle.
+ *
+ * @attention     None
+ *
+ * @return        NRF_SUCCESS on success, otherwise an error code.
+ *
+ */
+static ret_code_t m_ble_wfs_send_notification(ble_gatts_hvx_params_t *const p_hvx_params, uint16_t conn_handle)
+{
+  ret_code_t err_code = sd_ble_gatts_hvx(conn_handle, p_hvx_params);
+
+  if (err_code != NRF_SUCCESS)
+  {
+    NRF_LOG_DEBUG("Error: 0x%08X while sending notification with conn_handle: 0x%04X", err_code, conn_handle);
+  }
+
+  return err_code;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,206 @@
+/**
+ * @file       ble_wfs.h
+ * @copyright  Copyright (C) 2020 ThuanLe. All rights reserved.
+ * @license    This project is released under the ThuanLe License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      WFS (BLE Waveform Service)
+ * @note       None
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BLE_WFS_H
+#define __BLE_WFS_H
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "ble_link_ctx_manager.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BLE_UUID_WFS_SERVICE  (0x5234)                                  /**< The UUID of the Waveform Service. */
+#define BLE_WFS_MAX_DATA_LEN  (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3)       /**< Maximum length of a waveform packet. */
+#define BLE_WFS_CONFIG_LEN    (4)                                       /**< Length of the configuration value, 3 from the older peers. */
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Waveform Charaterictic
+ */
+typedef enum
+{
+  BLE_WFS_DATA_CHAR,        /**< Waveform packets */
+  BLE_WFS_CONFIG_CHAR,      /**< Stream configuration {source, bit depth, channel mask, compression} */
+  BLE_WFS_MAX_CHAR
+}
+ble_wfs_charaterictic_t;
+
+/**
+ * @brief Waveform Service event type
+ */
+typedef enum
+{
+  BLE_WFS_EVT_NOTIFICATION_ENABLED,   /**< Waveform notification enabled event. */
+  BLE_WFS_EVT_NOTIFICATION_DISABLED,  /**< Waveform notification disabled event. */
+  BLE_WFS_EVT_CONFIG_WRITE            /**< Configuration written by the peer. */
+}
+ble_wfs_evt_type_t;
+
+/**
+ * @brief Waveform Service event.
+ */
+typedef struct
+{
+  ble_wfs_evt_type_t evt_type;     /**< Type of event. */
+  uint16_t           conn_handle;  /**< Connection handle. */
+  const uint8_t     *p_data;       /**< Written value (BLE_WFS_EVT_CONFIG_WRITE only). */
+  uint16_t           len;          /**< Written length (BLE_WFS_EVT_CONFIG_WRITE only). */
+}
+ble_wfs_evt_t;
+
+/**
+ * @brief Waveform Service client context, one per link.
+ */
+typedef struct
+{
+  bool is_notification_enabled;    /**< Notifications of the data characteristic enabled by the peer. */
+}
+ble_wfs_client_context_t;
+
+/* Forward declaration of the ble_wfs_t type. */
+typedef struct ble_wfs_s ble_wfs_t;
+
+/* Waveform Service event handler type. */
+typedef void (* ble_wfs_evt_handler_t) (ble_wfs_t * p_wfs, ble_wfs_evt_t * p_evt);
+
+/**
+ * @brief Waveform Service initialization structure.
+ */
+typedef struct
+{
+  ble_wfs_evt_handler_t  evt_handler;                      /**< Event handler to be called for handling events in the Waveform Service. */
+  uint8_t                init_config[BLE_WFS_CONFIG_LEN];  /**< Initial value of the configuration characteristic. */
+  security_req_t         bl_rd_sec;                        /**< Security requirement for reading the configuration. */
+  security_req_t         bl_wr_sec;                        /**< Security requirement for writing the configuration. */
+  security_req_t         bl_cccd_wr_sec;                   /**< Security requirement for writing the characteristic CCCD. */
+}
+ble_wfs_init_t;
+
+/**
+ * @brief Waveform Service structure.
+ */
+struct ble_wfs_s
+{
+  uint8_t                  uuid_type;                            /**< UUID type for Waveform Service Base UUID. */
+  ble_wfs_evt_handler_t    evt_handler;                          /**< Event handler to be called for handling events in the Waveform Service. */
+  uint16_t                 service_handle;                       /**< Handle of Waveform Service (as provided by the BLE stack). */
+  ble_gatts_char_handles_t wfs_char_handles[BLE_WFS_MAX_CHAR];   /**< Handles related to the Waveform characteristics. */
+  uint8_t                  data_value[BLE_WFS_MAX_DATA_LEN];     /**< Application-held value of the data characteristic. */
+  blcm_link_ctx_storage_t *const p_link_ctx_storage;             /**< Client contexts of the links. */
+};
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Macro for defining a ble_wfs instance.
+ *
+ * @param[in]     _name         Name of the instance.
+ * @param[in]     _max_clients  Maximum number of links served at once.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+#define BLE_WFS_DEF(_name, _max_clients)                            \
+BLE_LINK_CTX_MANAGER_DEF(CONCAT_2(_name, _link_ctx_storage),        \
+                         (_max_clients),                            \
+                         sizeof(ble_wfs_client_context_t));         \
+static ble_wfs_t _name =                                            \
+{                                                                   \
+  .p_link_ctx_storage = &CONCAT_2(_name, _link_ctx_storage)         \
+};                                                                  \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                 \
+                     BLE_HRS_BLE_OBSERVER_PRIO,                     \
+                     ble_wfs_on_ble_evt, &_name)
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief                     Function for initializing the Waveform Service.
+ *
+ * @param[in]     p_wfs_init  Information needed to initialize the service.
+ *
+ * @param[out]    p_wfs       Waveform Service structure. This structure must be supplied
+ *                            by the application. It is initialized by this function and will
+ *                            later be used to identify this particular service instance.
+ *
+ * @attention     The data characteristic value is held in p_wfs and is not readable, so the
+ *                packets do not take space in the SoftDevice attribute table
+ *
+ * @return
+ * - NRF_SUCCESS If the service was successfully initialized. Otherwise, an error code is returned.
+ * - NRF_ERROR_NULL If either of the pointers p_wfs or p_wfs_init is NULL.
+ */
+uint32_t ble_wfs_init(ble_wfs_t *p_wfs, ble_wfs_init_t const *p_wfs_init);
+
+/**
+ * @brief                        Function for sending a waveform packet.
+ *
+ * @param[in]     p_wfs          Waveform Service structure.
+ * @param[in]     p_data         Packet to send
+ * @param[in]     len            Packet length, at most BLE_WFS_MAX_DATA_LEN and the negotiated ATT MTU - 3
+ * @param[in]     conn_handle    Connection handle.
+ *
+ * @attention     None
+ *
+ * @return
+ * - NRF_SUCCESS on success
+ * - NRF_ERROR_RESOURCES if the notification queue is full, the caller should retry later
+ * - NRF_ERROR_INVALID_STATE if the peer of the link has not enabled the notifications
+ * - Otherwise an error code is returned
+ */
+ret_code_t ble_wfs_data_update(ble_wfs_t *p_wfs, const uint8_t *p_data, uint16_t len, uint16_t conn_handle);
+
+/**
+ * @brief                        Function for updating the value of the configuration characteristic.
+ *
+ * @param[in]     p_wfs          Waveform Service structure.
+ * @param[in]     p_config       Configuration value, BLE_WFS_CONFIG_LEN bytes
+ *
+ * @attention     None
+ *
+ * @return        NRF_SUCCESS on success, otherwise an error code.
+ */
+ret_code_t ble_wfs_config_update(ble_wfs_t *p_wfs, const uint8_t *p_config);
+
+/**
+ * @brief                        Function for checking whether a link has enabled the notifications.
+ *
+ * @param[in]     p_wfs          Waveform Service structure.
+ * @param[in]     conn_handle    Connection handle.
+ *
+ * @attention     None
+ *
+ * @return        true if the peer of the link has enabled the data notifications
+ */
+bool ble_wfs_is_notification_enabled(ble_wfs_t *p_wfs, uint16_t conn_handle);
+
+/**
+ * @brief                     Function for handling the Waveform Service's BLE events.
+ *
+ * @param[in]     p_ble_evt   Event received from the SoftDevice.
+ * @param[in]     p_context   Waveform Service structure.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void ble_wfs_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+#endif // __BLE_WFS_H
+
+/* End of file -------------------------------------------------------- */
@@ -14,14 +14,64 @@
 
 /* Includes ----------------------------------------------------------- */
 #include "bsp_hw.h"
+#include "bsp_time.h"
+#include "app_util_platform.h"
+#include "nrf_rtc.h"
+#include "nrfx_twim.h"
 
 /* Private defines ---------------------------------------------------- */
 #define TWI_INSTANCE           0
+#define PPI_COUNTER_INSTANCE   2
+#define PPI_RTC                NRF_RTC2
 #define SPI_INSTANCE_1         1
 #define SPI_INSTANCE_2         2
 
 /* Private enumerate/structure ---------------------------------------- */
-static nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(TWI_INSTANCE);
+/**
+ * @brief I2C transaction slot structure, owned by the transaction until completion
+ */
+typedef struct
+{
+  nrf_twi_mngr_transaction_t transaction;
+  nrf_twi_mngr_transfer_t    transfers[2];
+  uint8_t                    buffer[1 + BSP_I2C_WRITE_MAX];  // Register address then write data
+  bsp_i2c_callback_t         callback;
+  void                      *p_context;
+  uint32_t                   start_tick;
+  bool                       busy;
+}
+m_i2c_slot_t;
+
+/**
+ * @brief I2C blocking transaction structure
+ */
+typedef struct
+{
+  volatile bool done;
+  base_status_t status;
+}
+m_i2c_sync_t;
+
+/**
+ * @brief I2C PPI read structure
+ */
+typedef struct
+{
+  volatile bool         active;
+  uint8_t               reg_addr;
+  uint8_t              *p_buffer;
+  uint8_t               len;
+  uint16_t              count;
+  bsp_i2c_ppi_handler_t handler;
+  nrf_ppi_channel_t     ch_trigger;
+  nrf_ppi_channel_t     ch_count;
+  nrf_ppi_channel_t     ch_stop;
+}
+m_i2c_ppi_t;
+
+NRF_TWI_MNGR_DEF(m_twi_mngr, BSP_I2C_QUEUE_SIZE, TWI_INSTANCE);
+static const nrfx_twim_t     m_ppi_twim    = NRFX_TWIM_INSTANCE(TWI_INSTANCE);
+static const nrf_drv_timer_t m_ppi_counter = NRF_DRV_TIMER_INSTANCE(PPI_COUNTER_INSTANCE);
 static nrf_drv_spi_t m_spi_1 = NRF_DRV_SPI_INSTANCE(SPI_INSTANCE_1);
 static nrf_drv_spi_t m_spi_2 = NRF_DRV_SPI_INSTANCE(SPI_INSTANCE_2);
 
@@ -30,11 +80,40 @@ static nrf_drv_spi_t m_spi_2 = NRF_DRV_SPI_INSTANCE(SPI_INSTANCE_2);
 /* Private variables -------------------------------------------------- */
 static volatile bool_t data_ready = BS_FALSE;
 
+static m_i2c_slot_t    m_i2c_slots[BSP_I2C_QUEUE_SIZE + 1];
+static bsp_i2c_stats_t m_i2c_stats;
+static m_i2c_ppi_t     m_i2c_ppi;
+
+static const nrf_drv_twi_config_t m_twi_config =
+{
+  .scl                = IO_I2C1_SCL,
+  .sda                = IO_I2C1_SDA,
+  .frequency          = NRF_DRV_TWI_FREQ_400K,
+  .interrupt_priority = APP_IRQ_PRIORITY_HIGH,
+  .clear_bus_init     = false
+};
+
+static const nrfx_twim_config_t m_ppi_twim_config =
+{
+  .scl                = IO_I2C1_SCL,
+  .sda                = IO_I2C1_SDA,
+  .frequency          = NRF_TWIM_FREQ_400K,
+  .interrupt_priority = APP_IRQ_PRIORITY_HIGH,
+  .hold_bus_uninit    = false
+};
+
 /* Private function prototypes ---------------------------------------- */
 static void m_bsp_i2c_init(void);
 static void m_bsp_gpio_init(void);
 static void m_bsp_spi_1_init(void);
 static void m_bsp_spi_2_init(void);
+static m_i2c_slot_t *m_bsp_i2c_slot_alloc(void);
+static base_status_t m_bsp_i2c_schedule(m_i2c_slot_t *p_slot, uint8_t number_of_transfers,
+                                        bsp_i2c_callback_t callback, void *p_context);
+static void m_bsp_i2c_done(ret_code_t result, void *p_user_data);
+static void m_bsp_i2c_sync_done(base_status_t status, void *p_context);
+static void m_bsp_i2c_ppi_twim_handler(nrfx_twim_evt_t const *p_event, void *p_context);
+static void m_bsp_i2c_ppi_counter_handler(nrf_timer_event_t event_type, void *p_context);
 
 /* Function definitions ----------------------------------------------- */
 void bsp_hw_init(void)
@@ -47,19 +126,211 @@ void bsp_hw_init(void)
 
 int bsp_i2c_write(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len)
 {
-  uint8_t buffer[10];
+  m_i2c_sync_t sync = { .done = false, .status = BS_ERROR };
 
-  memcpy(buffer, &reg_addr, 1);
-  memcpy(buffer + 1, p_data, len);
+  if (bsp_i2c_write_async(slave_addr, reg_addr, p_data, len, m_bsp_i2c_sync_done, &sync) != BS_OK)
+    return 1;
 
-  return nrf_drv_twi_tx(&m_twi, slave_addr, buffer, len + 1, false);
+  while (!sync.done);
+
+  return (sync.status == BS_OK) ? 0 : 1;
 }
 
 int bsp_i2c_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len)
 {
-  nrf_drv_twi_tx(&m_twi, slave_addr, (uint8_t *)&reg_addr, 1, true);
+  m_i2c_sync_t sync = { .done = false, .status = BS_ERROR };
+
+  if (bsp_i2c_read_async(slave_addr, reg_addr, p_data, len, m_bsp_i2c_sync_done, &sync) != BS_OK)
+    return 1;
+
+  while (!sync.done);
+
+  return (sync.status == BS_OK) ? 0 : 1;
+}
+
+base_status_t bsp_i2c_read_async(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len,
+                                 bsp_i2c_callback_t callback, void *p_context)
+{
+  m_i2c_slot_t *p_slot;
+
+  CHECK(len <= UINT8_MAX, BS_ERROR_PARAMS);
+
+  p_slot = m_bsp_i2c_slot_alloc();
+  if (p_slot == NULL)
+  {
+    m_i2c_stats.rejected++;
+    return BS_ERROR;
+  }
+
+  p_slot->buffer[0] = reg_addr;
+
+  p_slot->transfers[0] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_WRITE(slave_addr, p_slot->buffer, 1, NRF_TWI_MNGR_NO_STOP);
+  p_slot->transfers[1] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_READ(slave_addr, p_data, len, 0);
+
+  return m_bsp_i2c_schedule(p_slot, 2, callback, p_context);
+}
+
+base_status_t bsp_i2c_write_async(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len,
+                                  bsp_i2c_callback_t callback, void *p_context)
+{
+  m_i2c_slot_t *p_slot;
+
+  CHECK(len <= BSP_I2C_WRITE_MAX, BS_ERROR_PARAMS);
+
+  p_slot = m_bsp_i2c_slot_alloc();
+  if (p_slot == NULL)
+  {
+    m_i2c_stats.rejected++;
+    return BS_ERROR;
+  }
+
+  p_slot->buffer[0] = reg_addr;
+  memcpy(&p_slot->buffer[1], p_data, len);
+
+  p_slot->transfers[0] = (nrf_twi_mngr_transfer_t)NRF_TWI_MNGR_WRITE(slave_addr, p_slot->buffer, len + 1, 0);
+
+  return m_bsp_i2c_schedule(p_slot, 1, callback, p_context);
+}
+
+void bsp_i2c_stats_get(bsp_i2c_stats_t *p_stats)
+{
+  CRITICAL_REGION_ENTER();
+  memcpy(p_stats, &m_i2c_stats, sizeof(bsp_i2c_stats_t));
+  CRITICAL_REGION_EXIT();
+}
+
+base_status_t bsp_i2c_ppi_read_start(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_buffer, uint8_t len,
+                                     uint16_t count, uint32_t period_ticks, bsp_i2c_ppi_handler_t handler)
+{
+  nrf_drv_timer_config_t timer_config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+  nrfx_twim_xfer_desc_t  xfer         = NRFX_TWIM_XFER_DESC_TXRX(slave_addr, &m_i2c_ppi.reg_addr, 1, p_buffer, len);
+  uint32_t               flags        = NRFX_TWIM_FLAG_HOLD_XFER | NRFX_TWIM_FLAG_RX_POSTINC |
+                                        NRFX_TWIM_FLAG_NO_XFER_EVT_HANDLER | NRFX_TWIM_FLAG_REPEATED_XFER |
+                                        NRFX_TWIM_FLAG_NO_SPURIOUS_STOP_CHECK;
+  ret_code_t             err_code;
+
+  CHECK((p_buffer != NULL) && (len > 0) && (count > 0) && (handler != NULL), BS_ERROR_PARAMS);
+  CHECK((period_ticks > 0) && (period_ticks <= RTC_CC_COMPARE_Msk), BS_ERROR_PARAMS);
+  CHECK(!m_i2c_ppi.active, BS_ERROR);
+
+  // Take the bus only when no transaction is queued, new ones are rejected from here on
+  CRITICAL_REGION_ENTER();
+  m_i2c_ppi.active = true;
+  for (uint8_t i = 0; i < ARRAY_SIZE(m_i2c_slots); i++)
+  {
+    if (m_i2c_slots[i].busy)
+      m_i2c_ppi.active = false;
+  }
+  CRITICAL_REGION_EXIT();
+
+  CHECK(m_i2c_ppi.active, BS_ERROR);
+
+  m_i2c_ppi.reg_addr = reg_addr;
+  m_i2c_ppi.p_buffer = p_buffer;
+  m_i2c_ppi.len      = len;
+  m_i2c_ppi.count    = count;
+  m_i2c_ppi.handler  = handler;
+
+  // The queue releases TWIM0 (TWIM1 shares SPIM1 with the AFE), the periodic reads own it from here,
+  // only bus errors raise an interrupt
+  nrf_twi_mngr_uninit(&m_twi_mngr);
+
+  err_code = nrfx_twim_init(&m_ppi_twim, &m_ppi_twim_config, m_bsp_i2c_ppi_twim_handler, NULL);
+  APP_ERROR_CHECK(err_code);
+  nrfx_twim_enable(&m_ppi_twim);
+
+  err_code = nrfx_twim_xfer(&m_ppi_twim, &xfer, flags);
+  APP_ERROR_CHECK(err_code);
+
+  // Counter of completed reads, interrupt at the end of each half of the buffer
+  timer_config.mode = NRF_TIMER_MODE_COUNTER;
+  err_code = nrf_drv_timer_init(&m_ppi_counter, &timer_config, m_bsp_i2c_ppi_counter_handler);
+  APP_ERROR_CHECK(err_code);
+
+  nrf_drv_timer_compare(&m_ppi_counter, NRF_TIMER_CC_CHANNEL0, count, true);
+  nrf_drv_timer_extended_compare(&m_ppi_counter, NRF_TIMER_CC_CHANNEL1, 2 * count,
+                                 NRF_TIMER_SHORT_COMPARE1_CLEAR_MASK, true);
+
+  // RTC2 compare starts a read and restarts the period
+  nrf_rtc_task_trigger(PPI_RTC, NRF_RTC_TASK_STOP);
+  nrf_rtc_task_trigger(PPI_RTC, NRF_RTC_TASK_CLEAR);
+  nrf_rtc_prescaler_set(PPI_RTC, 0);
+  nrf_rtc_cc_set(PPI_RTC, 0, period_ticks);
+  nrf_rtc_event_clear(PPI_RTC, NRF_RTC_EVENT_COMPARE_0);
+  nrf_rtc_event_enable(PPI_RTC, NRF_RTC_INT_COMPARE0_MASK);
+
+  err_code = nrf_drv_ppi_init();
+  if (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED)
+    APP_ERROR_CHECK(err_code);
+
+  err_code = nrf_drv_ppi_channel_alloc(&m_i2c_ppi.ch_trigger);
+  APP_ERROR_CHECK(err_code);
+  err_code = nrf_drv_ppi_channel_assign(m_i2c_ppi.ch_trigger,
+                                        nrf_rtc_event_address_get(PPI_RTC, NRF_RTC_EVENT_COMPARE_0),
+                                        nrfx_twim_start_task_get(&m_ppi_twim, NRFX_TWIM_XFER_TXRX));
+  APP_ERROR_CHECK(err_code);
+  err_code = nrf_drv_ppi_channel_fork_assign(m_i2c_ppi.ch_trigger, nrf_rtc_task_address_get(PPI_RTC, NRF_RTC_TASK_CLEAR));
+  APP_ERROR_CHECK(err_code);
+
+  // Each trigger is stamped, the newest one is the last read of a completed half
+  CHECK_STATUS(bsp_time_capture_attach(BSP_TIME_CAPTURE_IMU_PPI, nrf_rtc_event_address_get(PPI_RTC, NRF_RTC_EVENT_COMPARE_0)));
+
+  err_code = nrf_drv_ppi_channel_alloc(&m_i2c_ppi.ch_count);
+  APP_ERROR_CHECK(err_code);
+  err_code = nrf_drv_ppi_channel_assign(m_i2c_ppi.ch_count,
+                                        nrfx_twim_stopped_event_get(&m_ppi_twim),
+                                        nrf_drv_timer_task_address_get(&m_ppi_counter, NRF_TIMER_TASK_COUNT));
+  APP_ERROR_CHECK(err_code);
+
+  // The end of the buffer stops the trigger, no read lands past it before the EasyDMA pointer is rewound
+  err_code = nrf_drv_ppi_channel_alloc(&m_i2c_ppi.ch_stop);
+  APP_ERROR_CHECK(err_code);
+  err_code = nrf_drv_ppi_channel_assign(m_i2c_ppi.ch_stop,
+                                        nrf_drv_timer_event_address_get(&m_ppi_counter, NRF_TIMER_EVENT_COMPARE1),
+                                        nrf_rtc_task_address_get(PPI_RTC, NRF_RTC_TASK_STOP));
+  APP_ERROR_CHECK(err_code);
+
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_enable(m_i2c_ppi.ch_stop));
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_enable(m_i2c_ppi.ch_count));
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_enable(m_i2c_ppi.ch_trigger));
 
-  return nrf_drv_twi_rx(&m_twi, slave_addr, p_data, len);
+  nrf_drv_timer_enable(&m_ppi_counter);
+  nrf_rtc_task_trigger(PPI_RTC, NRF_RTC_TASK_START);
+
+  return BS_OK;
+}
+
+base_status_t bsp_i2c_ppi_read_stop(void)
+{
+  ret_code_t err_code;
+
+  CHECK(m_i2c_ppi.active, BS_ERROR);
+
+  // The block handler does not restart the trigger any more
+  nrf_drv_timer_compare_int_disable(&m_ppi_counter, NRF_TIMER_CC_CHANNEL0);
+  nrf_drv_timer_compare_int_disable(&m_ppi_counter, NRF_TIMER_CC_CHANNEL1);
+
+  // No new read is triggered, let the one on the bus finish (address, register, address, data)
+  nrf_rtc_task_trigger(PPI_RTC, NRF_RTC_TASK_STOP);
+  nrf_rtc_event_disable(PPI_RTC, NRF_RTC_INT_COMPARE0_MASK);
+  nrf_delay_us((m_i2c_ppi.len + 3) * 9 * 1000000 / 400000 + 100);
+
+  nrf_drv_ppi_channel_disable(m_i2c_ppi.ch_trigger);
+  nrf_drv_ppi_channel_disable(m_i2c_ppi.ch_count);
+  nrf_drv_ppi_channel_disable(m_i2c_ppi.ch_stop);
+  nrf_drv_ppi_channel_free(m_i2c_ppi.ch_trigger);
+  nrf_drv_ppi_channel_free(m_i2c_ppi.ch_count);
+  nrf_drv_ppi_channel_free(m_i2c_ppi.ch_stop);
+
+  nrf_drv_timer_uninit(&m_ppi_counter);
+  nrfx_twim_uninit(&m_ppi_twim);
+
+  err_code = nrf_twi_mngr_init(&m_twi_mngr, &m_twi_config);
+  CHECK(err_code == NRF_SUCCESS, BS_ERROR);
+
+  m_i2c_ppi.active = false;
+
+  return BS_OK;
 }
 
 void bsp_delay_ms(uint32_t ms)
@@ -82,9 +353,20 @@ base_status_t bsp_spi_1_transmit_receive(uint8_t *tx_data, uint8_t *rx_data, uin
 
 base_status_t bsp_spi_2_transmit_receive(uint8_t *tx_data, uint8_t *rx_data, uint16_t len)
 {
-  if (nrf_drv_spi_transfer(&m_spi_2, tx_data, len, rx_data, len) != NRF_SUCCESS)
-    return BS_ERROR;
-  
+  uint16_t offset = 0;
+
+  // The driver takes 8-bit lengths, a NAND page is sent in pieces with CS held by the caller
+  while (offset < len)
+  {
+    uint8_t chunk = (uint8_t)MIN(len - offset, UINT8_MAX);
+
+    if (nrf_drv_spi_transfer(&m_spi_2, &tx_data[offset], chunk,
+                             (rx_data != NULL) ? &rx_data[offset] : NULL, (rx_data != NULL) ? chunk : 0) != NRF_SUCCESS)
+      return BS_ERROR;
+
+    offset += chunk;
+  }
+
   return BS_OK;
 }
 
@@ -102,19 +384,135 @@ static void m_bsp_i2c_init(void)
 {
   ret_code_t err_code;
 
-  const nrf_drv_twi_config_t twi_config =
-  {
-    .scl                = IO_I2C1_SCL,
-    .sda                = IO_I2C1_SDA,
-    .frequency          = NRF_DRV_TWI_FREQ_400K,
-    .interrupt_priority = APP_IRQ_PRIORITY_HIGH,
-    .clear_bus_init     = false
-  };
-
-  err_code = nrf_drv_twi_init(&m_twi, &twi_config, NULL, NULL);
+  err_code = nrf_twi_mngr_init(&m_twi_mngr, &m_twi_config);
   APP_ERROR_CHECK(err_code);
+}
+
+/**
+ * @brief         I2C get a free transaction slot
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Pointer to slot, NULL if all slots are in use
+ */
+static m_i2c_slot_t *m_bsp_i2c_slot_alloc(void)
+{
+  m_i2c_slot_t *p_slot = NULL;
 
-  nrf_drv_twi_enable(&m_twi);
+  CRITICAL_REGION_ENTER();
+  for (uint8_t i = 0; (i < ARRAY_SIZE(m_i2c_slots)) && !m_i2c_ppi.active; i++)
+  {
+    if (!m_i2c_slots[i].busy)
+    {
+      m_i2c_slots[i].busy = true;
+      p_slot = &m_i2c_slots[i];
+      break;
+    }
+  }
+  CRITICAL_REGION_EXIT();
+
+  return p_slot;
+}
+
+/**
+ * @brief         I2C queue the transaction of a slot
+ *
+ * @param[in]     p_slot                Pointer to slot with the transfers set
+ * @param[in]     number_of_transfers   Transfers of the transaction
+ * @param[in]     callback              Completion callback
+ * @param[in]     p_context             Callback context
+ *
+ * @attention     The slot is released on failure
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_bsp_i2c_schedule(m_i2c_slot_t *p_slot, uint8_t number_of_transfers,
+                                        bsp_i2c_callback_t callback, void *p_context)
+{
+  p_slot->callback  = callback;
+  p_slot->p_context = p_context;
+
+  p_slot->transaction.callback            = m_bsp_i2c_done;
+  p_slot->transaction.p_user_data         = p_slot;
+  p_slot->transaction.p_transfers         = p_slot->transfers;
+  p_slot->transaction.number_of_transfers = number_of_transfers;
+  p_slot->transaction.p_required_twi_cfg  = NULL;
+
+  p_slot->start_tick = app_timer_cnt_get();
+
+  CRITICAL_REGION_ENTER();
+  m_i2c_stats.depth++;
+  if (m_i2c_stats.depth > m_i2c_stats.depth_max)
+    m_i2c_stats.depth_max = m_i2c_stats.depth;
+  CRITICAL_REGION_EXIT();
+
+  if (nrf_twi_mngr_schedule(&m_twi_mngr, &p_slot->transaction) != NRF_SUCCESS)
+  {
+    CRITICAL_REGION_ENTER();
+    m_i2c_stats.depth--;
+    m_i2c_stats.rejected++;
+    p_slot->busy = false;
+    CRITICAL_REGION_EXIT();
+
+    return BS_ERROR;
+  }
+
+  return BS_OK;
+}
+
+/**
+ * @brief         I2C transaction completion, TWI interrupt context
+ *
+ * @param[in]     result        Transaction result
+ * @param[in]     p_user_data   Pointer to slot
+ *
+ * @attention     The slot is released before the callback so the callback can queue the next transaction
+ *
+ * @return        None
+ */
+static void m_bsp_i2c_done(ret_code_t result, void *p_user_data)
+{
+  m_i2c_slot_t      *p_slot    = (m_i2c_slot_t *)p_user_data;
+  bsp_i2c_callback_t callback  = p_slot->callback;
+  void              *p_context = p_slot->p_context;
+  uint32_t           ticks     = app_timer_cnt_diff_compute(app_timer_cnt_get(), p_slot->start_tick);
+  uint32_t           latency   = (uint32_t)(((uint64_t)ticks * 1000000) / APP_TIMER_CLOCK_FREQ);
+
+  CRITICAL_REGION_ENTER();
+  m_i2c_stats.depth--;
+  m_i2c_stats.transactions++;
+  if (result != NRF_SUCCESS)
+    m_i2c_stats.errors++;
+  m_i2c_stats.latency_last_us = latency;
+  if (latency > m_i2c_stats.latency_max_us)
+    m_i2c_stats.latency_max_us = latency;
+  p_slot->busy = false;
+  CRITICAL_REGION_EXIT();
+
+  if (callback != NULL)
+    callback((result == NRF_SUCCESS) ? BS_OK : BS_ERROR, p_context);
+}
+
+/**
+ * @brief         I2C completion of a blocking transaction
+ *
+ * @param[in]     status        Transaction status
+ * @param[in]     p_context     Pointer to the waiting m_i2c_sync_t
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_i2c_sync_done(base_status_t status, void *p_context)
+{
+  m_i2c_sync_t *p_sync = (m_i2c_sync_t *)p_context;
+
+  p_sync->status = status;
+  p_sync->done   = true;
 }
 
 void spi_event_handler(nrf_drv_spi_evt_t const *p_event, void *p_context)
@@ -204,4 +602,51 @@ static void m_bsp_gpio_init(void)
   bsp_gpio_write(IO_AVCC_EN, 1);
 }
 
+/**
+ * @brief         TWIM handler while the periodic reads run, only bus errors are reported
+ *
+ * @param[in]     p_event       TWI event
+ * @param[in]     p_context     Unused
+ *
+ * @attention     The next trigger restarts the read, the list pointer keeps advancing
+ *
+ * @return        None
+ */
+static void m_bsp_i2c_ppi_twim_handler(nrfx_twim_evt_t const *p_event, void *p_context)
+{
+  if (p_event->type != NRFX_TWIM_EVT_DONE)
+    m_i2c_stats.errors++;
+}
+
+/**
+ * @brief         Read counter handler, a half of the double buffer is complete
+ *
+ * @param[in]     event_type    COMPARE0 first half, COMPARE1 second half
+ * @param[in]     p_context     Unused
+ *
+ * @attention     COMPARE1 stopped the RTC through PPI, the EasyDMA pointer is moved back to the
+ *                buffer start before the trigger is restarted. The read after a wrap is late by
+ *                the interrupt latency, none is lost or written past the buffer.
+ *
+ * @return        None
+ */
+static void m_bsp_i2c_ppi_counter_handler(nrf_timer_event_t event_type, void *p_context)
+{
+  uint32_t tick       = bsp_time_capture_get(BSP_TIME_CAPTURE_IMU_PPI);
+  uint32_t block_size = (uint32_t)m_i2c_ppi.count * m_i2c_ppi.len;
+
+  m_i2c_stats.transactions += m_i2c_ppi.count;
+
+  if (event_type == NRF_TIMER_EVENT_COMPARE0)
+  {
+    m_i2c_ppi.handler(m_i2c_ppi.p_buffer, tick);
+  }
+  else if (event_type == NRF_TIMER_EVENT_COMPARE1)
+  {
+    nrf_twim_rx_buffer_set(m_ppi_twim.p_twim, m_i2c_ppi.p_buffer, m_i2c_ppi.len);
+    nrf_rtc_task_trigger(PPI_RTC, NRF_RTC_TASK_START);
+    m_i2c_ppi.handler(m_i2c_ppi.p_buffer + block_size, tick);
+  }
+}
+
 /* End of file -------------------------------------------------------- */
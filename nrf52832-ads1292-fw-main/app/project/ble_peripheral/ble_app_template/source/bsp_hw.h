@@ -21,7 +21,9 @@ extern "C" {
 /* Includes ----------------------------------------------------------- */
 #include <stdint.h>
 #include <stdbool.h>
-#include "nrf_drv_twi.h"
+#include "nrf_twi_mngr.h"
+#include "nrf_drv_timer.h"
+#include "nrf_drv_ppi.h"
 #include "nrf_drv_spi.h"
 #include "nrf_drv_gpiote.h"
 #include "nrf_delay.h"
@@ -36,6 +38,9 @@ extern "C" {
 /* Public defines ----------------------------------------------------- */
 // #define TEMPERATURE_BOARD
 
+#define BSP_I2C_QUEUE_SIZE          (8)       // Pending I2C transactions, not counting the one on the bus
+#define BSP_I2C_WRITE_MAX           (9)       // Data bytes of a register write
+
 /* Public enumerate/structure ----------------------------------------- */
 /**
  * @brief Base status structure
@@ -58,6 +63,31 @@ typedef enum
 }
 bool_t;
 
+/**
+ * @brief I2C statistics structure
+ */
+typedef struct
+{
+  uint32_t transactions;          // Completed transactions
+  uint32_t errors;                // Transactions ended with a bus error
+  uint32_t rejected;              // Transactions not queued, queue full
+  uint8_t  depth;                 // Transactions queued or on the bus
+  uint8_t  depth_max;
+  uint32_t latency_last_us;       // Queueing to completion
+  uint32_t latency_max_us;
+}
+bsp_i2c_stats_t;
+
+/**
+ * @brief I2C transaction completion callback type
+ */
+typedef void (*bsp_i2c_callback_t)(base_status_t status, void *p_context);
+
+/**
+ * @brief I2C PPI read block handler type
+ */
+typedef void (*bsp_i2c_ppi_handler_t)(const uint8_t *p_block, uint32_t tick);
+
 /* Public macros ------------------------------------------------------ */
 #define CHECK(expr, ret)            \
   do {                              \
@@ -90,14 +120,15 @@ bool_t;
 void bsp_hw_init(void);
 
 /**
- * @brief         I2C read
+ * @brief         I2C write
  *
  * @param[in]     slave_addr    Slave address
  * @param[in]     reg_addr      Register address
  * @param[in]     p_data        Pointer to handle of data
  * @param[in]     len           Data length
  *
- * @attention     None
+ * @attention     Queued behind the pending transactions and waits for completion,
+ *                must not be called from an I2C completion callback
  *
  * @return
  * - 0      Succes
@@ -106,14 +137,15 @@ void bsp_hw_init(void);
 int bsp_i2c_write(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len);
 
 /**
- * @brief         I2C write
+ * @brief         I2C read
  *
  * @param[in]     slave_addr    Slave address
  * @param[in]     reg_addr      Register address
  * @param[in]     p_data        Pointer to handle of data
  * @param[in]     len           Data length
  *
- * @attention     None
+ * @attention     Queued behind the pending transactions and waits for completion,
+ *                must not be called from an I2C completion callback
  *
  * @return
  * - 0      Succes
@@ -121,6 +153,93 @@ int bsp_i2c_write(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_
  */
 int bsp_i2c_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len);
 
+/**
+ * @brief         I2C queue a register read
+ *
+ * @param[in]     slave_addr    Slave address
+ * @param[in]     reg_addr      Register address
+ * @param[in]     p_data        Pointer to handle of data, must stay valid until completion
+ * @param[in]     len           Data length, at most 255
+ * @param[in]     callback      Completion callback, called from the TWI interrupt (may be NULL)
+ * @param[in]     p_context     Callback context
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Queue full
+ */
+base_status_t bsp_i2c_read_async(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len,
+                                 bsp_i2c_callback_t callback, void *p_context);
+
+/**
+ * @brief         I2C queue a register write
+ *
+ * @param[in]     slave_addr    Slave address
+ * @param[in]     reg_addr      Register address
+ * @param[in]     p_data        Pointer to handle of data, copied
+ * @param[in]     len           Data length, at most BSP_I2C_WRITE_MAX
+ * @param[in]     callback      Completion callback, called from the TWI interrupt (may be NULL)
+ * @param[in]     p_context     Callback context
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Queue full
+ */
+base_status_t bsp_i2c_write_async(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t len,
+                                  bsp_i2c_callback_t callback, void *p_context);
+
+/**
+ * @brief         I2C get the transaction queue statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void bsp_i2c_stats_get(bsp_i2c_stats_t *p_stats);
+
+/**
+ * @brief         I2C start hardware-triggered periodic register reads
+ *
+ * @param[in]     slave_addr    Slave address
+ * @param[in]     reg_addr      Register address
+ * @param[in]     p_buffer      Double buffer, 2 * count * len bytes
+ * @param[in]     len           Bytes per read
+ * @param[in]     count         Reads per block
+ * @param[in]     period_ticks  Read period in 32768 Hz ticks
+ * @param[in]     handler       Block handler, called from the TIMER interrupt once per block
+ *
+ * @attention     RTC2 triggers the TWIM through PPI, each read is one EasyDMA list entry and
+ *                the TWIM STOPPED events are counted by TIMER2, so the CPU only wakes up per block.
+ *                The end of the buffer stops RTC2 through PPI until the block handler has rewound
+ *                the EasyDMA pointer. The I2C queue must be idle and rejects transactions until
+ *                bsp_i2c_ppi_read_stop().
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ * - BS_ERROR       I2C queue busy
+ */
+base_status_t bsp_i2c_ppi_read_start(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_buffer, uint8_t len,
+                                     uint16_t count, uint32_t period_ticks, bsp_i2c_ppi_handler_t handler);
+
+/**
+ * @brief         I2C stop the periodic register reads and give the bus back to the queue
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_i2c_ppi_read_stop(void);
+
 /**
  * @brief         SPI transmit and receive
  *
@@ -135,6 +254,20 @@ int bsp_i2c_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *p_data, uint32_t
  * - 1      Error
  */
 base_status_t bsp_spi_1_transmit_receive(uint8_t *tx_data, uint8_t *rx_data, uint16_t len);
+
+/**
+ * @brief         SPI 2 transmit and receive
+ *
+ * @param[in]     tx_data       Transmit data
+ * @param[in]     rx_data       Receive data, NULL to drop it
+ * @param[in]     len           Data length, split into transfers of at most 255 bytes
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
 base_status_t bsp_spi_2_transmit_receive(uint8_t *tx_data, uint8_t *rx_data, uint16_t len);
 
 void bsp_delay_ms(uint32_t ms);
@@ -12,44 +12,653 @@
 
 /* Includes ----------------------------------------------------------- */
 #include "bsp_imu.h"
+#include "imu_ahrs.h"
+#include "imu_activity.h"
+#include "imu_calib.h"
+#include "bsp_time.h"
+#include "app_util_platform.h"
 
 /* Private defines ---------------------------------------------------- */
+#define BSP_IMU_INT_TIMEOUT_BLOCKS  (2)       // Watermark periods without INT before the FIFO is polled
+
 /* Private enumerate/structure ---------------------------------------- */
 /* Private macros ----------------------------------------------------- */
 /* Public variables --------------------------------------------------- */
 /* Private variables -------------------------------------------------- */
 static mpu9250_t m_mpu9250;
 
+static bsp_imu_block_t         m_block;
+static mpu9250_fifo_frame_t    m_last_frame;
+static bsp_imu_block_handler_t m_block_handler = NULL;
+static bsp_imu_fifo_stats_t    m_stats;
+static uint32_t                m_overflow_count;
+static volatile uint16_t       m_int_count;
+static volatile uint32_t       m_int_tick;
+static volatile bool           m_drain_pending;
+static volatile bool           m_drain_busy;
+static volatile bool           m_block_ready;
+static volatile bool           m_int_seen;         // The INT pin fired since boot, it is wired
+static uint32_t                m_drain_tick;       // Start of the last drain
+
+static uint8_t                 m_ppi_buffer[2][BSP_IMU_FIFO_WATERMARK][MPU9250_MOTION9_SIZE];
+static volatile bool           m_ppi_running;
+static const uint8_t *volatile m_ppi_block;
+static volatile uint32_t       m_ppi_tick;
+static volatile bool           m_ppi_overrun;
+static uint8_t                 m_ppi_smplrt_div;
+
+static bool                    m_low_power;
+static volatile bool           m_motion;
+
 /* Private function prototypes ---------------------------------------- */
+static void m_bsp_imu_int_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
+static void m_bsp_imu_fifo_done(base_status_t status, void *p_context);
+static void m_bsp_imu_ppi_handler(const uint8_t *p_block, uint32_t tick);
+static void m_bsp_imu_ppi_deliver(void);
+static void m_bsp_imu_block_deliver(void);
+static bool m_bsp_imu_block_moved(const bsp_imu_block_t *p_block);
+static void m_bsp_imu_wom_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
+static base_status_t m_bsp_imu_acquisition_start(void);
+static void m_bsp_imu_burst_frame_get(mpu9250_fifo_frame_t *p_frame);
+
 /* Function definitions ----------------------------------------------- */
 base_status_t bsp_imu_init(void)
 {
   // Init
-  m_mpu9250.device_address = MPU9250_I2C_ADDR;
-  m_mpu9250.i2c_read       = bsp_i2c_read;
-  m_mpu9250.i2c_write      = bsp_i2c_write;
-  m_mpu9250.delay          = bsp_delay_ms;
+  m_mpu9250.device_address  = MPU9250_I2C_ADDR;
+  m_mpu9250.i2c_read        = bsp_i2c_read;
+  m_mpu9250.i2c_write       = bsp_i2c_write;
+  m_mpu9250.i2c_read_async  = bsp_i2c_read_async;
+  m_mpu9250.i2c_write_async = bsp_i2c_write_async;
+  m_mpu9250.delay           = bsp_delay_ms;
 
   // Configaration
   m_mpu9250.config.clock_source         = MPU9250_CLOCK_INTERNAL_20MHZ;
-  m_mpu9250.config.gyro_full_scale      = MPU9250_GYRO_FS_SEL_500;
-  m_mpu9250.config.accel_full_scale     = MPU9250_ACCEL_FS_SEL_4G;
+  m_mpu9250.config.gyro_full_scale      = BSP_IMU_GYRO_FS;
+  m_mpu9250.config.accel_full_scale     = BSP_IMU_ACCEL_FS;
   m_mpu9250.config.digi_low_pass_filter = MPU9250_DIGI_LPF_184A_188G_HZ;
   m_mpu9250.config.sleep_mode_bit       = 0;  // 1: Sleep mode, 0: Normal mode
+  m_mpu9250.config.mag_enable           = _CONFIG_IMU_MAG;
+
+  CHECK_STATUS(mpu9250_init(&m_mpu9250));
+
+#if (_CONFIG_IMU_CALIB)
+  // Loaded before the first frame so the fusion starts with the stored biases
+  imu_calib_config_t calib_config =
+  {
+    .sample_rate = _CONFIG_IMU_FIFO_RATE,
+    .accel_range = MPU9250_ACCEL_RANGE_MG(BSP_IMU_ACCEL_FS),
+    .gyro_range  = MPU9250_GYRO_RANGE_MDPS(BSP_IMU_GYRO_FS)
+  };
+
+  CHECK_STATUS(imu_calib_init(&calib_config));
+#endif
+
+#if (_CONFIG_IMU_AHRS)
+  // Fused at the frame rate of the continuous acquisition
+  imu_ahrs_config_t ahrs_config =
+  {
+    .sample_rate = _CONFIG_IMU_FIFO_RATE,
+    .output_rate = _CONFIG_IMU_AHRS_RATE,
+    .gyro_scale  = MPU9250_GYRO_RANGE_MDPS(BSP_IMU_GYRO_FS) / 32768000.0f,
+    .beta        = IMU_AHRS_BETA_DEFAULT
+  };
+
+  CHECK(imu_ahrs_init(&ahrs_config), BS_ERROR);
+#endif
+
+#if (_CONFIG_IMU_ACTIVITY)
+  imu_activity_config_t activity_config =
+  {
+    .sample_rate = _CONFIG_IMU_FIFO_RATE,
+    .accel_range = MPU9250_ACCEL_RANGE_MG(BSP_IMU_ACCEL_FS)
+  };
+
+  CHECK(imu_activity_init(&activity_config), BS_ERROR);
+#endif
+
+  CHECK_STATUS(m_bsp_imu_acquisition_start());
+
+  return BS_OK;
+}
+
+base_status_t bsp_gyro_accel_get(mpu9250_unit_data_t *accel_mg, mpu9250_unit_data_t *gyro_mdps)
+{
+  // Use the newest drained frame instead of two more bus transfers
+  if (m_mpu9250.fifo.enabled || m_ppi_running)
+  {
+    accel_mg->x = BSP_IMU_ACCEL_MG(m_last_frame.accel.x);
+    accel_mg->y = BSP_IMU_ACCEL_MG(m_last_frame.accel.y);
+    accel_mg->z = BSP_IMU_ACCEL_MG(m_last_frame.accel.z);
+
+    gyro_mdps->x = BSP_IMU_GYRO_MDPS(m_last_frame.gyro.x);
+    gyro_mdps->y = BSP_IMU_GYRO_MDPS(m_last_frame.gyro.y);
+    gyro_mdps->z = BSP_IMU_GYRO_MDPS(m_last_frame.gyro.z);
+
+    return BS_OK;
+  }
+
+  // Newest completed burst, the next one is queued for the following call
+  mpu9250_fifo_frame_t frame;
+
+  m_bsp_imu_burst_frame_get(&frame);
+
+  accel_mg->x = BSP_IMU_ACCEL_MG(frame.accel.x);
+  accel_mg->y = BSP_IMU_ACCEL_MG(frame.accel.y);
+  accel_mg->z = BSP_IMU_ACCEL_MG(frame.accel.z);
+
+  gyro_mdps->x = BSP_IMU_GYRO_MDPS(frame.gyro.x);
+  gyro_mdps->y = BSP_IMU_GYRO_MDPS(frame.gyro.y);
+  gyro_mdps->z = BSP_IMU_GYRO_MDPS(frame.gyro.z);
+
+  mpu9250_get_motion6_async(&m_mpu9250, NULL, NULL);
+
+  return BS_OK;
+}
+
+base_status_t bsp_mag_get(mpu9250_unit_data_t *mag_nt)
+{
+  CHECK(m_mpu9250.mag.enabled, BS_ERROR);
+
+  if (m_mpu9250.fifo.enabled || m_ppi_running)
+  {
+    mag_nt->x = BSP_IMU_MAG_NT(m_last_frame.mag.x);
+    mag_nt->y = BSP_IMU_MAG_NT(m_last_frame.mag.y);
+    mag_nt->z = BSP_IMU_MAG_NT(m_last_frame.mag.z);
+
+    return BS_OK;
+  }
+
+  mpu9250_fifo_frame_t frame;
+
+  m_bsp_imu_burst_frame_get(&frame);
+
+  mag_nt->x = BSP_IMU_MAG_NT(frame.mag.x);
+  mag_nt->y = BSP_IMU_MAG_NT(frame.mag.y);
+  mag_nt->z = BSP_IMU_MAG_NT(frame.mag.z);
+
+  return BS_OK;
+}
+
+base_status_t bsp_accel_raw_get(mpu9250_raw_data_t *accel_raw)
+{
+  // Newest drained FIFO/PPI frame, the sample loop never touches the bus
+  if (m_mpu9250.fifo.enabled || m_ppi_running)
+  {
+    memcpy(accel_raw, &m_last_frame.accel, sizeof(mpu9250_raw_data_t));
+    return BS_OK;
+  }
+
+  // Newest completed reading, the next one is queued for the following call
+  CRITICAL_REGION_ENTER();
+  memcpy(accel_raw, &m_mpu9250.accel.raw_data, sizeof(m_mpu9250.accel.raw_data));
+  CRITICAL_REGION_EXIT();
+
+  // Still, the reference is not refreshed at the caller's rate
+  if (!m_low_power)
+    mpu9250_get_accel_raw_data_async(&m_mpu9250, NULL, NULL);
+
+  return BS_OK;
+}
+
+base_status_t bsp_imu_fifo_start(uint16_t rate_hz)
+{
+  nrf_drv_gpiote_in_config_t in_config = GPIOTE_CONFIG_IN_SENSE_LOTOHI(true);
+
+  CHECK((rate_hz >= 4) && (rate_hz <= 1000), BS_ERROR_PARAMS);
+
+  // Internal sample rate is 1 kHz with the DLPF enabled
+  CHECK_STATUS(mpu9250_set_sample_rate_divider(&m_mpu9250, (uint8_t)(1000 / rate_hz - 1)));
+
+  m_int_count     = 0;
+  m_drain_pending = false;
+  m_block_ready   = false;
+  m_block.seq     = 0;
+  m_drain_tick    = bsp_time_now();
+
+  if (!nrf_drv_gpiote_in_is_set(IO_IMU_INT))
+  {
+    in_config.pull = NRF_GPIO_PIN_PULLDOWN;
+    CHECK(nrf_drv_gpiote_in_init(IO_IMU_INT, &in_config, m_bsp_imu_int_handler) == NRF_SUCCESS, BS_ERROR);
+  }
+
+  // The data-ready edge is stamped by PPI, the handler may run late
+  CHECK_STATUS(bsp_time_capture_attach(BSP_TIME_CAPTURE_IMU_INT, nrf_drv_gpiote_in_event_addr_get(IO_IMU_INT)));
+
+  CHECK_STATUS(mpu9250_fifo_enable(&m_mpu9250, true));
+  CHECK_STATUS(mpu9250_set_interrupt(&m_mpu9250, MPU9250_INT_RAW_RDY_EN | MPU9250_INT_FIFO_OFLOW_EN));
+
+  m_overflow_count = m_mpu9250.fifo.overflow_count;
+  nrf_drv_gpiote_in_event_enable(IO_IMU_INT, true);
+
+  return BS_OK;
+}
+
+base_status_t bsp_imu_fifo_stop(void)
+{
+  if (nrf_drv_gpiote_in_is_set(IO_IMU_INT))
+    nrf_drv_gpiote_in_uninit(IO_IMU_INT);
+
+  m_drain_pending = false;
+
+  CHECK_STATUS(mpu9250_set_interrupt(&m_mpu9250, 0x00));
+  CHECK_STATUS(mpu9250_fifo_enable(&m_mpu9250, false));
+
+  return BS_OK;
+}
+
+base_status_t bsp_imu_ppi_start(uint16_t rate_hz)
+{
+  CHECK((rate_hz >= 4) && (rate_hz <= 1000), BS_ERROR_PARAMS);
+  CHECK(!m_mpu9250.fifo.enabled && !m_ppi_running, BS_ERROR);
+
+  // The RTC sets the output rate, the sensor runs at its internal 1 kHz until bsp_imu_ppi_stop()
+  CHECK_STATUS(mpu9250_get_sample_rate_divider(&m_mpu9250, &m_ppi_smplrt_div));
+  CHECK_STATUS(mpu9250_set_sample_rate_divider(&m_mpu9250, 0));
+
+  m_ppi_block   = NULL;
+  m_ppi_overrun = false;
+  m_block.seq   = 0;
+
+  CHECK_STATUS(bsp_i2c_ppi_read_start(m_mpu9250.device_address, MPU9250_MOTION6_REG, &m_ppi_buffer[0][0][0],
+                                      mpu9250_motion_size(&m_mpu9250), BSP_IMU_FIFO_WATERMARK,
+                                      (APP_TIMER_CLOCK_FREQ + rate_hz / 2) / rate_hz, m_bsp_imu_ppi_handler));
+
+  m_ppi_running = true;
+
+  return BS_OK;
+}
+
+base_status_t bsp_imu_ppi_stop(void)
+{
+  CHECK(m_ppi_running, BS_ERROR);
+
+  CHECK_STATUS(bsp_i2c_ppi_read_stop());
+
+  m_ppi_running = false;
+  m_ppi_block   = NULL;
+
+  // The bus is back to the queue, restore the rate the sensor had before
+  CHECK_STATUS(mpu9250_set_sample_rate_divider(&m_mpu9250, m_ppi_smplrt_div));
+
+  return BS_OK;
+}
+
+base_status_t bsp_imu_low_power_enter(void)
+{
+  nrf_drv_gpiote_in_config_t in_config = GPIOTE_CONFIG_IN_SENSE_LOTOHI(false);
+
+  CHECK(!m_low_power, BS_ERROR);
+
+  // Waking up on motion needs the INT pin, the FIFO was polled without it
+  CHECK(!m_mpu9250.fifo.enabled || m_int_seen, BS_ERROR);
+
+  if (m_ppi_running)
+    CHECK_STATUS(bsp_imu_ppi_stop());
+  if (m_mpu9250.fifo.enabled)
+    CHECK_STATUS(bsp_imu_fifo_stop());
+
+  if (nrf_drv_gpiote_in_is_set(IO_IMU_INT))
+    nrf_drv_gpiote_in_uninit(IO_IMU_INT);
+
+  CHECK_STATUS(mpu9250_lp_accel_enter(&m_mpu9250, BSP_IMU_LP_ACCEL_ODR, BSP_IMU_MOTION_MG));
+
+  // Port event, the pin is sensed without keeping the high-frequency clock
+  in_config.pull = NRF_GPIO_PIN_PULLDOWN;
+  CHECK(nrf_drv_gpiote_in_init(IO_IMU_INT, &in_config, m_bsp_imu_wom_handler) == NRF_SUCCESS, BS_ERROR);
+
+  m_motion    = false;
+  m_low_power = true;
+  nrf_drv_gpiote_in_event_enable(IO_IMU_INT, true);
+
+  return BS_OK;
+}
+
+base_status_t bsp_imu_low_power_exit(void)
+{
+  CHECK(m_low_power, BS_ERROR);
+
+  if (nrf_drv_gpiote_in_is_set(IO_IMU_INT))
+    nrf_drv_gpiote_in_uninit(IO_IMU_INT);
+
+  CHECK_STATUS(mpu9250_lp_accel_exit(&m_mpu9250));
+
+  m_low_power = false;
+
+  CHECK_STATUS(m_bsp_imu_acquisition_start());
+
+  return BS_OK;
+}
+
+bool bsp_imu_motion_take(void)
+{
+  bool motion;
+
+  CRITICAL_REGION_ENTER();
+  motion   = m_motion;
+  m_motion = false;
+  CRITICAL_REGION_EXIT();
 
-  return mpu9250_init(&m_mpu9250);
+  return motion;
 }
 
-base_status_t bsp_gyro_accel_get(mpu9250_scaled_data_t *accel_scaled, mpu9250_scaled_data_t *gyro_scaled)
+base_status_t bsp_imu_fifo_process(void)
 {
-  mpu9250_get_accel_scale_data(&m_mpu9250);
-  mpu9250_get_gyro_scale_data(&m_mpu9250);
+  // A drain finished after the acquisition stopped
+  if (m_low_power)
+  {
+    m_block_ready = false;
+    return BS_OK;
+  }
+
+  if (m_ppi_running)
+  {
+    m_bsp_imu_ppi_deliver();
+    return BS_OK;
+  }
 
-  memcpy(accel_scaled, &m_mpu9250.accel.scaled_data, sizeof(m_mpu9250.accel.scaled_data));
-  memcpy(gyro_scaled, &m_mpu9250.gyro.scaled_data, sizeof(m_mpu9250.gyro.scaled_data));
+  // Deliver the block of the finished drain
+  if (m_block_ready)
+  {
+    m_block_ready = false;
+
+    m_block.overflow = (m_mpu9250.fifo.overflow_count != m_overflow_count);
+    m_overflow_count = m_mpu9250.fifo.overflow_count;
+
+    // The newest frame in the FIFO is the one of the last INT, back-date to the first drained one
+    m_block.timestamp -= BSP_TIME_SAMPLE_TICKS(m_mpu9250.fifo.available - 1, _CONFIG_IMU_FIFO_RATE);
+
+    m_bsp_imu_block_deliver();
+
+    // The FIFO may hold more than one block
+    if (m_block.count < m_mpu9250.fifo.available)
+      m_drain_pending = true;
+  }
+
+  // No INT for a while, the pin may not be wired: the FIFO is polled, 20 frames fit in it
+  if (!m_drain_pending && !m_drain_busy &&
+      ((bsp_time_now() - m_drain_tick) >= BSP_TIME_SAMPLE_TICKS(BSP_IMU_INT_TIMEOUT_BLOCKS * BSP_IMU_FIFO_WATERMARK,
+                                                                _CONFIG_IMU_FIFO_RATE)))
+  {
+    m_int_tick      = bsp_time_now();
+    m_drain_pending = true;
+    m_stats.polls++;
+  }
+
+  if (!m_drain_pending || m_drain_busy)
+    return BS_OK;
+
+  // Interrupts during the drain count towards the next one, the block is dated from the last one
+  m_drain_pending   = false;
+  m_int_count       = 0;
+  m_block.timestamp = m_int_tick;
+  m_drain_tick      = bsp_time_now();
+  m_drain_busy      = true;
+
+  if (mpu9250_fifo_read_async(&m_mpu9250, m_block.frames, BSP_IMU_FIFO_MAX_FRAMES, m_bsp_imu_fifo_done, NULL) != BS_OK)
+  {
+    // Retried on the next call
+    m_drain_busy    = false;
+    m_drain_pending = true;
+    m_stats.errors++;
+    return BS_ERROR;
+  }
 
   return BS_OK;
 }
 
+void bsp_imu_register_block_handler(bsp_imu_block_handler_t handler)
+{
+  m_block_handler = handler;
+}
+
+void bsp_imu_fifo_stats_get(bsp_imu_fifo_stats_t *p_stats)
+{
+  memcpy(p_stats, &m_stats, sizeof(bsp_imu_fifo_stats_t));
+}
+
 /* Private function definitions ---------------------------------------- */
+/**
+ * @brief         IMU INT pin handler, counts data-ready pulses up to the watermark
+ *
+ * @param[in]     pin           Pin
+ * @param[in]     action        Polarity
+ *
+ * @attention     Runs in interrupt context, the FIFO is read from the main loop
+ *
+ * @return        None
+ */
+static void m_bsp_imu_int_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+  m_int_tick = bsp_time_capture_get(BSP_TIME_CAPTURE_IMU_INT);
+  m_int_seen = true;
+
+  if (++m_int_count >= BSP_IMU_FIFO_WATERMARK)
+    m_drain_pending = true;
+}
+
+/**
+ * @brief         FIFO drain completion, the block is delivered from the main loop
+ *
+ * @param[in]     status        Drain status
+ * @param[in]     p_context     Unused
+ *
+ * @attention     Runs in I2C interrupt context
+ *
+ * @return        None
+ */
+static void m_bsp_imu_fifo_done(base_status_t status, void *p_context)
+{
+  if (status == BS_OK)
+  {
+    m_block.count = m_mpu9250.fifo.count;
+    m_block_ready = (m_block.count > 0);
+  }
+  else
+  {
+    m_stats.errors++;
+  }
+
+  m_drain_busy = false;
+}
+
+/**
+ * @brief         PPI read block handler, half of the DMA buffer is complete
+ *
+ * @param[in]     p_block       BSP_IMU_FIFO_WATERMARK motion6 bursts
+ * @param[in]     tick          Timebase tick of the last read of the block
+ *
+ * @attention     Runs in TIMER interrupt context, the block is converted from the main loop
+ *
+ * @return        None
+ */
+static void m_bsp_imu_ppi_handler(const uint8_t *p_block, uint32_t tick)
+{
+  // The previous half was not consumed before the DMA came back to it
+  if (m_ppi_block != NULL)
+    m_ppi_overrun = true;
+
+  m_ppi_tick  = tick;
+  m_ppi_block = p_block;
+}
+
+/**
+ * @brief         Convert and deliver the newest PPI read block
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_imu_ppi_deliver(void)
+{
+  const uint8_t *p_block;
+
+  CRITICAL_REGION_ENTER();
+  p_block           = m_ppi_block;
+  m_ppi_block       = NULL;
+  m_block.timestamp = m_ppi_tick - BSP_TIME_SAMPLE_TICKS(BSP_IMU_FIFO_WATERMARK - 1, _CONFIG_IMU_FIFO_RATE);
+  m_block.overflow  = m_ppi_overrun;
+  m_ppi_overrun     = false;
+  CRITICAL_REGION_EXIT();
+
+  if (p_block == NULL)
+    return;
+
+  for (uint8_t i = 0; i < BSP_IMU_FIFO_WATERMARK; i++)
+    mpu9250_motion_to_frame(&m_mpu9250, &p_block[i * mpu9250_motion_size(&m_mpu9250)], &m_block.frames[i]);
+
+  m_block.count = BSP_IMU_FIFO_WATERMARK;
+
+  m_bsp_imu_block_deliver();
+}
+
+/**
+ * @brief         Deliver a complete block, orientation filter first then the block handler
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_imu_block_deliver(void)
+{
+#if (_CONFIG_IMU_CALIB)
+  for (uint16_t i = 0; i < m_block.count; i++)
+    imu_calib_update(&m_block.frames[i]);
+#endif
+
+  if (m_bsp_imu_block_moved(&m_block))
+    m_motion = true;
+
+  m_last_frame = m_block.frames[m_block.count - 1];
+
+  m_stats.frames += m_block.count;
+  m_stats.blocks++;
+  if (m_block.overflow)
+    m_stats.overflows++;
+
+#if (_CONFIG_IMU_AHRS)
+  for (uint16_t i = 0; i < m_block.count; i++)
+    imu_ahrs_update(&m_block.frames[i], m_block.seq + i);
+#endif
+
+#if (_CONFIG_IMU_ACTIVITY)
+  for (uint16_t i = 0; i < m_block.count; i++)
+    imu_activity_update(&m_block.frames[i], m_block.seq + i, BSP_IMU_FRAME_TICK(&m_block, i));
+#endif
+
+  if (m_block_handler != NULL)
+    m_block_handler(&m_block);
+
+  m_block.seq += m_block.count;
+}
+
+/**
+ * @brief         Check a block for motion, the software counterpart of the wake on motion
+ *
+ * @param[in]     p_block       Pointer to block
+ *
+ * @attention     The peak-to-peak accelerometer change within the block is compared, a block at
+ *                the default rate spans about one low-power sample period
+ *
+ * @return
+ * - true       An axis moved by more than BSP_IMU_MOTION_MG
+ * - false      Still
+ */
+static bool m_bsp_imu_block_moved(const bsp_imu_block_t *p_block)
+{
+  int16_t min[3];
+  int16_t max[3];
+  int16_t value[3];
+
+  min[0] = max[0] = p_block->frames[0].accel.x;
+  min[1] = max[1] = p_block->frames[0].accel.y;
+  min[2] = max[2] = p_block->frames[0].accel.z;
+
+  for (uint16_t i = 1; i < p_block->count; i++)
+  {
+    value[0] = p_block->frames[i].accel.x;
+    value[1] = p_block->frames[i].accel.y;
+    value[2] = p_block->frames[i].accel.z;
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+      if (value[axis] < min[axis])
+        min[axis] = value[axis];
+      if (value[axis] > max[axis])
+        max[axis] = value[axis];
+    }
+  }
+
+  for (uint8_t axis = 0; axis < 3; axis++)
+  {
+    if ((int32_t)max[axis] - min[axis] > BSP_IMU_ACCEL_RAW(BSP_IMU_MOTION_MG))
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief         IMU INT pin handler in low power, wake on motion
+ *
+ * @param[in]     pin           Pin
+ * @param[in]     action        Polarity
+ *
+ * @attention     Runs in interrupt context
+ *
+ * @return        None
+ */
+static void m_bsp_imu_wom_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+  m_motion = true;
+}
+
+/**
+ * @brief         Start the configured continuous acquisition
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_bsp_imu_acquisition_start(void)
+{
+#if (_CONFIG_IMU_PPI)
+  CHECK_STATUS(bsp_imu_ppi_start(_CONFIG_IMU_FIFO_RATE));
+#elif (_CONFIG_IMU_FIFO)
+  CHECK_STATUS(bsp_imu_fifo_start(_CONFIG_IMU_FIFO_RATE));
+#endif
+
+  return BS_OK;
+}
+
+/**
+ * @brief         BSP IMU get the newest completed burst as a calibrated frame
+ *
+ * @param[in]     p_frame       Pointer to frame
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_imu_burst_frame_get(mpu9250_fifo_frame_t *p_frame)
+{
+  CRITICAL_REGION_ENTER();
+  p_frame->accel = m_mpu9250.accel.raw_data;
+  p_frame->gyro  = m_mpu9250.gyro.raw_data;
+  p_frame->mag   = m_mpu9250.mag.raw_data;
+  CRITICAL_REGION_EXIT();
+
+#if (_CONFIG_IMU_CALIB)
+  imu_calib_apply(p_frame);
+#endif
+}
+
 /* End of file -------------------------------------------------------- */
@@ -20,10 +20,65 @@ extern "C" {
 
 /* Includes ----------------------------------------------------------- */
 #include "mpu9250.h"
+#include "bsp_time.h"
 
 /* Public defines ----------------------------------------------------- */
+#define BSP_IMU_FIFO_MAX_FRAMES     (20)      // Frames per block, 13 with the magnetometer (255-byte I2C burst)
+#define BSP_IMU_FIFO_WATERMARK      (10)      // Data-ready interrupts before the FIFO is drained
+
+#define BSP_IMU_ACCEL_FS            (MPU9250_ACCEL_FS_SEL_4G)
+#define BSP_IMU_GYRO_FS             (MPU9250_GYRO_FS_SEL_500)
+
+#define BSP_IMU_LP_ACCEL_ODR        (MPU9250_LP_ACCEL_ODR_15_63_HZ)  // Accelerometer rate in low power
+#define BSP_IMU_MOTION_MG           (64)      // Motion threshold (mg), wake on motion and block check
+
 /* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief BSP IMU block structure
+ */
+typedef struct
+{
+  uint32_t timestamp;                                     // Timebase tick of the first frame (bsp_time)
+  uint32_t seq;                                           // Frame counter of the first frame
+  uint16_t count;                                         // Valid frames
+  bool     overflow;                                      // Frames were lost before this block
+  mpu9250_fifo_frame_t frames[BSP_IMU_FIFO_MAX_FRAMES];
+}
+bsp_imu_block_t;
+
+/**
+ * @brief BSP IMU FIFO statistics structure
+ */
+typedef struct
+{
+  uint32_t frames;                // Frames delivered
+  uint32_t blocks;                // Blocks delivered
+  uint32_t overflows;             // FIFO overflows
+  uint32_t errors;                // Failed drains
+  uint32_t polls;                 // Drains started without the INT pin, it did not fire in time
+}
+bsp_imu_fifo_stats_t;
+
+/**
+ * @brief BSP IMU block handler type
+ */
+typedef void (*bsp_imu_block_handler_t)(const bsp_imu_block_t *p_block);
+
 /* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Raw frame values to units, the scales are resolved at compile time
+ */
+#define BSP_IMU_ACCEL_MG(raw)       MPU9250_RAW_TO_UNIT(raw, MPU9250_ACCEL_RANGE_MG(BSP_IMU_ACCEL_FS))
+#define BSP_IMU_GYRO_MDPS(raw)      MPU9250_RAW_TO_UNIT(raw, MPU9250_GYRO_RANGE_MDPS(BSP_IMU_GYRO_FS))
+#define BSP_IMU_MAG_NT(raw)         ((int32_t)(raw) * MPU9250_MAG_NT_PER_LSB)
+#define BSP_IMU_ACCEL_RAW(mg)       ((int32_t)(mg) * 32768 / MPU9250_ACCEL_RANGE_MG(BSP_IMU_ACCEL_FS))
+
+/**
+ * @brief  Timebase tick of a frame of a block, on from the first one at the nominal rate
+ */
+#define BSP_IMU_FRAME_TICK(p_block, i) \
+  ((p_block)->timestamp + BSP_TIME_SAMPLE_TICKS(i, _CONFIG_IMU_FIFO_RATE))
+
 /* Public variables --------------------------------------------------- */
 /* Public function prototypes ----------------------------------------- */
 /**
@@ -42,8 +97,66 @@ base_status_t bsp_imu_init(void);
 /**
  * @brief         BSP IMU get data
  *
- * @param[in]     accel_scaled  Accel scaled data
- * @param[in]     gyro_scaled   Gyro scaled data
+ * @param[in]     accel_mg      Accel data (mg)
+ * @param[in]     gyro_mdps     Gyro data (mdps)
+ *
+ * @attention     Taken from the newest FIFO frame while the FIFO acquisition runs, otherwise
+ *                the newest completed burst is returned and the next one is queued
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_gyro_accel_get(mpu9250_unit_data_t *accel_mg, mpu9250_unit_data_t *gyro_mdps);
+
+/**
+ * @brief         BSP IMU get magnetometer data
+ *
+ * @param[in]     mag_nt        Mag data (nT), sensitivity adjusted
+ *
+ * @attention     Comes with the accel/gyro data, bsp_gyro_accel_get() queues the next burst
+ *                when no continuous acquisition runs
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Magnetometer not enabled
+ */
+base_status_t bsp_mag_get(mpu9250_unit_data_t *mag_nt);
+
+/**
+ * @brief         BSP IMU get accel raw data
+ *
+ * @param[in]     accel_raw     Accel raw data
+ *
+ * @attention     Never waits on the bus. With the FIFO or PPI acquisition running the newest
+ *                drained frame is returned (up to BSP_IMU_FIFO_WATERMARK frames old),
+ *                otherwise the newest completed reading is returned and the next one is queued
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_accel_raw_get(mpu9250_raw_data_t *accel_raw);
+
+/**
+ * @brief         BSP IMU start the FIFO acquisition
+ *
+ * @param[in]     rate_hz       Sample rate (Hz), 4..1000
+ *
+ * @attention     The FIFO is drained by bsp_imu_fifo_process() once BSP_IMU_FIFO_WATERMARK
+ *                data-ready interrupts were counted, or polled when the INT pin stays quiet for
+ *                two watermark periods
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_imu_fifo_start(uint16_t rate_hz);
+
+/**
+ * @brief         BSP IMU stop the FIFO acquisition
+ *
+ * @param[in]     None
  *
  * @attention     None
  *
@@ -51,7 +164,114 @@ base_status_t bsp_imu_init(void);
  * - BS_OK
  * - BS_ERROR
  */
-base_status_t bsp_gyro_accel_get(mpu9250_scaled_data_t *accel_scaled, mpu9250_scaled_data_t *gyro_scaled);
+base_status_t bsp_imu_fifo_stop(void);
+
+/**
+ * @brief         BSP IMU start the hardware-triggered acquisition
+ *
+ * @param[in]     rate_hz       Sample rate (Hz), 4..1000
+ *
+ * @attention     RTC2 triggers a motion6 read through PPI, the TWIM writes it by EasyDMA and
+ *                the CPU only wakes up every BSP_IMU_FIFO_WATERMARK frames. The blocks are
+ *                delivered by bsp_imu_fifo_process() like the FIFO ones. The I2C queue is not
+ *                available until bsp_imu_ppi_stop().
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ * - BS_ERROR
+ */
+base_status_t bsp_imu_ppi_start(uint16_t rate_hz);
+
+/**
+ * @brief         BSP IMU stop the hardware-triggered acquisition
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_imu_ppi_stop(void);
+
+/**
+ * @brief         BSP IMU enter the low-power mode
+ *
+ * @param[in]     None
+ *
+ * @attention     The FIFO or PPI acquisition stops and the MPU9250 cycles the accelerometer alone
+ *                at BSP_IMU_LP_ACCEL_ODR. Its wake-on-motion interrupt is the only source of the
+ *                INT pin, sensed by the low-power GPIOTE port event.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           The INT pin never fired in FIFO mode, motion could not wake the device
+ */
+base_status_t bsp_imu_low_power_enter(void);
+
+/**
+ * @brief         BSP IMU leave the low-power mode
+ *
+ * @param[in]     None
+ *
+ * @attention     The configured continuous acquisition restarts
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_imu_low_power_exit(void);
+
+/**
+ * @brief         BSP IMU take the motion flag
+ *
+ * @param[in]     None
+ *
+ * @attention     Set by the wake-on-motion interrupt in low power, otherwise by a block whose
+ *                accelerometer moved by more than BSP_IMU_MOTION_MG on an axis. Cleared by the call.
+ *
+ * @return
+ * - true       Motion since the previous call
+ * - false      Still
+ */
+bool bsp_imu_motion_take(void);
+
+/**
+ * @brief         BSP IMU deliver the drained block and queue the next drain, called from the main loop
+ *
+ * @param[in]     None
+ *
+ * @attention     The drain runs on the I2C queue, the block is delivered on the call after it completed
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_imu_fifo_process(void);
+
+/**
+ * @brief         BSP IMU register the FIFO block handler
+ *
+ * @param[in]     handler       Block handler, NULL to unregister
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void bsp_imu_register_block_handler(bsp_imu_block_handler_t handler);
+
+/**
+ * @brief         BSP IMU get the FIFO statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void bsp_imu_fifo_stats_get(bsp_imu_fifo_stats_t *p_stats);
 
 /* -------------------------------------------------------------------------- */
 #ifdef __cplusplus
@@ -38,6 +38,8 @@ extern "C" {
 #define IO_AFE_CS               (31)    // AFE CS
 #define IO_AVCC_EN              (23)
 
+#define IO_IMU_INT              (_CONFIG_IMU_INT_PIN)    // IMU INT (MPU9250 pin 12)
+
 #if (_CONFIG_DEVICE_DEVKIT)
 #define IO_FLASH_MISO           (12)
 #define IO_FLASH_MOSI           (5)
@@ -50,6 +52,27 @@ extern "C" {
 #define IO_FLASH_CS             (9)
 #endif // _CONFIG_DEVICE_DEVKIT
 
+#if (IO_IMU_INT == IO_I2C1_SCL) || (IO_IMU_INT == IO_I2C1_SDA) || (IO_IMU_INT == IO_AFE_DRDY) || \
+    (IO_IMU_INT == IO_AFE_START) || (IO_IMU_INT == IO_AFE_RST) || (IO_IMU_INT == IO_AVCC_EN) || \
+    (IO_IMU_INT == IO_FLASH_CS) || (IO_IMU_INT == IO_FLASH_SCLK) || (IO_IMU_INT == IO_FLASH_MOSI) || \
+    (IO_IMU_INT == IO_FLASH_MISO) || (IO_IMU_INT == IO_AFE_CS) || (IO_IMU_INT == IO_AFE_MISO) || \
+    (IO_IMU_INT == IO_AFE_MOSI) || (IO_IMU_INT == IO_AFE_SCLK)
+#error "_CONFIG_IMU_INT_PIN is already used on this board"
+#endif
+
+// Features fed by the FIFO/PPI blocks, the sample loop alone never reports motion
+#if (_CONFIG_PM) && !(_CONFIG_IMU_FIFO || _CONFIG_IMU_PPI)
+#error "_CONFIG_PM needs _CONFIG_IMU_FIFO or _CONFIG_IMU_PPI"
+#endif
+
+#if (_CONFIG_IMU_MOTION_STREAM) && !(_CONFIG_IMU_FIFO || _CONFIG_IMU_PPI)
+#error "_CONFIG_IMU_MOTION_STREAM needs _CONFIG_IMU_FIFO or _CONFIG_IMU_PPI"
+#endif
+
+#if (_CONFIG_WAVE_SPOOL) && !(_CONFIG_WAVE_STREAM)
+#error "_CONFIG_WAVE_SPOOL needs _CONFIG_WAVE_STREAM"
+#endif
+
 /* Public enumerate/structure ----------------------------------------- */
 /* Public macros ------------------------------------------------------ */
 /* Public variables --------------------------------------------------- */
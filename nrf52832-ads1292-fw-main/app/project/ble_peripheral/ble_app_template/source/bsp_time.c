@@ -0,0 +1,370 @@
+/**
+ * @file       bsp_time.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Board support package for the sample timebase (TIMER3)
+ * @note       The drift against the central comes from the spacing of the radio notifications:
+ *             connection events are a whole number of connection intervals of the central clock
+ *             apart, the remainder over BSP_TIME_LINK_WINDOW_S is the rate error of the counter.
+ *             The notification comes before every radio event, advertising and the other links
+ *             included, the ones off the grid of the tracked link are dropped.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "bsp_time.h"
+#include "nrf_soc.h"
+#include "nrf_nvic.h"
+#include "app_util_platform.h"
+#include "app_timer.h"
+
+/* Private defines ---------------------------------------------------- */
+#define TIME_TIMER_INSTANCE         3         // 6 CC registers
+#define TIME_LINK_IRQn              (RADIO_NOTIFICATION_IRQn)
+#define TIME_LINK_IRQ_PRIORITY      (APP_IRQ_PRIORITY_HIGH)
+#define TIME_LINK_DISTANCE          (NRF_RADIO_NOTIFICATION_DISTANCE_800US)
+#define TIME_LINK_EVENT_TICKS_Q4(i) ((uint32_t)(i) * 625)   // 1.25 ms at 31250 Hz is 39.0625 ticks
+#define TIME_LINK_RELOCK_MISSES     (8)       // Notifications off the grid in a row before locking again
+#define TIME_RTC_FOLD_INTERVAL      APP_TIMER_TICKS(60000)  // Well within the 24-bit RTC wrap
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static const nrf_drv_timer_t m_timer = NRF_DRV_TIMER_INSTANCE(TIME_TIMER_INSTANCE);
+static nrf_ppi_channel_t     m_ppi_channel[BSP_TIME_CAPTURE_MAX];
+static bool                  m_ppi_allocated[BSP_TIME_CAPTURE_MAX];
+static uint32_t              m_base;                // Tick of the counter at 0
+
+// Suspended timebase
+APP_TIMER_DEF(m_rtc_timer_id);
+static volatile bool     m_suspended;
+static uint32_t          m_suspend_tick;      // Tick at the suspension
+static uint32_t          m_rtc_last;          // RTC counter of the last fold
+static uint64_t          m_rtc_ticks;         // RTC ticks since the suspension, folded
+
+static bsp_time_link_t   m_link;
+static volatile bool     m_link_running;
+static volatile bool     m_link_new;
+static bool              m_link_primed;
+static bool              m_link_drift_valid;
+static uint32_t          m_link_last;
+static uint32_t          m_link_event_q4;     // Ticks per connection interval (Q4)
+static uint32_t          m_link_acc_ticks;
+static uint32_t          m_link_acc_events;
+static uint8_t           m_link_misses;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_bsp_time_timer_handler(nrf_timer_event_t event_type, void *p_context);
+static void m_bsp_time_rtc_handler(void *p_context);
+static uint32_t m_bsp_time_rtc_now(void);
+static void m_bsp_time_link_event(uint32_t tick);
+
+/* Function definitions ----------------------------------------------- */
+base_status_t bsp_time_init(void)
+{
+  nrf_drv_timer_config_t timer_config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+
+  timer_config.frequency = NRF_TIMER_FREQ_31250Hz;
+  timer_config.mode      = NRF_TIMER_MODE_TIMER;
+  timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+
+  // HFINT is only good to a percent, the crystal keeps the counter within its ppm
+  CHECK(sd_clock_hfclk_request() == NRF_SUCCESS, BS_ERROR);
+
+  CHECK(nrf_drv_timer_init(&m_timer, &timer_config, m_bsp_time_timer_handler) == NRF_SUCCESS, BS_ERROR);
+  CHECK(app_timer_create(&m_rtc_timer_id, APP_TIMER_MODE_REPEATED, m_bsp_time_rtc_handler) == NRF_SUCCESS, BS_ERROR);
+
+  m_base      = 0;
+  m_suspended = false;
+  nrf_drv_timer_clear(&m_timer);
+  nrf_drv_timer_enable(&m_timer);
+
+  // Set once, the SoftDevice refuses it while the radio is in use. The events are dropped until a link starts.
+  CHECK(sd_nvic_ClearPendingIRQ(TIME_LINK_IRQn) == NRF_SUCCESS, BS_ERROR);
+  CHECK(sd_nvic_SetPriority(TIME_LINK_IRQn, TIME_LINK_IRQ_PRIORITY) == NRF_SUCCESS, BS_ERROR);
+  CHECK(sd_nvic_EnableIRQ(TIME_LINK_IRQn) == NRF_SUCCESS, BS_ERROR);
+  CHECK(sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE, TIME_LINK_DISTANCE) == NRF_SUCCESS, BS_ERROR);
+
+  return BS_OK;
+}
+
+void bsp_time_suspend(void)
+{
+  if (m_suspended)
+    return;
+
+  CRITICAL_REGION_ENTER();
+  m_suspend_tick = m_base + nrf_drv_timer_capture(&m_timer, (nrf_timer_cc_channel_t)BSP_TIME_CAPTURE_NOW);
+  m_rtc_last     = app_timer_cnt_get();
+  m_rtc_ticks    = 0;
+  m_suspended    = true;
+  m_link_primed  = false;
+  nrf_drv_timer_disable(&m_timer);
+  CRITICAL_REGION_EXIT();
+
+  (void)app_timer_start(m_rtc_timer_id, TIME_RTC_FOLD_INTERVAL, NULL);
+  (void)sd_clock_hfclk_release();
+}
+
+base_status_t bsp_time_resume(void)
+{
+  if (!m_suspended)
+    return BS_OK;
+
+  CHECK(sd_clock_hfclk_request() == NRF_SUCCESS, BS_ERROR);
+  (void)app_timer_stop(m_rtc_timer_id);
+
+  CRITICAL_REGION_ENTER();
+  m_base = m_bsp_time_rtc_now();
+
+  // The captures of before the suspension would be taken from the new base
+  nrf_drv_timer_clear(&m_timer);
+  for (uint8_t i = 0; i < BSP_TIME_CAPTURE_MAX; i++)
+    nrf_timer_cc_write(m_timer.p_reg, (nrf_timer_cc_channel_t)i, 0);
+
+  nrf_drv_timer_enable(&m_timer);
+  m_suspended = false;
+  CRITICAL_REGION_EXIT();
+
+  return BS_OK;
+}
+
+uint32_t bsp_time_now(void)
+{
+  if (m_suspended)
+    return m_bsp_time_rtc_now();
+
+  return m_base + nrf_drv_timer_capture(&m_timer, (nrf_timer_cc_channel_t)BSP_TIME_CAPTURE_NOW);
+}
+
+base_status_t bsp_time_capture_attach(bsp_time_capture_t capture, uint32_t event_addr)
+{
+  ret_code_t err_code;
+
+  CHECK(capture < BSP_TIME_CAPTURE_LINK, BS_ERROR_PARAMS);
+
+  if (!m_ppi_allocated[capture])
+  {
+    err_code = nrf_drv_ppi_init();
+    CHECK((err_code == NRF_SUCCESS) || (err_code == NRF_ERROR_MODULE_ALREADY_INITIALIZED), BS_ERROR);
+
+    CHECK(nrf_drv_ppi_channel_alloc(&m_ppi_channel[capture]) == NRF_SUCCESS, BS_ERROR);
+    m_ppi_allocated[capture] = true;
+  }
+  else
+  {
+    nrf_drv_ppi_channel_disable(m_ppi_channel[capture]);
+  }
+
+  err_code = nrf_drv_ppi_channel_assign(m_ppi_channel[capture], event_addr,
+                                        nrf_drv_timer_capture_task_address_get(&m_timer, (uint32_t)capture));
+  CHECK(err_code == NRF_SUCCESS, BS_ERROR);
+  CHECK(nrf_drv_ppi_channel_enable(m_ppi_channel[capture]) == NRF_SUCCESS, BS_ERROR);
+
+  return BS_OK;
+}
+
+uint32_t bsp_time_capture_get(bsp_time_capture_t capture)
+{
+  if (m_suspended)
+    return m_bsp_time_rtc_now();
+
+  return m_base + nrf_drv_timer_capture_get(&m_timer, (nrf_timer_cc_channel_t)capture);
+}
+
+base_status_t bsp_time_link_start(uint16_t conn_interval)
+{
+  CHECK(conn_interval != 0, BS_ERROR_PARAMS);
+
+  CHECK(sd_nvic_DisableIRQ(TIME_LINK_IRQn) == NRF_SUCCESS, BS_ERROR);
+
+  // A new link counts its events from 0, a parameter update continues
+  if (!m_link_running)
+    m_link.events = 0;
+
+  m_link.conn_interval = conn_interval;
+  m_link_event_q4      = TIME_LINK_EVENT_TICKS_Q4(conn_interval);
+  m_link_primed        = false;
+  m_link_acc_ticks     = 0;
+  m_link_acc_events    = 0;
+  m_link_misses        = 0;
+  m_link_running       = true;
+
+  CHECK(sd_nvic_EnableIRQ(TIME_LINK_IRQn) == NRF_SUCCESS, BS_ERROR);
+
+  return BS_OK;
+}
+
+void bsp_time_link_stop(void)
+{
+  // The notification stays configured, its events are dropped
+  m_link_running = false;
+}
+
+bool bsp_time_link_get(bsp_time_link_t *p_link)
+{
+  bool is_new;
+
+  CRITICAL_REGION_ENTER();
+  *p_link    = m_link;
+  is_new     = m_link_new;
+  m_link_new = false;
+  CRITICAL_REGION_EXIT();
+
+  return is_new;
+}
+
+uint8_t bsp_time_link_encode(const bsp_time_link_t *p_link, uint8_t *p_buf)
+{
+  uint8_t len = 0;
+
+  len += uint32_encode(p_link->tick, &p_buf[len]);
+  len += uint32_encode(p_link->events, &p_buf[len]);
+  len += uint32_encode((uint32_t)p_link->drift_ppb, &p_buf[len]);
+  len += uint16_encode(p_link->conn_interval, &p_buf[len]);
+
+  return len;
+}
+
+/**
+ * @brief         Radio notification interrupt, the radio starts TIME_LINK_DISTANCE later
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void SWI1_EGU1_IRQHandler(void)
+{
+  // The RTC timebase is too coarse for the drift, the link is tracked again after the resume
+  if (!m_link_running || m_suspended)
+    return;
+
+  nrf_drv_timer_capture(&m_timer, (nrf_timer_cc_channel_t)BSP_TIME_CAPTURE_LINK);
+  m_bsp_time_link_event(bsp_time_capture_get(BSP_TIME_CAPTURE_LINK));
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Timer handler, no compare interrupt is enabled
+ *
+ * @param[in]     event_type    Timer event
+ * @param[in]     p_context     Unused
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_time_timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+}
+
+/**
+ * @brief         RTC fold timer handler, accounts the RTC ticks before the counter wraps
+ *
+ * @param[in]     p_context     Unused
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_time_rtc_handler(void *p_context)
+{
+  uint32_t rtc;
+
+  CRITICAL_REGION_ENTER();
+  rtc          = app_timer_cnt_get();
+  m_rtc_ticks += app_timer_cnt_diff_compute(rtc, m_rtc_last);
+  m_rtc_last   = rtc;
+  CRITICAL_REGION_EXIT();
+}
+
+/**
+ * @brief         Current tick of the suspended timebase
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Tick
+ */
+static uint32_t m_bsp_time_rtc_now(void)
+{
+  uint64_t rtc_ticks;
+
+  CRITICAL_REGION_ENTER();
+  rtc_ticks = m_rtc_ticks + app_timer_cnt_diff_compute(app_timer_cnt_get(), m_rtc_last);
+  CRITICAL_REGION_EXIT();
+
+  return m_suspend_tick + (uint32_t)(rtc_ticks * BSP_TIME_FREQ_HZ / APP_TIMER_CLOCK_FREQ);
+}
+
+/**
+ * @brief         Account a connection event and update the drift estimate
+ *
+ * @param[in]     tick          Tick of the notification
+ *
+ * @attention     A notification off the interval grid by more than an eighth of an interval is
+ *                advertising or another link and is dropped. The grid is taken again from the
+ *                newest notification after TIME_LINK_RELOCK_MISSES of them in a row.
+ *
+ * @return        None
+ */
+static void m_bsp_time_link_event(uint32_t tick)
+{
+  uint32_t dt_q4 = (tick - m_link_last) << 4;
+  uint32_t events;
+  int32_t  residual;
+
+  if (!m_link_primed)
+  {
+    m_link_primed = true;
+    m_link_last   = tick;
+    m_link.tick   = tick;
+    return;
+  }
+
+  events   = (dt_q4 + m_link_event_q4 / 2) / m_link_event_q4;
+  residual = (int32_t)(dt_q4 - events * m_link_event_q4);
+
+  if ((events == 0) || (residual > (int32_t)(m_link_event_q4 / 8)) || (residual < -(int32_t)(m_link_event_q4 / 8)))
+  {
+    // The first notification may have been advertising, never on the grid of the link
+    if (++m_link_misses >= TIME_LINK_RELOCK_MISSES)
+    {
+      m_link_misses     = 0;
+      m_link_last       = tick;
+      m_link_acc_ticks  = 0;
+      m_link_acc_events = 0;
+    }
+    return;
+  }
+
+  m_link_misses      = 0;
+
+  m_link.tick        = tick;
+  m_link.events     += events;
+  m_link_acc_ticks  += tick - m_link_last;
+  m_link_acc_events += events;
+  m_link_last        = tick;
+
+  // Connection intervals of 1.25 ms in the estimation window
+  if (m_link_acc_events * m_link.conn_interval < BSP_TIME_LINK_WINDOW_S * 800UL)
+    return;
+
+  int64_t expected_q4 = (int64_t)m_link_acc_events * m_link_event_q4;
+  int32_t drift_ppb   = (int32_t)((((int64_t)m_link_acc_ticks << 4) - expected_q4) * 1000000000LL / expected_q4);
+
+  m_link.drift_ppb   = m_link_drift_valid ? (m_link.drift_ppb + (drift_ppb - m_link.drift_ppb) / 4) : drift_ppb;
+  m_link_drift_valid = true;
+  m_link_new         = true;
+  m_link_acc_ticks   = 0;
+  m_link_acc_events  = 0;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,202 @@
+/**
+ * @file       bsp_time.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Board support package for the sample timebase (TIMER3)
+ * @note       One free-running 32-bit counter stamps every sensor. The data-ready edges are
+ *             captured by PPI, so the tick is the one of the edge and not of its handler.
+ *             Suspended, the counter and the crystal are off and the RTC carries the timebase.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BSP_TIME_H
+#define __BSP_TIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include "bsp_hw.h"
+#include "app_util.h"
+
+/* Public defines ----------------------------------------------------- */
+#define BSP_TIME_FREQ_HZ            (31250)   // Tick rate, 32 us resolution and 38 hours before the wrap
+#define BSP_TIME_LINK_WINDOW_S      (30)      // Link time of one drift estimate
+#define BSP_TIME_LINK_ENCODED_SIZE  (14)      // Size of an encoded link timing record (bytes)
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief BSP time capture enum, one TIMER3 CC register each
+ */
+typedef enum
+{
+  BSP_TIME_CAPTURE_AFE_DRDY = 0x00  // ADS1292 DRDY falling edge
+  , BSP_TIME_CAPTURE_IMU_INT        // MPU9250 INT rising edge
+  , BSP_TIME_CAPTURE_IMU_PPI        // RTC2 trigger of the hardware-triggered IMU reads
+  , BSP_TIME_CAPTURE_LINK           // Radio notification before a connection event
+  , BSP_TIME_CAPTURE_NOW            // Software capture
+  , BSP_TIME_CAPTURE_MAX
+}
+bsp_time_capture_t;
+
+/**
+ * @brief BSP time link structure, the timebase against the BLE connection events
+ */
+typedef struct
+{
+  uint32_t tick;              // Tick of the newest connection event
+  uint32_t events;            // Connection events since the link start, skipped ones included
+  int32_t  drift_ppb;         // Timebase rate error against the central (parts per billion)
+  uint16_t conn_interval;     // Connection interval (1.25 ms)
+}
+bsp_time_link_t;
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Ticks from the first sample to sample n, the period is not a whole number of ticks
+ */
+#define BSP_TIME_SAMPLE_TICKS(n, rate_hz) ((uint32_t)(n) * BSP_TIME_FREQ_HZ / (rate_hz))
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         BSP time init, the timebase starts from 0
+ *
+ * @param[in]     None
+ *
+ * @attention     The high-frequency crystal is requested from the SoftDevice for the accuracy
+ *                of the counter. Called right after the SoftDevice is enabled, before any radio
+ *                activity, the radio notification is only configured here.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_time_init(void);
+
+/**
+ * @brief         BSP time suspend the counter, the high-frequency crystal is released
+ *
+ * @param[in]     None
+ *
+ * @attention     The timebase goes on at the RTC resolution, the captures return the time of
+ *                their reading and the link tracking pauses
+ *
+ * @return        None
+ */
+void bsp_time_suspend(void);
+
+/**
+ * @brief         BSP time resume the counter from the RTC timebase
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_time_resume(void);
+
+/**
+ * @brief         BSP time get the current tick
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Tick
+ */
+uint32_t bsp_time_now(void);
+
+/**
+ * @brief         BSP time connect a hardware event to a capture
+ *
+ * @param[in]     capture       Capture, BSP_TIME_CAPTURE_AFE_DRDY..BSP_TIME_CAPTURE_IMU_PPI
+ * @param[in]     event_addr    Address of the event register
+ *
+ * @attention     The PPI channel stays allocated, attaching again moves it to the new event
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ * - BS_ERROR
+ */
+base_status_t bsp_time_capture_attach(bsp_time_capture_t capture, uint32_t event_addr);
+
+/**
+ * @brief         BSP time get the tick of the newest captured event
+ *
+ * @param[in]     capture       Capture
+ *
+ * @attention     None
+ *
+ * @return        Tick
+ */
+uint32_t bsp_time_capture_get(bsp_time_capture_t capture);
+
+/**
+ * @brief         BSP time start tracking the timebase against the connection events
+ *
+ * @param[in]     conn_interval Connection interval (1.25 ms)
+ *
+ * @attention     Called on every connection and connection parameter update. The radio
+ *                notification interrupt captures the tick before each radio event, only the
+ *                ones on the connection interval grid of the tracked link are kept.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_time_link_start(uint16_t conn_interval);
+
+/**
+ * @brief         BSP time stop tracking the connection events
+ *
+ * @param[in]     None
+ *
+ * @attention     The drift estimate is kept for the next link
+ *
+ * @return        None
+ */
+void bsp_time_link_stop(void);
+
+/**
+ * @brief         BSP time get the link timing
+ *
+ * @param[out]    p_link        Pointer to link timing
+ *
+ * @attention     A host converts a tick t to its clock with the tick of a connection event it
+ *                timestamped: host + (t - tick) * (1 - drift_ppb / 1e9) / BSP_TIME_FREQ_HZ
+ *
+ * @return
+ * - true       A new drift estimate since the previous call
+ * - false      No new estimate
+ */
+bool bsp_time_link_get(bsp_time_link_t *p_link);
+
+/**
+ * @brief         BSP time encode the link timing (little endian)
+ *
+ * @param[in]     p_link        Link timing
+ * @param[out]    p_buf         Output buffer, at least BSP_TIME_LINK_ENCODED_SIZE bytes
+ *
+ * @attention     None
+ *
+ * @return        Encoded length
+ */
+uint8_t bsp_time_link_encode(const bsp_time_link_t *p_link, uint8_t *p_buf);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __BSP_TIME_H
+
+/* End of file -------------------------------------------------------- */
@@ -22,6 +22,31 @@ extern "C" {
 /* Includes ----------------------------------------------------------- */
 /* Public defines ----------------------------------------------------- */
 #define _CONFIG_DEVICE_DEVKIT (0)
+#define _CONFIG_RESP_SOURCE_EDR (0)   // Boot with ECG-derived respiration, ADS1292R RESP modulation off
+#define _CONFIG_MOTION_CANCEL   (1)   // Accelerometer-referenced motion-artifact cancellation of the ECG/EMG
+#define _CONFIG_IMU_FIFO        (1)   // Continuous IMU acquisition through the MPU9250 FIFO
+#define _CONFIG_IMU_FIFO_RATE   (200) // IMU FIFO sample rate (Hz), 4..1000
+#define _CONFIG_IMU_INT_PIN     (22)  // GPIO wired to the MPU9250 INT (pin 12), set per board revision
+#define _CONFIG_IMU_MAG         (1)   // AK8963 magnetometer auto-read by the MPU9250 I2C master
+#define _CONFIG_IMU_CALIB       (1)   // Stored accel/mag calibration and gyro bias tracking, applied to every frame
+#define _CONFIG_IMU_AHRS        (1)   // Orientation filter on the FIFO/PPI frames
+#define _CONFIG_IMU_AHRS_RATE   (25)  // Orientation output rate (Hz), at most _CONFIG_IMU_FIFO_RATE
+#define _CONFIG_IMU_PPI         (0)   // IMU reads triggered by RTC2 through PPI and TWIM EasyDMA instead of the FIFO
+#define _CONFIG_IMU_ACTIVITY    (1)   // Activity classification and step counting on the FIFO/PPI frames
+#define _CONFIG_IMU_RAW_STREAM  (0)   // Legacy per-axis accel/gyro/mag services (ACS/GYS/MGS), one notification per axis
+#define _CONFIG_IMU_MOTION_STREAM (1) // Packed accel/gyro/mag frames on the motion service (MOS), needs the FIFO or PPI reads
+#define _CONFIG_IMU_MOTION_RATE (50)  // Motion service frame rate (Hz), the FIFO rate divided by a whole number
+#define _CONFIG_WAVE_STREAM     (1)   // Batched ECG/RESP/accel waveform notifications on the waveform service (WFS)
+#define _CONFIG_WAVE_RECORD     (1)   // Lossless-compressed filtered ECG recorded to the NAND flash log
+#define _CONFIG_WAVE_SPOOL      (1)   // Waveform packets kept in the NAND flash log, replayed after a gap and on request, needs the WFS
+#define _CONFIG_HRS             (1)   // Standard Heart Rate Service, heart rate and RR intervals per beat
+#define _CONFIG_CTRL_POINT      (1)   // Control point service (CPS): streams, channels, rates and filter chain set at runtime
+#define _CONFIG_BROADCAST       (1)   // Vitals in the manufacturer specific advertising data, advertising without timeout
+#define _CONFIG_BROADCAST_PERIOD (1000) // Vitals advertising data update period (ms)
+#define _CONFIG_BROADCAST_CONNECTABLE (1) // Boot advertising connectable, otherwise broadcast only until switched
+#define _CONFIG_PM              (1)   // Activity power states: wake on motion when still, AFE standby when unworn, needs the FIFO or PPI reads
+#define _CONFIG_PM_STILL_TIME   (60)  // Seconds without motion before the still state
+#define _CONFIG_PM_UNWORN_TIME  (120) // Seconds still with the ECG electrodes off before the unworn state
 
 /* Public enumerate/structure ----------------------------------------- */
 /* Public macros ------------------------------------------------------ */
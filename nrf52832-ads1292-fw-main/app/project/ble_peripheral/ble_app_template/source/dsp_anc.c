@@ -0,0 +1,231 @@
+/**
+ * @file       dsp_anc.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Adaptive (NLMS) motion-artifact canceller with accelerometer reference
+ * @note       The reference is the DC-removed accelerometer, delayed by the ECG FIR group
+ *             delay and fed to a DSP_ANC_TAPS tap filter per axis. Dot products and the
+ *             weight update run on packed int16 pairs (SMLALD / QADD16) when the core has
+ *             the DSP extension.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "nrf.h"
+#include "nordic_common.h"
+#include "dsp_anc.h"
+
+/* Private defines ---------------------------------------------------- */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define DSP_ANC_USE_SIMD            (1)
+#else
+#define DSP_ANC_USE_SIMD            (0)
+#endif
+
+#define DSP_ANC_ROUND               (1 << 14)                      // Rounding of the Q15 weight steps, truncation biases the weights
+
+#define DSP_ANC_SETTLE_SAMPLES      (8 << DSP_ANC_POWER_SHIFT)     // Samples after a reset before reporting convergence
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+#define DSP_ANC_SAT16(v)            (((v) > 32767) ? 32767 : (((v) < -32768) ? -32768 : (v)))
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static int16_t  m_x[DSP_ANC_LEN] __ALIGNED(4);                     // Reference taps, [axis][tap], newest first
+static int16_t  m_w[DSP_ANC_LEN] __ALIGNED(4);                     // Weights (Q3.12)
+
+static int32_t  m_dc[DSP_ANC_AXES];                                // Accelerometer DC estimate (Q8)
+static int16_t  m_delay[DSP_ANC_AXES][DSP_ANC_REF_DELAY];          // Reference delay line
+static uint16_t m_delay_idx;
+
+static uint32_t m_in_power;
+static uint32_t m_out_power;
+static uint16_t m_diverge_run;
+static uint16_t m_resets;
+static uint16_t m_settle;
+
+/* Private function prototypes ---------------------------------------- */
+static int64_t m_dsp_anc_dot(const int16_t *p_a, const int16_t *p_b);
+static void m_dsp_anc_update(int16_t gain);
+static void m_dsp_anc_monitor(int16_t sample, int16_t output);
+
+/* Function definitions ----------------------------------------------- */
+void dsp_anc_init(void)
+{
+  memset(m_x, 0, sizeof(m_x));
+  memset(m_dc, 0, sizeof(m_dc));
+  memset(m_delay, 0, sizeof(m_delay));
+  m_delay_idx = 0;
+  m_in_power  = 0;
+  m_out_power = 0;
+  m_resets    = 0;
+
+  dsp_anc_reset();
+}
+
+void dsp_anc_reset(void)
+{
+  memset(m_w, 0, sizeof(m_w));
+  m_diverge_run = 0;
+  m_settle      = 0;
+  m_out_power   = m_in_power;
+}
+
+int16_t dsp_anc_process(int16_t sample, const mpu9250_raw_data_t *accel)
+{
+  const int16_t raw[DSP_ANC_AXES] = { accel->x, accel->y, accel->z };
+  int64_t energy;
+  int32_t y, e;
+
+  // Remove gravity/DC, delay and push the reference into the tap lines
+  for (uint8_t a = 0; a < DSP_ANC_AXES; a++)
+  {
+    int32_t ref;
+    int16_t *p_taps = &m_x[a * DSP_ANC_TAPS];
+
+    m_dc[a] += (((int32_t)raw[a] << 8) - m_dc[a]) >> DSP_ANC_DC_SHIFT;
+    ref      = (int32_t)raw[a] - (m_dc[a] >> 8);
+
+    memmove(&p_taps[1], &p_taps[0], (DSP_ANC_TAPS - 1) * sizeof(int16_t));
+    p_taps[0] = m_delay[a][m_delay_idx];
+    m_delay[a][m_delay_idx] = (int16_t)DSP_ANC_SAT16(ref);
+  }
+
+  m_delay_idx = (m_delay_idx + 1) % DSP_ANC_REF_DELAY;
+
+  // Artifact estimate and error (the cleaned sample)
+  int64_t acc = m_dsp_anc_dot(m_w, m_x) >> DSP_ANC_WEIGHT_FRAC;
+
+  y = (int32_t)DSP_ANC_SAT16(acc);
+  e = DSP_ANC_SAT16((int32_t)sample - y);
+
+  // NLMS: w += mu * e * x / |x|^2, frozen while the subject is still
+  energy = m_dsp_anc_dot(m_x, m_x);
+  if (energy >= DSP_ANC_MIN_ENERGY)
+  {
+    int64_t gain = (((int64_t)DSP_ANC_MU_Q15 * e) << DSP_ANC_WEIGHT_FRAC) / (energy + DSP_ANC_MIN_ENERGY);
+
+    m_dsp_anc_update((int16_t)DSP_ANC_SAT16(gain));
+  }
+
+  m_dsp_anc_monitor(sample, (int16_t)e);
+
+  // Pass the input through while the canceller is adding power
+  return (m_diverge_run != 0) ? sample : (int16_t)e;
+}
+
+void dsp_anc_get_stats(dsp_anc_stats_t *p_stats)
+{
+  p_stats->input_power  = m_in_power;
+  p_stats->output_power = m_out_power;
+  p_stats->residual     = (m_in_power == 0) ? 1000 :
+                          (uint16_t)MIN(((uint64_t)m_out_power * 1000) / m_in_power, 0xFFFF);
+  p_stats->resets       = m_resets;
+  p_stats->converged    = (m_settle >= DSP_ANC_SETTLE_SAMPLES) && (m_out_power <= m_in_power);
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Dot product of two DSP_ANC_LEN int16 vectors
+ *
+ * @param[in]     p_a           Vector a (4-byte aligned)
+ * @param[in]     p_b           Vector b (4-byte aligned)
+ *
+ * @attention     None
+ *
+ * @return        Dot product
+ */
+static int64_t m_dsp_anc_dot(const int16_t *p_a, const int16_t *p_b)
+{
+#if (DSP_ANC_USE_SIMD)
+  const uint32_t *p_a2 = (const uint32_t *)p_a;
+  const uint32_t *p_b2 = (const uint32_t *)p_b;
+  uint64_t acc = 0;
+
+  for (uint8_t i = 0; i < DSP_ANC_LEN / 2; i++)
+    acc = __SMLALD(p_a2[i], p_b2[i], acc);
+
+  return (int64_t)acc;
+#else
+  int64_t acc = 0;
+
+  for (uint8_t i = 0; i < DSP_ANC_LEN; i++)
+    acc += (int32_t)p_a[i] * p_b[i];
+
+  return acc;
+#endif
+}
+
+/**
+ * @brief         Weight update w[i] += round((gain * x[i]) >> 15) with saturation
+ *
+ * @param[in]     gain          NLMS gain, mu * e * 2^12 / |x|^2
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_dsp_anc_update(int16_t gain)
+{
+#if (DSP_ANC_USE_SIMD)
+  const uint32_t *p_x2 = (const uint32_t *)m_x;
+  uint32_t       *p_w2 = (uint32_t *)m_w;
+
+  for (uint8_t i = 0; i < DSP_ANC_LEN / 2; i++)
+  {
+    int32_t lo = (gain * (int16_t)(p_x2[i] & 0xFFFF) + DSP_ANC_ROUND) >> 15;
+    int32_t hi = (gain * (int16_t)(p_x2[i] >> 16) + DSP_ANC_ROUND) >> 15;
+
+    p_w2[i] = __QADD16(p_w2[i], __PKHBT(lo, hi, 16));
+  }
+#else
+  for (uint8_t i = 0; i < DSP_ANC_LEN; i++)
+  {
+    int32_t w = m_w[i] + ((gain * m_x[i] + DSP_ANC_ROUND) >> 15);
+
+    m_w[i] = (int16_t)DSP_ANC_SAT16(w);
+  }
+#endif
+}
+
+/**
+ * @brief         Convergence/stability monitor, resets the weights on divergence
+ *
+ * @param[in]     sample        Input sample
+ * @param[in]     output        Cleaned sample
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_dsp_anc_monitor(int16_t sample, int16_t output)
+{
+  int64_t d2 = (int32_t)sample * sample;
+  int64_t e2 = (int32_t)output * output;
+
+  m_in_power  = (uint32_t)((int64_t)m_in_power  + ((d2 - (int64_t)m_in_power)  >> DSP_ANC_POWER_SHIFT));
+  m_out_power = (uint32_t)((int64_t)m_out_power + ((e2 - (int64_t)m_out_power) >> DSP_ANC_POWER_SHIFT));
+
+  if (m_settle < DSP_ANC_SETTLE_SAMPLES)
+    m_settle++;
+
+  if ((uint64_t)m_out_power > (uint64_t)m_in_power * DSP_ANC_DIVERGE_RATIO)
+  {
+    if (++m_diverge_run >= DSP_ANC_DIVERGE_COUNT)
+    {
+      m_resets++;
+      dsp_anc_reset();
+    }
+  }
+  else
+  {
+    m_diverge_run = 0;
+  }
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,109 @@
+/**
+ * @file       dsp_anc.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Adaptive (NLMS) motion-artifact canceller with accelerometer reference
+ * @note       None
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __DSP_ANC_H
+#define __DSP_ANC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu9250.h"
+
+/* Public defines ----------------------------------------------------- */
+#define DSP_ANC_TAPS                (8)       // Taps per accelerometer axis (even)
+#define DSP_ANC_AXES                (3)
+#define DSP_ANC_LEN                 (DSP_ANC_TAPS * DSP_ANC_AXES)
+
+#define DSP_ANC_REF_DELAY           (80)      // Reference delay, group delay of the 161-tap ECG FIR (samples)
+#define DSP_ANC_DC_SHIFT            (6)       // Accelerometer DC removal time constant (2^n samples)
+#define DSP_ANC_WEIGHT_FRAC         (12)      // Weights are Q3.12
+#define DSP_ANC_MU_Q15              (328)     // NLMS step size (0.01 in Q15)
+#define DSP_ANC_MIN_ENERGY          (4096)    // Reference energy below which the weights are frozen (no motion)
+
+#define DSP_ANC_POWER_SHIFT         (7)       // Power monitor time constant (2^n samples)
+#define DSP_ANC_DIVERGE_RATIO       (4)       // Output power above n x input power is a divergence
+#define DSP_ANC_DIVERGE_COUNT       (125)     // Diverged samples in a row before the weights are reset
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief DSP ANC statistics structure
+ */
+typedef struct
+{
+  uint32_t input_power;       // Running power of the input signal
+  uint32_t output_power;      // Running power of the cleaned signal
+  uint16_t residual;          // Output / input power (per mille), below 1000 when artifacts are removed
+  uint16_t resets;            // Weight resets by the stability monitor
+  bool     converged;         // Output power settled at or below the input power
+}
+dsp_anc_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         DSP ANC init
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_anc_init(void);
+
+/**
+ * @brief         DSP ANC reset the adaptive weights
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_anc_reset(void);
+
+/**
+ * @brief         DSP ANC cancel the motion artifact of one sample
+ *
+ * @param[in]     sample        Biosignal sample (ECG/EMG)
+ * @param[in]     accel         Accelerometer raw data read at the same sample instant
+ *
+ * @attention     None
+ *
+ * @return        Cleaned sample
+ */
+int16_t dsp_anc_process(int16_t sample, const mpu9250_raw_data_t *accel);
+
+/**
+ * @brief         DSP ANC get statistics of the convergence/stability monitor
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_anc_get_stats(dsp_anc_stats_t *p_stats);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __DSP_ANC_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,416 @@
+/**
+ * @file       dsp_codec.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Lossless sample block codec, delta prediction and adaptive Rice coding
+ * @note       The Rice parameter follows the residual magnitude as in JPEG-LS: k is the smallest
+ *             value with count * 2^k >= sum |residual|, the sums are halved every
+ *             DSP_CODEC_ADAPT_RESET samples. A filtered ECG codes at 4 to 7 bits per sample.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "dsp_codec.h"
+
+/* Private defines ---------------------------------------------------- */
+#define DSP_CODEC_ADAPT_INIT        (16)      // Residual magnitude sum at the start of a block
+#define DSP_CODEC_ADAPT_RESET       (32)      // Samples before the sums are halved
+#define DSP_CODEC_COST_MAX          (0xFFFF)  // Residual magnitude counted in the order costs
+#define DSP_CODEC_RAW_SPLIT         (13)      // Raw residuals are written in two parts
+
+#define DSP_CODEC_SAMPLE_MAX        ((1L << (DSP_CODEC_SAMPLE_BITS - 1)) - 1)
+#define DSP_CODEC_SAMPLE_MIN        (-(1L << (DSP_CODEC_SAMPLE_BITS - 1)))
+
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief DSP codec bit reader structure
+ */
+typedef struct
+{
+  const uint8_t *p_buf;
+  uint16_t       len;
+  uint16_t       pos;
+  uint32_t       bits;
+  uint8_t        bit_count;
+  bool           error;       // Read past the end of the block
+}
+dsp_codec_reader_t;
+
+/* Private macros ----------------------------------------------------- */
+#define DSP_CODEC_ABS(_x)           (((_x) < 0) ? -(_x) : (_x))
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+/* Private function prototypes ---------------------------------------- */
+static int32_t m_dsp_codec_predict(const dsp_codec_channel_t *p_ch, uint8_t order);
+static uint8_t m_dsp_codec_k(const dsp_codec_channel_t *p_ch);
+static void m_dsp_codec_adapt(dsp_codec_channel_t *p_ch, int32_t sample, int32_t residual);
+static void m_dsp_codec_channel_reset(dsp_codec_channel_t *p_ch);
+static void m_dsp_codec_put(dsp_codec_t *p_codec, uint32_t value, uint8_t count);
+static uint32_t m_dsp_codec_get(dsp_codec_reader_t *p_reader, uint8_t count);
+
+/* Function definitions ----------------------------------------------- */
+bool dsp_codec_init(dsp_codec_t *p_codec, uint8_t channels)
+{
+  if ((channels == 0) || (channels > DSP_CODEC_MAX_CHANNELS))
+    return false;
+
+  memset(p_codec, 0, sizeof(dsp_codec_t));
+  p_codec->channels = channels;
+
+  for (uint8_t c = 0; c < channels; c++)
+    p_codec->ch[c].order = 1;
+
+  return true;
+}
+
+void dsp_codec_block_start(dsp_codec_t *p_codec, uint8_t *p_buf, uint16_t size)
+{
+  p_codec->p_buf     = p_buf;
+  p_codec->size      = size;
+  p_codec->len       = DSP_CODEC_HEADER_SIZE;
+  p_codec->bits      = 0;
+  p_codec->bit_count = 0;
+  p_codec->frames    = 0;
+  p_codec->overflow  = false;
+
+  for (uint8_t c = 0; c < p_codec->channels; c++)
+    m_dsp_codec_channel_reset(&p_codec->ch[c]);
+}
+
+bool dsp_codec_block_add(dsp_codec_t *p_codec, const int32_t *p_frame)
+{
+  dsp_codec_channel_t saved[DSP_CODEC_MAX_CHANNELS];
+  uint16_t            saved_len       = p_codec->len;
+  uint32_t            saved_bits      = p_codec->bits;
+  uint8_t             saved_bit_count = p_codec->bit_count;
+
+  if ((p_codec->frames == UINT16_MAX) || (p_codec->len >= p_codec->size))
+    return false;
+
+  // Most frames take a few bits, the space is checked after the coding instead of reserving the worst case
+  memcpy(saved, p_codec->ch, p_codec->channels * sizeof(dsp_codec_channel_t));
+  p_codec->overflow = false;
+
+  for (uint8_t c = 0; c < p_codec->channels; c++)
+  {
+    dsp_codec_channel_t *p_ch = &p_codec->ch[c];
+    int32_t  sample   = p_frame[c];
+    int32_t  residual;
+    uint32_t mapped;
+    uint8_t  k;
+
+    if (sample > DSP_CODEC_SAMPLE_MAX)
+      sample = DSP_CODEC_SAMPLE_MAX;
+    else if (sample < DSP_CODEC_SAMPLE_MIN)
+      sample = DSP_CODEC_SAMPLE_MIN;
+
+    // Residual magnitude of every order once its history is there, for the next block
+    for (uint8_t o = 0; o <= DSP_CODEC_MAX_ORDER; o++)
+    {
+      if (p_codec->frames < o)
+        continue;
+
+      int32_t e = sample - m_dsp_codec_predict(p_ch, o);
+      p_ch->cost[o] += (uint32_t)((DSP_CODEC_ABS(e) > DSP_CODEC_COST_MAX) ? DSP_CODEC_COST_MAX : DSP_CODEC_ABS(e));
+    }
+
+    residual = sample - m_dsp_codec_predict(p_ch, (p_codec->frames < p_ch->order) ? p_codec->frames : p_ch->order);
+    mapped   = ((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31);
+    k        = m_dsp_codec_k(p_ch);
+
+    if ((mapped >> k) >= DSP_CODEC_ESCAPE)
+    {
+      m_dsp_codec_put(p_codec, (1u << DSP_CODEC_ESCAPE) - 1, DSP_CODEC_ESCAPE);
+      m_dsp_codec_put(p_codec, mapped >> DSP_CODEC_RAW_SPLIT, DSP_CODEC_RAW_BITS - DSP_CODEC_RAW_SPLIT);
+      m_dsp_codec_put(p_codec, mapped & ((1u << DSP_CODEC_RAW_SPLIT) - 1), DSP_CODEC_RAW_SPLIT);
+    }
+    else
+    {
+      uint32_t q = mapped >> k;
+
+      // q ones and the terminating zero, then the k low bits
+      m_dsp_codec_put(p_codec, ((1u << q) - 1) << 1, (uint8_t)(q + 1));
+      m_dsp_codec_put(p_codec, mapped & ((1u << k) - 1), k);
+    }
+
+    m_dsp_codec_adapt(p_ch, sample, residual);
+  }
+
+  // The padding of the last byte must fit as well
+  if (p_codec->overflow || ((p_codec->len + ((p_codec->bit_count != 0) ? 1 : 0)) > p_codec->size))
+  {
+    memcpy(p_codec->ch, saved, p_codec->channels * sizeof(dsp_codec_channel_t));
+    p_codec->len       = saved_len;
+    p_codec->bits      = saved_bits;
+    p_codec->bit_count = saved_bit_count;
+    p_codec->overflow  = false;
+
+    return false;
+  }
+
+  p_codec->frames++;
+
+  return true;
+}
+
+uint16_t dsp_codec_block_end(dsp_codec_t *p_codec)
+{
+  uint16_t orders = 0;
+
+  // Pad the last byte with zeros
+  if (p_codec->bit_count != 0)
+    m_dsp_codec_put(p_codec, 0, 8 - p_codec->bit_count);
+
+  for (uint8_t c = 0; c < p_codec->channels; c++)
+  {
+    dsp_codec_channel_t *p_ch = &p_codec->ch[c];
+
+    orders |= (uint16_t)(p_ch->order << (2 * c));
+
+    // The lowest cost order codes the next block, a lower order wins a tie
+    if (p_codec->frames > DSP_CODEC_MAX_ORDER)
+    {
+      uint8_t best = 0;
+
+      for (uint8_t o = 1; o <= DSP_CODEC_MAX_ORDER; o++)
+      {
+        if (p_ch->cost[o] < p_ch->cost[best])
+          best = o;
+      }
+      p_ch->order = best;
+    }
+  }
+
+  p_codec->p_buf[0] = (uint8_t)p_codec->frames;
+  p_codec->p_buf[1] = (uint8_t)(p_codec->frames >> 8);
+  p_codec->p_buf[2] = (uint8_t)orders;
+  p_codec->p_buf[3] = (uint8_t)(orders >> 8);
+
+  return p_codec->len;
+}
+
+uint16_t dsp_codec_decode(const uint8_t *p_buf, uint16_t len, uint8_t channels,
+                          int32_t *p_frames, uint16_t max_frames)
+{
+  dsp_codec_channel_t ch[DSP_CODEC_MAX_CHANNELS];
+  dsp_codec_reader_t  reader;
+  uint16_t            frames;
+  uint16_t            orders;
+
+  if ((channels == 0) || (channels > DSP_CODEC_MAX_CHANNELS) || (len < DSP_CODEC_HEADER_SIZE))
+    return 0;
+
+  frames = (uint16_t)(p_buf[0] | (p_buf[1] << 8));
+  orders = (uint16_t)(p_buf[2] | (p_buf[3] << 8));
+
+  if ((frames == 0) || (frames > max_frames))
+    return 0;
+
+  for (uint8_t c = 0; c < channels; c++)
+  {
+    m_dsp_codec_channel_reset(&ch[c]);
+    ch[c].order = (orders >> (2 * c)) & 0x03;
+
+    if (ch[c].order > DSP_CODEC_MAX_ORDER)
+      return 0;
+  }
+
+  memset(&reader, 0, sizeof(reader));
+  reader.p_buf = p_buf;
+  reader.len   = len;
+  reader.pos   = DSP_CODEC_HEADER_SIZE;
+
+  for (uint16_t n = 0; n < frames; n++)
+  {
+    for (uint8_t c = 0; c < channels; c++)
+    {
+      dsp_codec_channel_t *p_ch = &ch[c];
+      uint8_t  k = m_dsp_codec_k(p_ch);
+      uint32_t q = 0;
+      uint32_t mapped;
+      int32_t  residual;
+      int32_t  sample;
+
+      while ((q < DSP_CODEC_ESCAPE) && m_dsp_codec_get(&reader, 1))
+        q++;
+
+      if (q == DSP_CODEC_ESCAPE)
+      {
+        mapped  = m_dsp_codec_get(&reader, DSP_CODEC_RAW_BITS - DSP_CODEC_RAW_SPLIT) << DSP_CODEC_RAW_SPLIT;
+        mapped |= m_dsp_codec_get(&reader, DSP_CODEC_RAW_SPLIT);
+      }
+      else
+      {
+        mapped = (q << k) | m_dsp_codec_get(&reader, k);
+      }
+
+      if (reader.error)
+        return 0;
+
+      residual = (int32_t)(mapped >> 1) ^ -(int32_t)(mapped & 1);
+      sample   = residual + m_dsp_codec_predict(p_ch, (n < p_ch->order) ? (uint8_t)n : p_ch->order);
+
+      m_dsp_codec_adapt(p_ch, sample, residual);
+      p_frames[(uint32_t)n * channels + c] = sample;
+    }
+  }
+
+  return frames;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Predict the next sample of a channel
+ *
+ * @param[in]     p_ch          Pointer to channel state
+ * @param[in]     order         Predictor order, at most the samples seen in the block
+ *
+ * @attention     None
+ *
+ * @return        Prediction
+ */
+static int32_t m_dsp_codec_predict(const dsp_codec_channel_t *p_ch, uint8_t order)
+{
+  switch (order)
+  {
+  case 1:
+    return p_ch->prev[0];
+
+  case 2:
+    return 2 * p_ch->prev[0] - p_ch->prev[1];
+
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief         Rice parameter of the next residual of a channel
+ *
+ * @param[in]     p_ch          Pointer to channel state
+ *
+ * @attention     At most DSP_CODEC_MAX_K iterations
+ *
+ * @return        Rice parameter
+ */
+static uint8_t m_dsp_codec_k(const dsp_codec_channel_t *p_ch)
+{
+  uint8_t k = 0;
+
+  while ((k < DSP_CODEC_MAX_K) && (((uint32_t)p_ch->acc_count << k) < p_ch->acc))
+    k++;
+
+  return k;
+}
+
+/**
+ * @brief         Update the history and the residual magnitude of a channel
+ *
+ * @param[in]     p_ch          Pointer to channel state
+ * @param[in]     sample        Coded sample
+ * @param[in]     residual      Its residual
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_dsp_codec_adapt(dsp_codec_channel_t *p_ch, int32_t sample, int32_t residual)
+{
+  p_ch->prev[1] = p_ch->prev[0];
+  p_ch->prev[0] = sample;
+
+  p_ch->acc += (uint32_t)DSP_CODEC_ABS(residual);
+  if (++p_ch->acc_count >= DSP_CODEC_ADAPT_RESET)
+  {
+    p_ch->acc       >>= 1;
+    p_ch->acc_count >>= 1;
+  }
+}
+
+/**
+ * @brief         Reset the block state of a channel, the order is kept
+ *
+ * @param[in]     p_ch          Pointer to channel state
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_dsp_codec_channel_reset(dsp_codec_channel_t *p_ch)
+{
+  p_ch->prev[0]   = 0;
+  p_ch->prev[1]   = 0;
+  p_ch->acc       = DSP_CODEC_ADAPT_INIT;
+  p_ch->acc_count = 1;
+  memset(p_ch->cost, 0, sizeof(p_ch->cost));
+}
+
+/**
+ * @brief         Write bits to the block, MSB first
+ *
+ * @param[in]     p_codec       Pointer to codec
+ * @param[in]     value         Bits, right aligned
+ * @param[in]     count         Bit count, at most 24
+ *
+ * @attention     The bytes past the buffer are dropped and flag the overflow, dsp_codec_block_add()
+ *                rolls the frame back
+ *
+ * @return        None
+ */
+static void m_dsp_codec_put(dsp_codec_t *p_codec, uint32_t value, uint8_t count)
+{
+  if (count == 0)
+    return;
+
+  p_codec->bits       = (p_codec->bits << count) | value;
+  p_codec->bit_count += count;
+
+  while (p_codec->bit_count >= 8)
+  {
+    p_codec->bit_count -= 8;
+
+    if (p_codec->len >= p_codec->size)
+      p_codec->overflow = true;
+    else
+      p_codec->p_buf[p_codec->len++] = (uint8_t)(p_codec->bits >> p_codec->bit_count);
+  }
+}
+
+/**
+ * @brief         Read bits from the block, MSB first
+ *
+ * @param[in]     p_reader      Pointer to reader
+ * @param[in]     count         Bit count, at most 24
+ *
+ * @attention     Reading past the end sets the error flag and returns zeros
+ *
+ * @return        Bits, right aligned
+ */
+static uint32_t m_dsp_codec_get(dsp_codec_reader_t *p_reader, uint8_t count)
+{
+  if (count == 0)
+    return 0;
+
+  while (p_reader->bit_count < count)
+  {
+    if (p_reader->pos >= p_reader->len)
+    {
+      p_reader->error = true;
+      return 0;
+    }
+
+    p_reader->bits       = (p_reader->bits << 8) | p_reader->p_buf[p_reader->pos++];
+    p_reader->bit_count += 8;
+  }
+
+  p_reader->bit_count -= count;
+
+  return (p_reader->bits >> p_reader->bit_count) & ((1u << count) - 1);
+}
+
+/* End of file -------------------------------------------------------- */
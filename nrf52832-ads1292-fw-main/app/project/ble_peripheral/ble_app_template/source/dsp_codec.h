@@ -0,0 +1,154 @@
+/**
+ * @file       dsp_codec.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Lossless sample block codec, delta prediction and adaptive Rice coding
+ * @note       A block is {frames (u16), predictor orders (u16, 2 bits per channel), bit stream}.
+ *             Each sample is predicted from the previous ones of its channel (order 0, 1 or 2),
+ *             the zigzag-mapped residual is Rice coded with a parameter adapted to the running
+ *             residual magnitude. A quotient of DSP_CODEC_ESCAPE or more is sent as
+ *             DSP_CODEC_ESCAPE one bits followed by the raw residual, which bounds the bits
+ *             and the cycles of a sample. Blocks decode on their own, the bit stream is MSB
+ *             first. The module only needs the C library so the decoder builds on the host.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __DSP_CODEC_H
+#define __DSP_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Public defines ----------------------------------------------------- */
+#define DSP_CODEC_MAX_CHANNELS      (8)       // Orders of a block fit in 16 bits
+#define DSP_CODEC_MAX_ORDER         (2)       // Second-order delta
+#define DSP_CODEC_HEADER_SIZE       (4)       // Block header (bytes)
+#define DSP_CODEC_SAMPLE_BITS       (24)      // Samples are signed 24-bit, larger values are saturated
+#define DSP_CODEC_RAW_BITS          (DSP_CODEC_SAMPLE_BITS + 2)   // Zigzag residual of a second-order prediction
+#define DSP_CODEC_ESCAPE            (16)      // Rice quotient sent raw
+#define DSP_CODEC_MAX_K             (DSP_CODEC_SAMPLE_BITS)       // Largest Rice parameter
+#define DSP_CODEC_MAX_SAMPLE_BITS   (DSP_CODEC_ESCAPE + DSP_CODEC_RAW_BITS)   // Worst-case coded sample
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief DSP codec channel state structure
+ */
+typedef struct
+{
+  uint8_t  order;           // Predictor order of the block
+  int32_t  prev[DSP_CODEC_MAX_ORDER];   // Previous samples, newest first
+  uint32_t acc;             // Running residual magnitude (Rice parameter adaptation)
+  uint16_t acc_count;
+  uint32_t cost[DSP_CODEC_MAX_ORDER + 1];   // Residual magnitude of each order, picks the next block order
+}
+dsp_codec_channel_t;
+
+/**
+ * @brief DSP codec encoder/decoder structure
+ */
+typedef struct
+{
+  uint8_t             channels;
+  dsp_codec_channel_t ch[DSP_CODEC_MAX_CHANNELS];
+
+  uint8_t            *p_buf;        // Block buffer
+  uint16_t            size;         // Block buffer size (bytes)
+  uint16_t            len;          // Bytes written or read
+  uint32_t            bits;         // Bit accumulator
+  uint8_t             bit_count;    // Bits in the accumulator
+  uint16_t            frames;       // Frames of the block
+  bool                overflow;     // A write went past the buffer, the frame is rolled back
+}
+dsp_codec_t;
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Worst-case block size of a number of frames (bytes), the frames always fit
+ */
+#define DSP_CODEC_MAX_SIZE(_channels, _frames) \
+  (DSP_CODEC_HEADER_SIZE + (((uint32_t)(_channels) * (_frames) * DSP_CODEC_MAX_SAMPLE_BITS) + 7) / 8)
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         DSP codec init an encoder
+ *
+ * @param[out]    p_codec       Pointer to codec
+ * @param[in]     channels      Samples per frame, 1..DSP_CODEC_MAX_CHANNELS
+ *
+ * @attention     The first block is coded with the first-order prediction, each next block with
+ *                the order that fit the previous one best
+ *
+ * @return        true if the channel count is supported
+ */
+bool dsp_codec_init(dsp_codec_t *p_codec, uint8_t channels);
+
+/**
+ * @brief         DSP codec start a block
+ *
+ * @param[in]     p_codec       Pointer to codec
+ * @param[out]    p_buf         Block buffer
+ * @param[in]     size          Block buffer size, at least DSP_CODEC_HEADER_SIZE
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_codec_block_start(dsp_codec_t *p_codec, uint8_t *p_buf, uint16_t size);
+
+/**
+ * @brief         DSP codec add a frame to the block
+ *
+ * @param[in]     p_codec       Pointer to codec
+ * @param[in]     p_frame       One sample per channel
+ *
+ * @attention     The frame is coded in place, one that does not fit the rest of the buffer is
+ *                rolled back and the block is left as it was. At most UINT16_MAX frames.
+ *
+ * @return        true if the frame is added, false if the block is full
+ */
+bool dsp_codec_block_add(dsp_codec_t *p_codec, const int32_t *p_frame);
+
+/**
+ * @brief         DSP codec end the block
+ *
+ * @param[in]     p_codec       Pointer to codec
+ *
+ * @attention     The predictor orders of the next block are chosen here
+ *
+ * @return        Block length (bytes)
+ */
+uint16_t dsp_codec_block_end(dsp_codec_t *p_codec);
+
+/**
+ * @brief         DSP codec decode a block
+ *
+ * @param[in]     p_buf         Block
+ * @param[in]     len           Block length
+ * @param[in]     channels      Samples per frame
+ * @param[out]    p_frames      Interleaved frames
+ * @param[in]     max_frames    Frames that fit p_frames
+ *
+ * @attention     None
+ *
+ * @return        Frames decoded, 0 on a corrupted or too large block
+ */
+uint16_t dsp_codec_decode(const uint8_t *p_buf, uint16_t len, uint8_t channels,
+                          int32_t *p_frames, uint16_t max_frames);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __DSP_CODEC_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,211 @@
+/**
+ * @file       dsp_pipeline.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Streaming DSP pipeline with block processing
+ * @note       Per-stage cost is measured with the DWT cycle counter
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "nrf.h"
+#include "dsp_pipeline.h"
+
+/* Private defines ---------------------------------------------------- */
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+#define DSP_PIPELINE_CYCLES()       (DWT->CYCCNT)
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+/* Private function prototypes ---------------------------------------- */
+static void m_dsp_pipeline_stats_update(dsp_stage_stats_t *p_stats, uint32_t cycles);
+
+/* Function definitions ----------------------------------------------- */
+void dsp_pipeline_init(dsp_pipeline_t *p_pipeline)
+{
+  memset(p_pipeline, 0, sizeof(dsp_pipeline_t));
+
+  // Enable the cycle counter for the stage accounting
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+bool dsp_pipeline_stage_add(dsp_pipeline_t *p_pipeline, const dsp_stage_t *p_stage)
+{
+  if ((p_stage == NULL) || (p_stage->process == NULL) || (p_pipeline->stage_count >= DSP_PIPELINE_MAX_STAGES))
+    return false;
+
+  if (p_stage->init != NULL)
+    p_stage->init(p_stage->p_ctx);
+
+  memset(&p_pipeline->stats[p_pipeline->stage_count], 0, sizeof(dsp_stage_stats_t));
+  p_pipeline->p_stages[p_pipeline->stage_count++] = p_stage;
+
+  return true;
+}
+
+bool dsp_pipeline_stage_set(dsp_pipeline_t *p_pipeline, const dsp_stage_t * const *p_stages, uint8_t count)
+{
+  dsp_stage_stats_t stats[DSP_PIPELINE_MAX_STAGES];
+  uint8_t i, j;
+
+  if (count > DSP_PIPELINE_MAX_STAGES)
+    return false;
+
+  for (i = 0; i < count; i++)
+  {
+    if ((p_stages[i] == NULL) || (p_stages[i]->process == NULL))
+      return false;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    // Look the stage up in the current chain
+    for (j = 0; j < p_pipeline->stage_count; j++)
+    {
+      if (p_pipeline->p_stages[j] == p_stages[i])
+        break;
+    }
+
+    if (j < p_pipeline->stage_count)
+    {
+      memcpy(&stats[i], &p_pipeline->stats[j], sizeof(dsp_stage_stats_t));
+    }
+    else
+    {
+      if (p_stages[i]->init != NULL)
+        p_stages[i]->init(p_stages[i]->p_ctx);
+
+      memset(&stats[i], 0, sizeof(dsp_stage_stats_t));
+    }
+  }
+
+  memcpy(p_pipeline->p_stages, p_stages, count * sizeof(p_stages[0]));
+  memcpy(p_pipeline->stats, stats, count * sizeof(stats[0]));
+  p_pipeline->stage_count = count;
+
+  return true;
+}
+
+bool dsp_pipeline_sink_add(dsp_pipeline_t *p_pipeline, dsp_sink_handler_t handler, void *p_ctx)
+{
+  if ((handler == NULL) || (p_pipeline->sink_count >= DSP_PIPELINE_MAX_SINKS))
+    return false;
+
+  p_pipeline->sinks[p_pipeline->sink_count].handler = handler;
+  p_pipeline->sinks[p_pipeline->sink_count].p_ctx   = p_ctx;
+  p_pipeline->sink_count++;
+
+  return true;
+}
+
+bool dsp_pipeline_push(dsp_pipeline_t *p_pipeline, const int16_t *p_sample, uint16_t channel_mask, bool lead_off,
+                       uint32_t tick)
+{
+  dsp_block_t *p_block = &p_pipeline->block;
+
+  if (p_block->count == 0)
+  {
+    p_block->timestamp     = p_pipeline->sample_counter;
+    p_block->tick          = tick;
+    p_block->channel_mask  = channel_mask;
+    p_block->lead_off_mask = 0;
+  }
+
+  for (uint8_t ch = 0; ch < DSP_CHANNEL_MAX; ch++)
+    p_block->data[ch][p_block->count] = p_sample[ch];
+
+  if (lead_off)
+    p_block->lead_off_mask |= (1u << p_block->count);
+
+  p_block->count++;
+  p_pipeline->sample_counter++;
+
+  if (p_block->count < DSP_PIPELINE_BLOCK_SIZE)
+    return false;
+
+  dsp_pipeline_run(p_pipeline, p_block);
+  p_block->count = 0;
+
+  return true;
+}
+
+void dsp_pipeline_run(dsp_pipeline_t *p_pipeline, dsp_block_t *p_block)
+{
+  uint32_t start;
+
+  for (uint8_t i = 0; i < p_pipeline->stage_count; i++)
+  {
+    const dsp_stage_t *p_stage = p_pipeline->p_stages[i];
+
+    start = DSP_PIPELINE_CYCLES();
+    p_stage->process(p_stage->p_ctx, p_block);
+    m_dsp_pipeline_stats_update(&p_pipeline->stats[i], DSP_PIPELINE_CYCLES() - start);
+  }
+
+  start = DSP_PIPELINE_CYCLES();
+  for (uint8_t i = 0; i < p_pipeline->sink_count; i++)
+  {
+    p_pipeline->sinks[i].handler(p_block, p_pipeline->sinks[i].p_ctx);
+  }
+  m_dsp_pipeline_stats_update(&p_pipeline->sink_stats, DSP_PIPELINE_CYCLES() - start);
+}
+
+void dsp_pipeline_reset(dsp_pipeline_t *p_pipeline)
+{
+  for (uint8_t i = 0; i < p_pipeline->stage_count; i++)
+  {
+    const dsp_stage_t *p_stage = p_pipeline->p_stages[i];
+
+    if (p_stage->reset != NULL)
+      p_stage->reset(p_stage->p_ctx);
+  }
+
+  p_pipeline->block.count = 0;
+}
+
+bool dsp_pipeline_stats_get(const dsp_pipeline_t *p_pipeline, uint8_t index, dsp_stage_stats_t *p_stats)
+{
+  if (index < p_pipeline->stage_count)
+    memcpy(p_stats, &p_pipeline->stats[index], sizeof(dsp_stage_stats_t));
+  else if (index == p_pipeline->stage_count)
+    memcpy(p_stats, &p_pipeline->sink_stats, sizeof(dsp_stage_stats_t));
+  else
+    return false;
+
+  return true;
+}
+
+void dsp_pipeline_stats_clear(dsp_pipeline_t *p_pipeline)
+{
+  memset(p_pipeline->stats, 0, sizeof(p_pipeline->stats));
+  memset(&p_pipeline->sink_stats, 0, sizeof(p_pipeline->sink_stats));
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Account the cycles of one block
+ *
+ * @param[in]     p_stats       Pointer to statistics
+ * @param[in]     cycles        CPU cycles spent on the block
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_dsp_pipeline_stats_update(dsp_stage_stats_t *p_stats, uint32_t cycles)
+{
+  p_stats->blocks++;
+  p_stats->cycles_last   = cycles;
+  p_stats->cycles_total += cycles;
+
+  if (cycles > p_stats->cycles_max)
+    p_stats->cycles_max = cycles;
+}
+
+/* End of file -------------------------------------------------------- */
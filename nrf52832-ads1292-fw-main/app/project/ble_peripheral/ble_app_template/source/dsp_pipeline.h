@@ -0,0 +1,280 @@
+/**
+ * @file       dsp_pipeline.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Streaming DSP pipeline with block processing
+ * @note       Stages process whole sample blocks in place, in order, then the block is
+ *             fanned out to the sinks. All memory is static.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __DSP_PIPELINE_H
+#define __DSP_PIPELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Public defines ----------------------------------------------------- */
+#define DSP_PIPELINE_BLOCK_SIZE     (8)       // Samples per block (64 ms @ 125 SPS), at most 16
+#define DSP_PIPELINE_MAX_STAGES     (8)
+#define DSP_PIPELINE_MAX_SINKS      (6)
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief DSP block channel enum
+ */
+typedef enum
+{
+   DSP_CHANNEL_ECG                // ECG/EMG
+  ,DSP_CHANNEL_RESP               // Impedance respiration
+  ,DSP_CHANNEL_ACC_X              // Accelerometer raw, sampled with the AFE
+  ,DSP_CHANNEL_ACC_Y
+  ,DSP_CHANNEL_ACC_Z
+  ,DSP_CHANNEL_MAX
+}
+dsp_channel_t;
+
+/**
+ * @brief DSP sample block structure
+ */
+typedef struct
+{
+  uint32_t timestamp;                                       // Sample counter of the first sample
+  uint32_t tick;                                            // Timebase tick of the first sample (bsp_time)
+  uint16_t count;                                           // Valid samples per channel
+  uint16_t channel_mask;                                    // BIT(dsp_channel_t) set for channels holding data
+  uint16_t lead_off_mask;                                   // BIT(n) set if sample n was taken with a lead off
+  int16_t  data[DSP_CHANNEL_MAX][DSP_PIPELINE_BLOCK_SIZE];
+}
+dsp_block_t;
+
+/**
+ * @brief DSP stage descriptor structure
+ */
+typedef struct
+{
+  const char *name;
+  void (*init)(void *p_ctx);                                // Called when the stage is added (may be NULL)
+  void (*process)(void *p_ctx, dsp_block_t *p_block);       // Process one block in place
+  void (*reset)(void *p_ctx);                               // Drop the stage state (may be NULL)
+  void *p_ctx;                                              // Stage context, statically allocated by the stage
+}
+dsp_stage_t;
+
+/**
+ * @brief DSP sink handler type
+ */
+typedef void (*dsp_sink_handler_t)(const dsp_block_t *p_block, void *p_ctx);
+
+/**
+ * @brief DSP stage statistics structure
+ */
+typedef struct
+{
+  uint32_t blocks;                // Blocks processed
+  uint32_t cycles_last;           // CPU cycles of the last block
+  uint32_t cycles_max;            // Worst case CPU cycles per block
+  uint64_t cycles_total;          // CPU cycles since the last statistics reset
+}
+dsp_stage_stats_t;
+
+/**
+ * @brief DSP pipeline structure
+ */
+typedef struct
+{
+  const dsp_stage_t *p_stages[DSP_PIPELINE_MAX_STAGES];
+  dsp_stage_stats_t  stats[DSP_PIPELINE_MAX_STAGES];
+  uint8_t            stage_count;
+
+  struct
+  {
+    dsp_sink_handler_t handler;
+    void              *p_ctx;
+  }
+  sinks[DSP_PIPELINE_MAX_SINKS];
+  uint8_t            sink_count;
+  dsp_stage_stats_t  sink_stats;  // All sinks together
+
+  dsp_block_t        block;       // Block being filled by the acquisition
+  uint32_t           sample_counter;
+}
+dsp_pipeline_t;
+
+/* Public macros ------------------------------------------------------ */
+/**
+ * @brief  Macro for defining a pipeline instance
+ *
+ * @param[in]     _name  Name of the instance.
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+#define DSP_PIPELINE_DEF(_name)   static dsp_pipeline_t _name
+
+/**
+ * @brief  Macro for defining a stage descriptor
+ *
+ * @param[in]     _name     Name of the descriptor
+ * @param[in]     _init     Init handler (may be NULL)
+ * @param[in]     _process  Block process handler
+ * @param[in]     _reset    Reset handler (may be NULL)
+ * @param[in]     _ctx      Stage context
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+#define DSP_STAGE_DEF(_name, _init, _process, _reset, _ctx)   \
+const dsp_stage_t _name =                                     \
+{                                                             \
+  .name    = #_name,                                          \
+  .init    = (_init),                                         \
+  .process = (_process),                                      \
+  .reset   = (_reset),                                        \
+  .p_ctx   = (_ctx)                                           \
+}
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         DSP pipeline init, clears the stages and sinks and enables the cycle counter
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_pipeline_init(dsp_pipeline_t *p_pipeline);
+
+/**
+ * @brief         DSP pipeline append a stage to the chain
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ * @param[in]     p_stage       Pointer to stage descriptor
+ *
+ * @attention     None
+ *
+ * @return
+ * - true       Stage added
+ * - false      Chain is full
+ */
+bool dsp_pipeline_stage_add(dsp_pipeline_t *p_pipeline, const dsp_stage_t *p_stage);
+
+/**
+ * @brief         DSP pipeline replace the chain (sinks are kept)
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ * @param[in]     p_stages      Stage descriptors, in processing order
+ * @param[in]     count         Number of stages
+ *
+ * @attention     Used to rebuild the chain at runtime. Stages already in the chain keep their
+ *                state and statistics, only the new ones are initialized.
+ *
+ * @return
+ * - true       Chain replaced
+ * - false      Invalid stage or too many stages, the chain is not changed
+ */
+bool dsp_pipeline_stage_set(dsp_pipeline_t *p_pipeline, const dsp_stage_t * const *p_stages, uint8_t count);
+
+/**
+ * @brief         DSP pipeline register a sink
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ * @param[in]     handler       Sink handler, called with every processed block
+ * @param[in]     p_ctx         Sink context
+ *
+ * @attention     None
+ *
+ * @return
+ * - true       Sink added
+ * - false      Sink table is full
+ */
+bool dsp_pipeline_sink_add(dsp_pipeline_t *p_pipeline, dsp_sink_handler_t handler, void *p_ctx);
+
+/**
+ * @brief         DSP pipeline add one acquired sample, runs the chain when the block is full
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ * @param[in]     p_sample      One sample per channel (DSP_CHANNEL_MAX values)
+ * @param[in]     channel_mask  Channels holding data
+ * @param[in]     lead_off      Sample taken with a lead off
+ * @param[in]     tick          Timebase tick of the sample
+ *
+ * @attention     Only the tick of the first sample of a block is kept, the others follow at the
+ *                sample rate
+ *
+ * @return
+ * - true       A block was processed
+ * - false      Block not full yet
+ */
+bool dsp_pipeline_push(dsp_pipeline_t *p_pipeline, const int16_t *p_sample, uint16_t channel_mask, bool lead_off,
+                       uint32_t tick);
+
+/**
+ * @brief         DSP pipeline run the chain and the sinks on a block
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ * @param[in]     p_block       Block, processed in place
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_pipeline_run(dsp_pipeline_t *p_pipeline, dsp_block_t *p_block);
+
+/**
+ * @brief         DSP pipeline reset the state of every stage and drop the partial block
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_pipeline_reset(dsp_pipeline_t *p_pipeline);
+
+/**
+ * @brief         DSP pipeline get the cycle accounting of a stage
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ * @param[in]     index         Stage index in the chain, stage_count for the sinks
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return
+ * - true       Statistics copied
+ * - false      No such stage
+ */
+bool dsp_pipeline_stats_get(const dsp_pipeline_t *p_pipeline, uint8_t index, dsp_stage_stats_t *p_stats);
+
+/**
+ * @brief         DSP pipeline clear the cycle accounting
+ *
+ * @param[in]     p_pipeline    Pointer to pipeline
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_pipeline_stats_clear(dsp_pipeline_t *p_pipeline);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __DSP_PIPELINE_H
+
+/* End of file -------------------------------------------------------- */
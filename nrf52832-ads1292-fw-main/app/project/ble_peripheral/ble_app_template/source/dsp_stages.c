@@ -0,0 +1,270 @@
+/**
+ * @file       dsp_stages.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Stage descriptors of the biosignal DSP pipeline
+ * @note       The legacy per-sample algorithms are wrapped into block stages
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "dsp_stages.h"
+#include "dsp_anc.h"
+#include "ecg_res_algo.h"
+
+/* Private defines ---------------------------------------------------- */
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief RESP filter stage context
+ */
+typedef struct
+{
+  volatile uint8_t rate;
+}
+m_resp_ctx_t;
+
+/**
+ * @brief EMG features stage context
+ */
+typedef struct
+{
+  int16_t  raw[DSP_EMG_MA_SIZE];
+  int32_t  raw_sum;
+  uint8_t  raw_idx;
+  int16_t  smoothed[DSP_EMG_WINDOW_SIZE];
+  uint8_t  smoothed_idx;
+  dsp_emg_features_t features;
+}
+m_emg_ctx_t;
+
+/* Private macros ----------------------------------------------------- */
+#define M_LEAD_OFF(_block, _n)      (((_block)->lead_off_mask & (1u << (_n))) != 0)
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static m_resp_ctx_t m_resp_ctx;
+static m_emg_ctx_t  m_emg_ctx;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_ecg_filter_process(void *p_ctx, dsp_block_t *p_block);
+static void m_motion_cancel_init(void *p_ctx);
+static void m_motion_cancel_process(void *p_ctx, dsp_block_t *p_block);
+static void m_resp_filter_init(void *p_ctx);
+static void m_resp_filter_process(void *p_ctx, dsp_block_t *p_block);
+static void m_emg_features_init(void *p_ctx);
+static void m_emg_features_process(void *p_ctx, dsp_block_t *p_block);
+
+/* Stage descriptors -------------------------------------------------- */
+DSP_STAGE_DEF(dsp_stage_ecg_filter,    NULL,                  m_ecg_filter_process,    NULL,                  NULL);
+DSP_STAGE_DEF(dsp_stage_motion_cancel, m_motion_cancel_init,  m_motion_cancel_process, m_motion_cancel_init,  NULL);
+DSP_STAGE_DEF(dsp_stage_resp_filter,   m_resp_filter_init,    m_resp_filter_process,   m_resp_filter_init,    &m_resp_ctx);
+DSP_STAGE_DEF(dsp_stage_emg_features,  m_emg_features_init,   m_emg_features_process,  m_emg_features_init,   &m_emg_ctx);
+
+/* Function definitions ----------------------------------------------- */
+const dsp_stage_t *dsp_stages_get(uint8_t id)
+{
+  switch (id)
+  {
+  case DSP_STAGE_ECG_FILTER:
+    return &dsp_stage_ecg_filter;
+
+  case DSP_STAGE_MOTION_CANCEL:
+    return &dsp_stage_motion_cancel;
+
+  case DSP_STAGE_RESP_FILTER:
+    return &dsp_stage_resp_filter;
+
+  case DSP_STAGE_EMG_FEATURES:
+    return &dsp_stage_emg_features;
+
+  default:
+    return NULL;
+  }
+}
+
+uint8_t dsp_stages_resp_rate_get(void)
+{
+  return m_resp_ctx.rate;
+}
+
+void dsp_stages_emg_get(dsp_emg_features_t *p_features)
+{
+  memcpy(p_features, &m_emg_ctx.features, sizeof(dsp_emg_features_t));
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         ECG filter stage, filter out the line noise @40Hz cutoff 161 order
+ *
+ * @param[in]     p_ctx         Stage context (unused)
+ * @param[in]     p_block       Block processed in place
+ *
+ * @attention     Lead-off samples are not filtered and output as 0
+ *
+ * @return        None
+ */
+static void m_ecg_filter_process(void *p_ctx, dsp_block_t *p_block)
+{
+  int16_t *p_ecg = p_block->data[DSP_CHANNEL_ECG];
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    if (M_LEAD_OFF(p_block, n))
+    {
+      p_ecg[n] = 0;
+    }
+    else
+    {
+      int16_t in = p_ecg[n];
+      ECG_ProcessCurrSample(&in, &p_ecg[n]);
+    }
+  }
+}
+
+/**
+ * @brief         Motion cancel stage init
+ *
+ * @param[in]     p_ctx         Stage context (unused)
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_motion_cancel_init(void *p_ctx)
+{
+  dsp_anc_init();
+}
+
+/**
+ * @brief         Motion cancel stage, the accelerometer channels are the NLMS reference
+ *
+ * @param[in]     p_ctx         Stage context (unused)
+ * @param[in]     p_block       Block processed in place
+ *
+ * @attention     Bypassed for blocks without accelerometer data
+ *
+ * @return        None
+ */
+static void m_motion_cancel_process(void *p_ctx, dsp_block_t *p_block)
+{
+  const uint16_t acc_mask = (1u << DSP_CHANNEL_ACC_X) | (1u << DSP_CHANNEL_ACC_Y) | (1u << DSP_CHANNEL_ACC_Z);
+  int16_t *p_ecg = p_block->data[DSP_CHANNEL_ECG];
+
+  if ((p_block->channel_mask & acc_mask) != acc_mask)
+    return;
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    mpu9250_raw_data_t accel;
+
+    if (M_LEAD_OFF(p_block, n))
+      continue;
+
+    accel.x = p_block->data[DSP_CHANNEL_ACC_X][n];
+    accel.y = p_block->data[DSP_CHANNEL_ACC_Y][n];
+    accel.z = p_block->data[DSP_CHANNEL_ACC_Z][n];
+
+    p_ecg[n] = dsp_anc_process(p_ecg[n], &accel);
+  }
+}
+
+/**
+ * @brief         RESP filter stage init
+ *
+ * @param[in]     p_ctx         Stage context
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_resp_filter_init(void *p_ctx)
+{
+  m_resp_ctx_t *p_resp = (m_resp_ctx_t *)p_ctx;
+
+  p_resp->rate = 0;
+}
+
+/**
+ * @brief         RESP filter stage, filter out the respiration @2Hz cutoff 161 order and detect the rate
+ *
+ * @param[in]     p_ctx         Stage context
+ * @param[in]     p_block       Block processed in place
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_resp_filter_process(void *p_ctx, dsp_block_t *p_block)
+{
+  m_resp_ctx_t *p_resp = (m_resp_ctx_t *)p_ctx;
+  int16_t *p_resp_data = p_block->data[DSP_CHANNEL_RESP];
+
+  if ((p_block->channel_mask & (1u << DSP_CHANNEL_RESP)) == 0)
+    return;
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    if (M_LEAD_OFF(p_block, n))
+    {
+      p_resp_data[n] = 0;
+      continue;
+    }
+
+    p_resp_data[n] = Resp_ProcessCurrSample(p_resp_data[n]);
+    RESP_Algorithm_Interface(p_resp_data[n], &p_resp->rate);
+  }
+}
+
+/**
+ * @brief         EMG features stage init
+ *
+ * @param[in]     p_ctx         Stage context
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_emg_features_init(void *p_ctx)
+{
+  memset(p_ctx, 0, sizeof(m_emg_ctx_t));
+}
+
+/**
+ * @brief         EMG features stage, moving average then iEMG and MAV over the smoothed window
+ *
+ * @param[in]     p_ctx         Stage context
+ * @param[in]     p_block       Block, the ECG/EMG channel is left untouched
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_emg_features_process(void *p_ctx, dsp_block_t *p_block)
+{
+  m_emg_ctx_t *p_emg = (m_emg_ctx_t *)p_ctx;
+  const int16_t *p_data = p_block->data[DSP_CHANNEL_ECG];
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    int16_t smoothed;
+
+    // Moving average filter on the running sum
+    p_emg->raw_sum += p_data[n] - p_emg->raw[p_emg->raw_idx];
+    p_emg->raw[p_emg->raw_idx] = p_data[n];
+    p_emg->raw_idx = (p_emg->raw_idx + 1) % DSP_EMG_MA_SIZE;
+    smoothed = (int16_t)(p_emg->raw_sum / DSP_EMG_MA_SIZE);
+
+    // Integrate the smoothed window
+    p_emg->features.integrated += smoothed - p_emg->smoothed[p_emg->smoothed_idx];
+    p_emg->smoothed[p_emg->smoothed_idx] = smoothed;
+    p_emg->smoothed_idx = (p_emg->smoothed_idx + 1) % DSP_EMG_WINDOW_SIZE;
+  }
+
+  p_emg->features.mean_absolute_value = (int16_t)(p_emg->features.integrated / DSP_EMG_WINDOW_SIZE);
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,98 @@
+/**
+ * @file       dsp_stages.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Stage descriptors of the biosignal DSP pipeline
+ * @note       None
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __DSP_STAGES_H
+#define __DSP_STAGES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include "dsp_pipeline.h"
+
+/* Public defines ----------------------------------------------------- */
+#define DSP_EMG_MA_SIZE             (50)      // Moving average length of the EMG smoothing
+#define DSP_EMG_WINDOW_SIZE         (64)      // Smoothed samples integrated for the EMG features
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief DSP stage identifier enum, used to configure the chain at boot or over BLE
+ */
+typedef enum
+{
+   DSP_STAGE_ECG_FILTER     = 0x01   // 40 Hz low-pass FIR on the ECG channel
+  ,DSP_STAGE_MOTION_CANCEL  = 0x02   // Accelerometer-referenced NLMS on the ECG channel
+  ,DSP_STAGE_RESP_FILTER    = 0x03   // 2 Hz low-pass FIR and rate detection on the RESP channel
+  ,DSP_STAGE_EMG_FEATURES   = 0x04   // EMG moving average, iEMG and MAV
+}
+dsp_stage_id_t;
+
+/**
+ * @brief EMG features structure
+ */
+typedef struct
+{
+  int32_t integrated;             // iEMG, sum of the last DSP_EMG_WINDOW_SIZE smoothed samples
+  int16_t mean_absolute_value;    // MAV
+}
+dsp_emg_features_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+extern const dsp_stage_t dsp_stage_ecg_filter;
+extern const dsp_stage_t dsp_stage_motion_cancel;
+extern const dsp_stage_t dsp_stage_resp_filter;
+extern const dsp_stage_t dsp_stage_emg_features;
+
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         DSP stages get a stage descriptor by identifier
+ *
+ * @param[in]     id            Stage identifier
+ *
+ * @attention     None
+ *
+ * @return        Pointer to stage descriptor, NULL if unknown
+ */
+const dsp_stage_t *dsp_stages_get(uint8_t id);
+
+/**
+ * @brief         DSP stages get the respiration rate of the RESP filter stage
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Respiration rate (breaths/min)
+ */
+uint8_t dsp_stages_resp_rate_get(void);
+
+/**
+ * @brief         DSP stages get the EMG features
+ *
+ * @param[out]    p_features    Pointer to features
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void dsp_stages_emg_get(dsp_emg_features_t *p_features);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __DSP_STAGES_H
+
+/* End of file -------------------------------------------------------- */
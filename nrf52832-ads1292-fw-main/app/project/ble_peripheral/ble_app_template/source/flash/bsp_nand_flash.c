@@ -11,10 +11,37 @@
  */
 
 /* Includes ----------------------------------------------------------- */
+#include <string.h>
 #include "bsp_nand_flash.h"
 
 /* Private defines ---------------------------------------------------- */
+#define NAND_PAGES_PER_BLOCK        (FLASH_BLOCK64_SIZE / FLASH_PAGE_SIZE)
+#define NAND_LOG_FIRST_PAGE         (BSP_NAND_FLASH_LOG_FIRST_BLOCK * NAND_PAGES_PER_BLOCK)
+#define NAND_LOG_PAGES              (BSP_NAND_FLASH_LOG_BLOCKS * NAND_PAGES_PER_BLOCK)
+#define NAND_LOG_HEADER_SIZE        (4)       // Page sequence number
+#define NAND_LOG_SEQ_ERASED         (0xFFFFFFFF)
+#define NAND_LOG_END_OF_PAGE        (0xFF)
+#define NAND_PAGE_NONE              (0xFFFFFFFF)
+
+#define NAND_SPI_BUDGET             (256)     // SPI bytes per main loop pass, 2 ms at 1 MHz
+#define NAND_CMD_SIZE               (4)       // Command bytes of a data buffer read or load
+#define NAND_PAGE_READ_POLLS        (20)      // tRD is 60 us, a status read takes 24 us at 1 MHz
+#define NAND_PROGRAM_TIMEOUT_MS     (2)
+#define NAND_ERASE_TIMEOUT_MS       (12)
+
 /* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Page programming state enum
+ */
+typedef enum
+{
+   NAND_LOG_STATE_IDLE = 0x00   // No page being programmed
+  ,NAND_LOG_STATE_ERASE         // Block erase running
+  ,NAND_LOG_STATE_LOAD          // Page loaded into the data buffer, NAND_SPI_BUDGET bytes per pass
+  ,NAND_LOG_STATE_PROGRAM       // Program execute running
+}
+bsp_nand_flash_state_t;
+
 /* Private macros ----------------------------------------------------- */
 /* Public variables --------------------------------------------------- */
 /* Private variables -------------------------------------------------- */
@@ -23,12 +50,40 @@ static w25n01_t m_w25n01;
 static uint8_t write_buf[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0};
 static uint8_t read_buf[10] = {0};
 
+static uint8_t  m_log_page[2][FLASH_PAGE_SIZE];
+static uint8_t  m_log_fill;       // Buffer collecting the records, the other one is being programmed
+static uint16_t m_log_len;        // Bytes used in the fill buffer
+static uint32_t m_log_page_addr;  // Page the fill buffer is programmed to
+static uint32_t m_log_seq;        // Sequence number of the fill buffer
+static bool     m_log_ready;
+static bool     m_log_flush;      // Flush requested while the previous page was being programmed
+
+static bsp_nand_flash_state_t m_prog_state;
+static uint32_t m_prog_page_addr; // Page being programmed
+static uint32_t m_prog_seq;       // Its sequence number
+static uint16_t m_prog_len;       // Bytes to load, the data buffer is reset to 0xFF
+static uint16_t m_prog_offset;    // Bytes loaded
+
+static uint32_t m_read_page_addr; // Page held by the data buffer, NAND_PAGE_NONE after a load
+static uint32_t m_read_seq;       // Its sequence number
+static uint16_t m_spi_budget;     // SPI bytes left until the next bsp_nand_flash_process()
+
 /* Private function prototypes ---------------------------------------- */
+static base_status_t m_bsp_nand_flash_log_recover(void);
+static base_status_t m_bsp_nand_flash_log_seal(void);
+static base_status_t m_bsp_nand_flash_log_step(void);
+static base_status_t m_bsp_nand_flash_log_drain(void);
+static base_status_t m_bsp_nand_flash_page_load(uint32_t page_addr);
+static base_status_t m_bsp_nand_flash_data_read(uint16_t offset, uint8_t *p_data, uint8_t len);
+static void m_bsp_nand_flash_log_page_start(void);
+static void m_bsp_nand_flash_budget_spend(uint16_t len);
+
 /* Function definitions ----------------------------------------------- */
 base_status_t bsp_nand_flash_init(void)
 {
   m_w25n01.spi_transfer = bsp_spi_2_transmit_receive;
   m_w25n01.gpio_write   = bsp_gpio_write;
+  m_w25n01.delay        = bsp_delay_ms;
 
   CHECK_STATUS(w25n01_init(&m_w25n01));
   bsp_delay_ms(10);
@@ -48,8 +103,457 @@ base_status_t bsp_nand_flash_init(void)
   CHECK_STATUS(w25n01_read_data(&m_w25n01, 0, read_buf, 10));
   bsp_delay_ms(10);
 
+  CHECK_STATUS(m_bsp_nand_flash_log_recover());
+
+  return BS_OK;
+}
+
+base_status_t bsp_nand_flash_process(void)
+{
+  base_status_t ret = BS_OK;
+
+  m_spi_budget = NAND_SPI_BUDGET;
+
+  if (!m_log_ready)
+    return BS_OK;
+
+  if (m_prog_state != NAND_LOG_STATE_IDLE)
+  {
+    ret = m_bsp_nand_flash_log_step();
+
+    // The page is lost, the readers find its sequence number missing
+    if (ret != BS_OK)
+      m_prog_state = NAND_LOG_STATE_IDLE;
+  }
+
+  if ((m_prog_state == NAND_LOG_STATE_IDLE) && m_log_flush)
+    ret = bsp_nand_flash_log_flush();
+
+  return ret;
+}
+
+base_status_t bsp_nand_flash_log_append(const uint8_t *p_data, uint8_t len)
+{
+  CHECK((len > 0) && (len <= BSP_NAND_FLASH_LOG_RECORD_MAX), BS_ERROR_PARAMS);
+  CHECK(m_log_ready, BS_ERROR);
+
+  if (m_log_len + 1 + len > FLASH_PAGE_SIZE)
+  {
+    // Both buffers are in use, the record is dropped
+    CHECK(m_prog_state == NAND_LOG_STATE_IDLE, BS_ERROR);
+    CHECK_STATUS(m_bsp_nand_flash_log_seal());
+  }
+
+  m_log_page[m_log_fill][m_log_len++] = len;
+  memcpy(&m_log_page[m_log_fill][m_log_len], p_data, len);
+  m_log_len += len;
+
+  return BS_OK;
+}
+
+base_status_t bsp_nand_flash_log_flush(void)
+{
+  CHECK(m_log_ready, BS_ERROR);
+
+  m_log_flush = false;
+
+  if (m_log_len <= NAND_LOG_HEADER_SIZE)
+    return BS_OK;
+
+  // Sealed by bsp_nand_flash_process() once the previous page is programmed
+  if (m_prog_state != NAND_LOG_STATE_IDLE)
+  {
+    m_log_flush = true;
+    return BS_OK;
+  }
+
+  return m_bsp_nand_flash_log_seal();
+}
+
+base_status_t bsp_nand_flash_log_sync(void)
+{
+  CHECK(m_log_ready, BS_ERROR);
+
+  CHECK_STATUS(m_bsp_nand_flash_log_drain());
+  CHECK_STATUS(bsp_nand_flash_log_flush());
+  CHECK_STATUS(m_bsp_nand_flash_log_drain());
+
+  return BS_OK;
+}
+
+bool bsp_nand_flash_log_busy(void)
+{
+  return (m_prog_state != NAND_LOG_STATE_IDLE) || (m_spi_budget == 0);
+}
+
+void bsp_nand_flash_log_cursor_get(bsp_nand_flash_cursor_t *p_cursor)
+{
+  p_cursor->page_addr = m_log_page_addr;
+  p_cursor->seq       = m_log_seq;
+  p_cursor->offset    = m_log_len;
+}
+
+base_status_t bsp_nand_flash_log_read(bsp_nand_flash_cursor_t *p_cursor, uint8_t *p_data, uint8_t *p_len)
+{
+  const uint8_t *p_page;
+  uint8_t len;
+
+  CHECK(m_log_ready, BS_ERROR);
+  CHECK(p_cursor->seq <= m_log_seq, BS_ERROR);
+
+  *p_len = 0;
+
+  for (;;)
+  {
+    // Page being filled
+    if (p_cursor->seq == m_log_seq)
+    {
+      if (p_cursor->offset >= m_log_len)
+        return BS_OK;
+
+      p_page = m_log_page[m_log_fill];
+      len    = p_page[p_cursor->offset];
+      memcpy(p_data, &p_page[p_cursor->offset + 1], len);
+      break;
+    }
+
+    // Page being programmed, still in its buffer
+    if ((m_prog_state != NAND_LOG_STATE_IDLE) && (p_cursor->seq == m_prog_seq))
+    {
+      p_page = m_log_page[m_log_fill ^ 1];
+      len    = (p_cursor->offset < FLASH_PAGE_SIZE) ? p_page[p_cursor->offset] : NAND_LOG_END_OF_PAGE;
+
+      if (len != NAND_LOG_END_OF_PAGE)
+      {
+        memcpy(p_data, &p_page[p_cursor->offset + 1], len);
+        break;
+      }
+    }
+    else
+    {
+      // The data buffer is shared with the programming
+      CHECK(m_prog_state == NAND_LOG_STATE_IDLE, BS_ERROR);
+      CHECK_STATUS(m_bsp_nand_flash_page_load(p_cursor->page_addr));
+      CHECK(m_read_seq == p_cursor->seq, BS_ERROR);
+
+      len = NAND_LOG_END_OF_PAGE;
+      if (p_cursor->offset < FLASH_PAGE_SIZE)
+        CHECK_STATUS(m_bsp_nand_flash_data_read(p_cursor->offset, &len, 1));
+
+      if (len != NAND_LOG_END_OF_PAGE)
+      {
+        CHECK_STATUS(m_bsp_nand_flash_data_read(p_cursor->offset + 1, p_data, len));
+        break;
+      }
+    }
+
+    // Next page of the ring
+    p_cursor->page_addr++;
+    if (p_cursor->page_addr >= NAND_LOG_FIRST_PAGE + NAND_LOG_PAGES)
+      p_cursor->page_addr = NAND_LOG_FIRST_PAGE;
+    p_cursor->seq++;
+    p_cursor->offset = NAND_LOG_HEADER_SIZE;
+  }
+
+  p_cursor->offset += 1 + len;
+  *p_len = len;
+
   return BS_OK;
 }
 
 /* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Find the end of the record log
+ *
+ * @param[in]     None
+ *
+ * @attention     The block holding the highest page sequence number is the newest one, its
+ *                first erased page is the next one to program
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_bsp_nand_flash_log_recover(void)
+{
+  uint32_t seq;
+  uint32_t newest_seq  = 0;
+  uint32_t newest_page = 0;
+  bool     found       = false;
+
+  // The data buffer holds the self-test page
+  m_read_page_addr = NAND_PAGE_NONE;
+
+  for (uint32_t page = NAND_LOG_FIRST_PAGE; page < NAND_LOG_FIRST_PAGE + NAND_LOG_PAGES; page += NAND_PAGES_PER_BLOCK)
+  {
+    CHECK_STATUS(m_bsp_nand_flash_page_load(page));
+    seq = m_read_seq;
+
+    if ((seq != NAND_LOG_SEQ_ERASED) && (!found || (seq > newest_seq)))
+    {
+      newest_seq  = seq;
+      newest_page = page;
+      found       = true;
+    }
+  }
+
+  if (!found)
+  {
+    m_log_page_addr = NAND_LOG_FIRST_PAGE;
+    m_log_seq       = 0;
+  }
+  else
+  {
+    // Last programmed page of the newest block
+    for (uint32_t page = newest_page + 1; page % NAND_PAGES_PER_BLOCK; page++)
+    {
+      CHECK_STATUS(m_bsp_nand_flash_page_load(page));
+      seq = m_read_seq;
+      if (seq == NAND_LOG_SEQ_ERASED)
+        break;
+
+      newest_seq  = seq;
+      newest_page = page;
+    }
+
+    m_log_page_addr = newest_page + 1;
+    if (m_log_page_addr >= NAND_LOG_FIRST_PAGE + NAND_LOG_PAGES)
+      m_log_page_addr = NAND_LOG_FIRST_PAGE;
+    m_log_seq = newest_seq + 1;
+  }
+
+  m_bsp_nand_flash_log_page_start();
+  m_spi_budget = NAND_SPI_BUDGET;
+  m_log_ready  = true;
+
+  return BS_OK;
+}
+
+/**
+ * @brief         Seal the fill buffer, its page is programmed by bsp_nand_flash_process()
+ *
+ * @param[in]     None
+ *
+ * @attention     No page may be being programmed. Entering a block, its erase is started and the
+ *                oldest records of the ring are dropped.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_bsp_nand_flash_log_seal(void)
+{
+  bsp_nand_flash_state_t state = NAND_LOG_STATE_LOAD;
+
+  if ((m_log_page_addr % NAND_PAGES_PER_BLOCK) == 0)
+  {
+    CHECK_STATUS(w25n01_block_erase(&m_w25n01, m_log_page_addr));
+    state = NAND_LOG_STATE_ERASE;
+  }
+
+  m_prog_state     = state;
+  m_prog_page_addr = m_log_page_addr;
+  m_prog_seq       = m_log_seq;
+  m_prog_len       = m_log_len;
+  m_prog_offset    = 0;
+  m_read_page_addr = NAND_PAGE_NONE;
+  m_log_flush      = false;
+
+  // The records go on in the other buffer
+  m_log_fill ^= 1;
+  m_log_page_addr++;
+  if (m_log_page_addr >= NAND_LOG_FIRST_PAGE + NAND_LOG_PAGES)
+    m_log_page_addr = NAND_LOG_FIRST_PAGE;
+
+  m_log_seq++;
+  m_bsp_nand_flash_log_page_start();
+
+  return BS_OK;
+}
+
+/**
+ * @brief         Move the page programming one step on, without waiting
+ *
+ * @param[in]     None
+ *
+ * @attention     The load takes the SPI budget of the pass
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           The SPI transfer failed, or the erase or program failed
+ */
+static base_status_t m_bsp_nand_flash_log_step(void)
+{
+  uint8_t *p_page = m_log_page[m_log_fill ^ 1];
+  uint16_t len;
+  bool     ready;
+
+  switch (m_prog_state)
+  {
+  case NAND_LOG_STATE_ERASE:
+    CHECK_STATUS(w25n01_poll_ready(&m_w25n01, &ready));
+    if (ready)
+      m_prog_state = NAND_LOG_STATE_LOAD;
+    break;
+
+  case NAND_LOG_STATE_LOAD:
+    // The first piece resets the data buffer to 0xFF, the rest of the page is not sent
+    len = MIN(NAND_SPI_BUDGET, m_prog_len - m_prog_offset);
+    if (m_prog_offset == 0)
+      CHECK_STATUS(w25n01_load_program_data(&m_w25n01, 0, p_page, len));
+    else
+      CHECK_STATUS(w25n01_load_random_program_data(&m_w25n01, m_prog_offset, &p_page[m_prog_offset], len));
+
+    m_prog_offset += len;
+    m_bsp_nand_flash_budget_spend(NAND_CMD_SIZE + len);
+
+    if (m_prog_offset >= m_prog_len)
+    {
+      CHECK_STATUS(w25n01_program_execute(&m_w25n01, m_prog_page_addr));
+      m_prog_state = NAND_LOG_STATE_PROGRAM;
+    }
+    break;
+
+  case NAND_LOG_STATE_PROGRAM:
+    CHECK_STATUS(w25n01_poll_ready(&m_w25n01, &ready));
+    if (ready)
+      m_prog_state = NAND_LOG_STATE_IDLE;
+    break;
+
+  default:
+    break;
+  }
+
+  return BS_OK;
+}
+
+/**
+ * @brief         Program the page being programmed to the end, waiting for the erase and program
+ *
+ * @param[in]     None
+ *
+ * @attention     Blocking, up to NAND_ERASE_TIMEOUT_MS + NAND_PROGRAM_TIMEOUT_MS
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           The page is lost
+ */
+static base_status_t m_bsp_nand_flash_log_drain(void)
+{
+  uint32_t timeout_ms = NAND_ERASE_TIMEOUT_MS + NAND_PROGRAM_TIMEOUT_MS;
+  bsp_nand_flash_state_t state;
+
+  while (m_prog_state != NAND_LOG_STATE_IDLE)
+  {
+    state = m_prog_state;
+
+    if (m_bsp_nand_flash_log_step() != BS_OK)
+    {
+      m_prog_state = NAND_LOG_STATE_IDLE;
+      return BS_ERROR;
+    }
+
+    // Erase or program still running
+    if ((m_prog_state == state) && (state != NAND_LOG_STATE_LOAD))
+    {
+      if (timeout_ms-- == 0)
+      {
+        m_prog_state = NAND_LOG_STATE_IDLE;
+        return BS_ERROR;
+      }
+
+      bsp_delay_ms(1);
+    }
+  }
+
+  return BS_OK;
+}
+
+/**
+ * @brief         Transfer a log page to the data buffer and read its sequence number
+ *
+ * @param[in]     page_addr     Page
+ *
+ * @attention     Nothing is transferred if the data buffer already holds the page, its sequence
+ *                number is left in m_read_seq, NAND_LOG_SEQ_ERASED for an erased page
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_bsp_nand_flash_page_load(uint32_t page_addr)
+{
+  uint8_t header[NAND_LOG_HEADER_SIZE];
+  bool    ready = false;
+
+  if (page_addr == m_read_page_addr)
+    return BS_OK;
+
+  m_read_page_addr = NAND_PAGE_NONE;
+
+  CHECK_STATUS(w25n01_page_data_read(&m_w25n01, page_addr));
+  for (uint8_t i = 0; !ready; i++)
+  {
+    CHECK(i < NAND_PAGE_READ_POLLS, BS_ERROR);
+    CHECK_STATUS(w25n01_poll_ready(&m_w25n01, &ready));
+  }
+
+  CHECK_STATUS(m_bsp_nand_flash_data_read(0, header, sizeof(header)));
+
+  m_read_seq       = uint32_decode(header);
+  m_read_page_addr = page_addr;
+
+  return BS_OK;
+}
+
+/**
+ * @brief         Read from the page in the data buffer
+ *
+ * @param[in]     offset        Offset in the page
+ * @param[out]    p_data        Data
+ * @param[in]     len           Length
+ *
+ * @attention     The bytes are taken from the SPI budget of the pass
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_bsp_nand_flash_data_read(uint16_t offset, uint8_t *p_data, uint8_t len)
+{
+  m_bsp_nand_flash_budget_spend(NAND_CMD_SIZE + len);
+
+  return w25n01_read_data(&m_w25n01, offset, p_data, len);
+}
+
+/**
+ * @brief         Start a new page in the buffer
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_nand_flash_log_page_start(void)
+{
+  memset(m_log_page[m_log_fill], NAND_LOG_END_OF_PAGE, FLASH_PAGE_SIZE);
+
+  m_log_len = uint32_encode(m_log_seq, m_log_page[m_log_fill]);
+}
+
+/**
+ * @brief         Take bytes from the SPI budget of the pass
+ *
+ * @param[in]     len           SPI bytes
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_bsp_nand_flash_budget_spend(uint16_t len)
+{
+  m_spi_budget = (len < m_spi_budget) ? (m_spi_budget - len) : 0;
+}
+
 /* End of file -------------------------------------------------------- */
@@ -22,7 +22,33 @@ extern "C" {
 #include "w25n01.h"
 
 /* Public defines ----------------------------------------------------- */
+#define BSP_NAND_FLASH_LOG_FIRST_BLOCK  (1)       // Block 0 is kept for the boot self-test
+#define BSP_NAND_FLASH_LOG_BLOCKS       (64)      // Record log size in 128 KB blocks, used as a ring
+#define BSP_NAND_FLASH_LOG_RECORD_MAX   (254)     // Largest record (bytes)
+
 /* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Log record type enum, first byte of every record
+ */
+typedef enum
+{
+   BSP_NAND_FLASH_RECORD_ACTIVITY = 0x01   // Encoded imu_activity record
+  ,BSP_NAND_FLASH_RECORD_WAVE     = 0x02   // Compressed ECG block of wave_record
+  ,BSP_NAND_FLASH_RECORD_SPOOL    = 0x03   // Waveform packet of wave_spool
+}
+bsp_nand_flash_record_t;
+
+/**
+ * @brief Log read position structure
+ */
+typedef struct
+{
+  uint32_t page_addr;       // Page of the next record
+  uint32_t seq;             // Sequence number the page must hold, it is overwritten otherwise
+  uint16_t offset;          // Length byte of the next record in the page
+}
+bsp_nand_flash_cursor_t;
+
 /* Public macros ------------------------------------------------------ */
 /* Public variables --------------------------------------------------- */
 /* Public function prototypes ----------------------------------------- */
@@ -39,6 +65,104 @@ extern "C" {
  */
 base_status_t bsp_nand_flash_init(void);
 
+/**
+ * @brief         BSP Nand Flash move the page programming on, once per main loop pass
+ *
+ * @param[in]     None
+ *
+ * @attention     Never waits: the erase and program are polled, the page is loaded a piece per
+ *                pass. Also renews the SPI budget of the log reads.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           The page being programmed is lost
+ */
+base_status_t bsp_nand_flash_process(void);
+
+/**
+ * @brief         BSP Nand Flash append a record to the log
+ *
+ * @param[in]     p_data        Record
+ * @param[in]     len           Record length, 1..BSP_NAND_FLASH_LOG_RECORD_MAX
+ *
+ * @attention     Records are collected in a page buffer, the page is handed to
+ *                bsp_nand_flash_process() once the next record does not fit and the records go on
+ *                in a second buffer. Each page starts with a 32-bit page sequence number followed
+ *                by the records, each prefixed with its length byte; 0xFF ends the page.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ * - BS_ERROR           The previous page is still being programmed, the record is dropped
+ */
+base_status_t bsp_nand_flash_log_append(const uint8_t *p_data, uint8_t len);
+
+/**
+ * @brief         BSP Nand Flash program the buffered records
+ *
+ * @param[in]     None
+ *
+ * @attention     The rest of the page stays unused, the next record starts a new page. Does not
+ *                wait, the page is programmed by bsp_nand_flash_process().
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_nand_flash_log_flush(void);
+
+/**
+ * @brief         BSP Nand Flash program the buffered records and wait for the end
+ *
+ * @param[in]     None
+ *
+ * @attention     Blocking, up to an erase and a program (14 ms). Before the power goes off.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t bsp_nand_flash_log_sync(void);
+
+/**
+ * @brief         BSP Nand Flash check whether the log can be read from the flash
+ *
+ * @param[in]     None
+ *
+ * @attention     Busy while a page is being programmed, or once the reads of the main loop pass
+ *                used up its SPI budget
+ *
+ * @return        true if busy
+ */
+bool bsp_nand_flash_log_busy(void);
+
+/**
+ * @brief         BSP Nand Flash get the position of the next appended record
+ *
+ * @param[out]    p_cursor      Pointer to cursor
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void bsp_nand_flash_log_cursor_get(bsp_nand_flash_cursor_t *p_cursor);
+
+/**
+ * @brief         BSP Nand Flash read the record at a cursor and move the cursor to the next one
+ *
+ * @param[in,out] p_cursor      Pointer to cursor
+ * @param[out]    p_data        Record, BSP_NAND_FLASH_LOG_RECORD_MAX bytes
+ * @param[out]    p_len         Record length, 0 at the end of the log
+ *
+ * @attention     The records not programmed yet are read from the page buffers. Not while
+ *                bsp_nand_flash_log_busy(), the flash pages cannot be read then.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           The page was overwritten by the ring, or the read failed
+ */
+base_status_t bsp_nand_flash_log_read(bsp_nand_flash_cursor_t *p_cursor, uint8_t *p_data, uint8_t *p_len);
+
 /* -------------------------------------------------------------------------- */
 #ifdef __cplusplus
 } // extern "C"
@@ -44,6 +44,10 @@
 #define W25N01GV_MAX_PAGE             (65535)
 #define W25N_MAX_COLUMN               (2112)
 
+#define W25N_STAT_BUSY                (0x01)
+#define W25N_STAT_E_FAIL              (0x04)
+#define W25N_STAT_P_FAIL              (0x08)
+
 /* Private enumerate/structure ---------------------------------------- */
 /* Private macros ----------------------------------------------------- */
 /* Public variables --------------------------------------------------- */
@@ -53,6 +57,7 @@ static base_status_t m_w25n01_transfer(w25n01_t *me, uint8_t *tx_data, uint8_t *
 static base_status_t m_w25n01_set_status_register(w25n01_t *me, uint8_t reg, uint8_t value);
 static base_status_t m_w25n01_get_status_register(w25n01_t *me, uint8_t reg, uint8_t *value);
 static base_status_t m_w25n01_write_enable(w25n01_t *me, bool enable);
+static base_status_t m_w25n01_load(w25n01_t *me, uint8_t op, uint16_t column_addr, uint8_t *p_data, uint32_t len);
 
 /* Function definitions ----------------------------------------------- */
 base_status_t w25n01_init(w25n01_t *me)
@@ -93,22 +98,12 @@ base_status_t w25n01_block_erase(w25n01_t *me, uint32_t page_addr)
 
 base_status_t w25n01_load_program_data(w25n01_t *me, uint16_t column_addr, uint8_t *p_data, uint32_t len)
 {
-  ASSERT(column_addr <= W25N_MAX_COLUMN);
-  ASSERT(len <= W25N_MAX_COLUMN - column_addr);
-
-  uint8_t column_high = (column_addr & 0xFF00) >> 8;
-  uint8_t column_low  = column_addr & 0xFF;
-  uint8_t cmd_buf[3]  = { W25N_OP_PROG_DATA_LOAD, column_high, column_low };
-
-  CHECK_STATUS(m_w25n01_write_enable(me, true));
-
-  // Write data
-  me->gpio_write(IO_FLASH_CS, 0);
-  CHECK_STATUS(me->spi_transfer(cmd_buf, NULL, sizeof(cmd_buf)));
-  CHECK_STATUS(me->spi_transfer(p_data, NULL, len));
-  me->gpio_write(IO_FLASH_CS, 1);
+  return m_w25n01_load(me, W25N_OP_PROG_DATA_LOAD, column_addr, p_data, len);
+}
 
-  return BS_OK;
+base_status_t w25n01_load_random_program_data(w25n01_t *me, uint16_t column_addr, uint8_t *p_data, uint32_t len)
+{
+  return m_w25n01_load(me, W25N_OP_RAND_PROG_DATA_LOAD, column_addr, p_data, len);
 }
 
 base_status_t w25n01_program_execute(w25n01_t *me, uint32_t page_addr)
@@ -156,6 +151,43 @@ base_status_t w25n01_read_data(w25n01_t *me, uint16_t column_addr, uint8_t *p_da
   return BS_OK;
 }
 
+base_status_t w25n01_wait_ready(w25n01_t *me, uint32_t timeout_ms)
+{
+  uint8_t status;
+
+  ASSERT(me->delay != NULL);
+
+  for (;;)
+  {
+    CHECK_STATUS(m_w25n01_get_status_register(me, W25N_REG_STAT, &status));
+
+    if (!(status & W25N_STAT_BUSY))
+      break;
+
+    if (timeout_ms-- == 0)
+      return BS_ERROR;
+
+    me->delay(1);
+  }
+
+  CHECK(!(status & (W25N_STAT_E_FAIL | W25N_STAT_P_FAIL)), BS_ERROR);
+
+  return BS_OK;
+}
+
+base_status_t w25n01_poll_ready(w25n01_t *me, bool *p_ready)
+{
+  uint8_t status;
+
+  CHECK_STATUS(m_w25n01_get_status_register(me, W25N_REG_STAT, &status));
+
+  *p_ready = !(status & W25N_STAT_BUSY);
+  if (*p_ready)
+    CHECK(!(status & (W25N_STAT_E_FAIL | W25N_STAT_P_FAIL)), BS_ERROR);
+
+  return BS_OK;
+}
+
 /* Private function definitions ---------------------------------------- */
 static base_status_t m_w25n01_transfer(w25n01_t *me, uint8_t *tx_data, uint8_t *rx_data, uint16_t len)
 {
@@ -197,4 +229,24 @@ static base_status_t m_w25n01_write_enable(w25n01_t *me, bool enable)
   return m_w25n01_transfer(me, &value, NULL, 1);
 }
 
+static base_status_t m_w25n01_load(w25n01_t *me, uint8_t op, uint16_t column_addr, uint8_t *p_data, uint32_t len)
+{
+  ASSERT(column_addr <= W25N_MAX_COLUMN);
+  ASSERT(len <= W25N_MAX_COLUMN - column_addr);
+
+  uint8_t column_high = (column_addr & 0xFF00) >> 8;
+  uint8_t column_low  = column_addr & 0xFF;
+  uint8_t cmd_buf[3]  = { op, column_high, column_low };
+
+  CHECK_STATUS(m_w25n01_write_enable(me, true));
+
+  // Write data
+  me->gpio_write(IO_FLASH_CS, 0);
+  CHECK_STATUS(me->spi_transfer(cmd_buf, NULL, sizeof(cmd_buf)));
+  CHECK_STATUS(me->spi_transfer(p_data, NULL, len));
+  me->gpio_write(IO_FLASH_CS, 1);
+
+  return BS_OK;
+}
+
 /* End of file -------------------------------------------------------- */
@@ -40,6 +40,7 @@ typedef struct
 {
   void (*gpio_write)(uint8_t pin , uint8_t state);
   base_status_t  (*spi_transfer)(uint8_t *tx_data, uint8_t *rx_data, uint16_t len);
+  void (*delay)(uint32_t ms);
 }
 w25n01_t;
 
@@ -65,6 +66,13 @@ base_status_t w25n01_block_erase(w25n01_t *me, uint32_t page_addr);
  */
 base_status_t w25n01_load_program_data(w25n01_t *me, uint16_t column_addr, uint8_t *p_data, uint32_t len);
 
+/**
+ * @brief W25N01 random load program data
+ * Same as the Load Program Data instruction except that the Data Buffer is not reset to FFh, a page can be
+ * loaded in several pieces before the Program Execute.
+ */
+base_status_t w25n01_load_random_program_data(w25n01_t *me, uint16_t column_addr, uint8_t *p_data, uint32_t len);
+
 /**
  * @brief W25N01 program execute
  * The Program Execute instruction is the second step of the Program operation. After the program data are
@@ -87,6 +95,20 @@ base_status_t w25n01_page_data_read(w25n01_t *me, uint32_t page_addr);
  */
 base_status_t w25n01_read_data(w25n01_t *me, uint16_t column_addr, uint8_t *p_data, uint32_t len);
 
+/**
+ * @brief W25N01 wait ready
+ * Polls the BUSY bit after a Program Execute, Block Erase or Page Data Read. The erase and program
+ * failure bits of the last operation are checked as well.
+ */
+base_status_t w25n01_wait_ready(w25n01_t *me, uint32_t timeout_ms);
+
+/**
+ * @brief W25N01 poll ready
+ * Reads the BUSY bit once, for callers that cannot wait. Once ready, the erase and program failure bits
+ * of the last operation are checked as well.
+ */
+base_status_t w25n01_poll_ready(w25n01_t *me, bool *p_ready);
+
 /* -------------------------------------------------------------------------- */
 #ifdef __cplusplus
 } // extern "C"
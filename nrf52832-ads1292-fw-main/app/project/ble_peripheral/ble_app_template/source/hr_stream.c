@@ -0,0 +1,161 @@
+/**
+ * @file       hr_stream.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Heart rate and RR interval packetizer for the standard Heart Rate Service
+ * @note       The heart rate is the mean of the last HR_STREAM_AVG_BEATS RR intervals, as the QRS
+ *             detector averages its own, but it follows every beat instead of every fourth.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "hr_stream.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+#define HR_STREAM_FLAG_CONTACT_DETECTED   (1u << 1)
+#define HR_STREAM_FLAG_CONTACT_SUPPORTED  (1u << 2)
+#define HR_STREAM_FLAG_RR_PRESENT         (1u << 4)
+
+#define HR_STREAM_RR_UNITS                (1024)    // RR interval units per second
+#define HR_STREAM_MAX_HEART_RATE          (250)     // Clamped like the QRS detector (bpm)
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static hr_stream_stats_t m_stats;
+static uint16_t          m_sampling_rate;
+static bool              m_contact_supported;
+static bool              m_contact;
+static uint8_t           m_heart_rate;
+static bool              m_pending;            // Beat not sent yet
+
+// RR intervals not sent yet (1/1024 s), oldest first
+static uint16_t          m_rr[HR_STREAM_MAX_RR];
+static uint8_t           m_rr_count;
+
+// Last RR intervals for the heart rate average (1/1024 s)
+static uint16_t          m_avg[HR_STREAM_AVG_BEATS];
+static uint8_t           m_avg_head;
+static uint8_t           m_avg_count;
+
+/* Private function prototypes ---------------------------------------- */
+/* Function definitions ----------------------------------------------- */
+base_status_t hr_stream_init(uint16_t sampling_rate, bool contact_supported)
+{
+  CHECK(sampling_rate != 0, BS_ERROR_PARAMS);
+
+  m_sampling_rate     = sampling_rate;
+  m_contact_supported = contact_supported;
+  m_contact           = true;
+  m_heart_rate        = 0;
+  m_pending           = false;
+  m_rr_count          = 0;
+  m_avg_head          = 0;
+  m_avg_count         = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+
+  return BS_OK;
+}
+
+void hr_stream_add_beat(const QRS_Beat_t *beat)
+{
+  uint32_t rr;
+  uint32_t sum = 0;
+
+  if (beat->rr_interval == 0)
+    return;
+
+  rr = ((uint32_t)beat->rr_interval * HR_STREAM_RR_UNITS) / m_sampling_rate;
+  rr = MIN(rr, UINT16_MAX);
+
+  // A full buffer loses its oldest interval, the newest ones describe the current rhythm
+  if (m_rr_count == HR_STREAM_MAX_RR)
+  {
+    memmove(&m_rr[0], &m_rr[1], (HR_STREAM_MAX_RR - 1) * sizeof(m_rr[0]));
+    m_rr_count--;
+    m_stats.dropped++;
+  }
+  m_rr[m_rr_count++] = (uint16_t)rr;
+
+  m_avg[m_avg_head] = (uint16_t)rr;
+  m_avg_head        = (m_avg_head + 1) % HR_STREAM_AVG_BEATS;
+  if (m_avg_count < HR_STREAM_AVG_BEATS)
+    m_avg_count++;
+
+  for (uint8_t i = 0; i < m_avg_count; i++)
+    sum += m_avg[i];
+
+  // 60 s over the mean interval, rounded
+  m_heart_rate = (uint8_t)MIN((60u * HR_STREAM_RR_UNITS * m_avg_count + sum / 2) / sum, HR_STREAM_MAX_HEART_RATE);
+  m_pending    = true;
+  m_stats.beats++;
+}
+
+void hr_stream_contact_set(bool detected)
+{
+  if (detected == m_contact)
+    return;
+
+  m_contact = detected;
+
+  // The intervals across a lost contact are not beats of the same rhythm
+  if (!detected)
+  {
+    m_avg_head  = 0;
+    m_avg_count = 0;
+    m_rr_count  = 0;
+  }
+
+  // Reported even without a new beat
+  m_pending = true;
+}
+
+uint16_t hr_stream_packet_build(uint8_t *p_buf, uint16_t max_len)
+{
+  uint8_t  flags = 0;
+  uint8_t  count;
+  uint16_t len   = 0;
+
+  if (!m_pending || (max_len < HR_STREAM_HEADER_SIZE))
+    return 0;
+
+  count = (uint8_t)MIN(m_rr_count, (max_len - HR_STREAM_HEADER_SIZE) / HR_STREAM_RR_SIZE);
+
+  if (m_contact_supported)
+    flags |= HR_STREAM_FLAG_CONTACT_SUPPORTED | (m_contact ? HR_STREAM_FLAG_CONTACT_DETECTED : 0);
+
+  if (count != 0)
+    flags |= HR_STREAM_FLAG_RR_PRESENT;
+
+  p_buf[len++] = flags;
+  p_buf[len++] = m_heart_rate;
+
+  for (uint8_t i = 0; i < count; i++)
+    len += uint16_encode(m_rr[i], &p_buf[len]);
+
+  // The intervals that did not fit go with the next packet
+  m_rr_count -= count;
+  memmove(&m_rr[0], &m_rr[count], m_rr_count * sizeof(m_rr[0]));
+  m_pending = (m_rr_count != 0);
+  m_stats.packets++;
+
+  return len;
+}
+
+uint8_t hr_stream_heart_rate_get(void)
+{
+  return m_heart_rate;
+}
+
+void hr_stream_stats_get(hr_stream_stats_t *p_stats)
+{
+  *p_stats = m_stats;
+}
+
+/* End of file -------------------------------------------------------- */
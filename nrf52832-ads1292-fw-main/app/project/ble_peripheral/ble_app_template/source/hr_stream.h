@@ -0,0 +1,129 @@
+/**
+ * @file       hr_stream.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Heart rate and RR interval packetizer for the standard Heart Rate Service
+ * @note       A packet is a Heart Rate Measurement value (Bluetooth HRS 1.0):
+ *             {flags (u8), heart rate in bpm (u8), RR intervals in 1/1024 s (u16) ...}
+ *             Flags bit 1 is the sensor contact status, bit 2 the sensor contact support and
+ *             bit 4 the RR interval presence. One packet is built per beat, the RR intervals of
+ *             the beats not sent yet are buffered and go with the next packet.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __HR_STREAM_H
+#define __HR_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+#include "ecg_res_algo.h"
+
+/* Public defines ----------------------------------------------------- */
+#define HR_STREAM_HEADER_SIZE       (2)       // Flags and 8-bit heart rate (bytes)
+#define HR_STREAM_RR_SIZE           (2)       // RR interval (bytes)
+#define HR_STREAM_MAX_RR            (9)       // RR intervals buffered, one 23-byte ATT MTU packet
+#define HR_STREAM_AVG_BEATS         (4)       // RR intervals averaged into the heart rate
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief HR stream statistics structure
+ */
+typedef struct
+{
+  uint32_t beats;           // Beats with an RR interval
+  uint32_t dropped;         // Oldest RR intervals overwritten by a full buffer
+  uint32_t packets;         // Packets built
+}
+hr_stream_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         HR stream init
+ *
+ * @param[in]     sampling_rate     QRS detector sampling rate (Hz)
+ * @param[in]     contact_supported Sensor contact is reported by hr_stream_contact_set()
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ */
+base_status_t hr_stream_init(uint16_t sampling_rate, bool contact_supported);
+
+/**
+ * @brief         HR stream add one beat from the QRS detector
+ *
+ * @param[in]     beat          Beat reported by the QRS detector
+ *
+ * @attention     Matches QRS_Beat_Callback_t, the first beat after a detector reset has no RR
+ *                interval and is skipped
+ *
+ * @return        None
+ */
+void hr_stream_add_beat(const QRS_Beat_t *beat);
+
+/**
+ * @brief         HR stream set the sensor contact status
+ *
+ * @param[in]     detected      Electrodes on the skin
+ *
+ * @attention     A lost contact restarts the heart rate average
+ *
+ * @return        None
+ */
+void hr_stream_contact_set(bool detected);
+
+/**
+ * @brief         HR stream build the measurement of the beats not sent yet
+ *
+ * @param[out]    p_buf         Output buffer
+ * @param[in]     max_len       Packet size, the usable ATT payload
+ *
+ * @attention     The RR intervals that do not fit max_len stay buffered for the next packet
+ *
+ * @return        Packet length, 0 if there is no new beat
+ */
+uint16_t hr_stream_packet_build(uint8_t *p_buf, uint16_t max_len);
+
+/**
+ * @brief         HR stream get the heart rate
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Heart rate (bpm), 0 until a beat with an RR interval
+ */
+uint8_t hr_stream_heart_rate_get(void);
+
+/**
+ * @brief         HR stream get the statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void hr_stream_stats_get(hr_stream_stats_t *p_stats);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __HR_STREAM_H
+
+/* End of file -------------------------------------------------------- */
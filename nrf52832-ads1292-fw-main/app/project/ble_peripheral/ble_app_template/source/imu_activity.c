@@ -0,0 +1,384 @@
+/**
+ * @file       imu_activity.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Activity classification, step counting and fall detection on the IMU frames
+ * @note       Steps are peaks of the low-passed magnitude above its gravity baseline. A fall is
+ *             an impact followed, once settled, by a tilt of the gravity vector of more than 60
+ *             degrees. The window class comes from a decision tree on the magnitude deviation
+ *             and the cadence.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "imu_activity.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+#define ACT_LP_SHIFT                (3)       // Step band low-pass, about 4 Hz at 200 Hz
+#define ACT_BASE_SHIFT              (8)       // Magnitude baseline, about 1.3 s at 200 Hz
+#define ACT_GRAVITY_SHIFT           (6)       // Gravity vector low-pass, about 0.3 s at 200 Hz
+
+#define ACT_STEP_THRESHOLD_MG       (100)     // Low-passed magnitude above the baseline for a step
+#define ACT_STEP_MIN_MS             (250)     // Shortest step interval (240 spm)
+#define ACT_STEP_MAX_MS             (2000)    // Longer intervals do not count for the cadence
+
+#define ACT_REST_SD_MG              (25)      // Below: rest
+#define ACT_RUN_SD_MG               (450)     // Above with steps: run
+#define ACT_RUN_CADENCE             (145)     // Above: run (spm)
+
+#define ACT_FALL_IMPACT_MG          (2500)    // Magnitude of the impact
+#define ACT_FALL_SETTLE_MS          (1500)    // Impact to orientation check
+#define ACT_FALL_COS_Q8             (128)     // cos(60 deg) in Q8, a smaller cosine is a fall
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+#define ACT_MS_TO_SAMPLES(ms)       ((uint32_t)(ms) * m_sample_rate / 1000)
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static uint16_t m_sample_rate;
+static int32_t  m_accel_range;
+static uint32_t m_window_len;
+static uint32_t m_sample;               // Samples since init
+
+// Filters, scaled by their shift
+static int32_t  m_lp;
+static int32_t  m_base;
+static int32_t  m_gravity[3];
+static bool     m_primed;
+
+// Steps
+static bool     m_step_armed;
+static uint32_t m_step_last;            // Sample of the last step
+static uint32_t m_total_steps;
+
+// Fall
+static int32_t  m_gravity_ref[3];       // Gravity vector at the end of the previous window (mg)
+static int32_t  m_fall_pre[3];
+static bool     m_fall_settling;
+static uint32_t m_fall_check;           // Sample of the orientation check
+static bool     m_fall_detected;
+
+// Window accumulators
+static uint32_t m_win_count;
+static uint32_t m_win_sum;
+static uint64_t m_win_sum_sq;
+static uint16_t m_win_peak;
+static uint8_t  m_win_steps;
+static uint32_t m_win_interval_sum;
+static uint8_t  m_win_intervals;
+
+static imu_activity_record_t         m_record;
+static imu_activity_record_handler_t m_record_handler = NULL;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_imu_activity_step_update(void);
+static void m_imu_activity_fall_update(int32_t magnitude);
+static void m_imu_activity_window_close(uint32_t seq, uint32_t tick);
+static imu_activity_class_t m_imu_activity_classify(uint16_t sd_mg, uint8_t steps, uint8_t cadence);
+static uint32_t m_imu_activity_isqrt(uint32_t value);
+
+/* Function definitions ----------------------------------------------- */
+bool imu_activity_init(const imu_activity_config_t *p_config)
+{
+  if ((p_config->sample_rate < 50) || (p_config->sample_rate > 1000) || (p_config->accel_range <= 0))
+    return false;
+
+  m_sample_rate = p_config->sample_rate;
+  m_accel_range = p_config->accel_range;
+  m_window_len  = (uint32_t)IMU_ACTIVITY_WINDOW_S * m_sample_rate;
+
+  m_sample         = 0;
+  m_primed         = false;
+  m_step_armed     = false;
+  m_step_last      = 0;
+  m_total_steps    = 0;
+  m_fall_settling  = false;
+  m_fall_detected  = false;
+
+  m_win_count        = 0;
+  m_win_sum          = 0;
+  m_win_sum_sq       = 0;
+  m_win_peak         = 0;
+  m_win_steps        = 0;
+  m_win_interval_sum = 0;
+  m_win_intervals    = 0;
+
+  memset(&m_record, 0, sizeof(m_record));
+
+  return true;
+}
+
+void imu_activity_register_record_handler(imu_activity_record_handler_t handler)
+{
+  m_record_handler = handler;
+}
+
+void imu_activity_update(const mpu9250_fifo_frame_t *p_frame, uint32_t seq, uint32_t tick)
+{
+  int32_t  accel[3];
+  uint32_t magnitude;
+
+  accel[0] = MPU9250_RAW_TO_UNIT(p_frame->accel.x, m_accel_range);
+  accel[1] = MPU9250_RAW_TO_UNIT(p_frame->accel.y, m_accel_range);
+  accel[2] = MPU9250_RAW_TO_UNIT(p_frame->accel.z, m_accel_range);
+
+  magnitude = m_imu_activity_isqrt((uint32_t)(accel[0] * accel[0]) + (uint32_t)(accel[1] * accel[1]) +
+                                   (uint32_t)(accel[2] * accel[2]));
+
+  // Filters start from the first sample instead of ramping up from zero
+  if (!m_primed)
+  {
+    m_lp   = (int32_t)magnitude << ACT_LP_SHIFT;
+    m_base = (int32_t)magnitude << ACT_BASE_SHIFT;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      m_gravity[i]     = accel[i] << ACT_GRAVITY_SHIFT;
+      m_gravity_ref[i] = accel[i];
+    }
+
+    m_primed = true;
+  }
+
+  m_lp   += (int32_t)magnitude - (m_lp >> ACT_LP_SHIFT);
+  m_base += (int32_t)magnitude - (m_base >> ACT_BASE_SHIFT);
+
+  for (uint8_t i = 0; i < 3; i++)
+    m_gravity[i] += accel[i] - (m_gravity[i] >> ACT_GRAVITY_SHIFT);
+
+  m_imu_activity_step_update();
+  m_imu_activity_fall_update((int32_t)magnitude);
+
+  // Window statistics
+  m_win_sum    += magnitude;
+  m_win_sum_sq += (uint64_t)magnitude * magnitude;
+  if (magnitude > m_win_peak)
+    m_win_peak = (uint16_t)MIN(magnitude, UINT16_MAX);
+
+  m_sample++;
+
+  if (++m_win_count >= m_window_len)
+    m_imu_activity_window_close(seq, tick);
+}
+
+void imu_activity_get(imu_activity_record_t *p_record)
+{
+  memcpy(p_record, &m_record, sizeof(imu_activity_record_t));
+}
+
+uint8_t imu_activity_record_encode(const imu_activity_record_t *p_record, uint8_t *p_buf)
+{
+  uint8_t len = 0;
+
+  len += uint32_encode(p_record->seq, &p_buf[len]);
+  p_buf[len++] = (uint8_t)p_record->activity;
+  p_buf[len++] = p_record->steps;
+  p_buf[len++] = p_record->cadence;
+  len += uint16_encode(p_record->mean_mg, &p_buf[len]);
+  len += uint16_encode(p_record->sd_mg, &p_buf[len]);
+  len += uint16_encode(p_record->peak_mg, &p_buf[len]);
+  len += uint32_encode(p_record->total_steps, &p_buf[len]);
+  len += uint32_encode(p_record->tick, &p_buf[len]);
+
+  return len;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Step detection on the low-passed magnitude
+ *
+ * @param[in]     None
+ *
+ * @attention     A step is counted when the signal rises above the threshold, the detector is
+ *                re-armed once it fell back under the baseline
+ *
+ * @return        None
+ */
+static void m_imu_activity_step_update(void)
+{
+  int32_t  dynamic  = (m_lp >> ACT_LP_SHIFT) - (m_base >> ACT_BASE_SHIFT);
+  uint32_t interval = m_sample - m_step_last;
+
+  if (!m_step_armed)
+  {
+    if (dynamic < 0)
+      m_step_armed = true;
+    return;
+  }
+
+  if ((dynamic < ACT_STEP_THRESHOLD_MG) || (interval < ACT_MS_TO_SAMPLES(ACT_STEP_MIN_MS)))
+    return;
+
+  // Intervals across a pause are not part of the cadence
+  if ((m_total_steps > 0) && (interval <= ACT_MS_TO_SAMPLES(ACT_STEP_MAX_MS)))
+  {
+    m_win_interval_sum += interval;
+    m_win_intervals++;
+  }
+
+  m_step_armed = false;
+  m_step_last  = m_sample;
+  m_total_steps++;
+  if (m_win_steps < UINT8_MAX)
+    m_win_steps++;
+}
+
+/**
+ * @brief         Fall detection, impact then orientation change
+ *
+ * @param[in]     magnitude     Accelerometer magnitude (mg)
+ *
+ * @attention     The orientation before the impact is the gravity vector of the previous window
+ *                end, the one after is taken ACT_FALL_SETTLE_MS later
+ *
+ * @return        None
+ */
+static void m_imu_activity_fall_update(int32_t magnitude)
+{
+  int32_t post[3];
+  int64_t dot;
+  int64_t norm;
+
+  if (!m_fall_settling)
+  {
+    if (magnitude < ACT_FALL_IMPACT_MG)
+      return;
+
+    memcpy(m_fall_pre, m_gravity_ref, sizeof(m_fall_pre));
+    m_fall_check    = m_sample + ACT_MS_TO_SAMPLES(ACT_FALL_SETTLE_MS);
+    m_fall_settling = true;
+    return;
+  }
+
+  if ((int32_t)(m_sample - m_fall_check) < 0)
+    return;
+
+  m_fall_settling = false;
+
+  for (uint8_t i = 0; i < 3; i++)
+    post[i] = m_gravity[i] >> ACT_GRAVITY_SHIFT;
+
+  dot  = (int64_t)m_fall_pre[0] * post[0] + (int64_t)m_fall_pre[1] * post[1] + (int64_t)m_fall_pre[2] * post[2];
+  norm = (int64_t)m_imu_activity_isqrt((uint32_t)(m_fall_pre[0] * m_fall_pre[0] + m_fall_pre[1] * m_fall_pre[1] +
+                                                  m_fall_pre[2] * m_fall_pre[2])) *
+         m_imu_activity_isqrt((uint32_t)(post[0] * post[0] + post[1] * post[1] + post[2] * post[2]));
+
+  // cos(tilt) = dot / (|pre| * |post|)
+  if (dot * 256 < norm * ACT_FALL_COS_Q8)
+    m_fall_detected = true;
+}
+
+/**
+ * @brief         Close the window, classify it and deliver the record
+ *
+ * @param[in]     seq           Frame counter of the last frame
+ * @param[in]     tick          Timebase tick of the last frame
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_imu_activity_window_close(uint32_t seq, uint32_t tick)
+{
+  uint32_t mean     = m_win_sum / m_win_count;
+  uint64_t mean_sq  = m_win_sum_sq / m_win_count;
+  uint64_t variance = (mean_sq > (uint64_t)mean * mean) ? mean_sq - (uint64_t)mean * mean : 0;
+  uint32_t cadence  = 0;
+
+  if (m_win_intervals > 0)
+    cadence = (60UL * m_sample_rate * m_win_intervals) / m_win_interval_sum;
+
+  m_record.seq         = seq;
+  m_record.tick        = tick;
+  m_record.steps       = m_win_steps;
+  m_record.cadence     = (uint8_t)MIN(cadence, UINT8_MAX);
+  m_record.mean_mg     = (uint16_t)MIN(mean, UINT16_MAX);
+  m_record.sd_mg       = (uint16_t)MIN(m_imu_activity_isqrt((uint32_t)MIN(variance, UINT32_MAX)), UINT16_MAX);
+  m_record.peak_mg     = m_win_peak;
+  m_record.total_steps = m_total_steps;
+  m_record.activity    = m_fall_detected ? IMU_ACTIVITY_FALL :
+                         m_imu_activity_classify(m_record.sd_mg, m_record.steps, m_record.cadence);
+
+  m_fall_detected = false;
+
+  for (uint8_t i = 0; i < 3; i++)
+    m_gravity_ref[i] = m_gravity[i] >> ACT_GRAVITY_SHIFT;
+
+  m_win_count        = 0;
+  m_win_sum          = 0;
+  m_win_sum_sq       = 0;
+  m_win_peak         = 0;
+  m_win_steps        = 0;
+  m_win_interval_sum = 0;
+  m_win_intervals    = 0;
+
+  if (m_record_handler != NULL)
+    m_record_handler(&m_record);
+}
+
+/**
+ * @brief         Decision tree of the window class
+ *
+ * @param[in]     sd_mg         Standard deviation of the magnitude
+ * @param[in]     steps         Steps in the window
+ * @param[in]     cadence       Cadence (spm)
+ *
+ * @attention     None
+ *
+ * @return        Activity class
+ */
+static imu_activity_class_t m_imu_activity_classify(uint16_t sd_mg, uint8_t steps, uint8_t cadence)
+{
+  if (sd_mg < ACT_REST_SD_MG)
+    return IMU_ACTIVITY_REST;
+
+  if ((steps < 2) && (cadence == 0))
+    return IMU_ACTIVITY_MOVE;
+
+  if ((cadence >= ACT_RUN_CADENCE) || (sd_mg >= ACT_RUN_SD_MG))
+    return IMU_ACTIVITY_RUN;
+
+  return IMU_ACTIVITY_WALK;
+}
+
+/**
+ * @brief         Integer square root
+ *
+ * @param[in]     value         Value
+ *
+ * @attention     None
+ *
+ * @return        floor(sqrt(value))
+ */
+static uint32_t m_imu_activity_isqrt(uint32_t value)
+{
+  uint32_t root = 0;
+  uint32_t bit  = 1UL << 30;
+
+  while (bit > value)
+    bit >>= 2;
+
+  while (bit != 0)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root   = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return root;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,145 @@
+/**
+ * @file       imu_activity.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Activity classification, step counting and fall detection on the IMU frames
+ * @note       Fixed point on the accelerometer magnitude, one record per window
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __IMU_ACTIVITY_H
+#define __IMU_ACTIVITY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu9250.h"
+
+/* Public defines ----------------------------------------------------- */
+#define IMU_ACTIVITY_WINDOW_S           (2)       // Window length (s)
+#define IMU_ACTIVITY_RECORD_ENCODED_SIZE (21)     // Size of an encoded record (bytes)
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief IMU activity class enum
+ */
+typedef enum
+{
+   IMU_ACTIVITY_REST = 0x00   // Lying, sitting or standing still
+  ,IMU_ACTIVITY_MOVE = 0x01   // Movement without steps
+  ,IMU_ACTIVITY_WALK = 0x02
+  ,IMU_ACTIVITY_RUN  = 0x03
+  ,IMU_ACTIVITY_FALL = 0x04   // Impact followed by an orientation change, overrides the others
+}
+imu_activity_class_t;
+
+/**
+ * @brief IMU activity configuration structure
+ */
+typedef struct
+{
+  uint16_t sample_rate;       // Frame rate (Hz), 50..1000
+  int32_t  accel_range;       // Accelerometer full-scale range (mg)
+}
+imu_activity_config_t;
+
+/**
+ * @brief IMU activity window record structure
+ */
+typedef struct
+{
+  uint32_t             seq;           // Frame counter of the last frame of the window
+  imu_activity_class_t activity;
+  uint8_t              steps;         // Steps in the window
+  uint8_t              cadence;       // Steps per minute, 0 without a step interval in the window
+  uint16_t             mean_mg;       // Mean accelerometer magnitude
+  uint16_t             sd_mg;         // Standard deviation of the magnitude
+  uint16_t             peak_mg;       // Largest magnitude
+  uint32_t             total_steps;   // Steps since init
+  uint32_t             tick;          // Timebase tick of the last frame of the window (bsp_time)
+}
+imu_activity_record_t;
+
+/**
+ * @brief IMU activity record handler type
+ */
+typedef void (*imu_activity_record_handler_t)(const imu_activity_record_t *p_record);
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         IMU activity init, the step count restarts from zero
+ *
+ * @param[in]     p_config      Pointer to configuration
+ *
+ * @attention     None
+ *
+ * @return
+ * - true       Configuration applied
+ * - false      Invalid configuration
+ */
+bool imu_activity_init(const imu_activity_config_t *p_config);
+
+/**
+ * @brief         IMU activity register the record handler
+ *
+ * @param[in]     handler       Called at the end of each window
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void imu_activity_register_record_handler(imu_activity_record_handler_t handler);
+
+/**
+ * @brief         IMU activity process one frame
+ *
+ * @param[in]     p_frame       Accel/gyro/mag frame, raw
+ * @param[in]     seq           Frame counter
+ * @param[in]     tick          Timebase tick of the frame
+ *
+ * @attention     Only the accelerometer is used
+ *
+ * @return        None
+ */
+void imu_activity_update(const mpu9250_fifo_frame_t *p_frame, uint32_t seq, uint32_t tick);
+
+/**
+ * @brief         IMU activity get the newest record
+ *
+ * @param[out]    p_record      Pointer to record
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void imu_activity_get(imu_activity_record_t *p_record);
+
+/**
+ * @brief         IMU activity encode a record (little endian)
+ *
+ * @param[in]     p_record      Pointer to record
+ * @param[out]    p_buf         Buffer of at least IMU_ACTIVITY_RECORD_ENCODED_SIZE bytes
+ *
+ * @attention     None
+ *
+ * @return        Encoded length
+ */
+uint8_t imu_activity_record_encode(const imu_activity_record_t *p_record, uint8_t *p_buf);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __IMU_ACTIVITY_H
+
+/* End of file -------------------------------------------------------- */
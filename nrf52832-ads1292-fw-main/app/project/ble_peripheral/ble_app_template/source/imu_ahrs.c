@@ -0,0 +1,346 @@
+/**
+ * @file       imu_ahrs.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Orientation filter (Madgwick) on the IMU frames
+ * @note       All arithmetic is float with f-suffixed constants and the f math functions,
+ *             so nothing is promoted to double and the Cortex-M4 FPU runs the filter
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include <math.h>
+#include "imu_ahrs.h"
+
+/* Private defines ---------------------------------------------------- */
+#define IMU_AHRS_DEG_TO_RAD         (0.0174532925f)
+#define IMU_AHRS_RAD_TO_CDEG        (5729.57795f)    // Radians to 0.01 deg
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static float m_q[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+static float m_dt;
+static float m_beta;
+static float m_gyro_scale;                           // rad/s per LSB
+static bool  m_seeded;                               // Orientation taken from the first frame
+
+static uint16_t m_sample_rate;
+static uint16_t m_decimation;
+static uint16_t m_decimation_count;
+
+static imu_ahrs_output_t         m_output;
+static imu_ahrs_output_handler_t m_output_handler = NULL;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_imu_ahrs_imu_gradient(const float *p_q, float ax, float ay, float az, float *p_s);
+static void m_imu_ahrs_marg_gradient(const float *p_q, float ax, float ay, float az,
+                                     float mx, float my, float mz, float *p_s);
+static void m_imu_ahrs_seed(const mpu9250_fifo_frame_t *p_frame);
+static void m_imu_ahrs_output_update(uint32_t seq);
+static int16_t m_imu_ahrs_to_q14(float value);
+
+/* Function definitions ----------------------------------------------- */
+bool imu_ahrs_init(const imu_ahrs_config_t *p_config)
+{
+  if ((p_config->sample_rate == 0) || (p_config->gyro_scale <= 0.0f))
+    return false;
+
+  m_sample_rate = p_config->sample_rate;
+  m_dt          = 1.0f / (float)p_config->sample_rate;
+  m_beta        = p_config->beta;
+  m_gyro_scale  = p_config->gyro_scale * IMU_AHRS_DEG_TO_RAD;
+
+  m_q[0] = 1.0f;
+  m_q[1] = 0.0f;
+  m_q[2] = 0.0f;
+  m_q[3] = 0.0f;
+  m_seeded = false;
+
+  memset(&m_output, 0, sizeof(m_output));
+  m_output.q[0] = IMU_AHRS_Q14_ONE;
+
+  return imu_ahrs_set_output_rate(p_config->output_rate);
+}
+
+bool imu_ahrs_set_output_rate(uint16_t output_rate)
+{
+  if ((output_rate == 0) || (output_rate > m_sample_rate))
+    return false;
+
+  m_decimation       = (m_sample_rate + output_rate / 2) / output_rate;
+  m_decimation_count = 0;
+
+  return true;
+}
+
+void imu_ahrs_register_output_handler(imu_ahrs_output_handler_t handler)
+{
+  m_output_handler = handler;
+}
+
+void imu_ahrs_update(const mpu9250_fifo_frame_t *p_frame, uint32_t seq)
+{
+  float q0, q1, q2, q3;
+  float gx, gy, gz;
+  float ax, ay, az;
+  float mx, my, mz;
+  float q_dot[4];
+  float s[4];
+  float norm;
+
+  // Start from the measured attitude instead of converging from identity
+  if (!m_seeded && ((p_frame->accel.x != 0) || (p_frame->accel.y != 0) || (p_frame->accel.z != 0)))
+  {
+    m_imu_ahrs_seed(p_frame);
+    m_seeded = true;
+  }
+
+  q0 = m_q[0];
+  q1 = m_q[1];
+  q2 = m_q[2];
+  q3 = m_q[3];
+
+  gx = (float)p_frame->gyro.x * m_gyro_scale;
+  gy = (float)p_frame->gyro.y * m_gyro_scale;
+  gz = (float)p_frame->gyro.z * m_gyro_scale;
+
+  // Quaternion rate from the gyroscope
+  q_dot[0] = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  q_dot[1] = 0.5f * ( q0 * gx + q2 * gz - q3 * gy);
+  q_dot[2] = 0.5f * ( q0 * gy - q1 * gz + q3 * gx);
+  q_dot[3] = 0.5f * ( q0 * gz + q1 * gy - q2 * gx);
+
+  // Gradient descent correction, skipped in free fall (accel all zero)
+  if ((p_frame->accel.x != 0) || (p_frame->accel.y != 0) || (p_frame->accel.z != 0))
+  {
+    ax = (float)p_frame->accel.x;
+    ay = (float)p_frame->accel.y;
+    az = (float)p_frame->accel.z;
+
+    norm = 1.0f / sqrtf(ax * ax + ay * ay + az * az);
+    ax *= norm;
+    ay *= norm;
+    az *= norm;
+
+    if ((p_frame->mag.x != 0) || (p_frame->mag.y != 0) || (p_frame->mag.z != 0))
+    {
+      // AK8963 axes: X and Y swapped, Z inverted against the accel/gyro axes
+      mx = (float)p_frame->mag.y;
+      my = (float)p_frame->mag.x;
+      mz = -(float)p_frame->mag.z;
+
+      norm = 1.0f / sqrtf(mx * mx + my * my + mz * mz);
+      m_imu_ahrs_marg_gradient(m_q, ax, ay, az, mx * norm, my * norm, mz * norm, s);
+    }
+    else
+    {
+      m_imu_ahrs_imu_gradient(m_q, ax, ay, az, s);
+    }
+
+    norm = s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3];
+    if (norm > 0.0f)
+    {
+      norm = 1.0f / sqrtf(norm);
+
+      for (uint8_t i = 0; i < 4; i++)
+        q_dot[i] -= m_beta * s[i] * norm;
+    }
+  }
+
+  // Integrate and normalise
+  for (uint8_t i = 0; i < 4; i++)
+    m_q[i] += q_dot[i] * m_dt;
+
+  norm = 1.0f / sqrtf(m_q[0] * m_q[0] + m_q[1] * m_q[1] + m_q[2] * m_q[2] + m_q[3] * m_q[3]);
+  for (uint8_t i = 0; i < 4; i++)
+    m_q[i] *= norm;
+
+  if (++m_decimation_count >= m_decimation)
+  {
+    m_decimation_count = 0;
+    m_imu_ahrs_output_update(seq);
+  }
+}
+
+void imu_ahrs_get(imu_ahrs_output_t *p_output)
+{
+  memcpy(p_output, &m_output, sizeof(imu_ahrs_output_t));
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Set the orientation from one frame
+ *
+ * @param[in]     p_frame       Accel/gyro/mag frame, raw
+ *
+ * @attention     Roll and pitch come from the gravity, the yaw from the tilt-compensated
+ *                magnetometer (0 without magnetometer), in the frame of the gradient functions
+ *
+ * @return        None
+ */
+static void m_imu_ahrs_seed(const mpu9250_fifo_frame_t *p_frame)
+{
+  float ax = (float)p_frame->accel.x;
+  float ay = (float)p_frame->accel.y;
+  float az = (float)p_frame->accel.z;
+  float roll  = atan2f(ay, az);
+  float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+  float yaw   = 0.0f;
+  float cr, sr, cp, sp, cy, sy;
+
+  if ((p_frame->mag.x != 0) || (p_frame->mag.y != 0) || (p_frame->mag.z != 0))
+  {
+    // Same axis mapping as the update
+    float mx = (float)p_frame->mag.y;
+    float my = (float)p_frame->mag.x;
+    float mz = -(float)p_frame->mag.z;
+    float hx = mx * cosf(pitch) + (my * sinf(roll) + mz * cosf(roll)) * sinf(pitch);
+    float hy = my * cosf(roll) - mz * sinf(roll);
+
+    yaw = atan2f(-hy, hx);
+  }
+
+  cr = cosf(0.5f * roll);
+  sr = sinf(0.5f * roll);
+  cp = cosf(0.5f * pitch);
+  sp = sinf(0.5f * pitch);
+  cy = cosf(0.5f * yaw);
+  sy = sinf(0.5f * yaw);
+
+  m_q[0] = cr * cp * cy + sr * sp * sy;
+  m_q[1] = sr * cp * cy - cr * sp * sy;
+  m_q[2] = cr * sp * cy + sr * cp * sy;
+  m_q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+/**
+ * @brief         Objective function gradient, gravity only
+ *
+ * @param[in]     p_q           Quaternion
+ * @param[in]     ax, ay, az    Normalised accelerometer
+ * @param[out]    p_s           Gradient (not normalised)
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_imu_ahrs_imu_gradient(const float *p_q, float ax, float ay, float az, float *p_s)
+{
+  float q0 = p_q[0], q1 = p_q[1], q2 = p_q[2], q3 = p_q[3];
+  float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+  float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+  float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+  float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+  p_s[0] = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+  p_s[1] = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+  p_s[2] = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+  p_s[3] = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+}
+
+/**
+ * @brief         Objective function gradient, gravity and earth magnetic field
+ *
+ * @param[in]     p_q           Quaternion
+ * @param[in]     ax, ay, az    Normalised accelerometer
+ * @param[in]     mx, my, mz    Normalised magnetometer, in the accel/gyro frame
+ * @param[out]    p_s           Gradient (not normalised)
+ *
+ * @attention     The reference field is re-estimated from the current orientation,
+ *                so magnetic inclination is handled
+ *
+ * @return        None
+ */
+static void m_imu_ahrs_marg_gradient(const float *p_q, float ax, float ay, float az,
+                                     float mx, float my, float mz, float *p_s)
+{
+  float q0 = p_q[0], q1 = p_q[1], q2 = p_q[2], q3 = p_q[3];
+  float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+  float _2q0q2 = 2.0f * q0 * q2, _2q2q3 = 2.0f * q2 * q3;
+  float q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+  float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+  float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+  float _2q0mx = 2.0f * q0 * mx, _2q0my = 2.0f * q0 * my, _2q0mz = 2.0f * q0 * mz, _2q1mx = 2.0f * q1 * mx;
+  float hx, hy, _2bx, _2bz, _4bx, _4bz;
+  float ex, ey, ez;
+
+  // Earth field in the horizontal (bx) and vertical (bz) components
+  hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+  hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+  _2bx = sqrtf(hx * hx + hy * hy);
+  _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+  _4bx = 2.0f * _2bx;
+  _4bz = 2.0f * _2bz;
+
+  // Field errors, shared by the four gradient terms
+  ex = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+  ey = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+  ez = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+  p_s[0] = -_2q2 * (2.0f * q1q3 - _2q0q2 - ax) + _2q1 * (2.0f * q0q1 + _2q2q3 - ay)
+           - _2bz * q2 * ex + (-_2bx * q3 + _2bz * q1) * ey + _2bx * q2 * ez;
+  p_s[1] = _2q3 * (2.0f * q1q3 - _2q0q2 - ax) + _2q0 * (2.0f * q0q1 + _2q2q3 - ay)
+           - 4.0f * q1 * (1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az)
+           + _2bz * q3 * ex + (_2bx * q2 + _2bz * q0) * ey + (_2bx * q3 - _4bz * q1) * ez;
+  p_s[2] = -_2q0 * (2.0f * q1q3 - _2q0q2 - ax) + _2q3 * (2.0f * q0q1 + _2q2q3 - ay)
+           - 4.0f * q2 * (1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az)
+           + (-_4bx * q2 - _2bz * q0) * ex + (_2bx * q1 + _2bz * q3) * ey + (_2bx * q0 - _4bz * q2) * ez;
+  p_s[3] = _2q1 * (2.0f * q1q3 - _2q0q2 - ax) + _2q2 * (2.0f * q0q1 + _2q2q3 - ay)
+           + (-_4bx * q3 + _2bz * q1) * ex + (-_2bx * q0 + _2bz * q2) * ey + _2bx * q1 * ez;
+}
+
+/**
+ * @brief         Update the output from the current quaternion and notify
+ *
+ * @param[in]     seq           Frame counter
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_imu_ahrs_output_update(uint32_t seq)
+{
+  float q0 = m_q[0], q1 = m_q[1], q2 = m_q[2], q3 = m_q[3];
+  float sin_pitch;
+
+  m_output.seq = seq;
+
+  for (uint8_t i = 0; i < 4; i++)
+    m_output.q[i] = m_imu_ahrs_to_q14(m_q[i]);
+
+  // ZYX (yaw, pitch, roll) angles
+  sin_pitch = 2.0f * (q0 * q2 - q3 * q1);
+  if (sin_pitch > 1.0f)
+    sin_pitch = 1.0f;
+  else if (sin_pitch < -1.0f)
+    sin_pitch = -1.0f;
+
+  m_output.roll  = (int16_t)(atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2)) * IMU_AHRS_RAD_TO_CDEG);
+  m_output.pitch = (int16_t)(asinf(sin_pitch) * IMU_AHRS_RAD_TO_CDEG);
+  m_output.yaw   = (int16_t)(atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3)) * IMU_AHRS_RAD_TO_CDEG);
+
+  if (m_output_handler != NULL)
+    m_output_handler(&m_output);
+}
+
+/**
+ * @brief         Convert a unit quaternion component to Q14 with rounding
+ *
+ * @param[in]     value         Component, -1..1
+ *
+ * @attention     None
+ *
+ * @return        Q14 value
+ */
+static int16_t m_imu_ahrs_to_q14(float value)
+{
+  return (int16_t)(value * (float)IMU_AHRS_Q14_ONE + ((value >= 0.0f) ? 0.5f : -0.5f));
+}
+
+/* End of file -------------------------------------------------------- */
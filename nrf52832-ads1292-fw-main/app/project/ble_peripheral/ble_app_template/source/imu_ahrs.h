@@ -0,0 +1,130 @@
+/**
+ * @file       imu_ahrs.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Orientation filter (Madgwick) on the IMU frames
+ * @note       Single precision on the FPU, the output is a Q14 quaternion and posture angles
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __IMU_AHRS_H
+#define __IMU_AHRS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu9250.h"
+
+/* Public defines ----------------------------------------------------- */
+#define IMU_AHRS_Q14_ONE            (16384)   // 1.0 in the output quaternion
+#define IMU_AHRS_BETA_DEFAULT       (0.1f)    // Gradient descent gain, higher trusts accel/mag more
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief IMU AHRS configuration structure
+ */
+typedef struct
+{
+  uint16_t sample_rate;       // Frame rate (Hz)
+  uint16_t output_rate;       // Output rate (Hz), at most sample_rate
+  float    gyro_scale;        // Gyro sensitivity (dps/LSB)
+  float    beta;              // Filter gain
+}
+imu_ahrs_config_t;
+
+/**
+ * @brief IMU AHRS output structure
+ */
+typedef struct
+{
+  uint32_t seq;               // Frame counter of the last fused frame
+  int16_t  q[4];              // w, x, y, z (Q14)
+  int16_t  roll;              // 0.01 deg
+  int16_t  pitch;             // 0.01 deg
+  int16_t  yaw;               // 0.01 deg, magnetic heading with the magnetometer, relative otherwise
+}
+imu_ahrs_output_t;
+
+/**
+ * @brief IMU AHRS output handler type
+ */
+typedef void (*imu_ahrs_output_handler_t)(const imu_ahrs_output_t *p_output);
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         IMU AHRS init, the orientation restarts from the attitude of the next frame
+ *
+ * @param[in]     p_config      Pointer to configuration
+ *
+ * @attention     None
+ *
+ * @return
+ * - true       Configuration applied
+ * - false      Invalid configuration
+ */
+bool imu_ahrs_init(const imu_ahrs_config_t *p_config);
+
+/**
+ * @brief         IMU AHRS set the output rate
+ *
+ * @param[in]     output_rate   Output rate (Hz), 1..sample_rate
+ *
+ * @attention     The filter keeps running at the sample rate
+ *
+ * @return
+ * - true       Rate applied
+ * - false      Invalid rate
+ */
+bool imu_ahrs_set_output_rate(uint16_t output_rate);
+
+/**
+ * @brief         IMU AHRS register the output handler
+ *
+ * @param[in]     handler       Called at the output rate
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void imu_ahrs_register_output_handler(imu_ahrs_output_handler_t handler);
+
+/**
+ * @brief         IMU AHRS fuse one frame
+ *
+ * @param[in]     p_frame       Accel/gyro/mag frame, raw
+ * @param[in]     seq           Frame counter
+ *
+ * @attention     Without magnetometer data (all zero) the 6-axis update is used
+ *
+ * @return        None
+ */
+void imu_ahrs_update(const mpu9250_fifo_frame_t *p_frame, uint32_t seq);
+
+/**
+ * @brief         IMU AHRS get the newest output
+ *
+ * @param[out]    p_output      Pointer to output
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void imu_ahrs_get(imu_ahrs_output_t *p_output);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __IMU_AHRS_H
+
+/* End of file -------------------------------------------------------- */
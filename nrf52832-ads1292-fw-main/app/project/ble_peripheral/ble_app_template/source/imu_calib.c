@@ -0,0 +1,644 @@
+/**
+ * @file       imu_calib.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      IMU calibration (accel 6-position, gyro bias, mag hard/soft iron) kept in FDS
+ * @note       The frames are cut in windows of half a second. A window is still when no
+ *             accel and gyro axis moved by more than its threshold and the accel variance
+ *             stays low, its means feed the gyro bias and the accelerometer positions.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include <stdlib.h>
+#include "imu_calib.h"
+#include "fds.h"
+#include "nrf_soc.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+
+/* Private defines ---------------------------------------------------- */
+#define IMU_CALIB_STILL_ACCEL_MG    (40)      // Accel peak-to-peak of a still window
+#define IMU_CALIB_STILL_GYRO_MDPS   (2000)    // Gyro peak-to-peak of a still window
+#define IMU_CALIB_STILL_ACCEL_SD_MG (12)      // Accel standard deviation of a still window
+#define IMU_CALIB_GYRO_BIAS_MAX     (10000)   // Larger means are a slow rotation, not a bias (mdps)
+#define IMU_CALIB_GYRO_SAVE_DELTA   (500)     // Bias drift worth a flash write (mdps)
+#define IMU_CALIB_GYRO_SAVE_TIME    (600)     // Seconds between two bias writes
+#define IMU_CALIB_GYRO_TRACK_SHIFT  (2)       // Bias tracking, 1/4 of each still window
+
+#define IMU_CALIB_ACCEL_FACE_PCT    (80)      // Share of 1 g on the axis facing up
+#define IMU_CALIB_ACCEL_TOL_PCT     (12)      // Accepted span and offset error of an axis
+
+#define IMU_CALIB_MAG_MIN_SPAN_NT   (30000)   // Smallest extent of an axis, about the earth field
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+#define IMU_CALIB_ACCEL_RAW(mg)     ((int32_t)(mg) * 32768 / m_accel_range)
+#define IMU_CALIB_GYRO_RAW(mdps)    ((int32_t)(mdps) * 32768 / m_gyro_range)
+
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static imu_calib_params_t m_params;
+static imu_calib_params_t m_flash_params;   // Source of the FDS write until it completes
+static imu_calib_state_t  m_state = IMU_CALIB_STATE_IDLE;
+static imu_calib_done_handler_t m_done_handler = NULL;
+
+static uint16_t m_sample_rate;
+static int32_t  m_accel_range;
+static int32_t  m_gyro_range;
+
+// Still window
+static uint16_t m_win_len;
+static uint16_t m_win_count;
+static int32_t  m_win_sum[6];               // Accel x, y, z then gyro x, y, z
+static int16_t  m_win_min[6];
+static int16_t  m_win_max[6];
+static int64_t  m_win_sq[3];                // Accel x, y, z sums of squares, from the first sample
+
+// Gyro bias tracking
+static int32_t  m_gyro_bias_q4[3];
+static uint32_t m_gyro_save_windows;        // Still or not, windows since the last bias write
+
+// Accelerometer positions
+static uint8_t  m_positions;
+static int32_t  m_position_mean[IMU_CALIB_ACCEL_POSITIONS];
+
+// Magnetometer extremes
+static uint32_t m_mag_frames;
+static uint32_t m_mag_frames_total;
+static int16_t  m_mag_min[3];
+static int16_t  m_mag_max[3];
+
+// FDS
+static volatile bool m_fds_ready;
+static volatile bool m_fds_busy;
+static volatile bool m_fds_pending;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_imu_calib_window_add(const mpu9250_fifo_frame_t *p_frame);
+static void m_imu_calib_window_close(void);
+static void m_imu_calib_gyro_track(const int32_t *p_mean);
+static void m_imu_calib_accel_capture(const int32_t *p_mean);
+static void m_imu_calib_accel_finish(void);
+static void m_imu_calib_mag_add(const mpu9250_raw_data_t *p_mag);
+static void m_imu_calib_mag_finish(void);
+static void m_imu_calib_done(bool success);
+static base_status_t m_imu_calib_load(void);
+static void m_imu_calib_save(void);
+static void m_imu_calib_fds_handler(fds_evt_t const *p_evt);
+static int16_t m_imu_calib_sat(int32_t value);
+
+/* Function definitions ----------------------------------------------- */
+base_status_t imu_calib_init(const imu_calib_config_t *p_config)
+{
+  CHECK((p_config->sample_rate >= 2) && (p_config->accel_range > 0) && (p_config->gyro_range > 0), BS_ERROR_PARAMS);
+
+  m_sample_rate = p_config->sample_rate;
+  m_accel_range = p_config->accel_range;
+  m_gyro_range  = p_config->gyro_range;
+  m_win_len     = m_sample_rate / 2;
+  m_win_count   = 0;
+  m_state       = IMU_CALIB_STATE_IDLE;
+
+  memset(&m_params, 0, sizeof(m_params));
+  m_params.version = IMU_CALIB_VERSION;
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    m_params.accel_scale[i] = IMU_CALIB_Q14_ONE;
+    m_params.mag_scale[i]   = IMU_CALIB_Q14_ONE;
+  }
+
+  CHECK(fds_register(m_imu_calib_fds_handler) == NRF_SUCCESS, BS_ERROR);
+  CHECK(fds_init() == NRF_SUCCESS, BS_ERROR);
+
+  // The flash is scanned in the background, the parameters are needed before the first frame
+  while (!m_fds_ready)
+    (void)sd_app_evt_wait();
+
+  // Nothing stored yet is not an error, the defaults stay
+  m_imu_calib_load();
+
+  for (uint8_t i = 0; i < 3; i++)
+    m_gyro_bias_q4[i] = (int32_t)m_params.gyro_bias[i] << 4;
+
+  return BS_OK;
+}
+
+void imu_calib_register_done_handler(imu_calib_done_handler_t handler)
+{
+  m_done_handler = handler;
+}
+
+base_status_t imu_calib_accel_start(void)
+{
+  CHECK(m_state == IMU_CALIB_STATE_IDLE, BS_ERROR);
+
+  m_positions = 0;
+  m_state     = IMU_CALIB_STATE_ACCEL;
+
+  return BS_OK;
+}
+
+base_status_t imu_calib_mag_start(uint16_t duration_s)
+{
+  CHECK(m_state == IMU_CALIB_STATE_IDLE, BS_ERROR);
+  CHECK(duration_s != 0, BS_ERROR_PARAMS);
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    m_mag_min[i] = INT16_MAX;
+    m_mag_max[i] = INT16_MIN;
+  }
+
+  m_mag_frames       = 0;
+  m_mag_frames_total = (uint32_t)duration_s * m_sample_rate;
+  m_state            = IMU_CALIB_STATE_MAG;
+
+  return BS_OK;
+}
+
+void imu_calib_abort(void)
+{
+  m_state = IMU_CALIB_STATE_IDLE;
+}
+
+void imu_calib_update(mpu9250_fifo_frame_t *p_frame)
+{
+  m_imu_calib_window_add(p_frame);
+
+  if (m_state == IMU_CALIB_STATE_MAG)
+    m_imu_calib_mag_add(&p_frame->mag);
+
+  imu_calib_apply(p_frame);
+}
+
+void imu_calib_apply(mpu9250_fifo_frame_t *p_frame)
+{
+  int16_t *p_accel = &p_frame->accel.x;
+  int16_t *p_gyro  = &p_frame->gyro.x;
+  int16_t *p_mag   = &p_frame->mag.x;
+  bool     has_mag = (p_mag[0] != 0) || (p_mag[1] != 0) || (p_mag[2] != 0);
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    if (m_params.valid & IMU_CALIB_VALID_ACCEL)
+      p_accel[i] = m_imu_calib_sat(((int32_t)(p_accel[i] - m_params.accel_offset[i]) * m_params.accel_scale[i]) >> 14);
+
+    if (m_params.valid & IMU_CALIB_VALID_GYRO)
+      p_gyro[i] = m_imu_calib_sat((int32_t)p_gyro[i] - m_params.gyro_bias[i]);
+
+    if ((m_params.valid & IMU_CALIB_VALID_MAG) && has_mag)
+      p_mag[i] = m_imu_calib_sat(((int32_t)(p_mag[i] - m_params.mag_offset[i]) * m_params.mag_scale[i]) >> 14);
+  }
+}
+
+imu_calib_state_t imu_calib_state_get(uint8_t *p_positions)
+{
+  if (p_positions != NULL)
+    *p_positions = m_positions;
+
+  return m_state;
+}
+
+void imu_calib_params_get(imu_calib_params_t *p_params)
+{
+  memcpy(p_params, &m_params, sizeof(imu_calib_params_t));
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Add a raw frame to the still window
+ *
+ * @param[in]     p_frame       Raw frame
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_imu_calib_window_add(const mpu9250_fifo_frame_t *p_frame)
+{
+  const int16_t values[6] = { p_frame->accel.x, p_frame->accel.y, p_frame->accel.z,
+                              p_frame->gyro.x, p_frame->gyro.y, p_frame->gyro.z };
+
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    if (m_win_count == 0)
+    {
+      m_win_sum[i] = 0;
+      m_win_min[i] = values[i];
+      m_win_max[i] = values[i];
+      if (i < 3)
+        m_win_sq[i] = 0;
+    }
+
+    m_win_sum[i] += values[i];
+    m_win_min[i]  = MIN(m_win_min[i], values[i]);
+    m_win_max[i]  = MAX(m_win_max[i], values[i]);
+
+    if (i < 3)
+      m_win_sq[i] += (int64_t)values[i] * values[i];
+  }
+
+  if (++m_win_count >= m_win_len)
+    m_imu_calib_window_close();
+}
+
+/**
+ * @brief         Close the still window, its means go to the estimators when it was still
+ *
+ * @param[in]     None
+ *
+ * @attention     A write left pending by a busy FDS is retried here, in main context
+ *
+ * @return        None
+ */
+static void m_imu_calib_window_close(void)
+{
+  int32_t mean[6];
+  int64_t var_limit = (int64_t)IMU_CALIB_ACCEL_RAW(IMU_CALIB_STILL_ACCEL_SD_MG) * IMU_CALIB_ACCEL_RAW(IMU_CALIB_STILL_ACCEL_SD_MG);
+  bool    still     = true;
+
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    int32_t limit = (i < 3) ? IMU_CALIB_ACCEL_RAW(IMU_CALIB_STILL_ACCEL_MG) : IMU_CALIB_GYRO_RAW(IMU_CALIB_STILL_GYRO_MDPS);
+
+    if ((m_win_max[i] - m_win_min[i]) > limit)
+      still = false;
+
+    // Variance n * sum(x^2) - sum(x)^2, against the limit scaled by n^2
+    if ((i < 3) && ((m_win_sq[i] * m_win_count - (int64_t)m_win_sum[i] * m_win_sum[i]) >
+                    var_limit * m_win_count * m_win_count))
+      still = false;
+
+    mean[i] = m_win_sum[i] / (int32_t)m_win_count;
+  }
+
+  m_win_count = 0;
+  m_gyro_save_windows++;
+
+  if (m_fds_pending && !m_fds_busy)
+    m_imu_calib_save();
+
+  if (!still)
+    return;
+
+  m_imu_calib_gyro_track(&mean[3]);
+
+  if (m_state == IMU_CALIB_STATE_ACCEL)
+    m_imu_calib_accel_capture(&mean[0]);
+}
+
+/**
+ * @brief         Track the gyro bias on a still window
+ *
+ * @param[in]     p_mean        Gyro means (raw)
+ *
+ * @attention     The first estimate is taken as is and written at once, the following ones
+ *                are smoothed and only written after a drift, at most every IMU_CALIB_GYRO_SAVE_TIME
+ *
+ * @return        None
+ */
+static void m_imu_calib_gyro_track(const int32_t *p_mean)
+{
+  bool    first = !(m_params.valid & IMU_CALIB_VALID_GYRO);
+  int32_t drift = 0;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    if (abs(p_mean[i]) > IMU_CALIB_GYRO_RAW(IMU_CALIB_GYRO_BIAS_MAX))
+      return;
+  }
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    if (first)
+      m_gyro_bias_q4[i] = p_mean[i] << 4;
+    else
+      m_gyro_bias_q4[i] += ((p_mean[i] << 4) - m_gyro_bias_q4[i]) >> IMU_CALIB_GYRO_TRACK_SHIFT;
+
+    m_params.gyro_bias[i] = (int16_t)(m_gyro_bias_q4[i] >> 4);
+    drift = MAX(drift, abs(m_params.gyro_bias[i] - m_flash_params.gyro_bias[i]));
+  }
+
+  m_params.valid |= IMU_CALIB_VALID_GYRO;
+
+  if (first || ((drift > IMU_CALIB_GYRO_RAW(IMU_CALIB_GYRO_SAVE_DELTA)) &&
+                (m_gyro_save_windows >= 2UL * IMU_CALIB_GYRO_SAVE_TIME)))
+  {
+    m_gyro_save_windows = 0;
+    m_imu_calib_save();
+  }
+}
+
+/**
+ * @brief         Capture the accelerometer position of a still window
+ *
+ * @param[in]     p_mean        Accel means (raw)
+ *
+ * @attention     The position is the axis carrying most of the gravity and its sign
+ *
+ * @return        None
+ */
+static void m_imu_calib_accel_capture(const int32_t *p_mean)
+{
+  int32_t one_g = IMU_CALIB_ACCEL_RAW(1000);
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    if (abs(p_mean[i]) < one_g * IMU_CALIB_ACCEL_FACE_PCT / 100)
+      continue;
+
+    uint8_t position = i * 2 + ((p_mean[i] < 0) ? 1 : 0);
+
+    if (m_positions & (1 << position))
+      return;
+
+    m_position_mean[position] = p_mean[i];
+    m_positions |= (1 << position);
+
+    if (m_positions == ((1 << IMU_CALIB_ACCEL_POSITIONS) - 1))
+      m_imu_calib_accel_finish();
+
+    return;
+  }
+}
+
+/**
+ * @brief         Compute the accelerometer offsets and scales from the 6 positions
+ *
+ * @param[in]     None
+ *
+ * @attention     An axis out of tolerance fails the calibration
+ *
+ * @return        None
+ */
+static void m_imu_calib_accel_finish(void)
+{
+  int32_t one_g = IMU_CALIB_ACCEL_RAW(1000);
+  int16_t offset[3];
+  int16_t scale[3];
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t pos  = m_position_mean[i * 2];
+    int32_t neg  = m_position_mean[i * 2 + 1];
+    int32_t span = pos - neg;
+
+    if ((abs(span - 2 * one_g) > 2 * one_g * IMU_CALIB_ACCEL_TOL_PCT / 100) ||
+        (abs(pos + neg) / 2 > one_g * IMU_CALIB_ACCEL_TOL_PCT / 100))
+    {
+      m_imu_calib_done(false);
+      return;
+    }
+
+    offset[i] = (int16_t)((pos + neg) / 2);
+    scale[i]  = (int16_t)((2 * one_g * IMU_CALIB_Q14_ONE) / span);
+  }
+
+  memcpy(m_params.accel_offset, offset, sizeof(offset));
+  memcpy(m_params.accel_scale, scale, sizeof(scale));
+  m_params.valid |= IMU_CALIB_VALID_ACCEL;
+
+  m_imu_calib_save();
+  m_imu_calib_done(true);
+}
+
+/**
+ * @brief         Add a raw magnetometer sample to the extremes
+ *
+ * @param[in]     p_mag         Sensitivity adjusted magnetometer
+ *
+ * @attention     Frames without a magnetometer sample are skipped
+ *
+ * @return        None
+ */
+static void m_imu_calib_mag_add(const mpu9250_raw_data_t *p_mag)
+{
+  const int16_t *p_value = &p_mag->x;
+
+  if ((p_value[0] == 0) && (p_value[1] == 0) && (p_value[2] == 0))
+    return;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    m_mag_min[i] = MIN(m_mag_min[i], p_value[i]);
+    m_mag_max[i] = MAX(m_mag_max[i], p_value[i]);
+  }
+
+  if (++m_mag_frames >= m_mag_frames_total)
+    m_imu_calib_mag_finish();
+}
+
+/**
+ * @brief         Fit the hard and soft iron from the magnetometer extremes
+ *
+ * @param[in]     None
+ *
+ * @attention     The hard iron is the centre of the extremes, the soft iron scales every axis
+ *                to the mean radius. An axis not rotated through fails the calibration.
+ *
+ * @return        None
+ */
+static void m_imu_calib_mag_finish(void)
+{
+  int32_t radius[3];
+  int32_t radius_mean = 0;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t span = (int32_t)m_mag_max[i] - m_mag_min[i];
+
+    if (span < IMU_CALIB_MAG_MIN_SPAN_NT / MPU9250_MAG_NT_PER_LSB)
+    {
+      m_imu_calib_done(false);
+      return;
+    }
+
+    radius[i]    = span / 2;
+    radius_mean += radius[i];
+  }
+
+  radius_mean /= 3;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    m_params.mag_offset[i] = (int16_t)(((int32_t)m_mag_max[i] + m_mag_min[i]) / 2);
+    m_params.mag_scale[i]  = (int16_t)((radius_mean * IMU_CALIB_Q14_ONE) / radius[i]);
+  }
+
+  m_params.valid |= IMU_CALIB_VALID_MAG;
+
+  m_imu_calib_save();
+  m_imu_calib_done(true);
+}
+
+/**
+ * @brief         End the running calibration
+ *
+ * @param[in]     success       Parameters updated
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_imu_calib_done(bool success)
+{
+  imu_calib_state_t state = m_state;
+
+  m_state = IMU_CALIB_STATE_IDLE;
+
+  if (m_done_handler != NULL)
+    m_done_handler(state, success);
+}
+
+/**
+ * @brief         Load the parameters from FDS
+ *
+ * @param[in]     None
+ *
+ * @attention     A record of another layout is ignored
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       No valid record
+ */
+static base_status_t m_imu_calib_load(void)
+{
+  fds_record_desc_t  desc;
+  fds_find_token_t   token;
+  fds_flash_record_t record;
+  base_status_t      ret = BS_ERROR;
+
+  memset(&token, 0, sizeof(token));
+
+  CHECK(fds_record_find(IMU_CALIB_FILE_ID, IMU_CALIB_RECORD_KEY, &desc, &token) == NRF_SUCCESS, BS_ERROR);
+  CHECK(fds_record_open(&desc, &record) == NRF_SUCCESS, BS_ERROR);
+
+  if ((record.p_header->length_words * sizeof(uint32_t) >= sizeof(imu_calib_params_t)) &&
+      (((const imu_calib_params_t *)record.p_data)->version == IMU_CALIB_VERSION))
+  {
+    memcpy(&m_params, record.p_data, sizeof(imu_calib_params_t));
+    memcpy(&m_flash_params, record.p_data, sizeof(imu_calib_params_t));
+    ret = BS_OK;
+  }
+
+  fds_record_close(&desc);
+
+  return ret;
+}
+
+/**
+ * @brief         Write the parameters to FDS
+ *
+ * @param[in]     None
+ *
+ * @attention     Main context only. A write requested while another one runs is left pending
+ *                and retried at a window close, a full flash is garbage collected first
+ *
+ * @return        None
+ */
+static void m_imu_calib_save(void)
+{
+  fds_record_desc_t desc;
+  fds_find_token_t  token;
+  fds_record_t      record;
+  ret_code_t        err_code;
+  bool              busy;
+
+  // Busy until the write or the garbage collection completes, taken before the event may come
+  CRITICAL_REGION_ENTER();
+  busy = m_fds_busy;
+  m_fds_pending = busy;
+  m_fds_busy    = true;
+  CRITICAL_REGION_EXIT();
+
+  if (busy)
+    return;
+
+  // The handler no longer touches the copy, it is only rewritten here once the last write completed
+  memcpy(&m_flash_params, &m_params, sizeof(imu_calib_params_t));
+
+  record.file_id           = IMU_CALIB_FILE_ID;
+  record.key               = IMU_CALIB_RECORD_KEY;
+  record.data.p_data       = &m_flash_params;
+  record.data.length_words = BYTES_TO_WORDS(sizeof(imu_calib_params_t));
+
+  memset(&token, 0, sizeof(token));
+
+  if (fds_record_find(IMU_CALIB_FILE_ID, IMU_CALIB_RECORD_KEY, &desc, &token) == NRF_SUCCESS)
+    err_code = fds_record_update(&desc, &record);
+  else
+    err_code = fds_record_write(NULL, &record);
+
+  if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+  {
+    // Written again at the first window close after the garbage collection
+    m_fds_pending = true;
+    err_code      = fds_gc();
+  }
+
+  // Lost on any other error
+  if (err_code != NRF_SUCCESS)
+  {
+    CRITICAL_REGION_ENTER();
+    m_fds_pending = false;
+    m_fds_busy    = false;
+    CRITICAL_REGION_EXIT();
+  }
+}
+
+/**
+ * @brief         FDS event handler
+ *
+ * @param[in]     p_evt         FDS event
+ *
+ * @attention     Only clears the busy flag, a pending write is started from main context
+ *
+ * @return        None
+ */
+static void m_imu_calib_fds_handler(fds_evt_t const *p_evt)
+{
+  switch (p_evt->id)
+  {
+  case FDS_EVT_INIT:
+    m_fds_ready = true;
+    break;
+
+  case FDS_EVT_WRITE:
+  case FDS_EVT_UPDATE:
+    if (p_evt->write.file_id != IMU_CALIB_FILE_ID)
+      break;
+    // fall through
+  case FDS_EVT_GC:
+    m_fds_busy = false;
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief         Saturate to a raw sample
+ *
+ * @param[in]     value         Value
+ *
+ * @attention     None
+ *
+ * @return        Saturated value
+ */
+static int16_t m_imu_calib_sat(int32_t value)
+{
+  if (value > INT16_MAX)
+    return INT16_MAX;
+  if (value < INT16_MIN)
+    return INT16_MIN;
+
+  return (int16_t)value;
+}
+
+/* End of file -------------------------------------------------------- */
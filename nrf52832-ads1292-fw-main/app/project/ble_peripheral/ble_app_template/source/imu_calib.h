@@ -0,0 +1,206 @@
+/**
+ * @file       imu_calib.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      IMU calibration (accel 6-position, gyro bias, mag hard/soft iron) kept in FDS
+ * @note       The calibration works on the raw frames, before the orientation and activity
+ *             algorithms. The gyro bias follows the sensor whenever it is still.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __IMU_CALIB_H
+#define __IMU_CALIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu9250.h"
+
+/* Public defines ----------------------------------------------------- */
+#define IMU_CALIB_VERSION           (1)       // Layout of imu_calib_params_t
+#define IMU_CALIB_Q14_ONE           (16384)   // Unity scale
+#define IMU_CALIB_FILE_ID           (0x1C00)  // FDS file of the calibration
+#define IMU_CALIB_RECORD_KEY        (0x1C01)  // FDS record of the calibration
+#define IMU_CALIB_ACCEL_POSITIONS   (6)       // +X, -X, +Y, -Y, +Z, -Z facing up
+#define IMU_CALIB_MAG_TIME_DEFAULT  (30)      // Seconds of rotation for the magnetometer fit
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief IMU calibration state enum
+ */
+typedef enum
+{
+  IMU_CALIB_STATE_IDLE = 0x00  // Only the gyro bias is tracked
+  , IMU_CALIB_STATE_ACCEL      // Collecting the 6 accelerometer positions
+  , IMU_CALIB_STATE_MAG        // Collecting the magnetometer extremes
+}
+imu_calib_state_t;
+
+/**
+ * @brief IMU calibration valid flags enum
+ */
+typedef enum
+{
+  IMU_CALIB_VALID_ACCEL = 0x01
+  , IMU_CALIB_VALID_GYRO  = 0x02
+  , IMU_CALIB_VALID_MAG   = 0x04
+}
+imu_calib_valid_t;
+
+/**
+ * @brief IMU calibration configuration structure
+ */
+typedef struct
+{
+  uint16_t sample_rate;       // Frame rate (Hz)
+  int32_t  accel_range;       // Accel full-scale range (mg)
+  int32_t  gyro_range;        // Gyro full-scale range (mdps)
+}
+imu_calib_config_t;
+
+/**
+ * @brief IMU calibration parameters structure, stored as is in FDS
+ */
+typedef struct
+{
+  uint16_t version;           // IMU_CALIB_VERSION of the writer
+  uint8_t  valid;             // imu_calib_valid_t flags
+  uint8_t  reserved;
+  int16_t  accel_offset[3];   // Raw LSB
+  int16_t  accel_scale[3];    // Q14
+  int16_t  gyro_bias[3];      // Raw LSB
+  int16_t  mag_offset[3];     // Raw LSB, hard iron
+  int16_t  mag_scale[3];      // Q14, soft iron (axis-aligned)
+  int16_t  reserved_2;
+}
+imu_calib_params_t;
+
+/**
+ * @brief IMU calibration done handler type
+ */
+typedef void (*imu_calib_done_handler_t)(imu_calib_state_t state, bool success);
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         IMU calibration init, the stored parameters are loaded
+ *
+ * @param[in]     p_config      Pointer to configuration
+ *
+ * @attention     Waits for the FDS initialisation, the SoftDevice must be enabled
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ * - BS_ERROR
+ */
+base_status_t imu_calib_init(const imu_calib_config_t *p_config);
+
+/**
+ * @brief         IMU calibration register the done handler
+ *
+ * @param[in]     handler       Called when an accelerometer or magnetometer calibration ends
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void imu_calib_register_done_handler(imu_calib_done_handler_t handler);
+
+/**
+ * @brief         IMU calibration start the 6-position accelerometer calibration
+ *
+ * @param[in]     None
+ *
+ * @attention     Each face is captured once the sensor rests on it, in any order
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Another calibration runs
+ */
+base_status_t imu_calib_accel_start(void);
+
+/**
+ * @brief         IMU calibration start the magnetometer calibration
+ *
+ * @param[in]     duration_s    Seconds of rotation through all orientations
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Another calibration runs
+ */
+base_status_t imu_calib_mag_start(uint16_t duration_s);
+
+/**
+ * @brief         IMU calibration abort the running calibration
+ *
+ * @param[in]     None
+ *
+ * @attention     The previous parameters are kept
+ *
+ * @return        None
+ */
+void imu_calib_abort(void);
+
+/**
+ * @brief         IMU calibration observe and correct one frame
+ *
+ * @param[in]     p_frame       Raw frame, corrected in place
+ *
+ * @attention     Called for every frame in order, the estimators see the raw values
+ *
+ * @return        None
+ */
+void imu_calib_update(mpu9250_fifo_frame_t *p_frame);
+
+/**
+ * @brief         IMU calibration correct one frame
+ *
+ * @param[in]     p_frame       Raw frame, corrected in place
+ *
+ * @attention     For the occasional readings outside the continuous acquisition
+ *
+ * @return        None
+ */
+void imu_calib_apply(mpu9250_fifo_frame_t *p_frame);
+
+/**
+ * @brief         IMU calibration get the state
+ *
+ * @param[out]    p_positions   Captured accelerometer positions (bit mask), NULL if not needed
+ *
+ * @attention     None
+ *
+ * @return        State
+ */
+imu_calib_state_t imu_calib_state_get(uint8_t *p_positions);
+
+/**
+ * @brief         IMU calibration get the parameters
+ *
+ * @param[out]    p_params      Pointer to parameters
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void imu_calib_params_get(imu_calib_params_t *p_params);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __IMU_CALIB_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,234 @@
+/**
+ * @file       motion_stream.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      IMU frame decimator and packetizer for the motion service
+ * @note       The FIFO frames are averaged over the decimation factor, which is also the
+ *             anti-alias filter of the output rate. One notification carries all nine axes of
+ *             up to 13 frames.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "motion_stream.h"
+#include "bsp_time.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+#define MOTION_STREAM_MAX_LATENCY_MS  (250)   // Oldest frame age that sends a short packet
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static motion_stream_stats_t m_stats;
+static bool                  m_enabled;
+static uint8_t               m_format;
+static uint16_t              m_frame_rate;
+static uint16_t              m_decimation;
+static uint16_t              m_period;             // Output frame period (ticks)
+static uint16_t              m_sequence;
+
+// Decimation accumulator, accel, gyro and mag X/Y/Z
+static int32_t               m_acc_sum[9];
+static uint16_t              m_acc_count;
+static uint32_t              m_acc_tick;           // Tick of the first frame of the group
+
+static mpu9250_fifo_frame_t  m_ring[MOTION_STREAM_RING_SIZE];
+static uint32_t              m_ring_tick[MOTION_STREAM_RING_SIZE];
+static uint16_t              m_ring_period[MOTION_STREAM_RING_SIZE];   // Frame period of each frame (ticks)
+static uint16_t              m_ring_head;          // Next frame written
+static uint16_t              m_ring_count;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_motion_stream_push(const mpu9250_fifo_frame_t *p_frame, uint32_t tick);
+
+/* Function definitions ----------------------------------------------- */
+base_status_t motion_stream_init(uint16_t frame_rate, uint16_t output_rate, bool mag_valid)
+{
+  CHECK((output_rate != 0) && (output_rate <= frame_rate), BS_ERROR_PARAMS);
+
+  m_frame_rate = frame_rate;
+  m_decimation = frame_rate / output_rate;
+  m_period     = (uint16_t)BSP_TIME_SAMPLE_TICKS(m_decimation, frame_rate);
+  m_format     = (uint8_t)(BSP_IMU_ACCEL_FS | (BSP_IMU_GYRO_FS << 2) | (mag_valid ? (1u << 4) : 0));
+  m_enabled    = false;
+  m_sequence   = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+
+  return BS_OK;
+}
+
+base_status_t motion_stream_rate_set(uint16_t output_rate)
+{
+  CHECK((output_rate != 0) && (output_rate <= m_frame_rate), BS_ERROR_PARAMS);
+
+  // The buffered frames keep their period, only the group being averaged restarts
+  m_decimation = m_frame_rate / output_rate;
+  m_period     = (uint16_t)BSP_TIME_SAMPLE_TICKS(m_decimation, m_frame_rate);
+  m_acc_count  = 0;
+
+  return BS_OK;
+}
+
+uint16_t motion_stream_rate_get(void)
+{
+  return m_frame_rate / m_decimation;
+}
+
+void motion_stream_enable(bool enable)
+{
+  m_enabled    = enable;
+  m_ring_head  = 0;
+  m_ring_count = 0;
+  m_acc_count  = 0;
+}
+
+void motion_stream_block_handler(const bsp_imu_block_t *p_block)
+{
+  if (!m_enabled)
+    return;
+
+  // A gap would be averaged into the group
+  if (p_block->overflow)
+    m_acc_count = 0;
+
+  for (uint16_t i = 0; i < p_block->count; i++)
+  {
+    const mpu9250_fifo_frame_t *p_frame = &p_block->frames[i];
+
+    if (m_acc_count == 0)
+    {
+      memset(m_acc_sum, 0, sizeof(m_acc_sum));
+      m_acc_tick = BSP_IMU_FRAME_TICK(p_block, i);
+    }
+
+    m_acc_sum[0] += p_frame->accel.x;
+    m_acc_sum[1] += p_frame->accel.y;
+    m_acc_sum[2] += p_frame->accel.z;
+    m_acc_sum[3] += p_frame->gyro.x;
+    m_acc_sum[4] += p_frame->gyro.y;
+    m_acc_sum[5] += p_frame->gyro.z;
+    m_acc_sum[6] += p_frame->mag.x;
+    m_acc_sum[7] += p_frame->mag.y;
+    m_acc_sum[8] += p_frame->mag.z;
+
+    if (++m_acc_count < m_decimation)
+      continue;
+
+    mpu9250_fifo_frame_t frame;
+
+    frame.accel.x = (int16_t)(m_acc_sum[0] / m_decimation);
+    frame.accel.y = (int16_t)(m_acc_sum[1] / m_decimation);
+    frame.accel.z = (int16_t)(m_acc_sum[2] / m_decimation);
+    frame.gyro.x  = (int16_t)(m_acc_sum[3] / m_decimation);
+    frame.gyro.y  = (int16_t)(m_acc_sum[4] / m_decimation);
+    frame.gyro.z  = (int16_t)(m_acc_sum[5] / m_decimation);
+    frame.mag.x   = (int16_t)(m_acc_sum[6] / m_decimation);
+    frame.mag.y   = (int16_t)(m_acc_sum[7] / m_decimation);
+    frame.mag.z   = (int16_t)(m_acc_sum[8] / m_decimation);
+
+    // The average sits in the middle of the group
+    m_motion_stream_push(&frame, m_acc_tick + (BSP_IMU_FRAME_TICK(p_block, i) - m_acc_tick) / 2);
+    m_acc_count = 0;
+  }
+}
+
+uint16_t motion_stream_packet_build(uint8_t *p_buf, uint16_t max_len)
+{
+  uint16_t tail;
+  uint16_t frames;
+  uint16_t same;
+  uint16_t period;
+  uint16_t len = 0;
+
+  if ((max_len < MOTION_STREAM_HEADER_SIZE + MOTION_STREAM_FRAME_SIZE) || (m_ring_count == 0))
+    return 0;
+
+  frames = (max_len - MOTION_STREAM_HEADER_SIZE) / MOTION_STREAM_FRAME_SIZE;
+  tail   = (m_ring_head + MOTION_STREAM_RING_SIZE - m_ring_count) % MOTION_STREAM_RING_SIZE;
+  period = m_ring_period[tail];
+
+  // A packet has one frame period, the frames after a rate change start the next one
+  for (same = 1; same < m_ring_count; same++)
+  {
+    if (m_ring_period[(tail + same) % MOTION_STREAM_RING_SIZE] != period)
+      break;
+  }
+
+  if (same < frames)
+  {
+    uint32_t newest = m_ring_tick[(m_ring_head + MOTION_STREAM_RING_SIZE - 1) % MOTION_STREAM_RING_SIZE];
+
+    // Not full yet, only sent once the oldest frame is too old or the rate changed
+    if ((same == m_ring_count) &&
+        ((newest - m_ring_tick[tail]) < (uint32_t)MOTION_STREAM_MAX_LATENCY_MS * BSP_TIME_FREQ_HZ / 1000))
+      return 0;
+
+    frames = same;
+  }
+
+  len += uint16_encode(m_sequence++, &p_buf[len]);
+  len += uint32_encode(m_ring_tick[tail], &p_buf[len]);
+  len += uint16_encode(period, &p_buf[len]);
+  p_buf[len++] = (uint8_t)frames;
+  p_buf[len++] = m_format;
+
+  for (uint16_t i = 0; i < frames; i++)
+  {
+    const mpu9250_fifo_frame_t *p_frame = &m_ring[tail];
+
+    len += uint16_encode((uint16_t)p_frame->accel.x, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->accel.y, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->accel.z, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->gyro.x, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->gyro.y, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->gyro.z, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->mag.x, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->mag.y, &p_buf[len]);
+    len += uint16_encode((uint16_t)p_frame->mag.z, &p_buf[len]);
+
+    tail = (tail + 1) % MOTION_STREAM_RING_SIZE;
+  }
+
+  m_ring_count -= frames;
+  m_stats.packets++;
+
+  return len;
+}
+
+void motion_stream_stats_get(motion_stream_stats_t *p_stats)
+{
+  *p_stats = m_stats;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Buffer a decimated frame, the oldest one is overwritten when the ring is full
+ *
+ * @param[in]     p_frame       Frame
+ * @param[in]     tick          Timebase tick of the frame
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_motion_stream_push(const mpu9250_fifo_frame_t *p_frame, uint32_t tick)
+{
+  m_ring[m_ring_head]        = *p_frame;
+  m_ring_tick[m_ring_head]   = tick;
+  m_ring_period[m_ring_head] = m_period;
+  m_ring_head = (m_ring_head + 1) % MOTION_STREAM_RING_SIZE;
+  m_stats.frames++;
+
+  if (m_ring_count < MOTION_STREAM_RING_SIZE)
+    m_ring_count++;
+  else
+    m_stats.dropped++;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,144 @@
+/**
+ * @file       motion_stream.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      IMU frame decimator and packetizer for the motion service
+ * @note       A packet is a header followed by frames of accel, gyro and mag X/Y/Z (i16), little
+ *             endian, in calibrated sensor counts:
+ *             {sequence (u16), tick of the first frame (u32), frame period in ticks (u16),
+ *              frames (u8), format (u8), frames * MOTION_STREAM_FRAME_SIZE bytes}
+ *             Format bits 0-1 are the accel full scale, bits 2-3 the gyro full scale and bit 4
+ *             is set when the magnetometer values are valid (0.15 uT per count).
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __MOTION_STREAM_H
+#define __MOTION_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_imu.h"
+
+/* Public defines ----------------------------------------------------- */
+#define MOTION_STREAM_RING_SIZE     (64)      // Frames buffered, 1.28 s at 50 Hz
+#define MOTION_STREAM_HEADER_SIZE   (10)      // Packet header (bytes)
+#define MOTION_STREAM_FRAME_SIZE    (18)      // Accel, gyro and mag X/Y/Z (bytes)
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Motion stream statistics structure
+ */
+typedef struct
+{
+  uint32_t frames;          // Decimated frames buffered
+  uint32_t dropped;         // Oldest frames overwritten by a full ring
+  uint32_t packets;         // Packets built
+}
+motion_stream_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Motion stream init, stopped until motion_stream_enable()
+ *
+ * @param[in]     frame_rate    IMU frame rate (Hz)
+ * @param[in]     output_rate   Streamed frame rate (Hz), frames are averaged down to it
+ * @param[in]     mag_valid     Magnetometer values are read
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ */
+base_status_t motion_stream_init(uint16_t frame_rate, uint16_t output_rate, bool mag_valid);
+
+/**
+ * @brief         Motion stream set the streamed frame rate
+ *
+ * @param[in]     output_rate   Streamed frame rate (Hz), at most the IMU frame rate
+ *
+ * @attention     The frames already buffered are sent with their own period, the rate applies
+ *                from the next averaged group
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ */
+base_status_t motion_stream_rate_set(uint16_t output_rate);
+
+/**
+ * @brief         Motion stream get the streamed frame rate
+ *
+ * @param[in]     None
+ *
+ * @attention     The IMU frame rate divided by the whole decimation factor
+ *
+ * @return        Streamed frame rate (Hz)
+ */
+uint16_t motion_stream_rate_get(void);
+
+/**
+ * @brief         Motion stream start or stop buffering, the ring is emptied
+ *
+ * @param[in]     enable        Buffer the frames
+ *
+ * @attention     Stopped while nobody receives the packets. Main loop only, the ring may be
+ *                in use by the packet builder.
+ *
+ * @return        None
+ */
+void motion_stream_enable(bool enable);
+
+/**
+ * @brief         Motion stream IMU block handler, decimates and buffers the frames
+ *
+ * @param[in]     p_block       FIFO/PPI block, calibrated
+ *
+ * @attention     Registered with bsp_imu_register_block_handler()
+ *
+ * @return        None
+ */
+void motion_stream_block_handler(const bsp_imu_block_t *p_block);
+
+/**
+ * @brief         Motion stream build the next packet from the oldest frames
+ *
+ * @param[out]    p_buf         Output buffer
+ * @param[in]     max_len       Packet size, the usable ATT payload
+ *
+ * @attention     A packet is only built once enough frames fill max_len, the frames are
+ *                removed from the ring
+ *
+ * @return        Packet length, 0 if there is no packet
+ */
+uint16_t motion_stream_packet_build(uint8_t *p_buf, uint16_t max_len);
+
+/**
+ * @brief         Motion stream get the statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void motion_stream_stats_get(motion_stream_stats_t *p_stats);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __MOTION_STREAM_H
+
+/* End of file -------------------------------------------------------- */
@@ -11,6 +11,7 @@
  */
 
 /* Includes ----------------------------------------------------------- */
+#include <string.h>
 #include "mpu9250.h"
 
 /* Private defines ---------------------------------------------------- */
@@ -30,6 +31,18 @@
 #define MPU9250_REG_USER_CNT          (0x6A)
 #define MPU9250_REG_FIFO_COUNTH       (0x72)
 #define MPU9250_REG_FIFO_R_W          (0x74)
+#define MPU9250_REG_INT_PIN_CFG       (0x37)
+#define MPU9250_REG_I2C_MST_CTRL      (0x24)
+#define MPU9250_REG_I2C_SLV0_ADDR     (0x25)
+#define MPU9250_REG_I2C_SLV0_REG      (0x26)
+#define MPU9250_REG_I2C_SLV0_CTRL     (0x27)
+#define MPU9250_REG_EXT_SENS_DATA_00  (0x49)
+#define MPU9250_REG_I2C_SLV0_DO       (0x63)
+#define MPU9250_REG_PWR_MGMT_2        (0x6C)
+#define MPU9250_REG_ACCEL_CONFIG_2    (0x1D)
+#define MPU9250_REG_LP_ACCEL_ODR      (0x1E)
+#define MPU9250_REG_WOM_THR           (0x1F)
+#define MPU9250_REG_MOT_DETECT_CTRL   (0x69)
 
 // Mag (AK8963) Register Map
 #define AK8963_WIA                    (0x00)   // Device ID - (0x48)
@@ -49,8 +62,37 @@
 #define AK8963_ASAY                   (0x11)   // Y-axis hassasiyet değeri
 #define AK8963_ASAZ                   (0x12)   // Z-axis hassasiyet değeri
 
+#define AK8963_I2C_ADDR               (0x0C)
+#define AK8963_DEVICE_ID              (0x48)
+#define AK8963_DATA_SIZE              (7)      // HXL..HZH, ST2
+#define AK8963_ST2_HOFL               (0x08)   // Magnetic sensor overflow
+#define AK8963_CNTL_POWER_DOWN        (0x00)
+#define AK8963_CNTL_FUSE_ROM          (0x0F)
+#define AK8963_CNTL_CONT_100HZ_16BIT  (0x16)   // Continuous measurement mode 2, 16-bit output
+
 #define MPU9250_PART_IDENTIFIER       (0x71)
 
+#define MPU9250_TEMP_CDEG_Q15         (9815)   // 100 / 333.87 LSB/degC in Q15
+#define MPU9250_TEMP_OFFSET_CDEG      (2100)
+
+#define MPU9250_CONFIG_FIFO_MODE      (0x40)   // Additional writes are dropped when the FIFO is full
+#define MPU9250_FIFO_EN_ACCEL_GYRO    (0x78)   // GYRO_XOUT, GYRO_YOUT, GYRO_ZOUT, ACCEL
+#define MPU9250_USER_CTRL_FIFO_EN     (0x40)
+#define MPU9250_USER_CTRL_FIFO_RST    (0x04)
+#define MPU9250_INT_STATUS_FIFO_OFLOW (0x10)
+#define MPU9250_FIFO_EN_SLV0          (0x01)
+#define MPU9250_USER_CTRL_I2C_MST_EN  (0x20)
+#define MPU9250_I2C_MST_WAIT_FOR_ES   (0x40)   // Data ready waits for the external sensor data
+#define MPU9250_I2C_MST_CLK_400K      (0x0D)
+#define MPU9250_I2C_SLV_READ          (0x80)
+#define MPU9250_I2C_SLV_EN            (0x80)
+#define MPU9250_PWR_MGMT_1_CYCLE      (0x20)
+#define MPU9250_PWR_MGMT_2_DIS_G      (0x07)   // DIS_XG, DIS_YG, DIS_ZG
+#define MPU9250_ACCEL_DLPF_184HZ      (0x01)   // ACCEL_FCHOICE_B = 0, A_DLPFCFG = 1
+#define MPU9250_MOT_DETECT_INTEL      (0xC0)   // ACCEL_INTEL_EN, compare with the previous sample
+#define MPU9250_WOM_THR_MG_PER_LSB    (4)
+#define MPU9250_GYRO_STARTUP_MS       (35)
+
 /* Private enumerate/structure ---------------------------------------- */
 /* Private macros ----------------------------------------------------- */
 /* Public variables --------------------------------------------------- */
@@ -58,6 +100,23 @@
 /* Private function prototypes ---------------------------------------- */
 static base_status_t m_mpu9250_read_reg(mpu9250_t *me, uint8_t reg, uint8_t *p_data, uint32_t len);
 static base_status_t m_mpu9250_write_reg(mpu9250_t *me, uint8_t reg, uint8_t *p_data, uint32_t len);
+static base_status_t m_mpu9250_int_status_read(mpu9250_t *me, uint8_t *p_status);
+static base_status_t m_mpu9250_request_start(mpu9250_t *me, mpu9250_request_t *p_request, uint8_t reg, uint8_t *p_data,
+                                             uint32_t len, bsp_i2c_callback_t done, mpu9250_callback_t callback, void *p_context);
+static void m_mpu9250_request_end(mpu9250_request_t *p_request, base_status_t status);
+static base_status_t m_mpu9250_mag_config(mpu9250_t *me);
+static base_status_t m_ak8963_write_reg(mpu9250_t *me, uint8_t reg, uint8_t value);
+static base_status_t m_ak8963_read_reg(mpu9250_t *me, uint8_t reg, uint8_t *p_data, uint8_t len);
+static void m_mpu9250_mag_parse(mpu9250_t *me, const uint8_t *p_ext);
+static void m_mpu9250_motion6_parse(mpu9250_t *me, const uint8_t *p_buffer);
+static uint16_t m_mpu9250_fifo_available(mpu9250_t *me, uint8_t status, const uint8_t *p_count);
+static void m_mpu9250_fifo_convert(mpu9250_t *me, mpu9250_fifo_frame_t *p_frames, uint16_t frames);
+static void m_mpu9250_accel_done(base_status_t status, void *p_context);
+static void m_mpu9250_motion6_done(base_status_t status, void *p_context);
+static void m_mpu9250_fifo_status_done(base_status_t status, void *p_context);
+static void m_mpu9250_fifo_count_done(base_status_t status, void *p_context);
+static void m_mpu9250_fifo_frames_done(base_status_t status, void *p_context);
+static void m_mpu9250_fifo_reset_done(base_status_t status, void *p_context);
 
 /* Function definitions ----------------------------------------------- */
 base_status_t mpu9250_init(mpu9250_t *me)
@@ -111,25 +170,15 @@ base_status_t mpu9250_config(mpu9250_t *me)
   // Set sample rate devider to default
   CHECK_STATUS(mpu9250_set_sample_rate_divider(me, 0x04));
 
-  // Accelerometer scaling factor
-  switch (me->config.accel_full_scale)
-  {
-  case MPU9250_ACCEL_FS_SEL_2G : me->accel.scale_factor = (2000.0f / 32768.0f);  break;
-  case MPU9250_ACCEL_FS_SEL_4G : me->accel.scale_factor = (4000.0f / 32768.0f);  break;
-  case MPU9250_ACCEL_FS_SEL_8G : me->accel.scale_factor = (8000.0f / 32768.0f);  break;
-  case MPU9250_ACCEL_FS_SEL_16G: me->accel.scale_factor = (16000.0f / 32768.0f); break;
-  default : break;
-  }
+  // Full-scale ranges, unit = raw * range / 32768
+  me->accel.range = MPU9250_ACCEL_RANGE_MG(me->config.accel_full_scale);
+  me->gyro.range  = MPU9250_GYRO_RANGE_MDPS(me->config.gyro_full_scale);
 
-  // Gyroscope scaling factor
-  switch (me->config.gyro_full_scale)
-  {
-  case MPU9250_GYRO_FS_SEL_250 : me->gyro.scale_factor = 250.0f / 32768.0f;  break;
-  case MPU9250_GYRO_FS_SEL_500 : me->gyro.scale_factor = 500.0f / 32768.0f;  break;
-  case MPU9250_GYRO_FS_SEL_1000: me->gyro.scale_factor = 1000.0f / 32768.0f; break;
-  case MPU9250_GYRO_FS_SEL_2000: me->gyro.scale_factor = 2000.0f / 32768.0f; break;
-  default : break;
-  }
+  // Magnetometer behind the internal I2C master
+  me->lp_accel    = false;
+  me->mag.enabled = false;
+  if (me->config.mag_enable)
+    CHECK_STATUS(m_mpu9250_mag_config(me));
 
   return BS_OK;
 }
@@ -177,7 +226,7 @@ base_status_t mpu9250_get_accel_raw_data(mpu9250_t *me)
   uint8_t status;
   uint8_t buffer[6];
 
-  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_INT_STATUS, &status, 1));
+  CHECK_STATUS(m_mpu9250_int_status_read(me, &status));
 
   if ((status && 0x01))
   {
@@ -199,9 +248,9 @@ base_status_t mpu9250_get_accel_scale_data(mpu9250_t *me)
 {
   CHECK_STATUS(mpu9250_get_accel_raw_data(me));
 
-  me->accel.scaled_data.x = ((me->accel.raw_data.x + 0.0f) * me->accel.scale_factor);
-  me->accel.scaled_data.y = ((me->accel.raw_data.y + 0.0f) * me->accel.scale_factor);
-  me->accel.scaled_data.z = ((me->accel.raw_data.z + 0.0f) * me->accel.scale_factor);
+  me->accel.unit_data.x = MPU9250_RAW_TO_UNIT(me->accel.raw_data.x, me->accel.range);
+  me->accel.unit_data.y = MPU9250_RAW_TO_UNIT(me->accel.raw_data.y, me->accel.range);
+  me->accel.unit_data.z = MPU9250_RAW_TO_UNIT(me->accel.raw_data.z, me->accel.range);
 
   return BS_OK;
 }
@@ -210,23 +259,22 @@ base_status_t mpu9250_get_accel_calib_data(mpu9250_t *me)
 {
   CHECK_STATUS(mpu9250_get_accel_scale_data(me));
 
-  me->accel.calib_data.x = me->accel.scaled_data.x - me->bias.x;
-  me->accel.calib_data.y = me->accel.scaled_data.y - me->bias.y;
-  me->accel.calib_data.z = me->accel.scaled_data.z - me->bias.z;
+  me->accel.calib_data.x = me->accel.unit_data.x - me->bias.x;
+  me->accel.calib_data.y = me->accel.unit_data.y - me->bias.y;
+  me->accel.calib_data.z = me->accel.unit_data.z - me->bias.z;
 
   return BS_OK;
 }
 
 base_status_t mpu9250_get_mag_raw_data(mpu9250_t *me)
 {
-  uint8_t status;
-  uint8_t buffer[6];
+  uint8_t buffer[AK8963_DATA_SIZE];
+
+  CHECK(me->mag.enabled, BS_ERROR);
 
-  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_ACCEL_XOUT_H, buffer, 6));
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_EXT_SENS_DATA_00, buffer, AK8963_DATA_SIZE));
 
-  me->mag.raw_data.x = ((buffer[0] << 8) + buffer[1]);
-  me->mag.raw_data.y = ((buffer[2] << 8) + buffer[3]);
-  me->mag.raw_data.z = ((buffer[4] << 8) + buffer[5]);
+  m_mpu9250_mag_parse(me, buffer);
 
   return BS_OK;
 }
@@ -236,7 +284,7 @@ base_status_t mpu9250_get_gyro_raw_data(mpu9250_t *me)
   uint8_t status;
   uint8_t buffer[6];
 
-  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_INT_STATUS, &status, 1));
+  CHECK_STATUS(m_mpu9250_int_status_read(me, &status));
 
   CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_GYRO_XOUT_H, buffer, 6));
 
@@ -251,18 +299,263 @@ base_status_t mpu9250_get_gyro_scale_data(mpu9250_t *me)
 {
   CHECK_STATUS(mpu9250_get_gyro_raw_data(me));
 
-  me->gyro.scaled_data.x = me->gyro.raw_data.x * me->gyro.scale_factor;
-  me->gyro.scaled_data.y = me->gyro.raw_data.y * me->gyro.scale_factor;
-  me->gyro.scaled_data.z = me->gyro.raw_data.z * me->gyro.scale_factor;
+  me->gyro.unit_data.x = MPU9250_RAW_TO_UNIT(me->gyro.raw_data.x, me->gyro.range);
+  me->gyro.unit_data.y = MPU9250_RAW_TO_UNIT(me->gyro.raw_data.y, me->gyro.range);
+  me->gyro.unit_data.z = MPU9250_RAW_TO_UNIT(me->gyro.raw_data.z, me->gyro.range);
 
   return BS_OK;
 }
 
-base_status_t mpu9250_accel_calib(mpu9250_t *me, float x_min, float x_max, float y_min, float y_max, float z_min, float z_max)
+base_status_t mpu9250_get_motion6(mpu9250_t *me)
 {
-  me->bias.x = (x_max + x_min) / 2.0f;
-  me->bias.y = (y_max + y_min) / 2.0f;
-  me->bias.z = (z_max + z_min) / 2.0f;
+  uint8_t buffer[MPU9250_MOTION9_SIZE];
+
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_ACCEL_XOUT_H, buffer, mpu9250_motion_size(me)));
+
+  m_mpu9250_motion6_parse(me, buffer);
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_get_accel_raw_data_async(mpu9250_t *me, mpu9250_callback_t callback, void *p_context)
+{
+  return m_mpu9250_request_start(me, &me->accel_request, MPU9250_REG_ACCEL_XOUT_H, me->accel_request.buffer, 6,
+                                 m_mpu9250_accel_done, callback, p_context);
+}
+
+base_status_t mpu9250_get_motion6_async(mpu9250_t *me, mpu9250_callback_t callback, void *p_context)
+{
+  return m_mpu9250_request_start(me, &me->motion6_request, MPU9250_REG_ACCEL_XOUT_H, me->motion6_request.buffer,
+                                 mpu9250_motion_size(me), m_mpu9250_motion6_done, callback, p_context);
+}
+
+base_status_t mpu9250_accel_calib(mpu9250_t *me, int32_t x_min, int32_t x_max, int32_t y_min, int32_t y_max, int32_t z_min, int32_t z_max)
+{
+  me->bias.x = (x_max + x_min) / 2;
+  me->bias.y = (y_max + y_min) / 2;
+  me->bias.z = (z_max + z_min) / 2;
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_set_interrupt(mpu9250_t *me, uint8_t int_enable)
+{
+  uint8_t value = 0x00;
+
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_INT_PIN_CFG, &value, 1));
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_INT_ENABLE, &int_enable, 1));
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_fifo_enable(mpu9250_t *me, bool enable)
+{
+  uint8_t value;
+
+  // Stop writing into the FIFO
+  value = 0x00;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_FIFO_EN, &value, 1));
+
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_CONFIG, &value, 1));
+  value |= MPU9250_CONFIG_FIFO_MODE;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_CONFIG, &value, 1));
+
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+  value &= ~MPU9250_USER_CTRL_FIFO_EN;
+  if (enable)
+    value |= MPU9250_USER_CTRL_FIFO_EN;
+  me->fifo.user_ctrl = value;
+
+  value |= (enable) ? MPU9250_USER_CTRL_FIFO_RST : 0;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+
+  // The AK8963 data follows the gyro in each frame
+  me->fifo.frame_size = (me->mag.enabled) ? MPU9250_FIFO_FRAME_MAG_SIZE : MPU9250_FIFO_FRAME_SIZE;
+
+  if (enable)
+  {
+    value = MPU9250_FIFO_EN_ACCEL_GYRO | ((me->mag.enabled) ? MPU9250_FIFO_EN_SLV0 : 0);
+    CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_FIFO_EN, &value, 1));
+  }
+
+  me->fifo.enabled          = enable;
+  me->fifo.overflow_pending = false;
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_fifo_reset(mpu9250_t *me)
+{
+  uint8_t value;
+
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+  me->fifo.user_ctrl = value & ~MPU9250_USER_CTRL_FIFO_RST;
+
+  value |= MPU9250_USER_CTRL_FIFO_RST;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+
+  me->fifo.overflow_pending = false;
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_fifo_read(mpu9250_t *me, mpu9250_fifo_frame_t *p_frames, uint16_t max_frames, uint16_t *p_count)
+{
+  uint8_t  status;
+  uint8_t  buffer[2];
+  uint16_t available;
+  uint16_t frames;
+
+  *p_count = 0;
+
+  CHECK(me->fifo.enabled, BS_ERROR);
+
+  CHECK_STATUS(m_mpu9250_int_status_read(me, &status));
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_FIFO_COUNTH, buffer, 2));
+
+  available  = m_mpu9250_fifo_available(me, status, buffer);
+  max_frames = mpu9250_fifo_capacity(me, max_frames);
+  frames     = (available < max_frames) ? available : max_frames;
+
+  if (frames > 0)
+  {
+    CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_FIFO_R_W, (uint8_t *)p_frames, frames * me->fifo.frame_size));
+    m_mpu9250_fifo_convert(me, p_frames, frames);
+  }
+
+  if (me->fifo.overflow_pending && (frames == available))
+  {
+    CHECK_STATUS(mpu9250_fifo_reset(me));
+    me->fifo.overflow_count++;
+  }
+
+  *p_count = frames;
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_fifo_read_async(mpu9250_t *me, mpu9250_fifo_frame_t *p_frames, uint16_t max_frames,
+                                      mpu9250_callback_t callback, void *p_context)
+{
+  CHECK(me->fifo.enabled, BS_ERROR);
+
+  me->fifo.p_frames   = p_frames;
+  me->fifo.max_frames = mpu9250_fifo_capacity(me, max_frames);
+  me->fifo.count      = 0;
+
+  // INT_STATUS, then FIFO_COUNT, then the frames burst, then the reset on overflow
+  return m_mpu9250_request_start(me, &me->fifo.request, MPU9250_REG_INT_STATUS, &me->fifo.request.buffer[0], 1,
+                                 m_mpu9250_fifo_status_done, callback, p_context);
+}
+
+uint16_t mpu9250_fifo_capacity(mpu9250_t *me, uint16_t max_frames)
+{
+  uint16_t frames = (uint16_t)((max_frames * sizeof(mpu9250_fifo_frame_t)) / me->fifo.frame_size);
+
+  if (frames > max_frames)
+    frames = max_frames;
+
+  if (frames > MPU9250_FIFO_BURST_MAX / me->fifo.frame_size)
+    frames = MPU9250_FIFO_BURST_MAX / me->fifo.frame_size;
+
+  return frames;
+}
+
+uint8_t mpu9250_motion_size(mpu9250_t *me)
+{
+  return (me->mag.enabled) ? MPU9250_MOTION9_SIZE : MPU9250_MOTION6_SIZE;
+}
+
+void mpu9250_motion_to_frame(mpu9250_t *me, const uint8_t *p_buffer, mpu9250_fifo_frame_t *p_frame)
+{
+  p_frame->accel.x = (int16_t)((p_buffer[0] << 8) | p_buffer[1]);
+  p_frame->accel.y = (int16_t)((p_buffer[2] << 8) | p_buffer[3]);
+  p_frame->accel.z = (int16_t)((p_buffer[4] << 8) | p_buffer[5]);
+  p_frame->gyro.x  = (int16_t)((p_buffer[8] << 8) | p_buffer[9]);
+  p_frame->gyro.y  = (int16_t)((p_buffer[10] << 8) | p_buffer[11]);
+  p_frame->gyro.z  = (int16_t)((p_buffer[12] << 8) | p_buffer[13]);
+
+  if (me->mag.enabled)
+    m_mpu9250_mag_parse(me, &p_buffer[MPU9250_MOTION6_SIZE]);
+
+  p_frame->mag = me->mag.raw_data;
+}
+
+base_status_t mpu9250_lp_accel_enter(mpu9250_t *me, mpu9250_lp_accel_odr_t odr, uint16_t wom_threshold_mg)
+{
+  uint8_t value;
+
+  CHECK((odr <= MPU9250_LP_ACCEL_ODR_500_HZ) && (wom_threshold_mg <= MPU9250_WOM_THRESHOLD_MAX_MG), BS_ERROR_PARAMS);
+  CHECK(!me->fifo.enabled, BS_ERROR);
+
+  // Magnetometer off, then its I2C master, nothing has to be read behind the accelerometer
+  if (me->mag.enabled)
+  {
+    CHECK_STATUS(m_ak8963_write_reg(me, AK8963_CNTL, AK8963_CNTL_POWER_DOWN));
+
+    value = 0x00;
+    CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_CTRL, &value, 1));
+
+    CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+    value &= ~MPU9250_USER_CTRL_I2C_MST_EN;
+    CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+
+    me->mag.enabled = false;
+  }
+
+  // Running, accelerometer only
+  value = me->config.clock_source & 0x07;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_PWR_MAGT_1, &value, 1));
+
+  value = MPU9250_PWR_MGMT_2_DIS_G;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_PWR_MGMT_2, &value, 1));
+
+  value = MPU9250_ACCEL_DLPF_184HZ;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_ACCEL_CONFIG_2, &value, 1));
+
+  // Wake on motion
+  CHECK_STATUS(mpu9250_set_interrupt(me, (wom_threshold_mg != 0) ? MPU9250_INT_WOM_EN : 0x00));
+
+  value = MPU9250_MOT_DETECT_INTEL;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_MOT_DETECT_CTRL, &value, 1));
+
+  value = (uint8_t)(wom_threshold_mg / MPU9250_WOM_THR_MG_PER_LSB);
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_WOM_THR, &value, 1));
+
+  value = (uint8_t)odr;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_LP_ACCEL_ODR, &value, 1));
+
+  // Sleep between the accelerometer samples
+  value = (me->config.clock_source & 0x07) | MPU9250_PWR_MGMT_1_CYCLE;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_PWR_MAGT_1, &value, 1));
+
+  me->lp_accel = true;
+
+  return BS_OK;
+}
+
+base_status_t mpu9250_lp_accel_exit(mpu9250_t *me)
+{
+  uint8_t value;
+
+  CHECK(me->lp_accel, BS_ERROR);
+
+  value = me->config.clock_source & 0x07;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_PWR_MAGT_1, &value, 1));
+
+  CHECK_STATUS(mpu9250_set_interrupt(me, 0x00));
+
+  value = 0x00;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_MOT_DETECT_CTRL, &value, 1));
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_ACCEL_CONFIG_2, &value, 1));
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_PWR_MGMT_2, &value, 1));
+
+  me->delay(MPU9250_GYRO_STARTUP_MS);
+
+  me->lp_accel = false;
+
+  if (me->config.mag_enable)
+    CHECK_STATUS(m_mpu9250_mag_config(me));
 
   return BS_OK;
 }
@@ -310,4 +603,480 @@ static base_status_t m_mpu9250_write_reg(mpu9250_t *me, uint8_t reg, uint8_t *p_
   return BS_OK;
 }
 
+/**
+ * @brief         MPU9250 read INT_STATUS, a FIFO overflow is latched before the read clears it
+ *
+ * @param[in]     me        Pointer to handle of MPU9250 module.
+ * @param[out]    p_status  Pointer to INT_STATUS
+ *
+ * @attention     Every INT_STATUS read goes through here, otherwise a data read between two
+ *                drains would lose the FIFO_OFLOW flag
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_mpu9250_int_status_read(mpu9250_t *me, uint8_t *p_status)
+{
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_INT_STATUS, p_status, 1));
+
+  if (me->fifo.enabled && (*p_status & MPU9250_INT_STATUS_FIFO_OFLOW))
+    me->fifo.overflow_pending = true;
+
+  return BS_OK;
+}
+
+/**
+ * @brief         MPU9250 start an asynchronous request with a register read
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     p_request   Pointer to request
+ * @param[in]     reg         Register
+ * @param[in]     p_data      Pointer to handle of data
+ * @param[in]     len         Data length
+ * @param[in]     done        Driver completion of the read
+ * @param[in]     callback    User completion callback
+ * @param[in]     p_context   User callback context
+ *
+ * @attention     The driver completion receives me as context
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_mpu9250_request_start(mpu9250_t *me, mpu9250_request_t *p_request, uint8_t reg, uint8_t *p_data,
+                                             uint32_t len, bsp_i2c_callback_t done, mpu9250_callback_t callback, void *p_context)
+{
+  CHECK(me->i2c_read_async != NULL, BS_ERROR);
+
+  if (p_request->busy)
+    return BS_ERROR;
+
+  p_request->busy      = true;
+  p_request->callback  = callback;
+  p_request->p_context = p_context;
+
+  if (me->i2c_read_async(me->device_address, reg, p_data, len, done, me) != BS_OK)
+  {
+    p_request->busy = false;
+    return BS_ERROR;
+  }
+
+  return BS_OK;
+}
+
+/**
+ * @brief         MPU9250 end an asynchronous request and notify the user
+ *
+ * @param[in]     p_request   Pointer to request
+ * @param[in]     status      Request status
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_mpu9250_request_end(mpu9250_request_t *p_request, base_status_t status)
+{
+  mpu9250_callback_t callback  = p_request->callback;
+  void              *p_context = p_request->p_context;
+
+  p_request->busy = false;
+
+  if (callback != NULL)
+    callback(status, p_context);
+}
+
+/**
+ * @brief         MPU9250 configure the AK8963 behind the internal I2C master
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ *
+ * @attention     The factory sensitivity is read from the fuse ROM, then SLV0 is left reading
+ *                HXL..ST2 into EXT_SENS_DATA_00 at every sample, so the magnetometer comes with
+ *                the accel/gyro burst and the FIFO frames without host transactions
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_mpu9250_mag_config(mpu9250_t *me)
+{
+  uint8_t value;
+  uint8_t asa[3];
+
+  // I2C master at 400 kHz, INT_PIN_CFG keeps the bypass off
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+  value |= MPU9250_USER_CTRL_I2C_MST_EN;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_USER_CNT, &value, 1));
+
+  value = MPU9250_I2C_MST_WAIT_FOR_ES | MPU9250_I2C_MST_CLK_400K;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_MST_CTRL, &value, 1));
+
+  CHECK_STATUS(m_ak8963_read_reg(me, AK8963_WIA, &value, 1));
+  CHECK(AK8963_DEVICE_ID == value, BS_ERROR);
+
+  // Sensitivity adjustment, Hadj = H * (ASA + 128) / 256
+  CHECK_STATUS(m_ak8963_write_reg(me, AK8963_CNTL, AK8963_CNTL_POWER_DOWN));
+  CHECK_STATUS(m_ak8963_write_reg(me, AK8963_CNTL, AK8963_CNTL_FUSE_ROM));
+  CHECK_STATUS(m_ak8963_read_reg(me, AK8963_ASAX, asa, 3));
+  CHECK_STATUS(m_ak8963_write_reg(me, AK8963_CNTL, AK8963_CNTL_POWER_DOWN));
+
+  for (uint8_t i = 0; i < 3; i++)
+    me->mag.asa_q8[i] = asa[i] + 128;
+
+  CHECK_STATUS(m_ak8963_write_reg(me, AK8963_CNTL, AK8963_CNTL_CONT_100HZ_16BIT));
+
+  // Auto-read, reading ST2 also releases the next measurement
+  value = AK8963_I2C_ADDR | MPU9250_I2C_SLV_READ;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_ADDR, &value, 1));
+  value = AK8963_HXL;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_REG, &value, 1));
+  value = MPU9250_I2C_SLV_EN | AK8963_DATA_SIZE;
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_CTRL, &value, 1));
+
+  me->mag.enabled = true;
+
+  return BS_OK;
+}
+
+/**
+ * @brief         AK8963 write a register through SLV0
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     reg         AK8963 register
+ * @param[in]     value       Value
+ *
+ * @attention     The write is done by the I2C master on the next samples
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_ak8963_write_reg(mpu9250_t *me, uint8_t reg, uint8_t value)
+{
+  uint8_t slv0[3] = { AK8963_I2C_ADDR, reg, MPU9250_I2C_SLV_EN | 1 };
+
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_DO, &value, 1));
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_ADDR, slv0, 3));
+
+  me->delay(10);
+
+  return BS_OK;
+}
+
+/**
+ * @brief         AK8963 read registers through SLV0
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     reg         AK8963 register
+ * @param[out]    p_data      Pointer to data
+ * @param[in]     len         Data length, at most AK8963_DATA_SIZE
+ *
+ * @attention     The data is taken from EXT_SENS_DATA_00 after the I2C master read it
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_ak8963_read_reg(mpu9250_t *me, uint8_t reg, uint8_t *p_data, uint8_t len)
+{
+  uint8_t slv0[3] = { AK8963_I2C_ADDR | MPU9250_I2C_SLV_READ, reg, MPU9250_I2C_SLV_EN | len };
+
+  CHECK_STATUS(m_mpu9250_write_reg(me, MPU9250_REG_I2C_SLV0_ADDR, slv0, 3));
+
+  me->delay(10);
+
+  CHECK_STATUS(m_mpu9250_read_reg(me, MPU9250_REG_EXT_SENS_DATA_00, p_data, len));
+
+  return BS_OK;
+}
+
+/**
+ * @brief         MPU9250 parse the AK8963 data of EXT_SENS_DATA
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     p_ext       HXL..HZH, ST2
+ *
+ * @attention     The sample is dropped on magnetic sensor overflow, the previous one is kept
+ *
+ * @return        None
+ */
+static void m_mpu9250_mag_parse(mpu9250_t *me, const uint8_t *p_ext)
+{
+  int16_t *p_raw = (int16_t *)&me->mag.raw_data;
+
+  if (p_ext[6] & AK8963_ST2_HOFL)
+    return;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int16_t h = (int16_t)((p_ext[2 * i + 1] << 8) | p_ext[2 * i]);
+
+    p_raw[i] = (int16_t)(((int32_t)h * me->mag.asa_q8[i]) >> 8);
+  }
+
+  me->mag.unit_data.x = (int32_t)me->mag.raw_data.x * MPU9250_MAG_NT_PER_LSB;
+  me->mag.unit_data.y = (int32_t)me->mag.raw_data.y * MPU9250_MAG_NT_PER_LSB;
+  me->mag.unit_data.z = (int32_t)me->mag.raw_data.z * MPU9250_MAG_NT_PER_LSB;
+}
+
+/**
+ * @brief         MPU9250 parse a motion6 burst
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     p_buffer    ACCEL_XOUT_H to GYRO_ZOUT_L, then HXL..ST2 with the magnetometer
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_mpu9250_motion6_parse(mpu9250_t *me, const uint8_t *p_buffer)
+{
+  me->accel.raw_data.x = ((p_buffer[0] << 8) + p_buffer[1]);
+  me->accel.raw_data.y = ((p_buffer[2] << 8) + p_buffer[3]);
+  me->accel.raw_data.z = ((p_buffer[4] << 8) + p_buffer[5]);
+  me->temp.raw_data    = ((p_buffer[6] << 8) + p_buffer[7]);
+  me->gyro.raw_data.x  = ((p_buffer[8] << 8) + p_buffer[9]);
+  me->gyro.raw_data.y  = ((p_buffer[10] << 8) + p_buffer[11]);
+  me->gyro.raw_data.z  = ((p_buffer[12] << 8) + p_buffer[13]);
+
+  me->accel.unit_data.x = MPU9250_RAW_TO_UNIT(me->accel.raw_data.x, me->accel.range);
+  me->accel.unit_data.y = MPU9250_RAW_TO_UNIT(me->accel.raw_data.y, me->accel.range);
+  me->accel.unit_data.z = MPU9250_RAW_TO_UNIT(me->accel.raw_data.z, me->accel.range);
+
+  me->temp.centi_celsius = (int16_t)(((me->temp.raw_data * MPU9250_TEMP_CDEG_Q15) >> 15) + MPU9250_TEMP_OFFSET_CDEG);
+
+  me->gyro.unit_data.x = MPU9250_RAW_TO_UNIT(me->gyro.raw_data.x, me->gyro.range);
+  me->gyro.unit_data.y = MPU9250_RAW_TO_UNIT(me->gyro.raw_data.y, me->gyro.range);
+  me->gyro.unit_data.z = MPU9250_RAW_TO_UNIT(me->gyro.raw_data.z, me->gyro.range);
+
+  if (me->mag.enabled)
+    m_mpu9250_mag_parse(me, &p_buffer[MPU9250_MOTION6_SIZE]);
+}
+
+/**
+ * @brief         MPU9250 complete frames in the FIFO, flags a pending overflow
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     status      INT_STATUS
+ * @param[in]     p_count     FIFO_COUNTH, FIFO_COUNTL
+ *
+ * @attention     None
+ *
+ * @return        Complete frames
+ */
+static uint16_t m_mpu9250_fifo_available(mpu9250_t *me, uint8_t status, const uint8_t *p_count)
+{
+  uint16_t fifo_count = ((p_count[0] & 0x1F) << 8) | p_count[1];
+
+  // With FIFO_MODE set a full FIFO may end with a partial frame
+  if ((status & MPU9250_INT_STATUS_FIFO_OFLOW) || (fifo_count > MPU9250_FIFO_SIZE - me->fifo.frame_size))
+    me->fifo.overflow_pending = true;
+
+  return fifo_count / me->fifo.frame_size;
+}
+
+/**
+ * @brief         MPU9250 convert packed raw FIFO frames to host order frames, in place
+ *
+ * @param[in]     me          Pointer to handle of MPU9250 module.
+ * @param[in]     p_frames    Pointer to frames
+ * @param[in]     frames      Frames
+ *
+ * @attention     Raw frames shorter than the structure are converted from the last one,
+ *                longer ones from the first, so no raw frame is overwritten before it is read
+ *
+ * @return        None
+ */
+static void m_mpu9250_fifo_convert(mpu9250_t *me, mpu9250_fifo_frame_t *p_frames, uint16_t frames)
+{
+  const uint8_t *p_raw      = (const uint8_t *)p_frames;
+  uint8_t        frame_size = me->fifo.frame_size;
+  bool           backward   = (frame_size < sizeof(mpu9250_fifo_frame_t));
+  uint8_t        raw[MPU9250_FIFO_FRAME_MAG_SIZE];
+
+  for (uint16_t n = 0; n < frames; n++)
+  {
+    uint16_t i = (backward) ? (frames - 1 - n) : n;
+
+    memcpy(raw, &p_raw[i * frame_size], frame_size);
+
+    p_frames[i].accel.x = (int16_t)((raw[0] << 8) | raw[1]);
+    p_frames[i].accel.y = (int16_t)((raw[2] << 8) | raw[3]);
+    p_frames[i].accel.z = (int16_t)((raw[4] << 8) | raw[5]);
+    p_frames[i].gyro.x  = (int16_t)((raw[6] << 8) | raw[7]);
+    p_frames[i].gyro.y  = (int16_t)((raw[8] << 8) | raw[9]);
+    p_frames[i].gyro.z  = (int16_t)((raw[10] << 8) | raw[11]);
+
+    if (me->mag.enabled)
+      m_mpu9250_mag_parse(me, &raw[MPU9250_FIFO_FRAME_SIZE]);
+
+    p_frames[i].mag = me->mag.raw_data;
+  }
+}
+
+/**
+ * @brief         MPU9250 accel read completion
+ *
+ * @param[in]     status      I2C status
+ * @param[in]     p_context   Pointer to handle of MPU9250 module.
+ *
+ * @attention     I2C interrupt context
+ *
+ * @return        None
+ */
+static void m_mpu9250_accel_done(base_status_t status, void *p_context)
+{
+  mpu9250_t     *me       = (mpu9250_t *)p_context;
+  const uint8_t *p_buffer = me->accel_request.buffer;
+
+  if (status == BS_OK)
+  {
+    me->accel.raw_data.x = ((p_buffer[0] << 8) + p_buffer[1]);
+    me->accel.raw_data.y = ((p_buffer[2] << 8) + p_buffer[3]);
+    me->accel.raw_data.z = ((p_buffer[4] << 8) + p_buffer[5]);
+  }
+
+  m_mpu9250_request_end(&me->accel_request, status);
+}
+
+/**
+ * @brief         MPU9250 motion6 read completion
+ *
+ * @param[in]     status      I2C status
+ * @param[in]     p_context   Pointer to handle of MPU9250 module.
+ *
+ * @attention     I2C interrupt context
+ *
+ * @return        None
+ */
+static void m_mpu9250_motion6_done(base_status_t status, void *p_context)
+{
+  mpu9250_t *me = (mpu9250_t *)p_context;
+
+  if (status == BS_OK)
+    m_mpu9250_motion6_parse(me, me->motion6_request.buffer);
+
+  m_mpu9250_request_end(&me->motion6_request, status);
+}
+
+/**
+ * @brief         MPU9250 FIFO drain, INT_STATUS read completion
+ *
+ * @param[in]     status      I2C status
+ * @param[in]     p_context   Pointer to handle of MPU9250 module.
+ *
+ * @attention     I2C interrupt context
+ *
+ * @return        None
+ */
+static void m_mpu9250_fifo_status_done(base_status_t status, void *p_context)
+{
+  mpu9250_t *me = (mpu9250_t *)p_context;
+
+  if (status == BS_OK)
+    status = me->i2c_read_async(me->device_address, MPU9250_REG_FIFO_COUNTH, &me->fifo.request.buffer[1], 2,
+                                m_mpu9250_fifo_count_done, me);
+
+  if (status != BS_OK)
+    m_mpu9250_request_end(&me->fifo.request, status);
+}
+
+/**
+ * @brief         MPU9250 FIFO drain, FIFO_COUNT read completion
+ *
+ * @param[in]     status      I2C status
+ * @param[in]     p_context   Pointer to handle of MPU9250 module.
+ *
+ * @attention     I2C interrupt context
+ *
+ * @return        None
+ */
+static void m_mpu9250_fifo_count_done(base_status_t status, void *p_context)
+{
+  mpu9250_t *me = (mpu9250_t *)p_context;
+  uint16_t   frames;
+
+  if (status != BS_OK)
+  {
+    m_mpu9250_request_end(&me->fifo.request, status);
+    return;
+  }
+
+  me->fifo.available = m_mpu9250_fifo_available(me, me->fifo.request.buffer[0], &me->fifo.request.buffer[1]);
+  frames             = (me->fifo.available < me->fifo.max_frames) ? me->fifo.available : me->fifo.max_frames;
+  me->fifo.count     = frames;
+
+  if (frames == 0)
+  {
+    m_mpu9250_fifo_frames_done(BS_OK, me);
+    return;
+  }
+
+  status = me->i2c_read_async(me->device_address, MPU9250_REG_FIFO_R_W, (uint8_t *)me->fifo.p_frames,
+                              frames * me->fifo.frame_size, m_mpu9250_fifo_frames_done, me);
+  if (status != BS_OK)
+  {
+    me->fifo.count = 0;
+    m_mpu9250_request_end(&me->fifo.request, status);
+  }
+}
+
+/**
+ * @brief         MPU9250 FIFO drain, frames burst completion
+ *
+ * @param[in]     status      I2C status
+ * @param[in]     p_context   Pointer to handle of MPU9250 module.
+ *
+ * @attention     I2C interrupt context
+ *
+ * @return        None
+ */
+static void m_mpu9250_fifo_frames_done(base_status_t status, void *p_context)
+{
+  mpu9250_t *me = (mpu9250_t *)p_context;
+  uint8_t    value;
+
+  if (status != BS_OK)
+  {
+    me->fifo.count = 0;
+    m_mpu9250_request_end(&me->fifo.request, status);
+    return;
+  }
+
+  m_mpu9250_fifo_convert(me, me->fifo.p_frames, me->fifo.count);
+
+  if (me->fifo.overflow_pending && (me->fifo.count == me->fifo.available) && (me->i2c_write_async != NULL))
+  {
+    value = me->fifo.user_ctrl | MPU9250_USER_CTRL_FIFO_RST;
+    if (me->i2c_write_async(me->device_address, MPU9250_REG_USER_CNT, &value, 1, m_mpu9250_fifo_reset_done, me) == BS_OK)
+      return;
+  }
+
+  m_mpu9250_request_end(&me->fifo.request, BS_OK);
+}
+
+/**
+ * @brief         MPU9250 FIFO drain, overflow reset completion
+ *
+ * @param[in]     status      I2C status
+ * @param[in]     p_context   Pointer to handle of MPU9250 module.
+ *
+ * @attention     I2C interrupt context, the frames read are kept even if the reset failed
+ *
+ * @return        None
+ */
+static void m_mpu9250_fifo_reset_done(base_status_t status, void *p_context)
+{
+  mpu9250_t *me = (mpu9250_t *)p_context;
+
+  if (status == BS_OK)
+  {
+    me->fifo.overflow_pending = false;
+    me->fifo.overflow_count++;
+  }
+
+  m_mpu9250_request_end(&me->fifo.request, BS_OK);
+}
+
 /* End of file -------------------------------------------------------- */
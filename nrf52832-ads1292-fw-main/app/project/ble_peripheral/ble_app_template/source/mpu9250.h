@@ -24,6 +24,25 @@ extern "C" {
 /* Public defines ----------------------------------------------------- */
 #define MPU9250_I2C_ADDR                  (0x68) // 7 Bits
 
+#define MPU9250_FIFO_SIZE                 (512)  // Bytes
+#define MPU9250_FIFO_FRAME_SIZE           (12)   // Accel XYZ + gyro XYZ, big endian
+#define MPU9250_FIFO_FRAME_MAG_SIZE       (19)   // FIFO frame + AK8963 HXL..ST2, little endian
+#define MPU9250_FIFO_BURST_MAX            (255)  // Bytes of one FIFO_R_W burst (TWI length is 8 bits)
+#define MPU9250_MOTION6_SIZE              (14)   // ACCEL_XOUT_H to GYRO_ZOUT_L
+#define MPU9250_MOTION9_SIZE              (21)   // Motion6 + EXT_SENS_DATA_00..06 (AK8963 HXL..ST2)
+#define MPU9250_MOTION6_REG               (0x3B) // ACCEL_XOUT_H, start of the motion6 burst
+
+#define MPU9250_ACCEL_RANGE_MG(fs)        (2000L << (fs))    // Full-scale range of a mpu9250_accel_full_scale_t (mg)
+#define MPU9250_GYRO_RANGE_MDPS(fs)       (250000L << (fs))  // Full-scale range of a mpu9250_gyro_full_scale_t (mdps)
+#define MPU9250_MAG_NT_PER_LSB            (150)              // AK8963 16-bit output (nT)
+#define MPU9250_RAW_TO_UNIT(raw, range)   ((int32_t)(((int64_t)(raw) * (range)) >> 15))
+
+#define MPU9250_INT_RAW_RDY_EN            (0x01) // INT_ENABLE, raw sensor data ready
+#define MPU9250_INT_FIFO_OFLOW_EN         (0x10) // INT_ENABLE, FIFO overflow
+#define MPU9250_INT_WOM_EN                (0x40) // INT_ENABLE, wake on motion
+
+#define MPU9250_WOM_THRESHOLD_MAX_MG      (1020) // WOM_THR is 8 bits of 4 mg
+
 /* Public enumerate/structure ----------------------------------------- */
 /**
  * @brief MPU9250 clock source enum
@@ -80,6 +99,26 @@ typedef enum
 }
 mpu9250_digi_low_pass_filter_t;
 
+/**
+ * @brief MPU9250 low-power accelerometer output data rate enum
+ */
+typedef enum
+{
+   MPU9250_LP_ACCEL_ODR_0_24_HZ  = 0x00
+  ,MPU9250_LP_ACCEL_ODR_0_49_HZ  = 0x01
+  ,MPU9250_LP_ACCEL_ODR_0_98_HZ  = 0x02
+  ,MPU9250_LP_ACCEL_ODR_1_95_HZ  = 0x03
+  ,MPU9250_LP_ACCEL_ODR_3_91_HZ  = 0x04
+  ,MPU9250_LP_ACCEL_ODR_7_81_HZ  = 0x05
+  ,MPU9250_LP_ACCEL_ODR_15_63_HZ = 0x06
+  ,MPU9250_LP_ACCEL_ODR_31_25_HZ = 0x07
+  ,MPU9250_LP_ACCEL_ODR_62_50_HZ = 0x08
+  ,MPU9250_LP_ACCEL_ODR_125_HZ   = 0x09
+  ,MPU9250_LP_ACCEL_ODR_250_HZ   = 0x0A
+  ,MPU9250_LP_ACCEL_ODR_500_HZ   = 0x0B
+}
+mpu9250_lp_accel_odr_t;
+
 /**
  * @brief MPU9250 external frame sysnchronization enum
  */
@@ -106,6 +145,7 @@ typedef struct
   mpu9250_accel_full_scale_t accel_full_scale;
   mpu9250_digi_low_pass_filter_t digi_low_pass_filter;
   bool sleep_mode_bit;
+  bool mag_enable;          // AK8963 read by the I2C master (SLV0) every sample
 }
 mpu9250_config_t;
 
@@ -121,15 +161,43 @@ typedef struct
 mpu9250_raw_data_t;
 
 /**
- * @brief MPU9250 scaled data structure
+ * @brief MPU9250 unit data structure (mg, mdps or nT)
+ */
+typedef struct
+{
+  int32_t x;
+  int32_t y;
+  int32_t z;
+}
+mpu9250_unit_data_t;
+
+/**
+ * @brief MPU9250 FIFO frame structure, host order
+ */
+typedef struct
+{
+  mpu9250_raw_data_t accel;
+  mpu9250_raw_data_t gyro;
+  mpu9250_raw_data_t mag;       // Sensitivity adjusted, last valid sample (0 without magnetometer)
+}
+mpu9250_fifo_frame_t;
+
+/**
+ * @brief MPU9250 asynchronous completion callback type
+ */
+typedef void (*mpu9250_callback_t)(base_status_t status, void *p_context);
+
+/**
+ * @brief MPU9250 asynchronous request structure
  */
 typedef struct
 {
-  float x;
-  float y;
-  float z;
+  uint8_t buffer[MPU9250_MOTION9_SIZE];
+  mpu9250_callback_t callback;
+  void *p_context;
+  volatile bool busy;
 }
-mpu9250_scaled_data_t;
+mpu9250_request_t;
 
 /**
  * @brief MPU9250 sensor struct
@@ -138,19 +206,19 @@ typedef struct
 {
   uint8_t  device_address;  // I2C device address
   mpu9250_config_t config;
-  mpu9250_scaled_data_t scaled_data;
   mpu9250_raw_data_t raw_data;
-  mpu9250_scaled_data_t bias;
+  mpu9250_unit_data_t bias;           // mg
+  bool lp_accel;                      // Accelerometer-only duty cycling, gyro and magnetometer off
 
 /**
  * @brief Accel structure
  */
   struct
   {
-    mpu9250_scaled_data_t scaled_data;
-    mpu9250_scaled_data_t calib_data;
+    mpu9250_unit_data_t unit_data;      // mg
+    mpu9250_unit_data_t calib_data;     // mg
     mpu9250_raw_data_t raw_data;
-    float scale_factor;
+    int32_t range;                      // Full-scale range (mg)
   }
   accel;
 
@@ -159,9 +227,10 @@ typedef struct
  */
   struct
   {
-    mpu9250_scaled_data_t scaled_data;
-    mpu9250_raw_data_t raw_data;
-    float scale_factor;
+    mpu9250_unit_data_t unit_data;      // nT
+    mpu9250_raw_data_t raw_data;        // Sensitivity adjusted
+    bool enabled;
+    uint16_t asa_q8[3];                 // ASA + 128, sensitivity adjustment in Q8
   }
   mag;
 
@@ -170,18 +239,59 @@ typedef struct
  */
   struct
   {
-    mpu9250_scaled_data_t scaled_data;
+    mpu9250_unit_data_t unit_data;      // mdps
     mpu9250_raw_data_t raw_data;
-    float scale_factor;
+    int32_t range;                      // Full-scale range (mdps)
   }
   gyro;
 
+/**
+ * @brief Temperature structure
+ */
+  struct
+  {
+    int16_t centi_celsius;              // 0.01 degree Celsius
+    int16_t raw_data;
+  }
+  temp;
+
+/**
+ * @brief FIFO structure
+ */
+  struct
+  {
+    bool enabled;
+    bool overflow_pending;    // Overflow seen, FIFO is reset once the complete frames are drained
+    uint32_t overflow_count;  // FIFO resets due to overflow
+    uint8_t user_ctrl;        // USER_CTRL value, used for the asynchronous reset
+    uint8_t frame_size;       // Bytes per FIFO frame
+
+    // Asynchronous drain
+    mpu9250_request_t request;
+    mpu9250_fifo_frame_t *p_frames;
+    uint16_t max_frames;
+    uint16_t available;
+    uint16_t count;           // Frames read by the last drain
+  }
+  fifo;
+
+  mpu9250_request_t accel_request;
+  mpu9250_request_t motion6_request;
+
   // Read n-bytes from device's internal address <reg_addr> via I2C bus
   int (*i2c_read) (uint8_t slave_addr, uint8_t reg_addr, uint8_t *data, uint32_t len);
 
   // Write n-bytes from device's internal address <reg_addr> via I2C bus
   int (*i2c_write) (uint8_t slave_addr, uint8_t reg_addr, uint8_t *data, uint32_t len);
 
+  // Queue a read of n-bytes from <reg_addr>, callback on completion (optional)
+  base_status_t (*i2c_read_async) (uint8_t slave_addr, uint8_t reg_addr, uint8_t *data, uint32_t len,
+                                   bsp_i2c_callback_t callback, void *p_context);
+
+  // Queue a write of n-bytes to <reg_addr>, callback on completion (optional)
+  base_status_t (*i2c_write_async) (uint8_t slave_addr, uint8_t reg_addr, uint8_t *data, uint32_t len,
+                                    bsp_i2c_callback_t callback, void *p_context);
+
   // Delay
   void (*delay) (uint32_t ms);
 }
@@ -286,7 +396,7 @@ base_status_t mpu9250_set_external_frame_sync(mpu9250_t *me, mpu9250_ext_frame_t
 base_status_t mpu9250_get_accel_raw_data(mpu9250_t *me);
 
 /**
- * @brief         MPU9250 get accel scaled data (g unit of gravity, 1g = 9.81m/s2)
+ * @brief         MPU9250 get accel data in mg (1g = 9.81m/s2)
  *
  * @param[in]     me            Pointer to handle of MPU9250 module.
  *
@@ -299,7 +409,7 @@ base_status_t mpu9250_get_accel_raw_data(mpu9250_t *me);
 base_status_t mpu9250_get_accel_scale_data(mpu9250_t *me);
 
 /**
- * @brief         MPU9250 get accel calibrated data
+ * @brief         MPU9250 get accel calibrated data (mg)
  *
  * @param[in]     me            Pointer to handle of MPU9250 module.
  *
@@ -311,6 +421,20 @@ base_status_t mpu9250_get_accel_scale_data(mpu9250_t *me);
  */
 base_status_t mpu9250_get_accel_calib_data(mpu9250_t *me);
 
+/**
+ * @brief         MPU9250 get mag raw data
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ *
+ * @attention     Taken from EXT_SENS_DATA, filled by the I2C master every sample.
+ *                The previous value is kept on magnetic sensor overflow.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Magnetometer not enabled
+ */
+base_status_t mpu9250_get_mag_raw_data(mpu9250_t *me);
+
 /**
  * @brief         MPU9250 get gyro raw data
  *
@@ -325,7 +449,7 @@ base_status_t mpu9250_get_accel_calib_data(mpu9250_t *me);
 base_status_t mpu9250_get_gyro_raw_data(mpu9250_t *me);
 
 /**
- * @brief         MPU9250 get gyro scaled data
+ * @brief         MPU9250 get gyro data in mdps
  *
  * @param[in]     me            Pointer to handle of MPU9250 module.
  *
@@ -337,24 +461,217 @@ base_status_t mpu9250_get_gyro_raw_data(mpu9250_t *me);
  */
 base_status_t mpu9250_get_gyro_scale_data(mpu9250_t *me);
 
+/**
+ * @brief         MPU9250 get accel, temperature and gyro raw and unit data
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ *
+ * @attention     ACCEL_XOUT_H to GYRO_ZOUT_L are read in one 14-byte burst, so accel and gyro
+ *                come from the same sample instant. With the magnetometer the burst continues
+ *                into EXT_SENS_DATA (21 bytes) and updates mag as well.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t mpu9250_get_motion6(mpu9250_t *me);
+
+/**
+ * @brief         MPU9250 queue an accel raw data read
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[in]     callback      Completion callback (may be NULL)
+ * @param[in]     p_context     Callback context
+ *
+ * @attention     accel.raw_data is updated from the I2C completion
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Request in progress or queue full
+ */
+base_status_t mpu9250_get_accel_raw_data_async(mpu9250_t *me, mpu9250_callback_t callback, void *p_context);
+
+/**
+ * @brief         MPU9250 queue a 14-byte accel, temperature and gyro read
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[in]     callback      Completion callback (may be NULL)
+ * @param[in]     p_context     Callback context
+ *
+ * @attention     Raw and unit data are updated from the I2C completion
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Request in progress or queue full
+ */
+base_status_t mpu9250_get_motion6_async(mpu9250_t *me, mpu9250_callback_t callback, void *p_context);
+
 /**
  * @brief         MPU9250 accel calib
  *
  * @param[in]     me            Pointer to handle of MPU9250 module.
- * @param[in]     x_min         Variable x_min
- * @param[in]     x_max         Variable x_max
- * @param[in]     y_min         Variable y_min
- * @param[in]     y_max         Variable y_max
- * @param[in]     z_min         Variable z_min
- * @param[in]     z_max         Variable z_max
+ * @param[in]     x_min         Variable x_min (mg)
+ * @param[in]     x_max         Variable x_max (mg)
+ * @param[in]     y_min         Variable y_min (mg)
+ * @param[in]     y_max         Variable y_max (mg)
+ * @param[in]     z_min         Variable z_min (mg)
+ * @param[in]     z_max         Variable z_max (mg)
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t mpu9250_accel_calib(mpu9250_t *me, int32_t x_min, int32_t x_max, int32_t y_min, int32_t y_max, int32_t z_min, int32_t z_max);
+
+/**
+ * @brief         MPU9250 set the interrupt sources of the INT pin
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[in]     int_enable    MPU9250_INT_xxx_EN bits
+ *
+ * @attention     INT pin is active high, push-pull, 50 us pulse
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t mpu9250_set_interrupt(mpu9250_t *me, uint8_t int_enable);
+
+/**
+ * @brief         MPU9250 enable or disable the accel and gyro FIFO
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[in]     enable        Enable
+ *
+ * @attention     The FIFO is reset and stops accepting data when full, so frames stay aligned
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t mpu9250_fifo_enable(mpu9250_t *me, bool enable);
+
+/**
+ * @brief         MPU9250 reset the FIFO
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t mpu9250_fifo_reset(mpu9250_t *me);
+
+/**
+ * @brief         MPU9250 burst read the complete frames of the FIFO
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[out]    p_frames      Pointer to frames
+ * @param[in]     max_frames    Frames p_frames can hold
+ * @param[out]    p_count       Frames read
+ *
+ * @attention     Frames are read in one I2C transfer, at most mpu9250_fifo_capacity(). On overflow the
+ *                FIFO is reset after the last complete frame is read and fifo.overflow_count is incremented.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t mpu9250_fifo_read(mpu9250_t *me, mpu9250_fifo_frame_t *p_frames, uint16_t max_frames, uint16_t *p_count);
+
+/**
+ * @brief         MPU9250 frames read by one FIFO burst
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[in]     max_frames    Frames the destination can hold
+ *
+ * @attention     Raw frames are read in place, so with the magnetometer (19-byte frames)
+ *                fewer than max_frames fit, and a burst is at most MPU9250_FIFO_BURST_MAX bytes
+ *
+ * @return        Frames
+ */
+uint16_t mpu9250_fifo_capacity(mpu9250_t *me, uint16_t max_frames);
+
+/**
+ * @brief         MPU9250 queue a drain of the complete frames of the FIFO
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[out]    p_frames      Pointer to frames, must stay valid until completion
+ * @param[in]     max_frames    Frames p_frames can hold
+ * @param[in]     callback      Completion callback
+ * @param[in]     p_context     Callback context
+ *
+ * @attention     Same sequence as mpu9250_fifo_read() chained from the I2C completions,
+ *                the frames read are in fifo.count when the callback runs
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       Drain in progress or queue full
+ */
+base_status_t mpu9250_fifo_read_async(mpu9250_t *me, mpu9250_fifo_frame_t *p_frames, uint16_t max_frames,
+                                      mpu9250_callback_t callback, void *p_context);
+
+/**
+ * @brief         MPU9250 burst size of a motion read
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
  *
  * @attention     None
  *
+ * @return        MPU9250_MOTION9_SIZE with the magnetometer, MPU9250_MOTION6_SIZE otherwise
+ */
+uint8_t mpu9250_motion_size(mpu9250_t *me);
+
+/**
+ * @brief         MPU9250 convert a motion burst into a frame
+ *
+ * @param[in]     me            Pointer to handle of MPU9250 module.
+ * @param[in]     p_buffer      mpu9250_motion_size() bytes from ACCEL_XOUT_H, read by another master
+ *                              (e.g. PPI-triggered DMA)
+ * @param[out]    p_frame       Pointer to frame
+ *
+ * @attention     The temperature is dropped, the magnetometer values update me->mag
+ *
+ * @return        None
+ */
+void mpu9250_motion_to_frame(mpu9250_t *me, const uint8_t *p_buffer, mpu9250_fifo_frame_t *p_frame);
+
+/**
+ * @brief         MPU9250 enter the low-power accelerometer mode
+ *
+ * @param[in]     me                Pointer to handle of MPU9250 module.
+ * @param[in]     odr               Accelerometer wake-up rate
+ * @param[in]     wom_threshold_mg  Wake-on-motion threshold (mg), 0 for no interrupt
+ *
+ * @attention     The gyro and the magnetometer are powered down and the accelerometer is
+ *                sampled at odr only. With a threshold the INT pin pulses when an axis changed
+ *                by more than it since the previous sample, all other interrupt sources are
+ *                turned off. The FIFO must be stopped before.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ * - BS_ERROR
+ */
+base_status_t mpu9250_lp_accel_enter(mpu9250_t *me, mpu9250_lp_accel_odr_t odr, uint16_t wom_threshold_mg);
+
+/**
+ * @brief         MPU9250 leave the low-power accelerometer mode
+ *
+ * @param[in]     me                Pointer to handle of MPU9250 module.
+ *
+ * @attention     The gyro start-up and, when configured, the magnetometer setup take about 100 ms.
+ *                The interrupts are off afterwards.
+ *
  * @return
  * - BS_OK
  * - BS_ERROR
  */
-base_status_t mpu9250_accel_calib(mpu9250_t *me, float x_min, float x_max, float y_min, float y_max, float z_min, float z_max);
+base_status_t mpu9250_lp_accel_exit(mpu9250_t *me);
 
 /* -------------------------------------------------------------------------- */
 #ifdef __cplusplus
@@ -0,0 +1,142 @@
+/**
+ * @file       sys_ctrl.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Control point command set
+ * @note       None
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "sys_ctrl.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+/* Private function prototypes ---------------------------------------- */
+/* Function definitions ----------------------------------------------- */
+base_status_t sys_ctrl_cmd_decode(const uint8_t *p_buf, uint16_t len, sys_ctrl_cmd_t *p_cmd)
+{
+  CHECK(len >= 1, BS_ERROR_PARAMS);
+
+  memset(p_cmd, 0, sizeof(*p_cmd));
+  p_cmd->opcode = p_buf[0];
+
+  // Parameters only
+  p_buf++;
+  len--;
+
+  switch (p_cmd->opcode)
+  {
+  case SYS_CTRL_OP_STATUS_GET:
+  case SYS_CTRL_OP_PIPELINE_GET:
+    CHECK(len == 0, BS_ERROR_PARAMS);
+    break;
+
+  case SYS_CTRL_OP_STREAMS_SET:
+    CHECK(len == 1, BS_ERROR_PARAMS);
+    p_cmd->params.streams = p_buf[0];
+    break;
+
+  case SYS_CTRL_OP_WAVE_CONFIG:
+    CHECK_STATUS(wave_stream_config_decode(p_buf, len, &p_cmd->params.wave_config));
+    break;
+
+  case SYS_CTRL_OP_PIPELINE_SET:
+    CHECK(len <= DSP_PIPELINE_MAX_STAGES, BS_ERROR_PARAMS);
+    p_cmd->params.pipeline.count = (uint8_t)len;
+    memcpy(p_cmd->params.pipeline.ids, p_buf, len);
+    break;
+
+  case SYS_CTRL_OP_RESP_SOURCE:
+    CHECK(len == 1, BS_ERROR_PARAMS);
+    p_cmd->params.resp_source = p_buf[0];
+    break;
+
+  case SYS_CTRL_OP_MOTION_RATE:
+    CHECK(len == 2, BS_ERROR_PARAMS);
+    p_cmd->params.motion_rate = uint16_decode(p_buf);
+    break;
+
+  case SYS_CTRL_OP_SENSORS_PERIOD:
+    CHECK(len == 2, BS_ERROR_PARAMS);
+    p_cmd->params.sensors_period = uint16_decode(p_buf);
+    break;
+
+  case SYS_CTRL_OP_LINK_PROFILE:
+    CHECK(len == 1, BS_ERROR_PARAMS);
+    p_cmd->params.link_profile = p_buf[0];
+    break;
+
+  case SYS_CTRL_OP_IMU_CALIB:
+    // The duration is only sent for the magnetometer
+    CHECK((len == 1) || (len == 3), BS_ERROR_PARAMS);
+    p_cmd->params.calib.target   = p_buf[0];
+    p_cmd->params.calib.duration = (len == 3) ? uint16_decode(&p_buf[1]) : 0;
+    break;
+
+  case SYS_CTRL_OP_BROADCAST:
+    CHECK(len == 3, BS_ERROR_PARAMS);
+    p_cmd->params.broadcast.connectable = p_buf[0];
+    p_cmd->params.broadcast.period      = uint16_decode(&p_buf[1]);
+    break;
+
+  case SYS_CTRL_OP_REPLAY:
+    CHECK(len == 4, BS_ERROR_PARAMS);
+    p_cmd->params.replay.first = uint16_decode(&p_buf[0]);
+    p_cmd->params.replay.count = uint16_decode(&p_buf[2]);
+    break;
+
+  default:
+    return BS_ERROR;
+  }
+
+  return BS_OK;
+}
+
+uint16_t sys_ctrl_response_encode(uint8_t opcode, sys_ctrl_result_t result, const uint8_t *p_payload, uint8_t len,
+                                  uint8_t *p_buf)
+{
+  uint16_t size = 0;
+
+  p_buf[size++] = SYS_CTRL_OP_RESPONSE;
+  p_buf[size++] = opcode;
+  p_buf[size++] = (uint8_t)result;
+
+  if ((result == SYS_CTRL_RESULT_SUCCESS) && (len != 0))
+  {
+    memcpy(&p_buf[size], p_payload, len);
+    size += len;
+  }
+
+  return size;
+}
+
+uint8_t sys_ctrl_status_encode(const sys_ctrl_status_t *p_status, uint8_t *p_buf)
+{
+  uint8_t len = 0;
+
+  p_buf[len++] = p_status->streams;
+  p_buf[len++] = p_status->streams_allowed;
+  p_buf[len++] = p_status->resp_source;
+  p_buf[len++] = p_status->pm_state;
+  p_buf[len++] = p_status->lead_off ? 1 : 0;
+  p_buf[len++] = p_status->heart_rate;
+  p_buf[len++] = p_status->respiration_rate;
+  p_buf[len++] = p_status->link_profile;
+  len += wave_stream_config_encode(&p_status->wave_config, &p_buf[len]);
+  len += uint16_encode(p_status->motion_rate, &p_buf[len]);
+  len += uint16_encode(p_status->sensors_period, &p_buf[len]);
+  p_buf[len++] = p_status->stage_count;
+
+  return len;
+}
+
+/* End of file -------------------------------------------------------- */
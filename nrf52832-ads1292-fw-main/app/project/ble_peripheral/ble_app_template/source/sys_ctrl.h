@@ -0,0 +1,218 @@
+/**
+ * @file       sys_ctrl.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Control point command set
+ * @note       A command is {opcode (u8), parameters}, little endian. Its response is
+ *             {SYS_CTRL_OP_RESPONSE, opcode (u8), result (u8), payload}.
+ *             Opcode                     Parameters                        Payload
+ *             SYS_CTRL_OP_STATUS_GET     None                              Status, SYS_CTRL_STATUS_SIZE bytes
+ *             SYS_CTRL_OP_STREAMS_SET    Streams of the writer (u8)        None
+ *             SYS_CTRL_OP_WAVE_CONFIG    Wave configuration (3-4 bytes)    None
+ *             SYS_CTRL_OP_PIPELINE_SET   Stage identifiers (u8 each)       None
+ *             SYS_CTRL_OP_PIPELINE_GET   None                              Stage identifiers
+ *             SYS_CTRL_OP_RESP_SOURCE    Respiration rate source (u8)      None
+ *             SYS_CTRL_OP_MOTION_RATE    Motion frame rate in Hz (u16)     None
+ *             SYS_CTRL_OP_SENSORS_PERIOD Measurement period in ms (u16)    None
+ *             SYS_CTRL_OP_LINK_PROFILE   Link profile of the writer (u8)   None
+ *             SYS_CTRL_OP_IMU_CALIB      Target (u8), duration in s (u16)  None
+ *             SYS_CTRL_OP_BROADCAST      Connectable (u8), period in ms    None
+ *                                        of the vitals update (u16)
+ *             SYS_CTRL_OP_REPLAY         First sequence (u16), packets     None
+ *                                        (u16) of the waveform to replay
+ *             The wave configuration and the motion rate are shared by the links, they fail while
+ *             another link streams.
+ *             The status is {streams running (u8), streams allowed (u8), respiration rate source
+ *             (u8), power state (u8), lead off (u8), heart rate (u8), respiration rate (u8), link
+ *             profile of the reader (u8), waveform configuration (4 bytes), motion frame rate (u16),
+ *             measurement period in ms (u16), pipeline stages (u8)}.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __SYS_CTRL_H
+#define __SYS_CTRL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+#include "dsp_pipeline.h"
+#include "wave_stream.h"
+
+/* Public defines ----------------------------------------------------- */
+#define SYS_CTRL_RESPONSE_HEADER_SIZE (3)     // Response opcode, request opcode and result (bytes)
+#define SYS_CTRL_STATUS_SIZE          (17)    // Encoded status, fits a 23-byte ATT MTU response (bytes)
+
+#define SYS_CTRL_STREAM_WAVE          (1u << 0)   // Waveform service
+#define SYS_CTRL_STREAM_MOTION        (1u << 1)   // Motion service
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Control point opcode enum
+ */
+typedef enum
+{
+   SYS_CTRL_OP_STATUS_GET     = 0x01
+  ,SYS_CTRL_OP_STREAMS_SET    = 0x02
+  ,SYS_CTRL_OP_WAVE_CONFIG    = 0x03
+  ,SYS_CTRL_OP_PIPELINE_SET   = 0x04
+  ,SYS_CTRL_OP_PIPELINE_GET   = 0x05
+  ,SYS_CTRL_OP_RESP_SOURCE    = 0x06
+  ,SYS_CTRL_OP_MOTION_RATE    = 0x07
+  ,SYS_CTRL_OP_SENSORS_PERIOD = 0x08
+  ,SYS_CTRL_OP_LINK_PROFILE   = 0x09
+  ,SYS_CTRL_OP_IMU_CALIB      = 0x0A
+  ,SYS_CTRL_OP_BROADCAST      = 0x0B
+  ,SYS_CTRL_OP_REPLAY         = 0x0C
+  ,SYS_CTRL_OP_RESPONSE       = 0x80
+}
+sys_ctrl_op_t;
+
+/**
+ * @brief Control point result enum
+ */
+typedef enum
+{
+   SYS_CTRL_RESULT_SUCCESS       = 0x01
+  ,SYS_CTRL_RESULT_NOT_SUPPORTED = 0x02   // Unknown opcode, or the feature is not built
+  ,SYS_CTRL_RESULT_INVALID_PARAM = 0x03   // Wrong length or value
+  ,SYS_CTRL_RESULT_FAILED        = 0x04   // Accepted but could not be applied
+}
+sys_ctrl_result_t;
+
+/**
+ * @brief IMU calibration target enum
+ */
+typedef enum
+{
+   SYS_CTRL_CALIB_ABORT = 0x00
+  ,SYS_CTRL_CALIB_ACCEL = 0x01
+  ,SYS_CTRL_CALIB_MAG   = 0x02
+}
+sys_ctrl_calib_t;
+
+/**
+ * @brief Control point command structure
+ */
+typedef struct
+{
+  uint8_t opcode;
+  union
+  {
+    uint8_t              streams;               // SYS_CTRL_STREAM_ bits
+    wave_stream_config_t wave_config;
+    struct
+    {
+      uint8_t count;
+      uint8_t ids[DSP_PIPELINE_MAX_STAGES];
+    }
+    pipeline;
+    uint8_t              resp_source;           // bsp_afe_resp_source_t
+    uint16_t             motion_rate;           // Hz
+    uint16_t             sensors_period;        // ms
+    uint8_t              link_profile;          // ble_link_profile_t
+    struct
+    {
+      uint8_t  target;                          // sys_ctrl_calib_t
+      uint16_t duration;                        // s, magnetometer only
+    }
+    calib;
+    struct
+    {
+      uint8_t  connectable;                     // 0 for broadcast only
+      uint16_t period;                          // ms, vitals advertising data update
+    }
+    broadcast;
+    struct
+    {
+      uint16_t first;                           // Sequence of the first waveform packet
+      uint16_t count;                           // Packets
+    }
+    replay;
+  }
+  params;
+}
+sys_ctrl_cmd_t;
+
+/**
+ * @brief Control point status structure
+ */
+typedef struct
+{
+  uint8_t              streams;                 // SYS_CTRL_STREAM_ bits running
+  uint8_t              streams_allowed;         // SYS_CTRL_STREAM_ bits allowed for the reader
+  uint8_t              resp_source;
+  uint8_t              pm_state;
+  bool                 lead_off;
+  uint8_t              heart_rate;
+  uint8_t              respiration_rate;
+  uint8_t              link_profile;
+  wave_stream_config_t wave_config;
+  uint16_t             motion_rate;
+  uint16_t             sensors_period;
+  uint8_t              stage_count;
+}
+sys_ctrl_status_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Control point decode a command
+ *
+ * @param[in]     p_buf         Written command
+ * @param[in]     len           Length
+ * @param[out]    p_cmd         Pointer to command, the opcode is set even if the command is rejected
+ *
+ * @attention     The values are checked by the modules they configure
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           Unknown opcode
+ * - BS_ERROR_PARAMS    Wrong length
+ */
+base_status_t sys_ctrl_cmd_decode(const uint8_t *p_buf, uint16_t len, sys_ctrl_cmd_t *p_cmd);
+
+/**
+ * @brief         Control point encode a response
+ *
+ * @param[in]     opcode        Opcode of the command
+ * @param[in]     result        Result of the command
+ * @param[in]     p_payload     Payload (may be NULL if len is 0)
+ * @param[in]     len           Payload length
+ * @param[out]    p_buf         Output buffer, SYS_CTRL_RESPONSE_HEADER_SIZE + len bytes
+ *
+ * @attention     The payload is only sent with SYS_CTRL_RESULT_SUCCESS
+ *
+ * @return        Encoded length
+ */
+uint16_t sys_ctrl_response_encode(uint8_t opcode, sys_ctrl_result_t result, const uint8_t *p_payload, uint8_t len,
+                                  uint8_t *p_buf);
+
+/**
+ * @brief         Control point encode the status
+ *
+ * @param[in]     p_status      Pointer to status
+ * @param[out]    p_buf         Output buffer, SYS_CTRL_STATUS_SIZE bytes
+ *
+ * @attention     None
+ *
+ * @return        Encoded length
+ */
+uint8_t sys_ctrl_status_encode(const sys_ctrl_status_t *p_status, uint8_t *p_buf);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __SYS_CTRL_H
+
+/* End of file -------------------------------------------------------- */
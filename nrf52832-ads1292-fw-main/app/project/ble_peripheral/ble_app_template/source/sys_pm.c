@@ -0,0 +1,158 @@
+/**
+ * @file       sys_pm.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      System module to handle the activity power states (PM)
+ * @note       None
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "sys_pm.h"
+#include "bsp_imu.h"
+#include "bsp_afe.h"
+
+/* Private defines ---------------------------------------------------- */
+#define SYS_PM_TICK_INTERVAL        APP_TIMER_TICKS(1000)
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+APP_TIMER_DEF(m_pm_timer_id);
+
+static sys_pm_state_t         m_state         = SYS_PM_STATE_ACTIVE;
+static sys_pm_state_handler_t m_state_handler = NULL;
+static volatile uint32_t      m_seconds;
+static uint32_t               m_seconds_done;
+static uint32_t               m_still_time;     // Seconds without motion
+static uint32_t               m_lead_off_time;  // Seconds still with the electrodes off
+
+/* Private function prototypes ---------------------------------------- */
+static void m_sys_pm_timer_handler(void *p_context);
+static base_status_t m_sys_pm_state_set(sys_pm_state_t state);
+
+/* Function definitions ----------------------------------------------- */
+base_status_t sys_pm_init(void)
+{
+  m_state         = SYS_PM_STATE_ACTIVE;
+  m_still_time    = 0;
+  m_lead_off_time = 0;
+  m_seconds_done  = m_seconds;
+
+  CHECK(app_timer_create(&m_pm_timer_id, APP_TIMER_MODE_REPEATED, m_sys_pm_timer_handler) == NRF_SUCCESS, BS_ERROR);
+  CHECK(app_timer_start(m_pm_timer_id, SYS_PM_TICK_INTERVAL, NULL) == NRF_SUCCESS, BS_ERROR);
+
+  return BS_OK;
+}
+
+void sys_pm_register_state_handler(sys_pm_state_handler_t handler)
+{
+  m_state_handler = handler;
+}
+
+base_status_t sys_pm_process(void)
+{
+  uint32_t elapsed;
+
+  // Out of the active state only the wake on motion is watched
+  if ((m_state != SYS_PM_STATE_ACTIVE) && bsp_imu_motion_take())
+    return m_sys_pm_state_set(SYS_PM_STATE_ACTIVE);
+
+  elapsed = m_seconds - m_seconds_done;
+  if (elapsed == 0)
+    return BS_OK;
+
+  m_seconds_done += elapsed;
+
+  switch (m_state)
+  {
+  case SYS_PM_STATE_ACTIVE:
+    m_still_time = bsp_imu_motion_take() ? 0 : m_still_time + elapsed;
+
+    if (m_still_time >= _CONFIG_PM_STILL_TIME)
+      return m_sys_pm_state_set(SYS_PM_STATE_STILL);
+    break;
+
+  case SYS_PM_STATE_STILL:
+    m_lead_off_time = bsp_afe_lead_off_get() ? m_lead_off_time + elapsed : 0;
+
+    if (m_lead_off_time >= _CONFIG_PM_UNWORN_TIME)
+      return m_sys_pm_state_set(SYS_PM_STATE_UNWORN);
+    break;
+
+  default:
+    break;
+  }
+
+  return BS_OK;
+}
+
+sys_pm_state_t sys_pm_state_get(void)
+{
+  return m_state;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Power manager timer handler
+ *
+ * @param[in]     p_context     Unused
+ *
+ * @attention     Runs in interrupt context, the bus transactions of a state change are made
+ *                from the main loop
+ *
+ * @return        None
+ */
+static void m_sys_pm_timer_handler(void *p_context)
+{
+  m_seconds++;
+}
+
+/**
+ * @brief         Power manager change the state
+ *
+ * @param[in]     state         New state
+ *
+ * @attention     The state is kept when a driver fails
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_sys_pm_state_set(sys_pm_state_t state)
+{
+  switch (state)
+  {
+  case SYS_PM_STATE_ACTIVE:
+    if (m_state == SYS_PM_STATE_UNWORN)
+      CHECK_STATUS(bsp_afe_set_standby(false));
+    CHECK_STATUS(bsp_imu_low_power_exit());
+    break;
+
+  case SYS_PM_STATE_STILL:
+    CHECK_STATUS(bsp_imu_low_power_enter());
+    break;
+
+  case SYS_PM_STATE_UNWORN:
+    CHECK_STATUS(bsp_afe_set_standby(true));
+    break;
+
+  default:
+    return BS_ERROR;
+  }
+
+  m_state         = state;
+  m_still_time    = 0;
+  m_lead_off_time = 0;
+
+  if (m_state_handler != NULL)
+    m_state_handler(state);
+
+  return BS_OK;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,102 @@
+/**
+ * @file       sys_pm.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      System module to handle the activity power states (PM)
+ * @note       Active, still (IMU on wake on motion) and unworn (AFE in standby as well)
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __SYS_PM_H
+#define __SYS_PM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+
+/* Public defines ----------------------------------------------------- */
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Power state enum
+ */
+typedef enum
+{
+   SYS_PM_STATE_ACTIVE    // Moving, full acquisition
+  ,SYS_PM_STATE_STILL     // No motion, accelerometer cycling with wake on motion, gyro and magnetometer off
+  ,SYS_PM_STATE_UNWORN    // Still with the electrodes off, AFE in standby as well
+  ,SYS_PM_STATE_MAX
+}
+sys_pm_state_t;
+
+/**
+ * @brief Power state handler type
+ */
+typedef void (*sys_pm_state_handler_t)(sys_pm_state_t state);
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Power manager init
+ *
+ * @param[in]     None
+ *
+ * @attention     Starts in the active state, the IMU and the AFE must be initialized
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+base_status_t sys_pm_init(void);
+
+/**
+ * @brief         Power manager register the state handler
+ *
+ * @param[in]     handler       Called after each state change, NULL to unregister
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void sys_pm_register_state_handler(sys_pm_state_handler_t handler);
+
+/**
+ * @brief         Power manager run the state machine, called from the main loop
+ *
+ * @param[in]     None
+ *
+ * @attention     The wake on motion is served on the next call, the timeouts once a second
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR       State change failed, retried on the next event
+ */
+base_status_t sys_pm_process(void);
+
+/**
+ * @brief         Power manager get the state
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Power state
+ */
+sys_pm_state_t sys_pm_state_get(void);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __SYS_PM_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,39 @@
+/**
+ * @file       vitals_adv.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Vitals broadcast in the manufacturer specific advertising data
+ * @note       None
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include "vitals_adv.h"
+
+/* Private defines ---------------------------------------------------- */
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static uint8_t m_sequence;
+
+/* Private function prototypes ---------------------------------------- */
+/* Function definitions ----------------------------------------------- */
+uint8_t vitals_adv_build(const vitals_adv_t *p_vitals, uint8_t *p_buf)
+{
+  uint8_t len = 0;
+
+  p_buf[len++] = VITALS_ADV_VERSION;
+  p_buf[len++] = m_sequence++;
+  p_buf[len++] = p_vitals->heart_rate;
+  p_buf[len++] = p_vitals->respiration_rate;
+  p_buf[len++] = p_vitals->battery_level;
+  p_buf[len++] = p_vitals->flags;
+
+  return len;
+}
+
+/* End of file -------------------------------------------------------- */
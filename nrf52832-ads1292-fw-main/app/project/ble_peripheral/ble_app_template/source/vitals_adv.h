@@ -0,0 +1,77 @@
+/**
+ * @file       vitals_adv.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Vitals broadcast in the manufacturer specific advertising data
+ * @note       The manufacturer data is {company identifier (u16), version (u8), sequence (u8),
+ *             heart rate in bpm (u8), respiration rate in rpm (u8), battery level in % (u8),
+ *             flags (u8)}, little endian. The sequence rolls over at every update so a scanner
+ *             tells a new value from a repeated advertising packet. The rates are 0 while they
+ *             are not measured, the battery level VITALS_ADV_BATTERY_UNKNOWN until its first
+ *             average.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __VITALS_ADV_H
+#define __VITALS_ADV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+
+/* Public defines ----------------------------------------------------- */
+#define VITALS_ADV_COMPANY_ID         (0xFFFF)    // Bluetooth SIG identifier reserved for tests, no company assigned
+#define VITALS_ADV_VERSION            (0x01)      // Layout of the manufacturer data
+#define VITALS_ADV_SIZE               (6)         // Manufacturer data after the company identifier (bytes)
+#define VITALS_ADV_BATTERY_UNKNOWN    (0xFF)      // Battery level not averaged yet
+
+#define VITALS_ADV_FLAG_LEAD_OFF      (1u << 0)   // ECG electrodes off, the rates are 0
+#define VITALS_ADV_FLAG_UNWORN        (1u << 1)   // Unworn power state, the AFE is in standby
+#define VITALS_ADV_FLAG_CONNECTABLE   (1u << 2)   // A central may connect
+#define VITALS_ADV_FLAG_LINKED        (1u << 3)   // At least one central connected
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Vitals structure
+ */
+typedef struct
+{
+  uint8_t heart_rate;           // bpm, 0 if not measured
+  uint8_t respiration_rate;     // rpm, 0 if not measured
+  uint8_t battery_level;        // %, VITALS_ADV_BATTERY_UNKNOWN if not measured
+  uint8_t flags;                // VITALS_ADV_FLAG_ bits
+}
+vitals_adv_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Vitals advertising build the manufacturer data of a new update
+ *
+ * @param[in]     p_vitals      Pointer to vitals
+ * @param[out]    p_buf         Output buffer, VITALS_ADV_SIZE bytes
+ *
+ * @attention     The sequence is incremented at every call, the company identifier is added by
+ *                the advertising data encoder
+ *
+ * @return        Built length
+ */
+uint8_t vitals_adv_build(const vitals_adv_t *p_vitals, uint8_t *p_buf);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __VITALS_ADV_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,132 @@
+/**
+ * @file       wave_record.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Compressed ECG recording to the NAND flash log
+ * @note       The ECG is coded losslessly with dsp_codec, about 5 to 6 bits per sample instead of
+ *             16. Every record is a codec block of its own, a lost page only loses its records.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "wave_record.h"
+#include "dsp_codec.h"
+#include "bsp_time.h"
+#include "bsp_nand_flash.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static wave_record_stats_t m_stats;
+static bool                m_enabled;
+static bool                m_open;              // A record is being filled
+static uint16_t            m_sample_rate;
+static dsp_codec_t         m_codec;
+static uint8_t             m_record[BSP_NAND_FLASH_LOG_RECORD_MAX];
+
+/* Private function prototypes ---------------------------------------- */
+static void m_wave_record_open(uint32_t tick);
+static void m_wave_record_close(void);
+
+/* Function definitions ----------------------------------------------- */
+void wave_record_init(uint16_t sample_rate)
+{
+  m_sample_rate = sample_rate;
+  m_open        = false;
+  m_enabled     = true;
+  memset(&m_stats, 0, sizeof(m_stats));
+
+  dsp_codec_init(&m_codec, 1);
+}
+
+void wave_record_enable(bool enable)
+{
+  if (!enable && m_open)
+    m_wave_record_close();
+
+  m_enabled = enable;
+}
+
+void wave_record_sink(const dsp_block_t *p_block, void *p_ctx)
+{
+  if (!m_enabled || ((p_block->channel_mask & (1u << DSP_CHANNEL_ECG)) == 0))
+    return;
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    int32_t sample = p_block->data[DSP_CHANNEL_ECG][n];
+
+    if (!m_open)
+      m_wave_record_open(p_block->tick + BSP_TIME_SAMPLE_TICKS(n, m_sample_rate));
+
+    if (!dsp_codec_block_add(&m_codec, &sample))
+    {
+      m_wave_record_close();
+      m_wave_record_open(p_block->tick + BSP_TIME_SAMPLE_TICKS(n, m_sample_rate));
+      dsp_codec_block_add(&m_codec, &sample);
+    }
+
+    m_stats.samples++;
+  }
+}
+
+void wave_record_stats_get(wave_record_stats_t *p_stats)
+{
+  *p_stats = m_stats;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Start a record
+ *
+ * @param[in]     tick          Timebase tick of the first sample
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_wave_record_open(uint32_t tick)
+{
+  uint8_t len = 0;
+
+  m_record[len++] = BSP_NAND_FLASH_RECORD_WAVE;
+  len += uint32_encode(tick, &m_record[len]);
+  len += uint16_encode(m_sample_rate, &m_record[len]);
+
+  dsp_codec_block_start(&m_codec, &m_record[len], sizeof(m_record) - len);
+  m_open = true;
+}
+
+/**
+ * @brief         Append the record to the log
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_wave_record_close(void)
+{
+  uint16_t len = WAVE_RECORD_HEADER_SIZE + dsp_codec_block_end(&m_codec);
+
+  m_open = false;
+
+  if (bsp_nand_flash_log_append(m_record, (uint8_t)len) != BS_OK)
+  {
+    m_stats.errors++;
+    return;
+  }
+
+  m_stats.records++;
+  m_stats.bytes += len;
+}
+
+/* End of file -------------------------------------------------------- */
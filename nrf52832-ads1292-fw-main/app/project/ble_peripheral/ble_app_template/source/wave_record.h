@@ -0,0 +1,99 @@
+/**
+ * @file       wave_record.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Compressed ECG recording to the NAND flash log
+ * @note       A record is {BSP_NAND_FLASH_RECORD_WAVE (u8), tick of the first sample (u32),
+ *             sample rate (u16), dsp_codec block of the filtered ECG}, filled up to
+ *             BSP_NAND_FLASH_LOG_RECORD_MAX.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __WAVE_RECORD_H
+#define __WAVE_RECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+#include "dsp_pipeline.h"
+
+/* Public defines ----------------------------------------------------- */
+#define WAVE_RECORD_HEADER_SIZE     (7)       // Record header (bytes)
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Wave record statistics structure
+ */
+typedef struct
+{
+  uint32_t records;         // Records appended to the log
+  uint32_t samples;         // Samples recorded
+  uint32_t bytes;           // Record bytes, headers included
+  uint32_t errors;          // Records the log refused
+}
+wave_record_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Wave record init, recording from the start
+ *
+ * @param[in]     sample_rate   Acquisition rate (Hz)
+ *
+ * @attention     The NAND flash log must be initialized
+ *
+ * @return        None
+ */
+void wave_record_init(uint16_t sample_rate);
+
+/**
+ * @brief         Wave record start or stop the recording
+ *
+ * @param[in]     enable        Record the ECG
+ *
+ * @attention     Stopping appends the open record
+ *
+ * @return        None
+ */
+void wave_record_enable(bool enable);
+
+/**
+ * @brief         Wave record pipeline sink, codes the filtered ECG
+ *
+ * @param[in]     p_block       Processed block
+ * @param[in]     p_ctx         Sink context (unused)
+ *
+ * @attention     A record is appended to the log once the next sample may not fit
+ *
+ * @return        None
+ */
+void wave_record_sink(const dsp_block_t *p_block, void *p_ctx);
+
+/**
+ * @brief         Wave record get the statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void wave_record_stats_get(wave_record_stats_t *p_stats);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __WAVE_RECORD_H
+
+/* End of file -------------------------------------------------------- */
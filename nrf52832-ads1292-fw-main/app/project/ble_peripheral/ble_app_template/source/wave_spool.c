@@ -0,0 +1,371 @@
+/**
+ * @file       wave_spool.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Store-and-forward of the waveform packets through the NAND flash log
+ * @note       The 16-bit packet sequence is extended to a 32-bit packet number. A log cursor is
+ *             kept every WAVE_SPOOL_CHECKPOINT_STEP packets, a replay reads the log from the
+ *             latest one before its first packet.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "wave_spool.h"
+#include "wave_stream.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+#define WAVE_SPOOL_FLAG_LIVE          (1u << 0)                           // Packet built for the links
+#define WAVE_SPOOL_BACKPRESSURE_LEVEL (WAVE_STREAM_RING_SIZE * 3 / 4)     // Frames buffered that spool while streaming
+#define WAVE_SPOOL_PROCESS_MAX        (4)                                 // Packets spooled per process call
+#define WAVE_SPOOL_SCAN_MAX           (8)                                 // Records read per replay call, at most
+
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Wave spool replay start point structure
+ */
+typedef struct
+{
+  uint32_t                number;       // Packet number of the record at the cursor
+  bsp_nand_flash_cursor_t cursor;
+}
+wave_spool_checkpoint_t;
+
+/**
+ * @brief Wave spool replay request structure
+ */
+typedef struct
+{
+  uint32_t first;                       // Packet numbers
+  uint32_t last;
+  bool     backlog;                     // Only the packets that were not built for the links
+}
+wave_spool_request_t;
+
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static wave_spool_stats_t m_stats;
+static volatile bool      m_live;
+static bool               m_numbered;           // m_number is set
+static uint32_t           m_number;             // Number of the last packet, its low 16 bits are the sequence
+static uint8_t            m_record[BSP_NAND_FLASH_LOG_RECORD_MAX];
+
+static wave_spool_checkpoint_t m_checkpoints[WAVE_SPOOL_CHECKPOINTS];
+static uint8_t            m_checkpoint_head;    // Next written
+static uint8_t            m_checkpoint_count;
+
+// Packets built for the log only since the links last took the waveform
+static bool               m_backlog;
+static uint32_t           m_backlog_first;
+static uint32_t           m_backlog_last;
+
+static wave_spool_request_t m_requests[WAVE_SPOOL_REQUESTS];
+static uint8_t            m_request_head;       // Request being replayed
+static uint8_t            m_request_count;
+static bool               m_replaying;          // m_cursor is set for the request being replayed
+static bsp_nand_flash_cursor_t m_cursor;
+static uint32_t           m_cursor_number;      // Number of the last packet read at m_cursor
+
+/* Private function prototypes ---------------------------------------- */
+static void m_wave_spool_append(uint8_t flags, uint16_t len);
+static base_status_t m_wave_spool_request_add(uint32_t first, uint32_t last, bool backlog);
+static base_status_t m_wave_spool_replay_start(const wave_spool_request_t *p_request);
+static void m_wave_spool_request_done(void);
+
+/* Function definitions ----------------------------------------------- */
+void wave_spool_init(void)
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+
+  m_live             = false;
+  m_numbered         = false;
+  m_checkpoint_head  = 0;
+  m_checkpoint_count = 0;
+  m_backlog          = false;
+  m_request_head     = 0;
+  m_request_count    = 0;
+  m_replaying        = false;
+
+  // The waveform is buffered whether a link takes it or not
+  wave_stream_enable(true);
+}
+
+void wave_spool_live_set(bool live)
+{
+  m_live = live;
+}
+
+void wave_spool_process(void)
+{
+  uint16_t len;
+
+  for (uint8_t n = 0; n < WAVE_SPOOL_PROCESS_MAX; n++)
+  {
+    // The links take the packets unless they fall behind
+    if (m_live && (wave_stream_level_get() < WAVE_SPOOL_BACKPRESSURE_LEVEL))
+      break;
+
+    len = wave_stream_packet_build(&m_record[WAVE_SPOOL_RECORD_HEADER_SIZE], WAVE_SPOOL_PACKET_SIZE);
+    if (len == 0)
+      break;
+
+    m_wave_spool_append(0, len);
+    m_stats.spooled++;
+
+    if (!m_backlog)
+    {
+      m_backlog       = true;
+      m_backlog_first = m_number;
+    }
+    m_backlog_last = m_number;
+  }
+
+  // The backlog goes out once the links keep up again
+  if (m_live && m_backlog && (wave_stream_level_get() < WAVE_SPOOL_BACKPRESSURE_LEVEL) &&
+      (m_wave_spool_request_add(m_backlog_first, m_backlog_last, true) == BS_OK))
+    m_backlog = false;
+}
+
+uint16_t wave_spool_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  uint16_t len;
+
+  if (!m_live)
+    return 0;
+
+  len = wave_stream_packet_build(&m_record[WAVE_SPOOL_RECORD_HEADER_SIZE], MIN(max_len, WAVE_SPOOL_PACKET_SIZE));
+  if (len == 0)
+    return 0;
+
+  m_wave_spool_append(WAVE_SPOOL_FLAG_LIVE, len);
+  m_stats.live++;
+
+  memcpy(p_buf, &m_record[WAVE_SPOOL_RECORD_HEADER_SIZE], len);
+
+  return len;
+}
+
+uint16_t wave_spool_replay_fill(uint8_t *p_buf, uint16_t max_len)
+{
+  wave_spool_request_t *p_request;
+  uint8_t               len;
+  uint16_t              seq;
+
+  // Before the MTU exchange every logged packet would be skipped
+  if (!m_live || (m_request_count == 0) || (max_len < WAVE_SPOOL_PACKET_SIZE))
+    return 0;
+
+  p_request = &m_requests[m_request_head];
+  if (!m_replaying && (m_wave_spool_replay_start(p_request) != BS_OK))
+  {
+    m_stats.errors++;
+    m_wave_spool_request_done();
+    return 0;
+  }
+
+  // The AFE is polled from the main loop too, the flash is read a little per pass
+  for (uint8_t n = 0; (n < WAVE_SPOOL_SCAN_MAX) && !bsp_nand_flash_log_busy(); n++)
+  {
+    if (bsp_nand_flash_log_read(&m_cursor, m_record, &len) != BS_OK)
+    {
+      // Overwritten by the ring
+      m_stats.errors++;
+      m_wave_spool_request_done();
+      return 0;
+    }
+
+    if (len == 0)
+    {
+      m_wave_spool_request_done();
+      return 0;
+    }
+
+    if ((m_record[0] != BSP_NAND_FLASH_RECORD_SPOOL) || (len <= WAVE_SPOOL_RECORD_HEADER_SIZE))
+      continue;
+
+    seq              = uint16_decode(&m_record[WAVE_SPOOL_RECORD_HEADER_SIZE]);
+    m_cursor_number += (uint16_t)(seq - (uint16_t)m_cursor_number);
+
+    if (m_cursor_number > p_request->last)
+    {
+      m_wave_spool_request_done();
+      return 0;
+    }
+
+    if ((m_cursor_number < p_request->first) ||
+        (p_request->backlog && (m_record[1] & WAVE_SPOOL_FLAG_LIVE)))
+      continue;
+
+    len -= WAVE_SPOOL_RECORD_HEADER_SIZE;
+    if (len > max_len)
+    {
+      m_stats.oversize++;
+      continue;
+    }
+
+    memcpy(p_buf, &m_record[WAVE_SPOOL_RECORD_HEADER_SIZE], len);
+    m_stats.replayed++;
+
+    return len;
+  }
+
+  return 0;
+}
+
+base_status_t wave_spool_replay_request(uint16_t first, uint16_t count)
+{
+  uint16_t age;
+  uint32_t number;
+  uint32_t last;
+  uint8_t  oldest;
+
+  CHECK((count > 0) && (count <= WAVE_SPOOL_CHECKPOINTS * WAVE_SPOOL_CHECKPOINT_STEP), BS_ERROR_PARAMS);
+  CHECK(m_numbered && (m_checkpoint_count != 0), BS_ERROR_PARAMS);
+
+  // Latest packet with this sequence
+  age = (uint16_t)((uint16_t)m_number - first);
+  CHECK(age <= m_number, BS_ERROR_PARAMS);
+
+  number = m_number - age;
+  last   = number + count - 1;
+  if (last > m_number)
+    last = m_number;
+
+  oldest = (m_checkpoint_head + WAVE_SPOOL_CHECKPOINTS - m_checkpoint_count) % WAVE_SPOOL_CHECKPOINTS;
+  CHECK(last >= m_checkpoints[oldest].number, BS_ERROR_PARAMS);
+
+  return m_wave_spool_request_add(number, last, false);
+}
+
+void wave_spool_stats_get(wave_spool_stats_t *p_stats)
+{
+  *p_stats = m_stats;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Append the packet in the record buffer to the log
+ *
+ * @param[in]     flags         Record flags
+ * @param[in]     len           Packet length
+ *
+ * @attention     The packet number is extended from the packet sequence, a start point is kept
+ *                every WAVE_SPOOL_CHECKPOINT_STEP packets
+ *
+ * @return        None
+ */
+static void m_wave_spool_append(uint8_t flags, uint16_t len)
+{
+  uint16_t seq  = uint16_decode(&m_record[WAVE_SPOOL_RECORD_HEADER_SIZE]);
+  uint8_t  last = (m_checkpoint_head + WAVE_SPOOL_CHECKPOINTS - 1) % WAVE_SPOOL_CHECKPOINTS;
+
+  m_number   = m_numbered ? (m_number + (uint16_t)(seq - (uint16_t)m_number)) : seq;
+  m_numbered = true;
+
+  if ((m_checkpoint_count == 0) || ((m_number - m_checkpoints[last].number) >= WAVE_SPOOL_CHECKPOINT_STEP))
+  {
+    m_checkpoints[m_checkpoint_head].number = m_number;
+    bsp_nand_flash_log_cursor_get(&m_checkpoints[m_checkpoint_head].cursor);
+
+    m_checkpoint_head = (m_checkpoint_head + 1) % WAVE_SPOOL_CHECKPOINTS;
+    if (m_checkpoint_count < WAVE_SPOOL_CHECKPOINTS)
+      m_checkpoint_count++;
+  }
+
+  m_record[0] = BSP_NAND_FLASH_RECORD_SPOOL;
+  m_record[1] = flags;
+
+  if (bsp_nand_flash_log_append(m_record, (uint8_t)(WAVE_SPOOL_RECORD_HEADER_SIZE + len)) != BS_OK)
+    m_stats.errors++;
+}
+
+/**
+ * @brief         Queue a replay request
+ *
+ * @param[in]     first         Number of the first packet
+ * @param[in]     last          Number of the last packet
+ * @param[in]     backlog       Only the packets that were not built for the links
+ *
+ * @attention     None
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR
+ */
+static base_status_t m_wave_spool_request_add(uint32_t first, uint32_t last, bool backlog)
+{
+  wave_spool_request_t *p_request;
+
+  CHECK(m_request_count < WAVE_SPOOL_REQUESTS, BS_ERROR);
+
+  p_request          = &m_requests[(m_request_head + m_request_count) % WAVE_SPOOL_REQUESTS];
+  p_request->first   = first;
+  p_request->last    = last;
+  p_request->backlog = backlog;
+  m_request_count++;
+
+  return BS_OK;
+}
+
+/**
+ * @brief         Place the log cursor for a replay request
+ *
+ * @param[in]     p_request     Pointer to request
+ *
+ * @attention     The cursor starts at the latest start point before the first packet, the oldest
+ *                one if the first packet is older
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR           The range is no longer in the log
+ */
+static base_status_t m_wave_spool_replay_start(const wave_spool_request_t *p_request)
+{
+  uint8_t oldest;
+  uint8_t start;
+  uint8_t idx;
+
+  CHECK(m_checkpoint_count != 0, BS_ERROR);
+
+  oldest = (m_checkpoint_head + WAVE_SPOOL_CHECKPOINTS - m_checkpoint_count) % WAVE_SPOOL_CHECKPOINTS;
+  CHECK(p_request->last >= m_checkpoints[oldest].number, BS_ERROR);
+
+  start = oldest;
+  for (uint8_t n = 1; n < m_checkpoint_count; n++)
+  {
+    idx = (oldest + n) % WAVE_SPOOL_CHECKPOINTS;
+    if (m_checkpoints[idx].number > p_request->first)
+      break;
+
+    start = idx;
+  }
+
+  m_cursor        = m_checkpoints[start].cursor;
+  m_cursor_number = m_checkpoints[start].number;
+  m_replaying     = true;
+
+  return BS_OK;
+}
+
+/**
+ * @brief         End the replay request being served
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_wave_spool_request_done(void)
+{
+  m_request_head = (m_request_head + 1) % WAVE_SPOOL_REQUESTS;
+  m_request_count--;
+  m_replaying    = false;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,151 @@
+/**
+ * @file       wave_spool.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Store-and-forward of the waveform packets through the NAND flash log
+ * @note       Every packet of the wave stream is appended to the log as a record
+ *             {BSP_NAND_FLASH_RECORD_SPOOL (u8), flags (u8), wave stream packet}. The packets are
+ *             built for the links while one streams the waveform, otherwise, or when the links
+ *             fall behind, the wave ring is emptied into the log only. This backlog is replayed
+ *             on the waveform characteristic once a link streams again, in turn with the live
+ *             packets, and any range of sequence numbers still in the log can be requested.
+ *             The replayed packets keep their sequence number and tick.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __WAVE_SPOOL_H
+#define __WAVE_SPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+#include "bsp_nand_flash.h"
+
+/* Public defines ----------------------------------------------------- */
+#define WAVE_SPOOL_RECORD_HEADER_SIZE (2)       // Record type and flags (bytes)
+#define WAVE_SPOOL_PACKET_SIZE      (182)     // Largest logged packet, the payload of a 185-byte ATT MTU
+#define WAVE_SPOOL_CHECKPOINTS      (64)      // Replay start points kept, one every WAVE_SPOOL_CHECKPOINT_STEP packets
+#define WAVE_SPOOL_CHECKPOINT_STEP  (512)     // Packets between two start points, 32768 packets can be requested
+#define WAVE_SPOOL_REQUESTS         (4)       // Replay requests queued
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Wave spool statistics structure
+ */
+typedef struct
+{
+  uint32_t live;            // Packets built for the links
+  uint32_t spooled;         // Packets built for the log only
+  uint32_t replayed;        // Packets replayed from the log
+  uint32_t oversize;        // Replayed packets longer than the payload of the links, skipped
+  uint32_t errors;          // Records the log refused, or requests cut by the ring
+}
+wave_spool_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Wave spool init
+ *
+ * @param[in]     None
+ *
+ * @attention     The NAND flash log must be initialized, the wave stream stays enabled from now on
+ *
+ * @return        None
+ */
+void wave_spool_init(void);
+
+/**
+ * @brief         Wave spool set whether a link streams the waveform
+ *
+ * @param[in]     live          A link has enabled the waveform notifications
+ *
+ * @attention     The backlog is replayed once a link streams again
+ *
+ * @return        None
+ */
+void wave_spool_live_set(bool live);
+
+/**
+ * @brief         Wave spool empty the wave ring into the log while no link takes it
+ *
+ * @param[in]     None
+ *
+ * @attention     Called from the main loop, the packets are WAVE_SPOOL_PACKET_SIZE long whatever
+ *                the links
+ *
+ * @return        None
+ */
+void wave_spool_process(void);
+
+/**
+ * @brief         Wave spool TX scheduler builder of the live waveform packets
+ *
+ * @param[out]    p_buf         Output buffer
+ * @param[in]     max_len       Usable ATT payload
+ *
+ * @attention     The packet is also appended to the log, it is cut to WAVE_SPOOL_PACKET_SIZE so
+ *                that any replay link takes it
+ *
+ * @return        Packet length, 0 if the stream has nothing to send
+ */
+uint16_t wave_spool_fill(uint8_t *p_buf, uint16_t max_len);
+
+/**
+ * @brief         Wave spool TX scheduler builder of the replayed waveform packets
+ *
+ * @param[out]    p_buf         Output buffer
+ * @param[in]     max_len       Usable ATT payload
+ *
+ * @attention     A few records are read per call, within the SPI budget of the NAND flash log; 0 is
+ *                returned when none of them is replayed. Nothing is replayed until the payload of the
+ *                links reaches WAVE_SPOOL_PACKET_SIZE.
+ *
+ * @return        Packet length, 0 if there is nothing to replay now
+ */
+uint16_t wave_spool_replay_fill(uint8_t *p_buf, uint16_t max_len);
+
+/**
+ * @brief         Wave spool request the replay of a range of packets
+ *
+ * @param[in]     first         Sequence number of the first packet
+ * @param[in]     count         Packets, 1..WAVE_SPOOL_CHECKPOINTS * WAVE_SPOOL_CHECKPOINT_STEP
+ *
+ * @attention     The sequence numbers are the latest ones with these low 16 bits. The packets no
+ *                longer in the log are skipped.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS    Bad count, or the range is not in the log
+ * - BS_ERROR           Request queue full
+ */
+base_status_t wave_spool_replay_request(uint16_t first, uint16_t count);
+
+/**
+ * @brief         Wave spool get the statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void wave_spool_stats_get(wave_spool_stats_t *p_stats);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __WAVE_SPOOL_H
+
+/* End of file -------------------------------------------------------- */
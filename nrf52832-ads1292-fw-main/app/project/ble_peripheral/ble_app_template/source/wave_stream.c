@@ -0,0 +1,335 @@
+/**
+ * @file       wave_stream.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Biosignal waveform ring buffer and packetizer for the waveform service
+ * @note       Frames are packed at the configured format when they are buffered, so a packet is
+ *             a header and one copy. Packets are filled up to the ATT payload to spread the
+ *             header and the link-layer overhead, a shorter one is sent rather than holding the
+ *             oldest frame longer than WAVE_STREAM_MAX_LATENCY_MS. Compressed packets take as
+ *             many frames as the codec fits, they are built once the oldest frame is that old or
+ *             WAVE_STREAM_CODEC_MAX_FRAMES are buffered. Each frame keeps the format it was
+ *             packed at, a configuration change is applied without dropping the buffered frames.
+ * @example    None
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <string.h>
+#include "wave_stream.h"
+#include "dsp_codec.h"
+#include "bsp_time.h"
+#include "app_util.h"
+
+/* Private defines ---------------------------------------------------- */
+#define WAVE_STREAM_FRAME_MAX       (DSP_CHANNEL_MAX * 3)   // Largest frame, every channel at 24 bits
+#define WAVE_STREAM_MAX_LATENCY_MS  (250)                   // Oldest frame age that sends a short packet
+#define WAVE_STREAM_CODEC_MAX_FRAMES (UINT8_MAX)             // Frames of a compressed packet
+#define WAVE_STREAM_FORMAT_24BIT    (0x80)                  // Frame format: channel mask, this flag for 24-bit samples
+
+STATIC_ASSERT((1u << DSP_CHANNEL_MAX) <= WAVE_STREAM_FORMAT_24BIT);
+
+/* Private enumerate/structure ---------------------------------------- */
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static wave_stream_config_t m_config     = { WAVE_STREAM_SOURCE_FILTERED, 16, (1u << DSP_CHANNEL_ECG), false };
+static wave_stream_stats_t  m_stats;
+static bool                 m_enabled;
+static uint16_t             m_sample_rate;
+static uint8_t              m_format     = (1u << DSP_CHANNEL_ECG);   // Format of the frames pushed from now on
+static uint16_t             m_sequence;
+static dsp_codec_t          m_codec;
+
+static uint8_t  m_ring[WAVE_STREAM_RING_SIZE][WAVE_STREAM_FRAME_MAX];
+static uint32_t m_ring_tick[WAVE_STREAM_RING_SIZE];
+static uint8_t  m_ring_format[WAVE_STREAM_RING_SIZE];   // Format the frame was packed at
+static uint16_t m_ring_head;        // Next frame written
+static uint16_t m_ring_count;
+
+/* Private function prototypes ---------------------------------------- */
+static void m_wave_stream_flush(void);
+static uint16_t m_wave_stream_packet_compress(uint8_t *p_buf, uint16_t max_len, uint16_t tail, uint16_t count);
+static uint8_t m_wave_stream_frame_size(uint8_t format);
+
+/* Function definitions ----------------------------------------------- */
+void wave_stream_init(uint16_t sample_rate)
+{
+  m_sample_rate = sample_rate;
+  m_sequence    = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+  dsp_codec_init(&m_codec, (uint8_t)__builtin_popcount(m_config.channel_mask));
+
+  m_wave_stream_flush();
+}
+
+base_status_t wave_stream_configure(const wave_stream_config_t *p_config)
+{
+  CHECK(p_config->source < WAVE_STREAM_SOURCE_MAX, BS_ERROR_PARAMS);
+  CHECK((p_config->bit_depth == 16) || (p_config->bit_depth == 24), BS_ERROR_PARAMS);
+  CHECK((p_config->channel_mask != 0) && (p_config->channel_mask < (1u << DSP_CHANNEL_MAX)), BS_ERROR_PARAMS);
+
+  // The buffered frames keep their format, they are sent first
+  m_config = *p_config;
+  m_format = m_config.channel_mask | ((m_config.bit_depth == 24) ? WAVE_STREAM_FORMAT_24BIT : 0);
+
+  return BS_OK;
+}
+
+void wave_stream_config_get(wave_stream_config_t *p_config)
+{
+  *p_config = m_config;
+}
+
+uint8_t wave_stream_config_encode(const wave_stream_config_t *p_config, uint8_t *p_buf)
+{
+  p_buf[0] = (uint8_t)p_config->source;
+  p_buf[1] = p_config->bit_depth;
+  p_buf[2] = (uint8_t)p_config->channel_mask;
+  p_buf[3] = p_config->compressed ? 1 : 0;
+
+  return WAVE_STREAM_CONFIG_SIZE;
+}
+
+base_status_t wave_stream_config_decode(const uint8_t *p_buf, uint16_t len, wave_stream_config_t *p_config)
+{
+  CHECK((len == WAVE_STREAM_CONFIG_SIZE) || (len == WAVE_STREAM_CONFIG_SIZE - 1), BS_ERROR_PARAMS);
+
+  p_config->source       = (wave_stream_source_t)p_buf[0];
+  p_config->bit_depth    = p_buf[1];
+  p_config->channel_mask = p_buf[2];
+  p_config->compressed   = (len == WAVE_STREAM_CONFIG_SIZE) && (p_buf[3] != 0);
+
+  return BS_OK;
+}
+
+void wave_stream_enable(bool enable)
+{
+  m_enabled = enable;
+  m_wave_stream_flush();
+}
+
+void wave_stream_push(wave_stream_source_t source, const int32_t *p_sample, uint32_t tick)
+{
+  uint8_t *p_frame;
+  uint8_t  len = 0;
+
+  if (!m_enabled || (source != m_config.source))
+    return;
+
+  p_frame = m_ring[m_ring_head];
+
+  for (uint8_t ch = 0; ch < DSP_CHANNEL_MAX; ch++)
+  {
+    if ((m_config.channel_mask & (1u << ch)) == 0)
+      continue;
+
+    int32_t value = MAX(MIN(p_sample[ch], 0x7FFFFF), -0x800000);
+
+    if (m_config.bit_depth == 24)
+      len += uint24_encode((uint32_t)value, &p_frame[len]);
+    else
+      len += uint16_encode((uint16_t)(value >> 8), &p_frame[len]);
+  }
+
+  m_ring_tick[m_ring_head]   = tick;
+  m_ring_format[m_ring_head] = m_format;
+  m_ring_head = (m_ring_head + 1) % WAVE_STREAM_RING_SIZE;
+  m_stats.frames++;
+
+  if (m_ring_count < WAVE_STREAM_RING_SIZE)
+    m_ring_count++;
+  else
+    m_stats.dropped++;
+}
+
+void wave_stream_sink(const dsp_block_t *p_block, void *p_ctx)
+{
+  int32_t sample[DSP_CHANNEL_MAX];
+
+  if (!m_enabled || (m_config.source != WAVE_STREAM_SOURCE_FILTERED))
+    return;
+
+  for (uint16_t n = 0; n < p_block->count; n++)
+  {
+    for (uint8_t ch = 0; ch < DSP_CHANNEL_MAX; ch++)
+      sample[ch] = (p_block->channel_mask & (1u << ch)) ? ((int32_t)p_block->data[ch][n] * 256) : 0;
+
+    wave_stream_push(WAVE_STREAM_SOURCE_FILTERED, sample, p_block->tick + BSP_TIME_SAMPLE_TICKS(n, m_sample_rate));
+  }
+}
+
+uint16_t wave_stream_packet_build(uint8_t *p_buf, uint16_t max_len)
+{
+  uint16_t tail;
+  uint16_t frames;
+  uint16_t run;
+  uint8_t  format;
+  uint8_t  frame_size;
+  uint16_t len = 0;
+
+  if (m_ring_count == 0)
+    return 0;
+
+  tail       = (m_ring_head + WAVE_STREAM_RING_SIZE - m_ring_count) % WAVE_STREAM_RING_SIZE;
+  format     = m_ring_format[tail];
+  frame_size = m_wave_stream_frame_size(format);
+
+  if (max_len < WAVE_STREAM_HEADER_SIZE + frame_size)
+    return 0;
+
+  frames = MIN((max_len - WAVE_STREAM_HEADER_SIZE) / frame_size, UINT8_MAX);
+
+  // The coded size is only known once coded, wait for the most frames a packet takes
+  if (m_config.compressed)
+    frames = WAVE_STREAM_CODEC_MAX_FRAMES;
+
+  // A packet holds frames of one format, the ones before a configuration change go out as they are
+  for (run = 1; (run < m_ring_count) && (run < frames) && (m_ring_format[(tail + run) % WAVE_STREAM_RING_SIZE] == format); run++)
+    ;
+
+  if (run < frames)
+  {
+    uint32_t newest = m_ring_tick[(m_ring_head + WAVE_STREAM_RING_SIZE - 1) % WAVE_STREAM_RING_SIZE];
+
+    // Not full yet, only sent once the oldest frame is too old
+    if ((run == m_ring_count) &&
+        ((newest - m_ring_tick[tail]) < (uint32_t)WAVE_STREAM_MAX_LATENCY_MS * BSP_TIME_FREQ_HZ / 1000))
+      return 0;
+
+    frames = run;
+  }
+
+  if (m_config.compressed)
+    return m_wave_stream_packet_compress(p_buf, max_len, tail, frames);
+
+  len += uint16_encode(m_sequence++, &p_buf[len]);
+  len += uint32_encode(m_ring_tick[tail], &p_buf[len]);
+  p_buf[len++] = format & ~WAVE_STREAM_FORMAT_24BIT;
+  p_buf[len++] = (format & WAVE_STREAM_FORMAT_24BIT) ? 24 : 16;
+  p_buf[len++] = (uint8_t)frames;
+
+  for (uint16_t i = 0; i < frames; i++)
+  {
+    memcpy(&p_buf[len], m_ring[tail], frame_size);
+    len += frame_size;
+    tail = (tail + 1) % WAVE_STREAM_RING_SIZE;
+  }
+
+  m_ring_count -= frames;
+  m_stats.packets++;
+  m_stats.raw_bytes   += (uint32_t)frames * frame_size;
+  m_stats.coded_bytes += (uint32_t)frames * frame_size;
+
+  return len;
+}
+
+uint16_t wave_stream_level_get(void)
+{
+  return m_ring_count;
+}
+
+void wave_stream_stats_get(wave_stream_stats_t *p_stats)
+{
+  *p_stats = m_stats;
+}
+
+/* Private function definitions ---------------------------------------- */
+/**
+ * @brief         Empty the ring
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_wave_stream_flush(void)
+{
+  m_ring_head  = 0;
+  m_ring_count = 0;
+}
+
+/**
+ * @brief         Build a compressed packet from the oldest frames
+ *
+ * @param[out]    p_buf         Output buffer
+ * @param[in]     max_len       Packet size
+ * @param[in]     tail          Oldest frame
+ * @param[in]     count         Frames of the format of the oldest one, at most
+ *                              WAVE_STREAM_CODEC_MAX_FRAMES
+ *
+ * @attention     The frames are unpacked back to their value at the bit depth and coded as one
+ *                dsp_codec block, the codec follows the channel count of the frames
+ *
+ * @return        Packet length, 0 if not a single frame fits
+ */
+static uint16_t m_wave_stream_packet_compress(uint8_t *p_buf, uint16_t max_len, uint16_t tail, uint16_t count)
+{
+  uint8_t  format     = m_ring_format[tail];
+  uint8_t  frame_size = m_wave_stream_frame_size(format);
+  uint8_t  channels   = (uint8_t)__builtin_popcount(format & ~WAVE_STREAM_FORMAT_24BIT);
+  uint16_t frames     = 0;
+  uint16_t len        = 0;
+  int32_t  values[DSP_CHANNEL_MAX];
+
+  if (m_codec.channels != channels)
+    dsp_codec_init(&m_codec, channels);
+
+  dsp_codec_block_start(&m_codec, &p_buf[WAVE_STREAM_HEADER_SIZE], max_len - WAVE_STREAM_HEADER_SIZE);
+
+  while (frames < count)
+  {
+    const uint8_t *p_frame = m_ring[(tail + frames) % WAVE_STREAM_RING_SIZE];
+
+    for (uint8_t c = 0; c < channels; c++)
+    {
+      if (format & WAVE_STREAM_FORMAT_24BIT)
+        values[c] = ((int32_t)(uint24_decode(&p_frame[3 * c]) << 8)) >> 8;
+      else
+        values[c] = (int16_t)uint16_decode(&p_frame[2 * c]);
+    }
+
+    if (!dsp_codec_block_add(&m_codec, values))
+      break;
+
+    frames++;
+  }
+
+  if (frames == 0)
+    return 0;
+
+  len += uint16_encode(m_sequence++, &p_buf[len]);
+  len += uint32_encode(m_ring_tick[tail], &p_buf[len]);
+  p_buf[len++] = format & ~WAVE_STREAM_FORMAT_24BIT;
+  p_buf[len++] = ((format & WAVE_STREAM_FORMAT_24BIT) ? 24 : 16) | WAVE_STREAM_DEPTH_COMPRESSED;
+  p_buf[len++] = (uint8_t)frames;
+  len += dsp_codec_block_end(&m_codec);
+
+  m_ring_count -= frames;
+  m_stats.packets++;
+  m_stats.raw_bytes   += (uint32_t)frames * frame_size;
+  m_stats.coded_bytes += len - WAVE_STREAM_HEADER_SIZE;
+
+  return len;
+}
+
+/**
+ * @brief         Size of a packed frame
+ *
+ * @param[in]     format        Frame format
+ *
+ * @attention     None
+ *
+ * @return        Frame size (bytes)
+ */
+static uint8_t m_wave_stream_frame_size(uint8_t format)
+{
+  uint8_t channels = (uint8_t)__builtin_popcount(format & ~WAVE_STREAM_FORMAT_24BIT);
+
+  return (format & WAVE_STREAM_FORMAT_24BIT) ? (3 * channels) : (2 * channels);
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,221 @@
+/**
+ * @file       wave_stream.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Biosignal waveform ring buffer and packetizer for the waveform service
+ * @note       A packet is a header followed by interleaved frames, one value per channel of the
+ *             mask in channel order, little endian:
+ *             {sequence (u16), tick of the first frame (u32), channel mask (u8), bit depth (u8),
+ *              frames (u8), frames * channels * bit depth / 8 bytes}
+ *             With the compression on, WAVE_STREAM_DEPTH_COMPRESSED is set in the bit depth and the
+ *             frames are one dsp_codec block of the values at the bit depth.
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __WAVE_STREAM_H
+#define __WAVE_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include "bsp_hw.h"
+#include "dsp_pipeline.h"
+
+/* Public defines ----------------------------------------------------- */
+#define WAVE_STREAM_RING_SIZE       (256)     // Frames buffered, 0.5 s at 500 SPS
+#define WAVE_STREAM_HEADER_SIZE     (9)       // Packet header (bytes)
+#define WAVE_STREAM_CONFIG_SIZE     (4)       // Encoded configuration (bytes)
+#define WAVE_STREAM_DEPTH_COMPRESSED (0x80)   // Bit depth flag of a compressed packet
+
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Wave stream source enum
+ */
+typedef enum
+{
+   WAVE_STREAM_SOURCE_FILTERED = 0x00   // Output of the AFE pipeline chain
+  ,WAVE_STREAM_SOURCE_RAW      = 0x01   // ADC samples before the pipeline, full 24-bit resolution
+  ,WAVE_STREAM_SOURCE_MAX
+}
+wave_stream_source_t;
+
+/**
+ * @brief Wave stream configuration structure
+ */
+typedef struct
+{
+  wave_stream_source_t source;
+  uint8_t              bit_depth;       // 16 or 24, values are cut to the top bits
+  uint16_t             channel_mask;    // BIT(dsp_channel_t) of the streamed channels
+  bool                 compressed;      // Lossless dsp_codec blocks instead of packed frames
+}
+wave_stream_config_t;
+
+/**
+ * @brief Wave stream statistics structure
+ */
+typedef struct
+{
+  uint32_t frames;          // Frames buffered
+  uint32_t dropped;         // Oldest frames overwritten by a full ring
+  uint32_t packets;         // Packets built
+  uint32_t raw_bytes;       // Packed size of the frames sent
+  uint32_t coded_bytes;     // Packet payload after the header
+}
+wave_stream_stats_t;
+
+/* Public macros ------------------------------------------------------ */
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+/**
+ * @brief         Wave stream init
+ *
+ * @param[in]     sample_rate   Acquisition rate (Hz)
+ *
+ * @attention     The configuration is kept, the boot one is the filtered ECG at 16 bits. The
+ *                stream is stopped until wave_stream_enable().
+ *
+ * @return        None
+ */
+void wave_stream_init(uint16_t sample_rate);
+
+/**
+ * @brief         Wave stream set the configuration
+ *
+ * @param[in]     p_config      Pointer to configuration
+ *
+ * @attention     The buffered frames are sent in the format they were packed at, the new one
+ *                applies from the next frame. Main loop only, between two AFE blocks.
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ */
+base_status_t wave_stream_configure(const wave_stream_config_t *p_config);
+
+/**
+ * @brief         Wave stream get the configuration
+ *
+ * @param[out]    p_config      Pointer to configuration
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void wave_stream_config_get(wave_stream_config_t *p_config);
+
+/**
+ * @brief         Wave stream encode the configuration {source, bit depth, channel mask, compression}
+ *
+ * @param[in]     p_config      Pointer to configuration
+ * @param[out]    p_buf         Output buffer, WAVE_STREAM_CONFIG_SIZE bytes
+ *
+ * @attention     None
+ *
+ * @return        Encoded length
+ */
+uint8_t wave_stream_config_encode(const wave_stream_config_t *p_config, uint8_t *p_buf);
+
+/**
+ * @brief         Wave stream decode a configuration
+ *
+ * @param[in]     p_buf         Encoded configuration
+ * @param[in]     len           Length
+ * @param[out]    p_config      Pointer to configuration
+ *
+ * @attention     The values are checked by wave_stream_configure(), a configuration without the
+ *                compression byte turns the compression off
+ *
+ * @return
+ * - BS_OK
+ * - BS_ERROR_PARAMS
+ */
+base_status_t wave_stream_config_decode(const uint8_t *p_buf, uint16_t len, wave_stream_config_t *p_config);
+
+/**
+ * @brief         Wave stream start or stop buffering, the ring is emptied
+ *
+ * @param[in]     enable        Buffer the frames
+ *
+ * @attention     Stopped while nobody receives the packets. Main loop only, the ring may be
+ *                in use by the packet builder.
+ *
+ * @return        None
+ */
+void wave_stream_enable(bool enable);
+
+/**
+ * @brief         Wave stream add an acquired sample
+ *
+ * @param[in]     source        Source of the sample, dropped if not the configured one
+ * @param[in]     p_sample      One value per channel (DSP_CHANNEL_MAX values), 24-bit scale
+ * @param[in]     tick          Timebase tick of the sample
+ *
+ * @attention     The oldest frame is overwritten when the ring is full
+ *
+ * @return        None
+ */
+void wave_stream_push(wave_stream_source_t source, const int32_t *p_sample, uint32_t tick);
+
+/**
+ * @brief         Wave stream pipeline sink, buffers the filtered samples
+ *
+ * @param[in]     p_block       Processed block
+ * @param[in]     p_ctx         Sink context (unused)
+ *
+ * @attention     The 16-bit pipeline values are brought to the 24-bit scale of the raw samples
+ *
+ * @return        None
+ */
+void wave_stream_sink(const dsp_block_t *p_block, void *p_ctx);
+
+/**
+ * @brief         Wave stream build the next packet from the oldest frames
+ *
+ * @param[out]    p_buf         Output buffer
+ * @param[in]     max_len       Packet size, the usable ATT payload
+ *
+ * @attention     A packet is only built once enough frames fill max_len, the frames are
+ *                removed from the ring
+ *
+ * @return        Packet length, 0 if there is no packet
+ */
+uint16_t wave_stream_packet_build(uint8_t *p_buf, uint16_t max_len);
+
+/**
+ * @brief         Wave stream get the frames buffered
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Frames in the ring, WAVE_STREAM_RING_SIZE once the oldest are overwritten
+ */
+uint16_t wave_stream_level_get(void);
+
+/**
+ * @brief         Wave stream get the statistics
+ *
+ * @param[out]    p_stats       Pointer to statistics
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+void wave_stream_stats_get(wave_stream_stats_t *p_stats);
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __WAVE_STREAM_H
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,68 @@
+/**
+ * @file       bsp_hw_host.h
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Thuan Le
+ * @brief      Host stand-in for bsp_hw.h, the types the sensor headers need without the SDK
+ * @note       Force-included ahead of the sources, it takes the bsp_hw.h include guard
+ * @example    None
+ */
+
+/* Define to prevent recursive inclusion ------------------------------ */
+#ifndef __BSP_HW_H
+#define __BSP_HW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ----------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Public defines ----------------------------------------------------- */
+/* Public enumerate/structure ----------------------------------------- */
+/**
+ * @brief Base status structure
+ */
+typedef enum
+{
+  BS_OK = 0x00,
+  BS_ERROR_PARAMS,
+  BS_ERROR
+}
+base_status_t;
+
+/**
+ * @brief I2C transaction completion callback type
+ */
+typedef void (*bsp_i2c_callback_t)(base_status_t status, void *p_context);
+
+/* Public macros ------------------------------------------------------ */
+#define CHECK(expr, ret)            \
+  do {                              \
+    if (!(expr)) {                  \
+      return (ret);                 \
+    }                               \
+  } while (0)
+
+#define CHECK_STATUS(expr)          \
+  do {                              \
+    base_status_t ret = (expr);     \
+    if (BS_OK != ret) {             \
+      return (ret);                 \
+    }                               \
+  } while (0)
+
+/* Public variables --------------------------------------------------- */
+/* Public function prototypes ----------------------------------------- */
+
+/* -------------------------------------------------------------------------- */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif // __BSP_HW_H
+
+/* End of file -------------------------------------------------------- */
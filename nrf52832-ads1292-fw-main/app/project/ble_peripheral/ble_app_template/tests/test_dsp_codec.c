@@ -0,0 +1,296 @@
+/**
+ * @file       test_dsp_codec.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Host test, encodes synthetic signals with dsp_codec and decodes them back
+ * @note       Every decoded sample must equal its input saturated to 24 bits, the blocks must
+ *             stay within their buffer whatever the frames cost
+ * @example    test_dsp_codec
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsp_codec.h"
+
+/* Private defines ---------------------------------------------------- */
+#define TEST_MAX_FRAMES             (2048)
+#define TEST_BLOCK_FRAMES           (256)     // Frames of a large block
+#define TEST_SMALL_BLOCK_SIZE       (48)      // Block buffer that fills before the frames run out
+#define TEST_SAMPLE_MAX             ((1L << (DSP_CODEC_SAMPLE_BITS - 1)) - 1)
+#define TEST_SAMPLE_MIN             (-(1L << (DSP_CODEC_SAMPLE_BITS - 1)))
+
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Test signal enum
+ */
+typedef enum
+{
+  TEST_SIGNAL_ECG = 0x00      // Slow wave with sharp beats and a little noise
+  , TEST_SIGNAL_WALK          // Random walk, second-order friendly
+  , TEST_SIGNAL_NOISE         // White noise over the full range, escapes
+  , TEST_SIGNAL_CLIP          // Values past 24 bits, saturated by the encoder
+  , TEST_SIGNAL_MAX
+}
+test_signal_t;
+
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static const char *m_signal_name[TEST_SIGNAL_MAX] = { "ecg", "walk", "noise", "clip" };
+
+static int32_t  m_input[TEST_MAX_FRAMES * DSP_CODEC_MAX_CHANNELS];
+static int32_t  m_output[TEST_MAX_FRAMES * DSP_CODEC_MAX_CHANNELS];
+static uint8_t  m_block[DSP_CODEC_MAX_SIZE(DSP_CODEC_MAX_CHANNELS, TEST_BLOCK_FRAMES) + 1];   // One guard byte
+static uint32_t m_rand = 1;
+
+/* Private function prototypes ---------------------------------------- */
+static int32_t m_test_rand(void);
+static int32_t m_test_saturate(int32_t value);
+static void m_test_generate(test_signal_t signal, uint8_t channels, uint16_t frames);
+static int m_test_round_trip(test_signal_t signal, uint8_t channels, uint16_t frames, uint16_t block_size);
+static int m_test_corrupt(void);
+
+/* Function definitions ----------------------------------------------- */
+int main(void)
+{
+  int failures = 0;
+
+  for (uint8_t s = 0; s < TEST_SIGNAL_MAX; s++)
+  {
+    failures += m_test_round_trip((test_signal_t)s, 1, TEST_MAX_FRAMES, sizeof(m_block) - 1);
+    failures += m_test_round_trip((test_signal_t)s, 3, TEST_MAX_FRAMES, sizeof(m_block) - 1);
+    failures += m_test_round_trip((test_signal_t)s, DSP_CODEC_MAX_CHANNELS, 1000, sizeof(m_block) - 1);
+
+    // Blocks that fill up frame after frame, the frame that does not fit is rolled back
+    failures += m_test_round_trip((test_signal_t)s, 1, TEST_MAX_FRAMES, TEST_SMALL_BLOCK_SIZE);
+    failures += m_test_round_trip((test_signal_t)s, 2, TEST_MAX_FRAMES, TEST_SMALL_BLOCK_SIZE + 1);
+  }
+
+  failures += m_test_corrupt();
+
+  printf("%s, %d failure(s)\n", (failures == 0) ? "PASS" : "FAIL", failures);
+
+  return failures;
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Reproducible pseudo-random number (LCG)
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        15-bit value
+ */
+static int32_t m_test_rand(void)
+{
+  m_rand = m_rand * 1103515245u + 12345u;
+
+  return (int32_t)((m_rand >> 16) & 0x7FFF);
+}
+
+/**
+ * @brief         Saturate to the codec sample range
+ *
+ * @param[in]     value         Value
+ *
+ * @attention     None
+ *
+ * @return        Saturated value
+ */
+static int32_t m_test_saturate(int32_t value)
+{
+  if (value > TEST_SAMPLE_MAX)
+    return TEST_SAMPLE_MAX;
+  if (value < TEST_SAMPLE_MIN)
+    return TEST_SAMPLE_MIN;
+
+  return value;
+}
+
+/**
+ * @brief         Fill the input with a test signal
+ *
+ * @param[in]     signal        Test signal
+ * @param[in]     channels      Samples per frame
+ * @param[in]     frames        Frames
+ *
+ * @attention     Each channel is scaled and offset differently
+ *
+ * @return        None
+ */
+static void m_test_generate(test_signal_t signal, uint8_t channels, uint16_t frames)
+{
+  int32_t walk[DSP_CODEC_MAX_CHANNELS] = { 0 };
+
+  m_rand = 1u + (uint32_t)signal;
+
+  for (uint16_t n = 0; n < frames; n++)
+  {
+    for (uint8_t c = 0; c < channels; c++)
+    {
+      int32_t value = 0;
+
+      switch (signal)
+      {
+      case TEST_SIGNAL_ECG:
+      {
+        // 125 SPS, 72 bpm, a 40 ms beat on a breathing baseline
+        uint16_t phase = n % 104;
+
+        value = (int32_t)(300.0 * sin(2.0 * M_PI * n / 500.0)) + (m_test_rand() % 9) - 4;
+        if (phase < 5)
+          value += (2 - abs((int)phase - 2)) * 900;
+        value = value * (c + 1) + c * 1000;
+        break;
+      }
+
+      case TEST_SIGNAL_WALK:
+        walk[c] += (m_test_rand() % 201) - 100;
+        value    = walk[c];
+        break;
+
+      case TEST_SIGNAL_NOISE:
+        value = ((m_test_rand() << 9) | (m_test_rand() & 0x1FF)) - (1L << 23);
+        break;
+
+      case TEST_SIGNAL_CLIP:
+        value = (m_test_rand() & 1) ? (TEST_SAMPLE_MAX + m_test_rand() * 1000) : (TEST_SAMPLE_MIN - m_test_rand() * 1000);
+        break;
+
+      default:
+        break;
+      }
+
+      m_input[(uint32_t)n * channels + c] = value;
+    }
+  }
+}
+
+/**
+ * @brief         Encode a signal in consecutive blocks and compare the decoded samples
+ *
+ * @param[in]     signal        Test signal
+ * @param[in]     channels      Samples per frame
+ * @param[in]     frames        Frames
+ * @param[in]     block_size    Block buffer size (bytes), less than the size of m_block
+ *
+ * @attention     The codec is not restarted between the blocks, as on the target
+ *
+ * @return        Number of failed checks
+ */
+static int m_test_round_trip(test_signal_t signal, uint8_t channels, uint16_t frames, uint16_t block_size)
+{
+  dsp_codec_t codec;
+  uint32_t    coded    = 0;
+  uint16_t    blocks   = 0;
+  uint16_t    done     = 0;
+  int         failures = 0;
+
+  m_test_generate(signal, channels, frames);
+
+  if (!dsp_codec_init(&codec, channels))
+  {
+    fprintf(stderr, "dsp_codec_init(%u) failed\n", channels);
+    return 1;
+  }
+
+  while (done < frames)
+  {
+    uint16_t count = 0;
+    uint16_t len;
+    uint16_t decoded;
+
+    // The byte past the buffer catches a write out of bounds
+    memset(m_block, 0xA5, sizeof(m_block));
+    dsp_codec_block_start(&codec, m_block, block_size);
+
+    while (((done + count) < frames) && (count < TEST_BLOCK_FRAMES) &&
+           dsp_codec_block_add(&codec, &m_input[(uint32_t)(done + count) * channels]))
+      count++;
+
+    len = dsp_codec_block_end(&codec);
+
+    if ((count == 0) || (len > block_size) || (m_block[block_size] != 0xA5))
+    {
+      printf("FAIL %-5s %u ch, block %u: %u frames in %u bytes of %u\n",
+             m_signal_name[signal], channels, blocks, count, len, block_size);
+      return failures + 1;
+    }
+
+    decoded = dsp_codec_decode(m_block, len, channels, &m_output[(uint32_t)done * channels], TEST_MAX_FRAMES - done);
+    if (decoded != count)
+    {
+      printf("FAIL %-5s %u ch, block %u: %u frames decoded of %u\n", m_signal_name[signal], channels, blocks, decoded, count);
+      return failures + 1;
+    }
+
+    coded += len;
+    done  += count;
+    blocks++;
+  }
+
+  for (uint32_t i = 0; i < (uint32_t)frames * channels; i++)
+  {
+    if (m_output[i] != m_test_saturate(m_input[i]))
+    {
+      if (failures++ < 4)
+        printf("FAIL %-5s %u ch, frame %u ch %u: %d decoded, %d coded\n", m_signal_name[signal], channels,
+               i / channels, i % channels, m_output[i], m_test_saturate(m_input[i]));
+    }
+  }
+
+  printf("%s %-5s %u ch, %4u frames in %3u blocks of %4u bytes, %5.2f bits/sample\n",
+         (failures == 0) ? "PASS" : "FAIL", m_signal_name[signal], channels, frames, blocks, block_size,
+         8.0 * coded / ((double)frames * channels));
+
+  return failures;
+}
+
+/**
+ * @brief         Decode truncated and inconsistent blocks
+ *
+ * @param[in]     None
+ *
+ * @attention     None
+ *
+ * @return        Number of failed checks
+ */
+static int m_test_corrupt(void)
+{
+  dsp_codec_t codec;
+  uint16_t    len;
+  int         failures = 0;
+
+  m_test_generate(TEST_SIGNAL_WALK, 1, 100);
+  dsp_codec_init(&codec, 1);
+  dsp_codec_block_start(&codec, m_block, sizeof(m_block));
+  for (uint16_t n = 0; n < 100; n++)
+    dsp_codec_block_add(&codec, &m_input[n]);
+  len = dsp_codec_block_end(&codec);
+
+  // Cut short, more frames than the output holds, no frame, bad predictor order
+  if (dsp_codec_decode(m_block, len / 2, 1, m_output, TEST_MAX_FRAMES) != 0)
+    failures++;
+  if (dsp_codec_decode(m_block, len, 1, m_output, 99) != 0)
+    failures++;
+  if (dsp_codec_decode(m_block, DSP_CODEC_HEADER_SIZE - 1, 1, m_output, TEST_MAX_FRAMES) != 0)
+    failures++;
+
+  m_block[2] |= 0x03;
+  if (dsp_codec_decode(m_block, len, 1, m_output, TEST_MAX_FRAMES) != 0)
+    failures++;
+
+  printf("%s corrupted blocks\n", (failures == 0) ? "PASS" : "FAIL");
+
+  return failures;
+}
+
+/* End of file -------------------------------------------------------- */
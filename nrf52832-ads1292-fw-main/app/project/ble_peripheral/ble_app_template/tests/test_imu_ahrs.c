@@ -0,0 +1,255 @@
+/**
+ * @file       test_imu_ahrs.c
+ * @copyright  Copyright (C) 2020 Hydratech. All rights reserved.
+ * @license    This project is released under the Hydratech License.
+ * @version    1.0.0
+ * @date       2026-10-18
+ * @author     Bony
+ * @brief      Host test, replays an IMU recording through the orientation filter
+ * @note       The output at each reference frame must match the reference orientation
+ *             within the tolerances below
+ * @example    test_imu_ahrs data/imu_turn_6axis.csv data/imu_turn_6axis_ref.csv
+ */
+
+/* Includes ----------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "imu_ahrs.h"
+
+/* Private defines ---------------------------------------------------- */
+#define TEST_SAMPLE_RATE            (200)               // _CONFIG_IMU_FIFO_RATE
+#define TEST_GYRO_SCALE             (500.0f / 32768.0f) // BSP_IMU_GYRO_FS, dps/LSB
+#define TEST_MAX_FRAMES             (4096)
+
+#define TEST_TILT_TOL_CDEG          (200)     // Roll and pitch
+#define TEST_YAW_TOL_CDEG           (300)     // Yaw, gyro bias is not compensated by the filter
+#define TEST_QUAT_TOL_DEG           (2.5f)    // Angle between the output and reference quaternions
+
+/* Private enumerate/structure ---------------------------------------- */
+/**
+ * @brief Reference orientation structure
+ */
+typedef struct
+{
+  uint32_t seq;
+  float    q[4];
+  int32_t  roll;
+  int32_t  pitch;
+  int32_t  yaw;
+}
+test_ref_t;
+
+/* Private macros ----------------------------------------------------- */
+/* Public variables --------------------------------------------------- */
+/* Private variables -------------------------------------------------- */
+static imu_ahrs_output_t m_outputs[TEST_MAX_FRAMES];
+
+/* Private function prototypes ---------------------------------------- */
+static void m_test_output_handler(const imu_ahrs_output_t *p_output);
+static int32_t m_test_angle_diff(int32_t a, int32_t b);
+static int m_test_replay(const char *p_path);
+static int m_test_check(const char *p_path);
+
+/* Function definitions ----------------------------------------------- */
+int main(int argc, char **argv)
+{
+  imu_ahrs_config_t config =
+  {
+    .sample_rate = TEST_SAMPLE_RATE,
+    .output_rate = TEST_SAMPLE_RATE,
+    .gyro_scale  = TEST_GYRO_SCALE,
+    .beta        = IMU_AHRS_BETA_DEFAULT
+  };
+
+  if (argc != 3)
+  {
+    fprintf(stderr, "usage: %s <frames.csv> <reference.csv>\n", argv[0]);
+    return 2;
+  }
+
+  if (!imu_ahrs_init(&config))
+  {
+    fprintf(stderr, "imu_ahrs_init failed\n");
+    return 1;
+  }
+
+  imu_ahrs_register_output_handler(m_test_output_handler);
+
+  if (m_test_replay(argv[1]) != 0)
+    return 1;
+
+  return m_test_check(argv[2]);
+}
+
+/* Private function definitions --------------------------------------- */
+/**
+ * @brief         Keep every output, indexed by frame counter
+ *
+ * @param[in]     p_output      Filter output
+ *
+ * @attention     None
+ *
+ * @return        None
+ */
+static void m_test_output_handler(const imu_ahrs_output_t *p_output)
+{
+  if (p_output->seq < TEST_MAX_FRAMES)
+    m_outputs[p_output->seq] = *p_output;
+}
+
+/**
+ * @brief         Difference of two angles, wrapped to +-180 deg
+ *
+ * @param[in]     a, b          Angles (0.01 deg)
+ *
+ * @attention     None
+ *
+ * @return        a - b (0.01 deg)
+ */
+static int32_t m_test_angle_diff(int32_t a, int32_t b)
+{
+  int32_t diff = (a - b) % 36000;
+
+  if (diff > 18000)
+    diff -= 36000;
+  else if (diff < -18000)
+    diff += 36000;
+
+  return diff;
+}
+
+/**
+ * @brief         Feed every frame of the recording to the filter
+ *
+ * @param[in]     p_path        Frame CSV: seq,ax,ay,az,gx,gy,gz,mx,my,mz (raw)
+ *
+ * @attention     Lines starting with '#' are skipped
+ *
+ * @return        0 on success
+ */
+static int m_test_replay(const char *p_path)
+{
+  FILE *f = fopen(p_path, "r");
+  char  line[256];
+  int   frames = 0;
+
+  if (f == NULL)
+  {
+    fprintf(stderr, "cannot open %s\n", p_path);
+    return 1;
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    mpu9250_fifo_frame_t frame;
+    unsigned int seq;
+    int v[9];
+
+    if (line[0] == '#')
+      continue;
+
+    if (sscanf(line, "%u,%d,%d,%d,%d,%d,%d,%d,%d,%d", &seq,
+               &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]) != 10)
+    {
+      fprintf(stderr, "%s: bad line %d\n", p_path, frames + 1);
+      fclose(f);
+      return 1;
+    }
+
+    frame.accel.x = (int16_t)v[0];
+    frame.accel.y = (int16_t)v[1];
+    frame.accel.z = (int16_t)v[2];
+    frame.gyro.x  = (int16_t)v[3];
+    frame.gyro.y  = (int16_t)v[4];
+    frame.gyro.z  = (int16_t)v[5];
+    frame.mag.x   = (int16_t)v[6];
+    frame.mag.y   = (int16_t)v[7];
+    frame.mag.z   = (int16_t)v[8];
+
+    imu_ahrs_update(&frame, seq);
+    frames++;
+  }
+
+  fclose(f);
+  printf("%s: %d frames\n", p_path, frames);
+
+  return (frames > 0) ? 0 : 1;
+}
+
+/**
+ * @brief         Compare the filter output with the reference orientations
+ *
+ * @param[in]     p_path        Reference CSV: seq,qw,qx,qy,qz,roll,pitch,yaw
+ *
+ * @attention     q and -q are the same orientation
+ *
+ * @return        Number of failed checks
+ */
+static int m_test_check(const char *p_path)
+{
+  FILE *f = fopen(p_path, "r");
+  char  line[256];
+  int   failures = 0;
+  int   checks   = 0;
+
+  if (f == NULL)
+  {
+    fprintf(stderr, "cannot open %s\n", p_path);
+    return 1;
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    const imu_ahrs_output_t *p_out;
+    test_ref_t ref;
+    float dot = 0.0f;
+    float q_err;
+    int32_t d_roll, d_pitch, d_yaw;
+    bool ok;
+
+    if (line[0] == '#')
+      continue;
+
+    if ((sscanf(line, "%u,%f,%f,%f,%f,%d,%d,%d", &ref.seq, &ref.q[0], &ref.q[1], &ref.q[2], &ref.q[3],
+                &ref.roll, &ref.pitch, &ref.yaw) != 8) || (ref.seq >= TEST_MAX_FRAMES))
+    {
+      fprintf(stderr, "%s: bad line\n", p_path);
+      failures++;
+      continue;
+    }
+
+    p_out = &m_outputs[ref.seq];
+
+    for (uint8_t i = 0; i < 4; i++)
+      dot += ref.q[i] * (float)p_out->q[i] / (float)IMU_AHRS_Q14_ONE;
+
+    q_err   = 2.0f * acosf(fminf(fabsf(dot), 1.0f)) * 57.2957795f;
+    d_roll  = m_test_angle_diff(p_out->roll, ref.roll);
+    d_pitch = m_test_angle_diff(p_out->pitch, ref.pitch);
+    d_yaw   = m_test_angle_diff(p_out->yaw, ref.yaw);
+
+    ok = (p_out->seq == ref.seq) && (q_err <= TEST_QUAT_TOL_DEG) &&
+         (abs(d_roll) <= TEST_TILT_TOL_CDEG) && (abs(d_pitch) <= TEST_TILT_TOL_CDEG) &&
+         (abs(d_yaw) <= TEST_YAW_TOL_CDEG);
+
+    printf("%s seq %5u  q err %5.2f deg  roll %6d (%+5d)  pitch %6d (%+5d)  yaw %6d (%+5d)\n",
+           ok ? "PASS" : "FAIL", ref.seq, q_err, p_out->roll, d_roll, p_out->pitch, d_pitch, p_out->yaw, d_yaw);
+
+    checks++;
+    if (!ok)
+      failures++;
+  }
+
+  fclose(f);
+
+  if (checks == 0)
+  {
+    fprintf(stderr, "%s: no reference\n", p_path);
+    return 1;
+  }
+
+  return failures;
+}
+
+/* End of file -------------------------------------------------------- */
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Generate the IMU replay recordings of the host tests.
+
+Each recording is a sequence of static poses and constant-rate turns about the
+earth vertical, sampled at the FIFO rate with the raw scales of bsp_imu.h
+(accel +-4 g, gyro +-500 dps, AK8963 0.15 uT/LSB). White noise and a constant
+gyro bias are added with a fixed seed so the files are reproducible.
+
+The frame CSV holds one raw frame per line:
+    seq,ax,ay,az,gx,gy,gz,mx,my,mz
+The reference CSV holds the true orientation at the checkpoints:
+    seq,qw,qx,qy,qz,roll,pitch,yaw        (angles in 0.01 deg)
+
+Usage: imu_csv_gen.py <output dir>
+"""
+
+import math
+import os
+import random
+import sys
+
+RATE_HZ       = 200
+ACCEL_LSB_G   = 32768 / 4.0
+GYRO_LSB_DPS  = 32768 / 500.0
+MAG_NT_LSB    = 150.0
+
+ACCEL_NOISE_G = 0.01
+GYRO_NOISE    = 0.15    # dps
+GYRO_BIAS     = (0.3, -0.2, 0.1)
+MAG_NOISE_NT  = 300.0
+
+# Earth field, 48 uT with 60 deg inclination, pointing north (+x) and down (-z)
+EARTH_FIELD_NT = (48000.0 * math.cos(math.radians(60)), 0.0, -48000.0 * math.sin(math.radians(60)))
+
+
+def q_mul(a, b):
+  return (a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3],
+          a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2],
+          a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1],
+          a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0])
+
+
+def q_from_euler(roll, pitch, yaw):
+  cr, sr = math.cos(roll / 2), math.sin(roll / 2)
+  cp, sp = math.cos(pitch / 2), math.sin(pitch / 2)
+  cy, sy = math.cos(yaw / 2), math.sin(yaw / 2)
+  return (cr * cp * cy + sr * sp * sy,
+          sr * cp * cy - cr * sp * sy,
+          cr * sp * cy + sr * cp * sy,
+          cr * cp * sy - sr * sp * cy)
+
+
+def q_to_euler(q):
+  w, x, y, z = q
+  roll  = math.atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y))
+  pitch = math.asin(max(-1.0, min(1.0, 2 * (w * y - z * x))))
+  yaw   = math.atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z))
+  return roll, pitch, yaw
+
+
+def earth_to_sensor(q, v):
+  """Rotate an earth vector into the sensor frame, q is the sensor to earth rotation."""
+  qc = (q[0], -q[1], -q[2], -q[3])
+  r  = q_mul(q_mul(qc, (0.0, v[0], v[1], v[2])), q)
+  return r[1], r[2], r[3]
+
+
+def raw(value, scale):
+  return max(-32768, min(32767, int(round(value * scale))))
+
+
+def generate(path, segments, checkpoints, use_mag, seed):
+  """segments: list of (seconds, yaw rate dps), the pose starts from segments[0] initial q."""
+  rng   = random.Random(seed)
+  q     = segments[0]
+  seq   = 0
+  refs  = []
+  dt    = 1.0 / RATE_HZ
+
+  with open(path + ".csv", "w") as f:
+    f.write("# seq,ax,ay,az,gx,gy,gz,mx,my,mz (raw LSB, %d Hz)\n" % RATE_HZ)
+
+    for seconds, rate_dps in segments[1:]:
+      for _ in range(int(seconds * RATE_HZ)):
+        # Constant turn about the earth vertical, seen by the gyro in the sensor frame
+        w_earth = (0.0, 0.0, math.radians(rate_dps))
+        w_body  = earth_to_sensor(q, w_earth)
+        half    = (0.0, w_body[0] * dt / 2, w_body[1] * dt / 2, w_body[2] * dt / 2)
+        q       = q_mul(q, (1.0, half[1], half[2], half[3]))
+        n       = math.sqrt(sum(c * c for c in q))
+        q       = tuple(c / n for c in q)
+
+        acc = earth_to_sensor(q, (0.0, 0.0, 1.0))
+        mag = earth_to_sensor(q, EARTH_FIELD_NT) if use_mag else (0.0, 0.0, 0.0)
+
+        frame  = [raw(a + rng.gauss(0, ACCEL_NOISE_G), ACCEL_LSB_G) for a in acc]
+        frame += [raw(math.degrees(w) + b + rng.gauss(0, GYRO_NOISE), GYRO_LSB_DPS)
+                  for w, b in zip(w_body, GYRO_BIAS)]
+        if use_mag:
+          # AK8963 axes: X and Y swapped, Z inverted against the accel/gyro axes
+          m = [mag[1], mag[0], -mag[2]]
+          frame += [raw(c + rng.gauss(0, MAG_NOISE_NT), 1.0 / MAG_NT_LSB) for c in m]
+        else:
+          frame += [0, 0, 0]
+
+        f.write("%d,%s\n" % (seq, ",".join(str(v) for v in frame)))
+
+        if seq in checkpoints:
+          r, p, y = q_to_euler(q)
+          refs.append((seq, q, r, p, y))
+        seq += 1
+
+  with open(path + "_ref.csv", "w") as f:
+    f.write("# seq,qw,qx,qy,qz,roll,pitch,yaw (quaternion, 0.01 deg)\n")
+    for seq, q, r, p, y in refs:
+      f.write("%d,%.5f,%.5f,%.5f,%.5f,%d,%d,%d\n" % (seq, q[0], q[1], q[2], q[3],
+              round(math.degrees(r) * 100), round(math.degrees(p) * 100), round(math.degrees(y) * 100)))
+
+
+def main():
+  out = sys.argv[1] if len(sys.argv) > 1 else "."
+
+  # 6-axis: tilted, 90 deg turn at 45 dps, settle, -45 deg turn, settle
+  generate(os.path.join(out, "imu_turn_6axis"),
+           [q_from_euler(math.radians(20), math.radians(-10), 0.0), (3, 0), (2, 45), (2, 0), (1, -45), (2, 0)],
+           {599, 999, 1399, 1599, 1999}, False, 1)
+
+  # 9-axis: tilted with a heading of 30 deg, 60 deg turn at 30 dps, settle
+  generate(os.path.join(out, "imu_turn_9axis"),
+           [q_from_euler(math.radians(-15), math.radians(25), math.radians(30)), (3, 0), (2, 30), (3, 0)],
+           {599, 999, 1599}, True, 2)
+
+
+if __name__ == "__main__":
+  main()